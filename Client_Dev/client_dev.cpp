@@ -1,5 +1,10 @@
 #include "client_dev.hpp"
 
+#define SPRITE_BENCHMARK 0
+#define PARALLAX_ARRAY 0
+#define TILEMAP_BENCHMARK 0
+#define PARTICLE_BENCHMARK 0
+
 ClientDev::ClientDev() {}
 
 ClientDev::~ClientDev() {
@@ -20,6 +25,9 @@ void ClientDev::Init() {
 	config.context_size = nxt::context::Size::FULLSCREEEN;
 
 	nxt::Context::Instance().Create(config);
+	// the benchmarks measure every frame they can draw
+	nxt::Context::Instance().SetVSync(false);
+	SetFixedStep(0.0f);
 	nxt::Context::Instance().SetIcon(
 		nxt::FileSystem::Instance().GetPathString("textures") + "tux.png");
 
@@ -59,6 +67,16 @@ void ClientDev::Init() {
 		nxt::FileSystem::Instance().GetPathString("textures") + "donut_icon.png",
 		"donut");
 
+#if SPRITE_BENCHMARK == 1
+	InitSpriteBenchmark();
+#endif
+#if TILEMAP_BENCHMARK == 1
+	InitTilemapBenchmark();
+#endif
+#if PARTICLE_BENCHMARK == 1
+	InitParticleBenchmark();
+#endif
+
 	p_sprite_ = std::make_shared<nxt::SpriteRenderer>(
 		nxt::ResourceManager::GetShader("sprite"),
 		nxt::Context::Instance().GetWidth(),
@@ -82,12 +100,21 @@ void ClientDev::Init() {
 		nxt::FileSystem::Instance().GetPathString("textures") + "parallax/01_ground.png"
 	};
 
+#if PARALLAX_ARRAY == 1
+	nxt::ResourceManager::LoadShader(
+		nxt::FileSystem::Instance().GetPathString("shader") + "parallax_vert_shader.glsl",
+		nxt::FileSystem::Instance().GetPathString("shader") + "parallax_frag_shader.glsl",
+		"parallax");
+	p_parallax_->Init(nxt::ResourceManager::GetShader("parallax"), image_path_list, nxt::ParallaxMode::TEXTURE_ARRAY);
+#else
 	p_parallax_->Init(nxt::ResourceManager::GetShader("sprite"), image_path_list);
+#endif
 
 	nxt::opengl::SetSpriteMode();
 }
 
 void ClientDev::ProcessInput(float dt) {
+	frame_dt_ = dt;
 	if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_ESCAPE))
 		nxt::Context::Instance().SetCloseFlag();
 
@@ -99,10 +126,25 @@ void ClientDev::ProcessInput(float dt) {
 	nxt::Context::Instance().PollEvents();
 }
 
-void ClientDev::Render() {
+// variable step, there is nothing to interpolate
+void ClientDev::Render(float) {
 	nxt::Renderer::Clear();
+#if SPRITE_BENCHMARK == 1
+	RenderSpriteBenchmark(frame_dt_);
+	return;
+#endif
+#if TILEMAP_BENCHMARK == 1
+	RenderTilemapBenchmark(frame_dt_);
+	return;
+#endif
+#if PARTICLE_BENCHMARK == 1
+	RenderParticleBenchmark(frame_dt_);
+	return;
+#endif
 	static float x{}, y{};
+#if PARALLAX_ARRAY == 0
 	static float x_half_width = nxt::Context::Instance().GetWidth() / 2;
+#endif
 	static float y_half_width = nxt::Context::Instance().GetHeight() / 2;
 
 	//p_parallax_->Draw(0.4f, glm::fvec2{ x, y });
@@ -111,7 +153,10 @@ void ClientDev::Render() {
 	x += 2.5f;
 	//y += 0.5f;
 
+#if PARALLAX_ARRAY == 0
+	// layers only wrap in texture array mode
 	x = glm::clamp<float>(x, 0, x_half_width * 2);
+#endif
 	//y = glm::clamp<float>(y, 0, y_half_width * 2);
 
 	//p_sprite_->Draw(
@@ -126,7 +171,197 @@ void ClientDev::Render() {
 		glm::fvec2{ 100.0f, 100.0f });
 
 	nxt::ResourceManager::GetTextRenderer("SedgwickAve")->Draw(
-		"Framerate: " + std::to_string(nxt::Context::Instance().GetFrameRate(2)).substr(0, 5),
+		nxt::FrameArena::Get().Format("Framerate: %.2f", nxt::Context::Instance().GetFrameRate(2)),
+		0.0f,
+		0.0f,
+		1.2f,
+		glm::fvec3{ 0.9f, 0.4f, 0.5f });
+
+	nxt::Context::Instance().SwapBuffers();
+}
+
+void ClientDev::InitSpriteBenchmark() {
+	nxt::ResourceManager::LoadShader(
+		nxt::FileSystem::Instance().GetPathString("shader") + "sprite_batch_vert_shader.glsl",
+		nxt::FileSystem::Instance().GetPathString("shader") + "sprite_batch_frag_shader.glsl",
+		"sprite_batch");
+	nxt::ResourceManager::LoadTexture(
+		nxt::ResourceManager::GetShader("sprite_batch"),
+		nxt::FileSystem::Instance().GetPathString("textures") + "pacman.png",
+		"pacman");
+
+	p_sprite_batch_ = std::make_unique<nxt::SpriteBatch>(
+		nxt::ResourceManager::GetShader("sprite_batch"),
+		nxt::Context::Instance().GetWidth(),
+		nxt::Context::Instance().GetHeight(),
+		kBenchmarkSprites);
+
+	const float width = static_cast<float>(nxt::Context::Instance().GetWidth());
+	const float height = static_cast<float>(nxt::Context::Instance().GetHeight());
+	v_bench_positions_.resize(kBenchmarkSprites);
+	v_bench_velocities_.resize(kBenchmarkSprites);
+	v_bench_rotations_.resize(kBenchmarkSprites);
+	v_bench_spins_.resize(kBenchmarkSprites);
+	for (size_t i{}; i < kBenchmarkSprites; ++i) {
+		v_bench_positions_[i] = glm::fvec2{ std::rand() % static_cast<int>(width), std::rand() % static_cast<int>(height) };
+		v_bench_velocities_[i] = glm::fvec2{ std::rand() % 400 - 200, std::rand() % 400 - 200 };
+		v_bench_rotations_[i] = static_cast<float>(std::rand() % 360);
+		v_bench_spins_[i] = static_cast<float>(std::rand() % 360 - 180);
+	}
+}
+
+void ClientDev::RenderSpriteBenchmark(float dt) {
+	const float width = static_cast<float>(nxt::Context::Instance().GetWidth());
+	const float height = static_cast<float>(nxt::Context::Instance().GetHeight());
+	const float begin_time = nxt::Context::Instance().GetTime();
+	const std::shared_ptr<nxt::Texture2D> textures[]{
+		nxt::ResourceManager::GetTexture("donut"),
+		nxt::ResourceManager::GetTexture("pacman") };
+
+	// interleave both textures on submission so the batch has to sort
+	p_sprite_batch_->Begin(nxt::SpriteSortMode::TEXTURE);
+	for (size_t i{}; i < kBenchmarkSprites; ++i) {
+		glm::fvec2 &position = v_bench_positions_[i];
+		glm::fvec2 &velocity = v_bench_velocities_[i];
+		position += velocity * dt;
+		if (position.x < 0.0f || position.x > width) velocity.x = -velocity.x;
+		if (position.y < 0.0f || position.y > height) velocity.y = -velocity.y;
+		float &rotation = v_bench_rotations_[i];
+		rotation = std::fmod(rotation + v_bench_spins_[i] * dt, 360.0f);
+
+		p_sprite_batch_->Draw(
+			textures[i & 1],
+			position,
+			glm::fvec2{ 16.0f, 16.0f },
+			rotation,
+			glm::fvec4{ 1.0f },
+			(i & 1) ? 0.5f : 0.0f);
+	}
+	p_sprite_batch_->End();
+	const float cpu_ms = (nxt::Context::Instance().GetTime() - begin_time) * 1000.0f;
+
+	nxt::ResourceManager::GetTextRenderer("SedgwickAve")->Draw(
+		nxt::FrameArena::Get().Format(
+			"Framerate: %.2f Sprites: %zu Draw calls: %zu CPU ms: %.3f",
+			nxt::Context::Instance().GetFrameRate(2),
+			p_sprite_batch_->GetSpriteCount(),
+			p_sprite_batch_->GetDrawCallCount(),
+			cpu_ms),
+		0.0f,
+		0.0f,
+		1.2f,
+		glm::fvec3{ 0.9f, 0.4f, 0.5f });
+
+	nxt::Context::Instance().SwapBuffers();
+}
+
+void ClientDev::InitTilemapBenchmark() {
+	nxt::ResourceManager::LoadShader(
+		nxt::FileSystem::Instance().GetPathString("shader") + "tilemap_vert_shader.glsl",
+		nxt::FileSystem::Instance().GetPathString("shader") + "tilemap_frag_shader.glsl",
+		"tilemap");
+
+	const std::vector<std::string> tile_names{ "donut", "pacman", "tux" };
+	p_tile_atlas_ = std::make_unique<nxt::TextureAtlas>(nxt::ResourceManager::GetShader("tilemap"));
+	p_tile_atlas_->Add("donut", nxt::FileSystem::Instance().GetPathString("textures") + "donut_icon.png");
+	p_tile_atlas_->Add("pacman", nxt::FileSystem::Instance().GetPathString("textures") + "pacman.png");
+	p_tile_atlas_->Add("tux", nxt::FileSystem::Instance().GetPathString("textures") + "tux.png");
+	p_tile_atlas_->Build(true);
+
+	p_tilemap_ = std::make_unique<nxt::TilemapRenderer>(
+		nxt::ResourceManager::GetShader("tilemap"),
+		nxt::Context::Instance().GetWidth(),
+		nxt::Context::Instance().GetHeight(),
+		p_tile_atlas_->GetTexture(),
+		nxt::TilemapRenderer::GetAtlasUVs(*p_tile_atlas_, tile_names),
+		glm::fvec2{ 32.0f, 32.0f });
+
+	// ground layer filled completely, decoration layer sparse
+	std::vector<std::uint16_t> ground(kBenchmarkMapSize * kBenchmarkMapSize);
+	std::vector<std::uint16_t> decoration(kBenchmarkMapSize * kBenchmarkMapSize, nxt::TilemapRenderer::kEmptyTile);
+	for (size_t i{}; i < ground.size(); ++i) {
+		ground[i] = static_cast<std::uint16_t>(std::rand() % 2);
+		if (std::rand() % 16 == 0) decoration[i] = 2;
+	}
+	p_tilemap_->AddLayer(kBenchmarkMapSize, kBenchmarkMapSize, ground);
+	p_tilemap_->AddLayer(kBenchmarkMapSize, kBenchmarkMapSize, decoration);
+}
+
+void ClientDev::RenderTilemapBenchmark(float dt) {
+	const float begin_time = nxt::Context::Instance().GetTime();
+	p_tilemap_->SetTile(
+		0,
+		static_cast<GLuint>(std::rand()) % kBenchmarkMapSize,
+		static_cast<GLuint>(std::rand()) % kBenchmarkMapSize,
+		static_cast<std::uint16_t>(std::rand() % 2));
+
+	tilemap_view_ += glm::fvec2{ 120.0f, 80.0f } * dt;
+	p_tilemap_->Draw(tilemap_view_);
+	const float cpu_ms = (nxt::Context::Instance().GetTime() - begin_time) * 1000.0f;
+
+	nxt::ResourceManager::GetTextRenderer("SedgwickAve")->Draw(
+		nxt::FrameArena::Get().Format(
+			"Framerate: %.2f Tiles: %u Chunks drawn: %zu CPU ms: %.3f",
+			nxt::Context::Instance().GetFrameRate(2),
+			2 * kBenchmarkMapSize * kBenchmarkMapSize,
+			p_tilemap_->GetDrawnChunkCount(),
+			cpu_ms),
+		0.0f,
+		0.0f,
+		1.2f,
+		glm::fvec3{ 0.9f, 0.4f, 0.5f });
+
+	nxt::Context::Instance().SwapBuffers();
+}
+
+void ClientDev::InitParticleBenchmark() {
+	nxt::ResourceManager::LoadShader(
+		nxt::FileSystem::Instance().GetPathString("shader") + "particle_vert_shader.glsl",
+		nxt::FileSystem::Instance().GetPathString("shader") + "particle_frag_shader.glsl",
+		"particle");
+
+	p_particles_ = std::make_unique<nxt::ParticleSystem>(
+		nxt::ResourceManager::GetShader("particle"),
+		nxt::Context::Instance().GetWidth(),
+		nxt::Context::Instance().GetHeight(),
+		nxt::ResourceManager::GetTexture("donut"),
+		kBenchmarkParticles);
+	p_particles_->SetGravity(glm::fvec2{ 0.0f, 200.0f });
+	p_particles_->SetSizeCurve({ { 0.0f, 2.0f }, { 1.0f, 6.0f } });
+	p_particles_->SetColorCurve({
+		{ 0.0f, glm::fvec4{ 1.0f, 0.9f, 0.3f, 1.0f } },
+		{ 0.5f, glm::fvec4{ 0.9f, 0.3f, 0.2f, 0.8f } },
+		{ 1.0f, glm::fvec4{ 0.2f, 0.2f, 0.8f, 0.0f } } });
+
+	const float width = static_cast<float>(nxt::Context::Instance().GetWidth());
+	const float height = static_cast<float>(nxt::Context::Instance().GetHeight());
+	for (int i{}; i < 4; ++i) {
+		nxt::ParticleEmitter fountain{};
+		fountain.position = glm::fvec2{ width * (i + 1) / 5.0f, height - 20.0f };
+		fountain.position_variance = glm::fvec2{ 10.0f, 2.0f };
+		fountain.velocity = glm::fvec2{ 0.0f, -500.0f };
+		fountain.velocity_variance = glm::fvec2{ 150.0f, 100.0f };
+		fountain.lifetime = 4.0f;
+		fountain.lifetime_variance = 0.5f;
+		fountain.rate = kBenchmarkParticles / (4 * fountain.lifetime);
+		p_particles_->AddEmitter(fountain);
+	}
+}
+
+void ClientDev::RenderParticleBenchmark(float dt) {
+	const float begin_time = nxt::Context::Instance().GetTime();
+	p_particles_->Update(dt);
+	const float update_time = nxt::Context::Instance().GetTime();
+	p_particles_->Draw();
+	const float end_time = nxt::Context::Instance().GetTime();
+
+	nxt::ResourceManager::GetTextRenderer("SedgwickAve")->Draw(
+		nxt::FrameArena::Get().Format(
+			"Framerate: %.2f Particles: %zu Update ms: %.3f Draw ms: %.3f",
+			nxt::Context::Instance().GetFrameRate(2),
+			p_particles_->GetParticleCount(),
+			(update_time - begin_time) * 1000.0f,
+			(end_time - update_time) * 1000.0f),
 		0.0f,
 		0.0f,
 		1.2f,
@@ -145,13 +380,6 @@ void ClientDev::SetCallbacks() {
 	});
 }
 
-void ClientDev::Run() {
-	while (!nxt::Context::Instance()) {
-		ProcessInput(nxt::Context::Instance().GetTimePerFrame());
-		Render();
-	}
-}
-
 nxt::Application* nxt::CreateApplication() {
 	return new ClientDev();
 }
@@ -10,13 +10,41 @@ public:
 
 	virtual void Init() override final;
 	virtual void ProcessInput(float dt) override final;
-	virtual void Render() override final;
+	virtual void Render(float alpha) override final;
 	virtual void SetCallbacks() override final;
-	virtual void Run() override final;
 
 private:
 	std::shared_ptr<nxt::SpriteRenderer> p_sprite_;
 	std::unique_ptr<nxt::ParallaxRenderer> p_parallax_;
+	float frame_dt_{};
+
+	// sprite batch stress benchmark
+	static constexpr size_t kBenchmarkSprites{ 100000 };
+	std::unique_ptr<nxt::SpriteBatch> p_sprite_batch_;
+	std::vector<glm::fvec2> v_bench_positions_;
+	std::vector<glm::fvec2> v_bench_velocities_;
+	// degrees, and degrees per second
+	std::vector<float> v_bench_rotations_;
+	std::vector<float> v_bench_spins_;
+
+	void InitSpriteBenchmark();
+	void RenderSpriteBenchmark(float dt);
+
+	// large tile world scrolled diagonally, one random tile edit per frame
+	static constexpr GLuint kBenchmarkMapSize{ 1024 };
+	std::unique_ptr<nxt::TextureAtlas> p_tile_atlas_;
+	std::unique_ptr<nxt::TilemapRenderer> p_tilemap_;
+	glm::fvec2 tilemap_view_{};
+
+	void InitTilemapBenchmark();
+	void RenderTilemapBenchmark(float dt);
+
+	// four fountains keeping about a million particles alive
+	static constexpr size_t kBenchmarkParticles{ 1000000 };
+	std::unique_ptr<nxt::ParticleSystem> p_particles_;
+
+	void InitParticleBenchmark();
+	void RenderParticleBenchmark(float dt);
 };
 
 nxt::Application* nxt::CreateApplication();
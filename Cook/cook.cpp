@@ -0,0 +1,581 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <nxt/image.hpp>
+#include <nxt/compressed_image.hpp>
+#include <nxt/filesystem.hpp>
+#include <nxt/asset_pack.hpp>
+#include <nxt/texture_cache.hpp>
+#include <nxt/texture_atlas.hpp>
+#include <nxt/mesh_renderer.hpp>
+#include <nxt/text_renderer.hpp>
+#include <nxt/shader.hpp>
+#include <nxt/jobs.hpp>
+#include <nxt/sound_buffer_cache.hpp>
+#include <GLFW/glfw3.h>
+
+// nxt_cook textures <dir> [bc1|bc3|bc7|auto]
+// writes <name>.dds next to every png/jpg in dir, Texture2D picks it up on load
+// nxt_cook atlas <dir> <out_name> [max_size]
+// packs every png/jpg in dir into <out_name>.png with the region table
+// <out_name>.txt for TextureAtlas::Load, regions are named after the files
+// nxt_cook pack <resource_dir> <out.nxtpack> [lz4]
+// packs resource_dir into one archive for FileSystem::MountPack
+// nxt_cook all <resource_dir> [force]
+// cooks every mesh, texture, font, shader and sound effect below resource_dir on
+// all cores, skipping inputs whose content hash matches the one in
+// <resource_dir>/.nxtcook. Sounds longer than SoundBufferCache::kMaxCookedDuration
+// are music and left to stream
+// nxt_cook jobs [job_count]
+// runs job_count small jobs on a jobs::Scheduler with 1 up to one thread per
+// core and prints the throughput, flat from this thread and nested from jobs
+
+namespace {
+	bool IsSourceImage(const bf::path& path) {
+		const std::string extension = path.extension().string();
+		return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga";
+	}
+
+	bool IsOpaque(const nxt::Image& image) {
+		const unsigned char *pixels = image.GetData();
+		for (size_t i{ 3 }; i < image.GetSize(); i += 4) {
+			if (pixels[i] != 255) return false;
+		}
+		return true;
+	}
+
+	GLenum ParseFormat(const std::string& name, const nxt::Image& image) {
+		if (name == "bc1") return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		if (name == "bc3") return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		if (name == "bc7") return GL_COMPRESSED_RGBA_BPTC_UNORM;
+		// opaque images lose nothing in BC1 at half the size
+		return IsOpaque(image) ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+
+	bf::path GetTextureTarget(const bf::path& source) {
+		bf::path target{ source };
+		return target.replace_extension(".dds");
+	}
+
+	bool CookTexture(const bf::path& source, const std::string& format_name, std::ostream& log) {
+		const auto begin = std::chrono::steady_clock::now();
+		nxt::Image image;
+		if (!image.Load(source.string(), 4)) {
+			std::cerr << "ERROR LOADING TEXTURE '" << source.string() << "'" << std::endl;
+			return false;
+		}
+		nxt::CompressedImage compressed;
+		const bf::path target = GetTextureTarget(source);
+		if (!compressed.Encode(image, ParseFormat(format_name, image)) || !compressed.SaveDDS(target.string())) {
+			return false;
+		}
+		const std::chrono::duration<float, std::milli> elapsed{ std::chrono::steady_clock::now() - begin };
+		log << source.filename().string() << " -> " << target.filename().string()
+			<< " (" << image.GetSize() / 1024 << " KB -> " << compressed.GetSize() / 1024 << " KB, "
+			<< compressed.GetLevelCount() << " levels, " << elapsed.count() << " ms)" << std::endl;
+		return true;
+	}
+
+	int CookTextures(const bf::path& directory, const std::string& format_name) {
+		boost::system::error_code error;
+		if (!bf::is_directory(directory, error)) {
+			std::cerr << "NOT A DIRECTORY '" << directory.string() << "'" << std::endl;
+			return 1;
+		}
+
+		int failed{};
+		for (const bf::directory_entry& entry : bf::directory_iterator(directory)) {
+			const bf::path& source = entry.path();
+			if (!bf::is_regular_file(source) || !IsSourceImage(source)) continue;
+			if (!CookTexture(source, format_name, std::cout)) ++failed;
+		}
+		return failed == 0 ? 0 : 1;
+	}
+
+	int CookAtlas(const bf::path& directory, const std::string& out_name, int max_size) {
+		boost::system::error_code error;
+		if (!bf::is_directory(directory, error)) {
+			std::cerr << "NOT A DIRECTORY '" << directory.string() << "'" << std::endl;
+			return 1;
+		}
+
+		const auto begin = std::chrono::steady_clock::now();
+		// sorted, so the same images always give the same atlas
+		std::vector<bf::path> sources;
+		for (const bf::directory_entry& entry : bf::directory_iterator(directory)) {
+			if (bf::is_regular_file(entry.path()) && IsSourceImage(entry.path())) sources.push_back(entry.path());
+		}
+		std::sort(sources.begin(), sources.end());
+
+		// the shader only matters to Build, which uploads
+		nxt::TextureAtlas atlas{ nullptr, max_size };
+		for (const bf::path& source : sources) {
+			if (!atlas.Add(source.stem().string(), source.string())) return 1;
+		}
+		if (!atlas.Layout() || !atlas.Save(out_name + ".png", out_name + ".txt")) return 1;
+		const std::chrono::duration<float, std::milli> elapsed{ std::chrono::steady_clock::now() - begin };
+		std::cout << out_name << ".png (" << atlas.GetSize().x << "x" << atlas.GetSize().y << ", "
+			<< atlas.GetRegions().size() << " regions, " << elapsed.count() << " ms)" << std::endl;
+		return 0;
+	}
+
+	int CookPack(const std::string& directory, const std::string& out_file, bool compress) {
+		const auto begin = std::chrono::steady_clock::now();
+		if (!nxt::AssetPack::Build(directory, out_file, compress)) return 1;
+		const std::chrono::duration<float, std::milli> elapsed{ std::chrono::steady_clock::now() - begin };
+		std::cout << out_file << " (" << elapsed.count() << " ms)" << std::endl;
+		return 0;
+	}
+
+	// bumped whenever a cooked format or the cooking itself changes
+	constexpr std::uint32_t kCookVersion{ 1 };
+	constexpr unsigned int kDefaultFontSize{ 48 };
+	const char *const kCookManifest{ ".nxtcook" };
+
+	enum class JobType {
+		MESH,
+		TEXTURE,
+		FONT,
+		SHADER,
+		SOUND
+	};
+
+	struct Job {
+		JobType type;
+		bf::path source;
+		std::string relative;
+		std::vector<unsigned int> font_sizes;
+		std::uint64_t key;
+		bool up_to_date;
+		bool failed;
+		// shaders are preprocessed by the workers and validated on the main thread
+		GLenum stage;
+		std::string shader_source;
+		// too long to keep decoded, streamed by Music instead
+		bool streamed;
+	};
+
+	std::uint64_t Hash(const std::string& text, std::uint64_t hash = 14695981039346656037ull) {
+		for (unsigned char c : text) {
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	std::string ToHex(std::uint64_t value) {
+		std::ostringstream oss;
+		oss << std::hex << std::setw(16) << std::setfill('0') << value;
+		return oss.str();
+	}
+
+	bool GetJobType(const bf::path& path, JobType& type) {
+		const std::string extension = path.extension().string();
+		if (extension == ".obj") type = JobType::MESH;
+		else if (IsSourceImage(path)) type = JobType::TEXTURE;
+		else if (extension == ".ttf") type = JobType::FONT;
+		else if (extension == ".glsl") type = JobType::SHADER;
+		else if (extension == ".ogg" || extension == ".wav" || extension == ".flac") type = JobType::SOUND;
+		else return false;
+		return true;
+	}
+
+	// files meant to be included have no stage of their own and are not cooked
+	GLenum GetShaderStage(const bf::path& path) {
+		const std::string name = path.filename().string();
+		if (name.find("vert") != std::string::npos) return GL_VERTEX_SHADER;
+		if (name.find("frag") != std::string::npos) return GL_FRAGMENT_SHADER;
+		return GL_NONE;
+	}
+
+	// only the header is read to tell
+	// false when the file cannot be opened, it is neither cooked nor streamed
+	bool IsStreamed(const bf::path& path, bool& streamed) {
+		sf::InputSoundFile file;
+		if (!file.openFromFile(path.string())) {
+			std::cerr << "ERROR OPENING SOUND '" << path.string() << "'" << std::endl;
+			return false;
+		}
+		streamed = file.getDuration().asSeconds() > nxt::SoundBufferCache::kMaxCookedDuration;
+		return true;
+	}
+
+	std::vector<std::string> GetOutputs(const Job& job) {
+		const std::string source = job.source.string();
+		switch (job.type) {
+		case JobType::MESH: return { nxt::MeshRenderer::GetCookedPath(source) };
+		case JobType::TEXTURE: return { GetTextureTarget(job.source).string() };
+		case JobType::SHADER:
+			if (job.stage == GL_NONE) return {};
+			return { nxt::ShaderSource::GetCookedPath(source) };
+		case JobType::SOUND:
+			if (job.streamed) return {};
+			return { nxt::SoundBufferCache::GetCookedPath(source) };
+		case JobType::FONT: {
+			std::vector<std::string> outputs;
+			for (unsigned int size : job.font_sizes) outputs.push_back(nxt::TextRenderer::GetCookedPath(source, size));
+			return outputs;
+		}
+		}
+		return {};
+	}
+
+	// pixel sizes the manifests ask for, by font path relative to the resource dir
+	std::map<std::string, std::set<unsigned int>> FindFontSizes(const bf::path& root) {
+		namespace pt = boost::property_tree;
+		std::map<std::string, std::set<unsigned int>> sizes;
+		for (const bf::directory_entry& entry : bf::directory_iterator(root)) {
+			if (entry.path().extension() != ".json") continue;
+			pt::ptree tree;
+			try {
+				pt::read_json(entry.path().string(), tree);
+			}
+			catch (const pt::json_parser_error& ex) {
+				std::cerr << "ERROR READING MANIFEST '" << entry.path().string() << "': " << ex.what() << std::endl;
+				continue;
+			}
+			const boost::optional<pt::ptree&> assets = tree.get_child_optional("assets");
+			if (!assets) continue;
+			for (const auto& asset : *assets) {
+				if (asset.second.get<std::string>("type", "") != "font") continue;
+				const std::string file = bf::path(asset.second.get<std::string>("file", "")).generic_string();
+				sizes[file].insert(asset.second.get<unsigned int>("pixel_size", kDefaultFontSize));
+			}
+		}
+		return sizes;
+	}
+
+	std::map<std::string, std::uint64_t> ReadCookManifest(const bf::path& file) {
+		std::map<std::string, std::uint64_t> keys;
+		std::ifstream ifs(file.string());
+		std::string key, relative;
+		while (ifs >> key && std::getline(ifs >> std::ws, relative)) {
+			// a damaged entry only cooks its file again
+			try {
+				keys[relative] = std::stoull(key, nullptr, 16);
+			}
+			catch (const std::logic_error&) {
+				std::cerr << "IGNORING INVALID COOK MANIFEST ENTRY '" << relative << "'" << std::endl;
+			}
+		}
+		return keys;
+	}
+
+	bool WriteCookManifest(const bf::path& file, const std::vector<Job>& jobs) {
+		std::ofstream ofs(file.string(), std::ios::out | std::ios::trunc);
+		for (const Job& job : jobs) {
+			// failed jobs are left out so the next run tries them again
+			if (!job.failed) ofs << ToHex(job.key) << " " << job.relative << "\n";
+		}
+		ofs.close();
+		if (!ofs) {
+			std::cerr << "ERROR WRITING '" << file.string() << "'" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// quad or triangle faces, judged by the first face of the file
+	bool HasQuadFaces(const bf::path& file) {
+		std::ifstream ifs(file.string());
+		std::string line;
+		while (std::getline(ifs, line)) {
+			if (line.compare(0, 2, "f ") != 0) continue;
+			std::istringstream iss{ line.substr(2) };
+			std::string corner;
+			size_t corners{};
+			while (iss >> corner) ++corners;
+			return corners == 4;
+		}
+		return false;
+	}
+
+	std::uint64_t GetKey(const Job& job) {
+		std::string options = std::to_string(static_cast<int>(job.type)) + "|" + std::to_string(kCookVersion);
+		for (unsigned int size : job.font_sizes) options += "|" + std::to_string(size);
+		// shaders hash what their includes resolve to, not only their own file
+		const std::uint64_t content = job.type == JobType::SHADER ?
+			Hash(job.shader_source) : nxt::TextureCache::HashFile(job.source.string());
+		return Hash(options, content);
+	}
+
+	bool Cook(Job& job, std::ostream& log) {
+		const std::string source = job.source.string();
+		switch (job.type) {
+		case JobType::MESH: {
+			nxt::MeshData data;
+			const std::string cooked_file = nxt::MeshRenderer::GetCookedPath(source);
+			if (!nxt::MeshRenderer::Parse(source, HasQuadFaces(job.source), data, false) ||
+				!nxt::MeshRenderer::SaveCooked(cooked_file, data)) return false;
+			log << job.relative << " -> " << bf::path(cooked_file).filename().string()
+				<< " (" << data.vertices.size() << " vertices)" << std::endl;
+			return true;
+		}
+		case JobType::TEXTURE:
+			return CookTexture(job.source, "auto", log);
+		case JobType::FONT:
+			for (unsigned int size : job.font_sizes) {
+				nxt::GlyphAtlas atlas;
+				const std::string cooked_file = nxt::TextRenderer::GetCookedPath(source, size);
+				if (!nxt::TextRenderer::Rasterize(source, size, atlas) || !atlas.Save(cooked_file)) return false;
+				log << job.relative << " -> " << bf::path(cooked_file).filename().string()
+					<< " (" << atlas.width << "x" << atlas.height << ", " << atlas.glyphs.size() << " glyphs)" << std::endl;
+			}
+			return true;
+		case JobType::SHADER:
+			// written once validated, see CookShaders
+			return true;
+		case JobType::SOUND: {
+			if (job.streamed) return true;
+			sf::SoundBuffer buffer;
+			const std::string cooked_file = nxt::SoundBufferCache::GetCookedPath(source);
+			if (!buffer.loadFromFile(source)) {
+				std::cerr << "ERROR LOADING SOUND '" << source << "'" << std::endl;
+				return false;
+			}
+			if (!nxt::SoundBufferCache::SaveCooked(cooked_file, buffer)) return false;
+			log << job.relative << " -> " << bf::path(cooked_file).filename().string()
+				<< " (" << buffer.getSampleCount() * sizeof(sf::Int16) / 1024 << " KB, "
+				<< buffer.getDuration().asSeconds() << " s)" << std::endl;
+			return true;
+		}
+		}
+		return false;
+	}
+
+	// hidden window, only there to give the shader compiler a context
+	GLFWwindow* CreateValidationContext() {
+		if (!glfwInit()) return nullptr;
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		GLFWwindow *window = glfwCreateWindow(1, 1, "nxt_cook", nullptr, nullptr);
+		if (!window) {
+			glfwTerminate();
+			return nullptr;
+		}
+		glfwMakeContextCurrent(window);
+		glewExperimental = GL_TRUE;
+		if (glewInit() != GLEW_OK) {
+			glfwDestroyWindow(window);
+			glfwTerminate();
+			return nullptr;
+		}
+		return window;
+	}
+
+	void CookShaders(std::vector<Job*>& shaders) {
+		if (shaders.empty()) return;
+		GLFWwindow *window = CreateValidationContext();
+		if (!window) std::cerr << "WARNING NO OPENGL CONTEXT, SHADERS ARE COOKED WITHOUT VALIDATION" << std::endl;
+		for (Job *job : shaders) {
+			std::string log;
+			if (window && !nxt::Shader::Validate(job->stage, job->shader_source, log)) {
+				std::cerr << "ERROR VALIDATING SHADER '" << job->relative << "'\n" << log << std::endl;
+				job->failed = true;
+				continue;
+			}
+			const std::string cooked_file = nxt::ShaderSource::GetCookedPath(job->source.string());
+			std::ofstream ofs(cooked_file, std::ios::out | std::ios::binary | std::ios::trunc);
+			ofs << job->shader_source;
+			ofs.close();
+			if (!ofs) {
+				std::cerr << "ERROR WRITING '" << cooked_file << "'" << std::endl;
+				job->failed = true;
+				continue;
+			}
+			std::cout << job->relative << " -> " << bf::path(cooked_file).filename().string() << std::endl;
+		}
+		if (window) {
+			glfwDestroyWindow(window);
+			glfwTerminate();
+		}
+	}
+
+	int CookAll(const bf::path& root, bool force) {
+		boost::system::error_code error;
+		if (!bf::is_directory(root, error)) {
+			std::cerr << "NOT A DIRECTORY '" << root.string() << "'" << std::endl;
+			return 1;
+		}
+		const auto begin = std::chrono::steady_clock::now();
+		const bf::path manifest = root / kCookManifest;
+		const std::map<std::string, std::uint64_t> previous_keys = force ?
+			std::map<std::string, std::uint64_t>{} : ReadCookManifest(manifest);
+		const std::map<std::string, std::set<unsigned int>> font_sizes = FindFontSizes(root);
+
+		std::vector<Job> jobs;
+		for (const bf::directory_entry& entry : bf::recursive_directory_iterator(root)) {
+			JobType type;
+			if (!bf::is_regular_file(entry.path(), error) || !GetJobType(entry.path(), type)) continue;
+			Job job{};
+			job.type = type;
+			job.source = entry.path();
+			job.relative = entry.path().lexically_relative(root).generic_string();
+			if (type == JobType::FONT) {
+				std::set<unsigned int> sizes{ kDefaultFontSize };
+				const auto it = font_sizes.find(job.relative);
+				if (it != font_sizes.end()) sizes.insert(it->second.begin(), it->second.end());
+				job.font_sizes.assign(sizes.begin(), sizes.end());
+			}
+			job.stage = type == JobType::SHADER ? GetShaderStage(job.source) : GL_NONE;
+			job.failed = type == JobType::SOUND && !IsStreamed(job.source, job.streamed);
+			jobs.push_back(std::move(job));
+		}
+
+		// small ranges so one slow texture does not hold up the rest
+		std::mutex log_mutex;
+		nxt::jobs::ParallelFor(jobs.size(), 1, [&](size_t first, size_t last) {
+			for (size_t i{ first }; i < last; ++i) {
+				Job& job = jobs[i];
+				if (job.failed) continue;
+				if (job.type == JobType::SHADER && !nxt::ShaderSource::Preprocess(job.source.string(), job.shader_source)) {
+					job.failed = true;
+					continue;
+				}
+				job.key = GetKey(job);
+				const auto previous = previous_keys.find(job.relative);
+				// the engine loads the source over an output older than it
+				bool outputs_current{ true };
+				for (const std::string& output : GetOutputs(job)) {
+					outputs_current = outputs_current && !nxt::FileSystem::Instance().FindCooked(job.source, output).empty();
+				}
+				job.up_to_date = previous != previous_keys.end() && previous->second == job.key && outputs_current;
+				if (job.up_to_date || job.type == JobType::SHADER) continue;
+
+				std::ostringstream log;
+				job.failed = !Cook(job, log);
+				std::lock_guard<std::mutex> lock{ log_mutex };
+				std::cout << log.str();
+			}
+		});
+		const size_t thread_count = nxt::jobs::Scheduler::Instance().GetWorkerCount() + 1;
+
+		std::vector<Job*> shaders;
+		for (Job& job : jobs) {
+			if (job.type == JobType::SHADER && job.stage != GL_NONE && !job.failed && !job.up_to_date) shaders.push_back(&job);
+		}
+		CookShaders(shaders);
+
+		size_t cooked{}, skipped{}, failed{};
+		for (const Job& job : jobs) {
+			if (job.failed) ++failed;
+			else if (job.up_to_date) ++skipped;
+			else ++cooked;
+		}
+		const bool written = WriteCookManifest(manifest, jobs);
+		const std::chrono::duration<float, std::milli> elapsed{ std::chrono::steady_clock::now() - begin };
+		std::cout << cooked << " COOKED, " << skipped << " UP TO DATE, " << failed << " FAILED ON "
+			<< thread_count << " THREADS (" << elapsed.count() << " ms)" << std::endl;
+		return failed == 0 && written ? 0 : 1;
+	}
+
+	// a few microseconds of hashing per job, short enough that the scheduling
+	// cost still shows next to it
+	std::uint64_t BenchmarkWork(std::uint64_t seed) {
+		std::uint64_t hash{ seed };
+		for (std::uint64_t i{}; i < 256; ++i) hash = (hash ^ i) * 1099511628211ull;
+		return hash;
+	}
+
+	int BenchmarkJobs(size_t job_count) {
+		constexpr size_t kChildren{ 64 };
+		const size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		std::cout << job_count << " JOBS" << std::endl;
+		std::cout << std::setw(8) << "THREADS" << std::setw(14) << "FLAT JOBS/S" << std::setw(9) << "SPEEDUP"
+			<< std::setw(16) << "NESTED JOBS/S" << std::setw(9) << "SPEEDUP" << std::setw(10) << "STEALS" << std::endl;
+		double flat_baseline{}, nested_baseline{};
+		for (size_t threads{ 1 }; threads <= max_threads; ++threads) {
+			// the calling thread runs jobs too while it waits
+			nxt::jobs::Scheduler scheduler(threads - 1);
+			std::atomic<std::uint64_t> sink{ 0 };
+
+			// every job started from outside, through the shared queue
+			auto begin = std::chrono::steady_clock::now();
+			{
+				nxt::jobs::Counter counter;
+				for (size_t i{}; i < job_count; ++i) {
+					scheduler.Run([&sink, i]() { sink.fetch_add(BenchmarkWork(i), std::memory_order_relaxed); }, &counter);
+				}
+				scheduler.Wait(counter);
+			}
+			const std::chrono::duration<double> flat{ std::chrono::steady_clock::now() - begin };
+
+			// parents start their children on their own deque, the other
+			// workers have to steal them
+			begin = std::chrono::steady_clock::now();
+			{
+				nxt::jobs::Counter counter;
+				for (size_t first{}; first < job_count; first += kChildren) {
+					const size_t last = std::min(first + kChildren, job_count);
+					scheduler.Run([&scheduler, &sink, first, last]() {
+						nxt::jobs::Counter children;
+						for (size_t i{ first }; i < last; ++i) {
+							scheduler.Run([&sink, i]() { sink.fetch_add(BenchmarkWork(i), std::memory_order_relaxed); }, &children);
+						}
+						scheduler.Wait(children);
+					}, &counter);
+				}
+				scheduler.Wait(counter);
+			}
+			const std::chrono::duration<double> nested{ std::chrono::steady_clock::now() - begin };
+
+			const double flat_rate = job_count / flat.count();
+			const double nested_rate = job_count / nested.count();
+			if (threads == 1) {
+				flat_baseline = flat_rate;
+				nested_baseline = nested_rate;
+			}
+			std::cout << std::fixed << std::setprecision(0)
+				<< std::setw(8) << threads << std::setw(14) << flat_rate
+				<< std::setprecision(2) << std::setw(9) << flat_rate / flat_baseline
+				<< std::setprecision(0) << std::setw(16) << nested_rate
+				<< std::setprecision(2) << std::setw(9) << nested_rate / nested_baseline
+				<< std::setw(10) << scheduler.GetStealCount() << std::endl;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char *argv[]) {
+	const std::vector<std::string> args(argv + 1, argv + argc);
+	if (args.size() >= 2 && args[0] == "textures") {
+		return CookTextures(args[1], args.size() > 2 ? args[2] : "auto");
+	}
+	if (args.size() >= 3 && args[0] == "atlas") {
+		return CookAtlas(args[1], args[2], args.size() > 3 ? std::stoi(args[3]) : 4096);
+	}
+	if (args.size() >= 3 && args[0] == "pack") {
+		return CookPack(args[1], args[2], args.size() > 3 && args[3] == "lz4");
+	}
+	if (args.size() >= 2 && args[0] == "all") {
+		return CookAll(args[1], args.size() > 2 && args[2] == "force");
+	}
+	if (args.size() >= 1 && args[0] == "jobs") {
+		return BenchmarkJobs(args.size() > 1 ? std::stoul(args[1]) : 100000);
+	}
+	std::cout << "usage: nxt_cook textures <dir> [bc1|bc3|bc7|auto]" << std::endl;
+	std::cout << "       nxt_cook atlas <dir> <out_name> [max_size]" << std::endl;
+	std::cout << "       nxt_cook pack <resource_dir> <out.nxtpack> [lz4]" << std::endl;
+	std::cout << "       nxt_cook all <resource_dir> [force]" << std::endl;
+	std::cout << "       nxt_cook jobs [job_count]" << std::endl;
+	return 1;
+}
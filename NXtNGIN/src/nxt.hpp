@@ -5,13 +5,38 @@
 #include "nxt/application.hpp"
 
 #include "nxt/parallax_renderer.hpp"
+#include "nxt/resource_registry.hpp"
 #include "nxt/resource_manager.hpp"
 #include "nxt/sprite_renderer.hpp"
+#include "nxt/sprite_batch.hpp"
+#include "nxt/texture_atlas.hpp"
+#include "nxt/tilemap_renderer.hpp"
+#include "nxt/particle_system.hpp"
+#include "nxt/thread_pool.hpp"
+#include "nxt/jobs.hpp"
+#include "nxt/render_thread.hpp"
+#include "nxt/command_list.hpp"
+#include "nxt/frame_arena.hpp"
+#include "nxt/memory_tracker.hpp"
+#include "nxt/pixel_buffer_pool.hpp"
+#include "nxt/texture_loader.hpp"
+#include "nxt/compressed_image.hpp"
+#include "nxt/texture_streamer.hpp"
+#include "nxt/texture_cache.hpp"
+#include "nxt/residency_manager.hpp"
+#include "nxt/asset_loader.hpp"
+#include "nxt/asset_pack.hpp"
+#include "nxt/async_io.hpp"
+#include "nxt/lz4.hpp"
 #include "nxt/mesh_renderer.hpp"
 #include "nxt/context.hpp"
 #include "nxt/camera.hpp"
+#include "nxt/music_stream.hpp"
 #include "nxt/music.hpp"
 #include "nxt/sound.hpp"
+#include "nxt/sound_buffer_cache.hpp"
+#include "nxt/voice_pool.hpp"
+#include "nxt/audio_scene.hpp"
 #include "nxt/gl.hpp"
 
 //*******Entry Point**********
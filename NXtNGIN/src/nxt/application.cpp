@@ -1,7 +1,74 @@
+#include <cmath>
+#include <algorithm>
+#include <thread>
+
 #include "application.hpp"
+#include "context.hpp"
+#include "frame_arena.hpp"
+#include "memory_tracker.hpp"
+#include "jobs.hpp"
+#include "render_thread.hpp"
 
 namespace nxt {
-	Application::Application() {}
+	namespace {
+		// the part of a frame wait left to spinning
+		constexpr std::chrono::microseconds kSpinTime{ 2000 };
+		// longest frame time taken into account, e.g. after a breakpoint
+		constexpr double kMaxFrameTime{ 0.25 };
+	}
+
+	Application::Application() :
+		fixed_step_{ 1.0f / 60.0f },
+		max_steps_{ 5 },
+		frame_limit_{ 0.0f } {}
 
 	Application::~Application() {}
+
+	void Application::Run() {
+		Clock::time_point previous = Clock::now();
+		double accumulator{};
+		while (!Context::Instance()) {
+			const Clock::time_point frame_begin = Clock::now();
+			const double frame_time = std::min(
+				std::chrono::duration<double>(frame_begin - previous).count(), kMaxFrameTime);
+			previous = frame_begin;
+			FrameArena::NextFrame();
+			MemoryTracker::Instance().NextFrame();
+
+			// GL work queued by jobs goes where the context is
+			if (RenderThread::Instance().IsRunning()) {
+				RenderThread::Instance().Record([]() { jobs::Scheduler::Instance().RunMainThreadJobs(); });
+			}
+			else {
+				jobs::Scheduler::Instance().RunMainThreadJobs();
+			}
+
+			if (fixed_step_ <= 0.0f) {
+				ProcessInput(static_cast<float>(frame_time));
+				// the state just simulated is the one to draw
+				Render(1.0f);
+			}
+			else {
+				accumulator += frame_time;
+				int steps{};
+				while (accumulator >= fixed_step_ && steps < max_steps_) {
+					ProcessInput(fixed_step_);
+					accumulator -= fixed_step_;
+					++steps;
+				}
+				if (accumulator >= fixed_step_) accumulator = std::fmod(accumulator, static_cast<double>(fixed_step_));
+				Render(static_cast<float>(accumulator / fixed_step_));
+			}
+
+			if (frame_limit_ > 0.0f) WaitForFrameEnd(frame_begin);
+		}
+	}
+
+	void Application::WaitForFrameEnd(Clock::time_point frame_begin) const {
+		const Clock::time_point frame_end = frame_begin +
+			std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frame_limit_));
+		const Clock::time_point sleep_end = frame_end - kSpinTime;
+		if (Clock::now() < sleep_end) std::this_thread::sleep_until(sleep_end);
+		while (Clock::now() < frame_end) std::this_thread::yield();
+	}
 }
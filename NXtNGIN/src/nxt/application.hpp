@@ -1,6 +1,8 @@
 #ifndef APPLICATION_HPP_
 #define APPLICATION_HPP_
 
+#include <chrono>
+
 namespace nxt {
 	class Application {
 	public:
@@ -8,10 +10,36 @@ namespace nxt {
 		virtual ~Application();
 
 		virtual void Init() = 0;
+		// advances the simulation by dt seconds, the fixed step unless it is 0
 		virtual void ProcessInput(float dt) = 0;
-		virtual void Render() = 0;
+		// alpha in [0, 1] is how far the time not yet simulated reaches into
+		// the next step, for interpolating between the last two states
+		virtual void Render(float alpha) = 0;
 		virtual void SetCallbacks() = 0;
-		virtual void Run() = 0;
+		// until the window closes: as many fixed steps as the time since the
+		// last frame covers, at most the max step count, then one Render
+		virtual void Run();
+	protected:
+		// seconds per ProcessInput call, 0 for one call per frame with the
+		// frame's own length and alpha always 1, the latest state
+		void SetFixedStep(float step) { fixed_step_ = step; }
+		// the time beyond this many steps in one frame is dropped, so a slow
+		// frame does not make the next one slower still
+		void SetMaxSteps(int max_steps) { max_steps_ = max_steps; }
+		// frames per second Run holds itself to, 0 for none; for when vsync
+		// is off, see Context::SetVSync
+		void SetFrameLimit(float frame_limit) { frame_limit_ = frame_limit; }
+		float GetFixedStep() const { return fixed_step_; }
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		float fixed_step_;
+		int max_steps_;
+		float frame_limit_;
+
+		// sleeps most of the way to the end of the frame and spins the rest,
+		// as a sleep may overshoot by more than a millisecond
+		void WaitForFrameEnd(Clock::time_point frame_begin) const;
 	};
 
 	Application* CreateApplication();
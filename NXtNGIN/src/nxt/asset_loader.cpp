@@ -0,0 +1,418 @@
+#include "asset_loader.hpp"
+
+namespace bpt = boost::property_tree;
+
+namespace nxt {
+	namespace {
+		std::vector<std::string> GetStrings(const bpt::ptree& node, const std::string& key) {
+			std::vector<std::string> result;
+			if (boost::optional<const bpt::ptree&> list = node.get_child_optional(key)) {
+				for (const auto& item : *list) result.push_back(item.second.get_value<std::string>());
+			}
+			return result;
+		}
+	}
+
+	bool AssetLoader::ParseType(const std::string& name, AssetType& type) {
+		static const std::map<std::string, AssetType> types{
+			{ "shader", AssetType::SHADER },
+			{ "texture", AssetType::TEXTURE },
+			{ "cubemap", AssetType::CUBE_MAP },
+			{ "font", AssetType::FONT },
+			{ "mesh", AssetType::MESH },
+			{ "music", AssetType::MUSIC },
+			{ "sound", AssetType::SOUND } };
+		auto it = types.find(name);
+		if (it == types.end()) return false;
+		type = it->second;
+		return true;
+	}
+
+	double AssetLoader::GetElapsed() const {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+	}
+
+	bool AssetLoader::ReadManifest(const std::string& manifest_file) {
+		bpt::ptree root;
+		try {
+			if (const FileBufferPtr packed = FileSystem::Instance().GetBuffer(manifest_file)) {
+				boost::interprocess::ibufferstream stream(packed->GetData(), packed->GetSize());
+				bpt::read_json(stream, root);
+			}
+			else {
+				bpt::read_json(manifest_file, root);
+			}
+		}
+		catch (const bpt::json_parser_error& ex) {
+			std::cerr << "ERROR READING ASSET MANIFEST: " << ex.what() << std::endl;
+			return false;
+		}
+
+		const bf::path& root_dir = FileSystem::Instance().GetResourceRootDir();
+		auto resolve = [&root_dir](const std::string& file) { return (root_dir / file).generic_string(); };
+
+		for (const auto& item : root.get_child("assets", bpt::ptree{})) {
+			const bpt::ptree& node = item.second;
+			auto asset = std::unique_ptr<Asset>(new Asset{});
+			asset->name = node.get<std::string>("name", "");
+			if (asset->name.empty() || !ParseType(node.get<std::string>("type", ""), asset->type)) {
+				std::cerr << "ASSET MANIFEST: ENTRY '" << asset->name << "' HAS NO NAME OR AN UNKNOWN TYPE" << std::endl;
+				return false;
+			}
+			if (names_.count(asset->name)) {
+				std::cerr << "ASSET MANIFEST: '" << asset->name << "' IS LISTED TWICE" << std::endl;
+				return false;
+			}
+			asset->shader = node.get<std::string>("shader", "");
+			asset->mode = node.get<std::string>("mode", "");
+			asset->depends = GetStrings(node, "depends");
+			asset->gen_mipmaps = node.get<bool>("mipmaps", true);
+			asset->is_face_quad = node.get<bool>("quads", true);
+			asset->keep_geometry = node.get<bool>("keep_geometry", false);
+			asset->pixel_size = node.get<unsigned int>("pixel_size", 48);
+
+			if (asset->type == AssetType::SHADER) {
+				asset->files = { resolve(node.get<std::string>("vert", "")), resolve(node.get<std::string>("frag", "")) };
+			}
+			else if (asset->type == AssetType::CUBE_MAP) {
+				for (const std::string& face : GetStrings(node, "faces")) asset->files.push_back(resolve(face));
+			}
+			else {
+				asset->files = { resolve(node.get<std::string>("file", "")) };
+			}
+
+			names_[asset->name] = assets_.size();
+			assets_.push_back(std::move(asset));
+		}
+		return true;
+	}
+
+	bool AssetLoader::ResolveDependencies() {
+		for (const std::unique_ptr<Asset>& asset : assets_) {
+			std::vector<std::string> depends = asset->depends;
+			if (!asset->shader.empty()) {
+				if (names_.count(asset->shader)) depends.push_back(asset->shader);
+				else if (!ResourceManager::shaders.count(asset->shader)) {
+					std::cerr << "ASSET MANIFEST: SHADER '" << asset->shader << "' OF '" << asset->name << "' IS NOT LOADED" << std::endl;
+					return false;
+				}
+			}
+			else if (asset->type != AssetType::SHADER && asset->type != AssetType::MUSIC && asset->type != AssetType::SOUND) {
+				std::cerr << "ASSET MANIFEST: '" << asset->name << "' NEEDS A SHADER" << std::endl;
+				return false;
+			}
+			for (const std::string& name : depends) {
+				auto it = names_.find(name);
+				if (it == names_.end()) {
+					std::cerr << "ASSET MANIFEST: '" << asset->name << "' DEPENDS ON UNKNOWN '" << name << "'" << std::endl;
+					return false;
+				}
+				asset->dependencies.push_back(it->second);
+			}
+		}
+
+		std::vector<int> state(assets_.size());
+		for (size_t i{}; i < assets_.size(); ++i) {
+			if (HasCycle(i, state)) {
+				std::cerr << "ASSET MANIFEST: DEPENDENCY CYCLE THROUGH '" << assets_[i]->name << "'" << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool AssetLoader::HasCycle(size_t index, std::vector<int>& state) const {
+		// 0 unvisited, 1 on the current path, 2 done
+		if (state[index] == 2) return false;
+		if (state[index] == 1) return true;
+		state[index] = 1;
+		for (size_t dependency : assets_[index]->dependencies) {
+			if (HasCycle(dependency, state)) return true;
+		}
+		state[index] = 2;
+		return false;
+	}
+
+	bool AssetLoader::HasCpuStage(const Asset& asset) {
+		switch (asset.type) {
+		case AssetType::TEXTURE: return asset.mode.empty();
+		// FreeType renders the glyphs while their textures are created
+		case AssetType::FONT: return false;
+		default: return true;
+		}
+	}
+
+	std::vector<std::string> AssetLoader::GetReads(const Asset& asset) {
+		switch (asset.type) {
+		case AssetType::TEXTURE: {
+			if (!asset.mode.empty()) return {};
+			// the cooked sibling is all Decode reads when there is one
+			const std::string compressed = Texture2D::FindCompressed(asset.files[0]);
+			return { compressed.empty() ? asset.files[0] : compressed };
+		}
+		case AssetType::SHADER: {
+			std::vector<std::string> reads;
+			for (const std::string& file : asset.files) {
+				const std::string cooked = ShaderSource::FindCooked(file);
+				reads.push_back(cooked.empty() ? file : cooked);
+			}
+			return reads;
+		}
+		case AssetType::FONT: {
+			const std::string cooked = TextRenderer::FindCooked(asset.files[0], asset.pixel_size);
+			return { cooked.empty() ? asset.files[0] : cooked };
+		}
+		case AssetType::MESH: {
+			const std::string cooked = MeshRenderer::FindCooked(asset.files[0]);
+			return { cooked.empty() ? asset.files[0] : cooked };
+		}
+		case AssetType::SOUND: {
+			// SoundBufferCache::Load reads the cooked samples over the source
+			const std::string cooked = SoundBufferCache::FindCooked(asset.files[0]);
+			return { cooked.empty() ? asset.files[0] : cooked };
+		}
+		// streamed from disk while playing
+		case AssetType::MUSIC: return {};
+		default: return asset.files;
+		}
+	}
+
+	void AssetLoader::Decode(Asset& asset) {
+		bool decoded{ false };
+		try {
+			decoded = !HasCpuStage(asset) || RunCpuStage(asset);
+		}
+		catch (const std::exception& ex) {
+			std::cerr << "ERROR LOADING ASSET '" << asset.name << "': " << ex.what() << std::endl;
+		}
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			asset.timing.cpu_end = GetElapsed();
+			asset.decoded = decoded;
+			asset.cpu_done = true;
+			++cpu_finished_;
+		}
+		condition_.notify_one();
+	}
+
+	bool AssetLoader::RunCpuStage(Asset& asset) const {
+		switch (asset.type) {
+		case AssetType::SHADER:
+			asset.shader_source = ShaderSource::Read(asset.files[0], asset.files[1]);
+			return !asset.shader_source.vertex.empty() && !asset.shader_source.fragment.empty();
+		case AssetType::TEXTURE:
+			return Texture2D::Decode(asset.files[0], asset.gen_mipmaps, asset.texture);
+		case AssetType::CUBE_MAP:
+			return Texture2D::Decode(asset.files, asset.texture);
+		case AssetType::MESH:
+			return MeshRenderer::Parse(asset.files[0], asset.is_face_quad, asset.mesh);
+		case AssetType::MUSIC:
+			asset.audio = std::unique_ptr<Audio>(new Music());
+			return asset.audio->Open(asset.files[0]);
+		case AssetType::SOUND:
+			asset.audio = std::unique_ptr<Audio>(new Sound());
+			return asset.audio->Open(asset.files[0]);
+		default:
+			return true;
+		}
+	}
+
+	bool AssetLoader::RunGlStage(Asset& asset) const {
+		const std::shared_ptr<Shader> shader = asset.shader.empty() ? nullptr : ResourceManager::GetShader(asset.shader);
+		switch (asset.type) {
+		case AssetType::SHADER:
+			return ResourceManager::LoadShader(asset.files[0], asset.files[1], asset.shader_source, asset.name) != nullptr;
+		case AssetType::TEXTURE:
+			if (asset.mode == "async") {
+				return ResourceManager::LoadTextureAsync(shader, asset.files[0], asset.name, asset.gen_mipmaps) != nullptr;
+			}
+			if (asset.mode == "streamed") {
+				return ResourceManager::LoadTextureStreamed(shader, asset.files[0], asset.name) != nullptr;
+			}
+			return ResourceManager::LoadTexture(shader, asset.files[0], asset.texture, asset.name, asset.gen_mipmaps)->GetHandle() != 0;
+		case AssetType::CUBE_MAP:
+			return ResourceManager::LoadTexture(shader, asset.files, asset.texture, asset.name)->GetHandle() != 0;
+		case AssetType::FONT:
+			return ResourceManager::LoadTextRenderer(
+				shader,
+				Context::Instance().GetWidth(),
+				Context::Instance().GetHeight(),
+				asset.pixel_size,
+				asset.files[0],
+				asset.name)->IsLoaded();
+		case AssetType::MESH:
+			asset.mesh_renderer = std::unique_ptr<MeshRenderer>(new MeshRenderer(shader));
+			return asset.mesh_renderer->Load(asset.files[0], std::move(asset.mesh), asset.keep_geometry);
+		default:
+			return true;
+		}
+	}
+
+	bool AssetLoader::Load(const std::string& manifest_file) {
+		start_ = std::chrono::steady_clock::now();
+		assets_.clear();
+		names_.clear();
+		cpu_finished_ = 0;
+		failed_ = 0;
+		if (!ReadManifest(manifest_file) || !ResolveDependencies()) return false;
+		cpu_thread_count_ = ThreadPool::Instance().GetThreadCount();
+		bytes_read_ = 0;
+
+		// every file up front in one batch, the decodes start as reads complete
+		std::vector<std::string> files;
+		std::vector<Asset*> readers;
+		for (const std::unique_ptr<Asset>& asset : assets_) {
+			asset->reads = GetReads(*asset);
+			asset->reads_remaining = asset->reads.size();
+			asset->buffers.resize(asset->reads.size());
+			asset->timing.cpu_begin = GetElapsed();
+			if (asset->reads.empty()) {
+				asset->timing.read_end = asset->timing.cpu_begin;
+				if (!HasCpuStage(*asset)) {
+					asset->decoded = true;
+					asset->cpu_done = true;
+					continue;
+				}
+				Asset *pending = asset.get();
+				ThreadPool::Instance().Submit([this, pending]() { Decode(*pending); });
+				continue;
+			}
+			for (const std::string& file : asset->reads) {
+				files.push_back(file);
+				readers.push_back(asset.get());
+			}
+		}
+		std::vector<size_t> first_read(files.size());
+		for (size_t i{ 1 }; i < files.size(); ++i) {
+			first_read[i] = readers[i] == readers[i - 1] ? first_read[i - 1] : i;
+		}
+		FileSystem::Instance().ReadAsync(files, [this, files, readers, first_read](size_t index, FileBufferPtr buffer) {
+			Asset& asset = *readers[index];
+			// a failed read leaves the decoder to report the missing file
+			if (buffer) FileSystem::Instance().AddOverlay(files[index], buffer);
+			bool complete{ false };
+			{
+				std::lock_guard<std::mutex> lock{ mutex_ };
+				if (buffer) bytes_read_ += buffer->GetSize();
+				asset.buffers[index - first_read[index]] = std::move(buffer);
+				complete = --asset.reads_remaining == 0;
+				if (complete) asset.timing.read_end = GetElapsed();
+			}
+			if (complete) Decode(asset);
+		});
+
+		// GL objects are created here, in dependency order as the decodes finish
+		std::unique_lock<std::mutex> lock{ mutex_ };
+		size_t finished{};
+		while (finished < assets_.size()) {
+			const size_t seen = cpu_finished_;
+			bool progressed{ false };
+			for (const std::unique_ptr<Asset>& asset : assets_) {
+				if (asset->gl_done || !asset->cpu_done) continue;
+				bool ready{ true };
+				bool dependencies_loaded{ true };
+				for (size_t dependency : asset->dependencies) {
+					ready = ready && assets_[dependency]->gl_done;
+					dependencies_loaded = dependencies_loaded && assets_[dependency]->loaded;
+				}
+				if (!ready) continue;
+
+				lock.unlock();
+				asset->timing.gl_begin = GetElapsed();
+				// nothing is handed to GL from a failed decode or a missing dependency
+				const bool loaded = asset->decoded && dependencies_loaded && RunGlStage(*asset);
+				asset->timing.gl_end = GetElapsed();
+				// only the reads that succeeded were overlaid
+				for (size_t i{}; i < asset->reads.size(); ++i) {
+					if (asset->buffers[i]) FileSystem::Instance().RemoveOverlay(asset->reads[i]);
+				}
+				asset->buffers.clear();
+				if (!loaded) {
+					std::cerr << "ERROR LOADING ASSET '" << asset->name << "'";
+					if (!dependencies_loaded) std::cerr << ", A DEPENDENCY FAILED";
+					std::cerr << std::endl;
+					++failed_;
+				}
+				lock.lock();
+				asset->loaded = loaded;
+				asset->gl_done = true;
+				++finished;
+				progressed = true;
+			}
+			if (!progressed) condition_.wait(lock, [this, seen]() { return cpu_finished_ != seen; });
+		}
+		total_time_ = GetElapsed();
+		return failed_ == 0;
+	}
+
+	std::unique_ptr<MeshRenderer> AssetLoader::TakeMesh(const std::string& name) {
+		auto it = names_.find(name);
+		if (it == names_.end()) return nullptr;
+		return std::move(assets_[it->second]->mesh_renderer);
+	}
+
+	std::unique_ptr<Audio> AssetLoader::TakeAudio(const std::string& name) {
+		auto it = names_.find(name);
+		if (it == names_.end()) return nullptr;
+		return std::move(assets_[it->second]->audio);
+	}
+
+	std::vector<AssetLoader::Timing> AssetLoader::GetTimings() const {
+		std::vector<Timing> timings;
+		for (const std::unique_ptr<Asset>& asset : assets_) {
+			timings.push_back(asset->timing);
+			timings.back().name = asset->name;
+		}
+		return timings;
+	}
+
+	std::vector<AssetLoader::Timing> AssetLoader::GetCriticalPath() const {
+		std::vector<Timing> path;
+		if (assets_.empty()) return path;
+		size_t current{};
+		for (size_t i{ 1 }; i < assets_.size(); ++i) {
+			if (assets_[i]->timing.gl_end > assets_[current]->timing.gl_end) current = i;
+		}
+		for (;;) {
+			const Asset& asset = *assets_[current];
+			path.push_back(asset.timing);
+			path.back().name = asset.name;
+			// the dependency that finished last held this one up if it was
+			// still loading when the decode was done
+			const Asset *blocking = nullptr;
+			for (size_t dependency : asset.dependencies) {
+				const Asset& candidate = *assets_[dependency];
+				if (!blocking || candidate.timing.gl_end > blocking->timing.gl_end) blocking = &candidate;
+			}
+			if (!blocking || blocking->timing.gl_end <= asset.timing.cpu_end) break;
+			current = names_.at(blocking->name);
+		}
+		std::reverse(path.begin(), path.end());
+		return path;
+	}
+
+	void AssetLoader::Report(std::ostream& os) const {
+		double cpu_time{}, gl_time{};
+		for (const std::unique_ptr<Asset>& asset : assets_) {
+			cpu_time += asset->timing.cpu_end - asset->timing.read_end;
+			gl_time += asset->timing.gl_end - asset->timing.gl_begin;
+		}
+		const std::ios::fmtflags flags = os.flags();
+		const std::streamsize precision = os.precision(1);
+		os.setf(std::ios::fixed);
+		os << "ASSETS LOADED: " << assets_.size() << " IN " << total_time_ << " MS, "
+			<< bytes_read_ / 1024 << " KB READ THROUGH " << AsyncIO::Instance().GetBackendName() << ", "
+			<< cpu_time << " MS OF DECODE WORK ON " << cpu_thread_count_ << " THREADS, "
+			<< gl_time << " MS ON THE GL THREAD";
+		if (failed_) os << ", " << failed_ << " FAILED";
+		os << std::endl << "CRITICAL PATH:";
+		for (const Timing& timing : GetCriticalPath()) {
+			os << " " << timing.name << " [READ " << timing.read_end - timing.cpu_begin
+				<< " MS, DECODE " << timing.cpu_end - timing.read_end
+				<< " MS, GL " << timing.gl_end - timing.gl_begin << " MS, DONE AT " << timing.gl_end << " MS]";
+		}
+		os << std::endl;
+		os.flags(flags);
+		os.precision(precision);
+	}
+}
@@ -0,0 +1,145 @@
+#ifndef ASSET_LOADER_HPP_
+#define ASSET_LOADER_HPP_
+
+#include <map>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <condition_variable>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/interprocess/streams/bufferstream.hpp>
+
+#include "resource_manager.hpp"
+#include "mesh_renderer.hpp"
+#include "thread_pool.hpp"
+#include "filesystem.hpp"
+#include "async_io.hpp"
+#include "context.hpp"
+#include "music.hpp"
+#include "sound.hpp"
+#include "non_copyable.hpp"
+
+namespace nxt {
+	// Loads the assets listed in a JSON manifest, for example
+	//
+	//   { "assets": [
+	//     { "name": "model", "type": "shader",
+	//       "vert": "shader/mesh_vert_phong.glsl", "frag": "shader/mesh_frag_phong.glsl" },
+	//     { "name": "tv", "type": "texture", "file": "textures/tv.jpg", "shader": "model" },
+	//     { "name": "tv_mesh", "type": "mesh", "file": "models/tv.obj", "shader": "model",
+	//       "quads": false, "depends": [ "tv" ] } ] }
+	//
+	// with files relative to the FileSystem resource root. All files are read
+	// ahead in one FileSystem::ReadAsync batch, each asset is decoded on the
+	// ThreadPool as soon as its last file arrives; the GL objects are then
+	// created on the calling thread, each after the assets it depends on, its
+	// "shader" and those under "depends". A shader not in the manifest must
+	// already be in the ResourceManager.
+	//
+	// types: shader (vert, frag), texture (file, shader, mipmaps, mode of
+	// "async" or "streamed"), cubemap (faces, shader), font (file, shader,
+	// pixel_size), mesh (file, shader, quads, keep_geometry), music, sound (file).
+	// Shaders, textures and fonts end up in the ResourceManager under their
+	// name, meshes and audio are handed over by TakeMesh and TakeAudio.
+	class AssetLoader : public NonCopyable {
+	public:
+		struct Timing {
+			std::string name;
+			// milliseconds since Load was called
+			double cpu_begin;
+			double read_end;
+			double cpu_end;
+			double gl_begin;
+			double gl_end;
+		};
+
+		AssetLoader() = default;
+
+		// blocks until everything is loaded, false when the manifest is
+		// invalid or an asset failed
+		bool Load(const std::string& manifest_file);
+
+		std::unique_ptr<MeshRenderer> TakeMesh(const std::string& name);
+		std::unique_ptr<Audio> TakeAudio(const std::string& name);
+
+		double GetTotalTime() const { return total_time_; }
+		std::vector<Timing> GetTimings() const;
+		// the chain of assets that finished last, each one waiting on its own
+		// decode or on the one before
+		std::vector<Timing> GetCriticalPath() const;
+		void Report(std::ostream& os = std::cout) const;
+	private:
+		enum class AssetType {
+			SHADER,
+			TEXTURE,
+			CUBE_MAP,
+			FONT,
+			MESH,
+			MUSIC,
+			SOUND
+		};
+
+		struct Asset {
+			std::string name;
+			AssetType type;
+			std::vector<std::string> files;
+			std::string shader;
+			std::string mode;
+			std::vector<std::string> depends;
+			std::vector<size_t> dependencies;
+			bool gen_mipmaps;
+			bool is_face_quad;
+			bool keep_geometry;
+			unsigned int pixel_size;
+
+			// filled on the thread pool
+			ShaderSource shader_source;
+			TextureData texture;
+			MeshData mesh;
+			std::unique_ptr<Audio> audio;
+			// read ahead, served to the decoders through FileSystem overlays
+			std::vector<std::string> reads;
+			std::vector<FileBufferPtr> buffers;
+			size_t reads_remaining;
+			bool decoded;
+
+			std::unique_ptr<MeshRenderer> mesh_renderer;
+			bool cpu_done;
+			bool gl_done;
+			// dependents of an asset that did not load are not created
+			bool loaded;
+			Timing timing;
+		};
+
+		std::vector<std::unique_ptr<Asset>> assets_;
+		std::map<std::string, size_t> names_;
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		size_t cpu_finished_{};
+		size_t failed_{};
+		size_t cpu_thread_count_{};
+		std::uint64_t bytes_read_{};
+		double total_time_{};
+		std::chrono::steady_clock::time_point start_;
+
+		static bool ParseType(const std::string& name, AssetType& type);
+		bool ReadManifest(const std::string& manifest_file);
+		bool ResolveDependencies();
+		bool HasCycle(size_t index, std::vector<int>& state) const;
+		static bool HasCpuStage(const Asset& asset);
+		static std::vector<std::string> GetReads(const Asset& asset);
+		void Decode(Asset& asset);
+		bool RunCpuStage(Asset& asset) const;
+		bool RunGlStage(Asset& asset) const;
+		double GetElapsed() const;
+	};
+}
+
+#endif // ASSET_LOADER_HPP_
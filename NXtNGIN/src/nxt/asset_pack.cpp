@@ -0,0 +1,229 @@
+#include "asset_pack.hpp"
+#include "memory_tracker.hpp"
+
+namespace bi = boost::interprocess;
+
+namespace nxt {
+	namespace {
+		std::uint64_t Align(std::uint64_t offset, std::uint64_t alignment) {
+			return (offset + alignment - 1) & ~(alignment - 1);
+		}
+
+		void Pad(std::ofstream& ofs, std::uint64_t& offset, std::uint64_t alignment) {
+			static const char zeros[AssetPack::kAlignment]{};
+			const std::uint64_t aligned = Align(offset, alignment);
+			ofs.write(zeros, static_cast<std::streamsize>(aligned - offset));
+			offset = aligned;
+		}
+
+		bool ReadFile(const bf::path& path, std::vector<char>& data) {
+			std::ifstream ifs(path.string(), std::ios::in | std::ios::binary | std::ios::ate);
+			if (!ifs) return false;
+			data.resize(static_cast<size_t>(ifs.tellg()));
+			ifs.seekg(0);
+			return data.empty() || ifs.read(data.data(), static_cast<std::streamsize>(data.size()));
+		}
+	}
+
+	bool AssetPack::Open(const std::string& file) {
+		MemoryScope scope{ MemoryTag::FILESYSTEM };
+		Close();
+		try {
+			mapping_ = bi::file_mapping(file.c_str(), bi::read_only);
+			region_ = bi::mapped_region(mapping_, bi::read_only);
+		}
+		catch (const bi::interprocess_exception& ex) {
+			std::cerr << "ERROR MAPPING ASSET PACK '" << file << "': " << ex.what() << std::endl;
+			Close();
+			return false;
+		}
+
+		const char *base = static_cast<const char*>(region_.get_address());
+		const std::uint64_t size = region_.get_size();
+		Header header{};
+		if (size >= sizeof(Header)) std::memcpy(&header, base, sizeof(header));
+		const bool valid =
+			size >= sizeof(Header) && header.magic == kMagic && header.version == kVersion &&
+			header.toc_offset % alignof(Entry) == 0 &&
+			// offset and size come from the file, their sum could wrap
+			header.toc_offset <= size &&
+			static_cast<std::uint64_t>(header.entry_count) * sizeof(Entry) <= size - header.toc_offset &&
+			header.names_offset <= size &&
+			header.names_size <= size - header.names_offset;
+		if (!valid) {
+			std::cerr << "ERROR INVALID ASSET PACK '" << file << "'" << std::endl;
+			Close();
+			return false;
+		}
+
+		entries_ = reinterpret_cast<const Entry*>(base + header.toc_offset);
+		names_ = base + header.names_offset;
+		entry_count_ = header.entry_count;
+		for (size_t i{}; i < entry_count_; ++i) {
+			const Entry& entry = entries_[i];
+			if (static_cast<std::uint64_t>(entry.path_offset) + entry.path_length > header.names_size ||
+				entry.offset > size || entry.stored_size > size - entry.offset ||
+				// unpacked into a buffer of entry.size, bounded before it is allocated
+				((entry.flags & kCompressed) && (entry.size > entry.stored_size * lz4::kMaxRatio ||
+					entry.size > std::numeric_limits<size_t>::max()))) {
+				std::cerr << "ERROR INVALID ASSET PACK ENTRY " << i << " IN '" << file << "'" << std::endl;
+				Close();
+				return false;
+			}
+		}
+		file_ = file;
+		return true;
+	}
+
+	void AssetPack::Close() {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		unpacked_.clear();
+		region_ = bi::mapped_region();
+		mapping_ = bi::file_mapping();
+		entries_ = nullptr;
+		names_ = nullptr;
+		entry_count_ = 0;
+		file_.clear();
+	}
+
+	boost::string_view AssetPack::GetPath(const Entry& entry) const {
+		return boost::string_view(names_ + entry.path_offset, entry.path_length);
+	}
+
+	const char* AssetPack::GetData(const Entry& entry) const {
+		return static_cast<const char*>(region_.get_address()) + entry.offset;
+	}
+
+	const AssetPack::Entry* AssetPack::FindEntry(const std::string& path) const {
+		const boost::string_view key{ path };
+		const Entry *end = entries_ + entry_count_;
+		const Entry *it = std::lower_bound(entries_, end, key,
+			[this](const Entry& entry, boost::string_view value) { return GetPath(entry) < value; });
+		return it != end && GetPath(*it) == key ? it : nullptr;
+	}
+
+	bool AssetPack::Find(const std::string& path, boost::string_view& view) const {
+		MemoryScope scope{ MemoryTag::FILESYSTEM };
+		const Entry *entry = FindEntry(path);
+		if (!entry) return false;
+		if (!(entry->flags & kCompressed)) {
+			view = boost::string_view(GetData(*entry), static_cast<size_t>(entry->stored_size));
+			return true;
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		std::unique_ptr<char[]>& data = unpacked_[entry];
+		if (!data) {
+			std::unique_ptr<char[]> buffer{ new char[static_cast<size_t>(entry->size)] };
+			if (!lz4::Decompress(
+				reinterpret_cast<const unsigned char*>(GetData(*entry)), static_cast<size_t>(entry->stored_size),
+				reinterpret_cast<unsigned char*>(buffer.get()), static_cast<size_t>(entry->size))) {
+				std::cerr << "ERROR UNPACKING '" << path << "' FROM '" << file_ << "'" << std::endl;
+				unpacked_.erase(entry);
+				return false;
+			}
+			data = std::move(buffer);
+		}
+		view = boost::string_view(data.get(), static_cast<size_t>(entry->size));
+		return true;
+	}
+
+	std::vector<std::string> AssetPack::GetPaths() const {
+		std::vector<std::string> paths;
+		paths.reserve(entry_count_);
+		for (size_t i{}; i < entry_count_; ++i) {
+			paths.push_back(GetPath(entries_[i]).to_string());
+		}
+		return paths;
+	}
+
+	bool AssetPack::Build(const std::string& root_dir, const std::string& out_file, bool compress, std::ostream& log) {
+		boost::system::error_code error;
+		const bf::path root{ root_dir };
+		if (!bf::is_directory(root, error)) {
+			std::cerr << "NOT A DIRECTORY '" << root_dir << "'" << std::endl;
+			return false;
+		}
+
+		std::vector<std::pair<std::string, bf::path>> files;
+		for (const bf::directory_entry& item : bf::recursive_directory_iterator(root)) {
+			if (!bf::is_regular_file(item.path(), error)) continue;
+			if (bf::exists(out_file, error) && bf::equivalent(item.path(), out_file, error)) continue;
+			files.emplace_back(item.path().lexically_relative(root).generic_string(), item.path());
+		}
+		std::sort(files.begin(), files.end());
+
+		std::ofstream ofs(out_file, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!ofs) {
+			std::cerr << "ERROR WRITING ASSET PACK '" << out_file << "'" << std::endl;
+			return false;
+		}
+
+		Header header{};
+		header.magic = kMagic;
+		header.version = kVersion;
+		header.entry_count = static_cast<std::uint32_t>(files.size());
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		std::uint64_t offset{ sizeof(header) };
+
+		std::vector<Entry> entries;
+		std::string names;
+		std::vector<char> data;
+		std::vector<unsigned char> packed;
+		std::uint64_t total_size{};
+		for (const auto& file : files) {
+			if (!ReadFile(file.second, data)) {
+				std::cerr << "ERROR READING '" << file.second.string() << "'" << std::endl;
+				return false;
+			}
+			Entry entry{};
+			entry.path_offset = static_cast<std::uint32_t>(names.size());
+			entry.path_length = static_cast<std::uint32_t>(file.first.size());
+			entry.size = data.size();
+			names += file.first;
+
+			const char *stored = data.data();
+			entry.stored_size = data.size();
+			if (compress && !data.empty()) {
+				packed.resize(lz4::GetMaxCompressedSize(data.size()));
+				const size_t packed_size = lz4::Compress(
+					reinterpret_cast<const unsigned char*>(data.data()), data.size(), packed.data(), packed.size());
+				// already compressed formats like png and ogg barely shrink, keep those raw
+				if (packed_size != 0 && packed_size < data.size() - data.size() / 8) {
+					stored = reinterpret_cast<const char*>(packed.data());
+					entry.stored_size = packed_size;
+					entry.flags |= kCompressed;
+				}
+			}
+
+			Pad(ofs, offset, kAlignment);
+			entry.offset = offset;
+			ofs.write(stored, static_cast<std::streamsize>(entry.stored_size));
+			offset += entry.stored_size;
+			total_size += entry.size;
+			entries.push_back(entry);
+			log << file.first << " (" << entry.size / 1024 << " KB"
+				<< ((entry.flags & kCompressed) ? " -> " + std::to_string(entry.stored_size / 1024) + " KB LZ4" : "")
+				<< ")" << std::endl;
+		}
+
+		Pad(ofs, offset, alignof(Entry));
+		header.toc_offset = offset;
+		ofs.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+		offset += entries.size() * sizeof(Entry);
+		header.names_offset = offset;
+		header.names_size = names.size();
+		ofs.write(names.data(), static_cast<std::streamsize>(names.size()));
+		offset += names.size();
+
+		ofs.seekp(0);
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		ofs.close();
+		if (!ofs) {
+			std::cerr << "ERROR WRITING ASSET PACK '" << out_file << "'" << std::endl;
+			return false;
+		}
+		log << files.size() << " FILES, " << total_size / 1024 << " KB -> " << offset / 1024 << " KB" << std::endl;
+		return true;
+	}
+}
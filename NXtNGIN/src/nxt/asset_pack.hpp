@@ -0,0 +1,97 @@
+#ifndef ASSET_PACK_HPP_
+#define ASSET_PACK_HPP_
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <unordered_map>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+
+#include <boost/utility/string_view.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "lz4.hpp"
+#include "filesystem.hpp"
+#include "non_copyable.hpp"
+
+namespace nxt {
+	// Read only archive of resource files, mapped into memory as a whole.
+	// Layout: a header, the entries each starting on a kAlignment boundary,
+	// then the table of contents sorted by path and the path strings. Entries
+	// are stored raw or, when it pays off, as an LZ4 block.
+	//
+	// Paths are relative to the packed directory with forward slashes, e.g.
+	// "textures/tv.jpg". Raw entries are handed out as views into the mapping,
+	// compressed ones are unpacked on first access and kept until Close.
+	// Find is safe to call from several threads at once.
+	class AssetPack : public NonCopyable {
+	public:
+		static constexpr std::uint32_t kMagic{ 0x5054584E }; // "NXTP"
+		static constexpr std::uint32_t kVersion{ 1 };
+		static constexpr std::uint64_t kAlignment{ 64 };
+
+		AssetPack() = default;
+		~AssetPack() { Close(); }
+
+		bool Open(const std::string& file);
+		void Close();
+		bool IsOpen() const { return region_.get_address() != nullptr; }
+		const std::string& GetFile() const { return file_; }
+
+		// false when the pack has no such entry or it fails to unpack
+		bool Find(const std::string& path, boost::string_view& view) const;
+		bool Contains(const std::string& path) const { return FindEntry(path) != nullptr; }
+		size_t GetEntryCount() const { return entry_count_; }
+		std::vector<std::string> GetPaths() const;
+
+		// packs every file below root_dir except out_file itself
+		static bool Build(const std::string& root_dir, const std::string& out_file, bool compress, std::ostream& log = std::cout);
+	private:
+		enum EntryFlags : std::uint32_t {
+			kCompressed = 1
+		};
+
+		struct Header {
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t entry_count;
+			std::uint32_t reserved;
+			std::uint64_t toc_offset;
+			std::uint64_t names_offset;
+			std::uint64_t names_size;
+		};
+
+		struct Entry {
+			std::uint32_t path_offset;
+			std::uint32_t path_length;
+			std::uint64_t offset;
+			std::uint64_t stored_size;
+			std::uint64_t size;
+			std::uint32_t flags;
+			std::uint32_t reserved;
+		};
+
+		std::string file_;
+		boost::interprocess::file_mapping mapping_;
+		boost::interprocess::mapped_region region_;
+		const Entry *entries_{};
+		const char *names_{};
+		size_t entry_count_{};
+
+		mutable std::mutex mutex_;
+		mutable std::unordered_map<const Entry*, std::unique_ptr<char[]>> unpacked_;
+
+		const Entry* FindEntry(const std::string& path) const;
+		boost::string_view GetPath(const Entry& entry) const;
+		const char* GetData(const Entry& entry) const;
+	};
+}
+
+#endif // ASSET_PACK_HPP_
@@ -0,0 +1,303 @@
+#include "async_io.hpp"
+#include "memory_tracker.hpp"
+
+#if defined(NXT_IO_URING)
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#endif
+
+namespace nxt {
+	AsyncIO& AsyncIO::Instance() {
+		static std::unique_ptr<AsyncIO> instance{ std::unique_ptr<AsyncIO>(new AsyncIO()) };
+		return *instance;
+	}
+
+	AsyncIO::AsyncIO(bool use_io_uring) : backend_{ Backend::THREAD_POOL }, bytes_read_{}, request_count_{} {
+		// constructed first, so the pool outlives the callbacks queued on it
+		ThreadPool::Instance();
+#if defined(NXT_IO_URING)
+		if (use_io_uring && SetupRing()) {
+			backend_ = Backend::IO_URING;
+			completion_thread_ = std::thread(&AsyncIO::CompletionLoop, this);
+		}
+#else
+		(void)use_io_uring;
+#endif
+	}
+
+	AsyncIO::~AsyncIO() {
+#if defined(NXT_IO_URING)
+		if (backend_ != Backend::IO_URING) return;
+		{
+			// the completion thread drains what is in flight before it returns
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			stop_ = true;
+		}
+		work_.notify_one();
+		completion_thread_.join();
+		DestroyRing();
+#endif
+	}
+
+	const char* AsyncIO::GetBackendName() const {
+		return backend_ == Backend::IO_URING ? "IO_URING" : "THREAD POOL";
+	}
+
+	FileBufferPtr AsyncIO::ReadFile(const std::string& file) {
+		MemoryScope scope{ MemoryTag::FILESYSTEM };
+		std::ifstream ifs(file, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!ifs) return nullptr;
+		std::shared_ptr<FileBuffer> buffer = std::make_shared<FileBuffer>(static_cast<size_t>(ifs.tellg()));
+		ifs.seekg(0);
+		if (buffer->GetSize() != 0 && !ifs.read(buffer->GetData(), static_cast<std::streamsize>(buffer->GetSize()))) return nullptr;
+		return buffer;
+	}
+
+	void AsyncIO::Read(const std::vector<std::string>& files, Callback callback) {
+		const std::shared_ptr<Callback> shared_callback = std::make_shared<Callback>(std::move(callback));
+		if (backend_ == Backend::THREAD_POOL) {
+			for (size_t index{}; index < files.size(); ++index) {
+				const std::string file = files[index];
+				ThreadPool::Instance().Submit([this, file, index, shared_callback]() {
+					FileBufferPtr buffer = ReadFile(file);
+					if (buffer) {
+						bytes_read_ += buffer->GetSize();
+						++request_count_;
+					}
+					(*shared_callback)(index, std::move(buffer));
+				});
+			}
+			return;
+		}
+#if defined(NXT_IO_URING)
+		std::vector<Request*> requests;
+		for (size_t index{}; index < files.size(); ++index) {
+			Request *request = CreateRequest(files[index], index, shared_callback);
+			if (request) requests.push_back(request);
+		}
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		for (Request *request : requests) {
+			for (Chunk& chunk : request->chunks) pending_.push_back(&chunk);
+		}
+		SubmitPending();
+#endif
+	}
+
+#if defined(NXT_IO_URING)
+	AsyncIO::Request* AsyncIO::CreateRequest(const std::string& file, size_t index, const std::shared_ptr<Callback>& callback) {
+		MemoryScope scope{ MemoryTag::FILESYSTEM };
+		const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat info;
+		if (fd < 0 || fstat(fd, &info) != 0) {
+			if (fd >= 0) close(fd);
+			ThreadPool::Instance().Submit([callback, index]() { (*callback)(index, nullptr); });
+			return nullptr;
+		}
+		std::shared_ptr<FileBuffer> buffer = std::make_shared<FileBuffer>(static_cast<size_t>(info.st_size));
+		if (info.st_size == 0) {
+			close(fd);
+			ThreadPool::Instance().Submit([callback, index, buffer]() { (*callback)(index, buffer); });
+			return nullptr;
+		}
+
+		Request *request = new Request{};
+		request->fd = fd;
+		request->index = index;
+		request->buffer = std::move(buffer);
+		request->callback = callback;
+		const std::uint64_t size = static_cast<std::uint64_t>(info.st_size);
+		for (std::uint64_t offset{}; offset < size; offset += kChunkSize) {
+			Chunk chunk{};
+			chunk.request = request;
+			chunk.offset = offset;
+			chunk.vector.iov_base = request->buffer->GetData() + offset;
+			chunk.vector.iov_len = static_cast<size_t>(std::min<std::uint64_t>(kChunkSize, size - offset));
+			request->chunks.push_back(chunk);
+		}
+		request->remaining = request->chunks.size();
+		request->failed = false;
+		++request_count_;
+		return request;
+	}
+
+	bool AsyncIO::SetupRing() {
+		io_uring_params params{};
+		ring_.fd = static_cast<int>(syscall(__NR_io_uring_setup, kQueueDepth, &params));
+		if (ring_.fd < 0) return false;
+
+		ring_.sq_memory_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		ring_.cq_memory_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single_mmap) {
+			ring_.sq_memory_size = ring_.cq_memory_size = std::max(ring_.sq_memory_size, ring_.cq_memory_size);
+		}
+		ring_.sq_memory = mmap(nullptr, ring_.sq_memory_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_.fd, IORING_OFF_SQ_RING);
+		if (ring_.sq_memory == MAP_FAILED) ring_.sq_memory = nullptr;
+		ring_.cq_memory = single_mmap ? ring_.sq_memory :
+			mmap(nullptr, ring_.cq_memory_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_.fd, IORING_OFF_CQ_RING);
+		if (ring_.cq_memory == MAP_FAILED) ring_.cq_memory = nullptr;
+		ring_.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+		ring_.sqes = mmap(nullptr, ring_.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_.fd, IORING_OFF_SQES);
+		if (ring_.sqes == MAP_FAILED) ring_.sqes = nullptr;
+		if (!ring_.sq_memory || !ring_.cq_memory || !ring_.sqes) {
+			std::cerr << "ERROR MAPPING IO_URING, READING ON THE THREAD POOL" << std::endl;
+			DestroyRing();
+			return false;
+		}
+
+		char *sq = static_cast<char*>(ring_.sq_memory);
+		char *cq = static_cast<char*>(ring_.cq_memory);
+		ring_.sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+		ring_.sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+		ring_.sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+		ring_.sq_entries = params.sq_entries;
+		ring_.sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+		ring_.cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+		ring_.cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+		ring_.cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+		ring_.cqes = cq + params.cq_off.cqes;
+		return true;
+	}
+
+	void AsyncIO::DestroyRing() {
+		if (ring_.sqes) munmap(ring_.sqes, ring_.sqes_size);
+		if (ring_.cq_memory && ring_.cq_memory != ring_.sq_memory) munmap(ring_.cq_memory, ring_.cq_memory_size);
+		if (ring_.sq_memory) munmap(ring_.sq_memory, ring_.sq_memory_size);
+		if (ring_.fd >= 0) close(ring_.fd);
+		ring_ = Ring{};
+	}
+
+	void AsyncIO::SubmitPending() {
+		unsigned tail = *ring_.sq_tail;
+		const unsigned head = __atomic_load_n(ring_.sq_head, __ATOMIC_ACQUIRE);
+		unsigned count{};
+		// at most one ring of reads in flight keeps the completion queue from overflowing
+		while (!pending_.empty() && in_flight_ < ring_.sq_entries && tail - head < ring_.sq_entries) {
+			Chunk *chunk = pending_.front();
+			pending_.pop_front();
+			const unsigned index = tail & ring_.sq_mask;
+			io_uring_sqe *sqe = static_cast<io_uring_sqe*>(ring_.sqes) + index;
+			std::memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = IORING_OP_READV;
+			sqe->fd = chunk->request->fd;
+			sqe->addr = reinterpret_cast<std::uint64_t>(&chunk->vector);
+			sqe->len = 1;
+			sqe->off = chunk->offset;
+			sqe->user_data = reinterpret_cast<std::uint64_t>(chunk);
+			ring_.sq_array[index] = index;
+			++tail;
+			++count;
+			++in_flight_;
+		}
+		if (count == 0) return;
+		__atomic_store_n(ring_.sq_tail, tail, __ATOMIC_RELEASE);
+		work_.notify_one();
+
+		while (count > 0) {
+			const long submitted = syscall(__NR_io_uring_enter, ring_.fd, count, 0, 0, nullptr, 0);
+			if (submitted >= 0) {
+				count -= static_cast<unsigned>(submitted);
+				continue;
+			}
+			if (errno == EINTR) continue;
+			if (errno == EAGAIN) {
+				std::this_thread::yield();
+				continue;
+			}
+			std::cerr << "ERROR SUBMITTING TO IO_URING: " << std::strerror(errno) << std::endl;
+			// the kernel consumes entries in order, so the last count are still
+			// ours to take back; with the ring refusing work the waiting chunks
+			// fail as well
+			const unsigned submitted_tail = tail - count;
+			for (unsigned i{ submitted_tail }; i != tail; ++i) {
+				const io_uring_sqe& sqe = static_cast<const io_uring_sqe*>(ring_.sqes)[i & ring_.sq_mask];
+				--in_flight_;
+				Fail(reinterpret_cast<Chunk*>(sqe.user_data));
+			}
+			__atomic_store_n(ring_.sq_tail, submitted_tail, __ATOMIC_RELEASE);
+			while (!pending_.empty()) {
+				Fail(pending_.front());
+				pending_.pop_front();
+			}
+			return;
+		}
+	}
+
+	void AsyncIO::Fail(Chunk *chunk) {
+		Request& request = *chunk->request;
+		request.failed = true;
+		if (--request.remaining == 0) Finish(&request);
+	}
+
+	void AsyncIO::CompletionLoop() {
+		std::vector<Request*> finished;
+		std::chrono::milliseconds backoff{};
+		for (;;) {
+			{
+				// nothing in flight, nothing the kernel could wake this thread for
+				std::unique_lock<std::mutex> lock{ mutex_ };
+				work_.wait(lock, [this]() { return stop_ || in_flight_ > 0; });
+				if (in_flight_ == 0) return;
+			}
+
+			const long result = syscall(__NR_io_uring_enter, ring_.fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if (result < 0 && errno != EINTR) {
+				// the completion queue is still read below, a failing wait only
+				// turns into polling it
+				if (backoff.count() == 0) std::cerr << "ERROR WAITING ON IO_URING: " << std::strerror(errno) << std::endl;
+				backoff = std::min(std::max(backoff * 2, std::chrono::milliseconds{ 1 }), std::chrono::milliseconds{ 100 });
+				std::this_thread::sleep_for(backoff);
+			}
+			else if (result >= 0) {
+				backoff = std::chrono::milliseconds{};
+			}
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex_ };
+				unsigned head = *ring_.cq_head;
+				const unsigned tail = __atomic_load_n(ring_.cq_tail, __ATOMIC_ACQUIRE);
+				for (; head != tail; ++head) {
+					const io_uring_cqe& cqe = static_cast<const io_uring_cqe*>(ring_.cqes)[head & ring_.cq_mask];
+					--in_flight_;
+					Chunk *chunk = reinterpret_cast<Chunk*>(cqe.user_data);
+					Request& request = *chunk->request;
+					if (cqe.res == -EAGAIN || cqe.res == -EINTR) {
+						pending_.push_front(chunk);
+						continue;
+					}
+					if (cqe.res > 0 && static_cast<size_t>(cqe.res) < chunk->vector.iov_len) {
+						// short read, ask for the rest
+						bytes_read_ += static_cast<std::uint64_t>(cqe.res);
+						chunk->offset += static_cast<std::uint64_t>(cqe.res);
+						chunk->vector.iov_base = static_cast<char*>(chunk->vector.iov_base) + cqe.res;
+						chunk->vector.iov_len -= static_cast<size_t>(cqe.res);
+						pending_.push_front(chunk);
+						continue;
+					}
+					if (cqe.res > 0) bytes_read_ += static_cast<std::uint64_t>(cqe.res);
+					else request.failed = true;
+					if (--request.remaining == 0) finished.push_back(&request);
+				}
+				__atomic_store_n(ring_.cq_head, head, __ATOMIC_RELEASE);
+				SubmitPending();
+			}
+
+			for (Request *request : finished) Finish(request);
+			finished.clear();
+		}
+	}
+
+	void AsyncIO::Finish(Request *request) {
+		close(request->fd);
+		const std::shared_ptr<Callback> callback = request->callback;
+		const size_t index = request->index;
+		const FileBufferPtr buffer = request->failed ? nullptr : std::move(request->buffer);
+		delete request;
+		ThreadPool::Instance().Submit([callback, index, buffer]() { (*callback)(index, buffer); });
+	}
+#endif
+}
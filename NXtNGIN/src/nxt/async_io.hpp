@@ -0,0 +1,142 @@
+#ifndef ASYNC_IO_HPP_
+#define ASYNC_IO_HPP_
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define NXT_IO_URING
+#endif
+#endif
+
+#if defined(NXT_IO_URING)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "filesystem.hpp"
+#include "thread_pool.hpp"
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// Whole file reads off the calling thread. On Linux the reads go through
+	// io_uring: files are split into kChunkSize requests into page aligned
+	// buffers, a batch is handed to the kernel with one system call and a
+	// completion thread collects the results. Elsewhere, or when the kernel
+	// refuses a ring, every file is read by a ThreadPool worker instead.
+	//
+	// Callbacks always run on a ThreadPool worker, so the decode can follow
+	// in place. Use FileSystem::ReadAsync, which also serves packed files.
+	class AsyncIO : public NonCopyable, public NonMoveable {
+	public:
+		enum class Backend {
+			IO_URING,
+			THREAD_POOL
+		};
+
+		using Callback = std::function<void(size_t index, FileBufferPtr buffer)>;
+
+		static constexpr std::uint32_t kChunkSize{ 1u << 20 };
+		static constexpr unsigned kQueueDepth{ 128 };
+
+		static AsyncIO& Instance();
+
+		explicit AsyncIO(bool use_io_uring = true);
+		~AsyncIO();
+
+		// callback gets the index into files and null for a file that cannot be read
+		void Read(const std::vector<std::string>& files, Callback callback);
+
+		Backend GetBackend() const { return backend_; }
+		const char* GetBackendName() const;
+		std::uint64_t GetBytesRead() const { return bytes_read_; }
+		std::uint64_t GetRequestCount() const { return request_count_; }
+	private:
+		Backend backend_;
+		std::atomic<std::uint64_t> bytes_read_;
+		std::atomic<std::uint64_t> request_count_;
+
+		static FileBufferPtr ReadFile(const std::string& file);
+
+#if defined(NXT_IO_URING)
+		struct Request;
+		struct Chunk {
+			Request *request;
+			std::uint64_t offset;
+			struct iovec vector;
+		};
+
+		struct Request {
+			int fd;
+			size_t index;
+			std::shared_ptr<FileBuffer> buffer;
+			std::shared_ptr<Callback> callback;
+			std::vector<Chunk> chunks;
+			// guarded by mutex_
+			size_t remaining;
+			bool failed;
+		};
+
+		// the shared ring memory, see io_uring_setup(2)
+		struct Ring {
+			int fd{ -1 };
+			void *sq_memory{};
+			size_t sq_memory_size{};
+			void *cq_memory{};
+			size_t cq_memory_size{};
+			void *sqes{};
+			size_t sqes_size{};
+			unsigned *sq_head{};
+			unsigned *sq_tail{};
+			unsigned sq_mask{};
+			unsigned sq_entries{};
+			unsigned *sq_array{};
+			unsigned *cq_head{};
+			unsigned *cq_tail{};
+			unsigned cq_mask{};
+			void *cqes{};
+		};
+
+		Ring ring_;
+		std::mutex mutex_;
+		// the completion thread waits here while nothing is in flight
+		std::condition_variable work_;
+		// waiting for a free submission slot
+		std::deque<Chunk*> pending_;
+		unsigned in_flight_{};
+		bool stop_{};
+		std::thread completion_thread_;
+
+		Request* CreateRequest(const std::string& file, size_t index, const std::shared_ptr<Callback>& callback);
+		bool SetupRing();
+		void DestroyRing();
+		// mutex_ held
+		void SubmitPending();
+		void Fail(Chunk *chunk);
+		void CompletionLoop();
+		void Finish(Request *request);
+#endif
+	};
+}
+
+#endif // ASYNC_IO_HPP_
@@ -4,6 +4,9 @@
 #include <memory>
 #include <SFML/Audio.hpp>
 
+#include "filesystem.hpp"
+#include "memory_tracker.hpp"
+
 namespace nxt {
 	class Audio {
 	public:
@@ -0,0 +1,315 @@
+#include "audio_scene.hpp"
+
+namespace nxt {
+	AudioScene& AudioScene::Instance() {
+		static std::unique_ptr<AudioScene> instance{ std::unique_ptr<AudioScene>(new AudioScene()) };
+		return *instance;
+	}
+
+	AudioScene::AudioScene() :
+		listener_position_{ 0.0f },
+		previous_listener_position_{ 0.0f },
+		listener_velocity_{ 0.0f },
+		listener_placed_{ false },
+		voice_budget_{ kVoiceCount },
+		doppler_factor_{ 1.0f },
+		emitter_count_{ 0 },
+		real_count_{ 0 },
+		virtual_count_{ 0 } {}
+
+	void AudioScene::SetListener(const glm::fvec3& position, const glm::fvec3& front, const glm::fvec3& up) {
+		listener_position_ = position;
+		if (!listener_placed_) {
+			previous_listener_position_ = position;
+			listener_placed_ = true;
+		}
+		sf::Listener::setPosition(position.x, position.y, position.z);
+		sf::Listener::setDirection(front.x, front.y, front.z);
+		sf::Listener::setUpVector(up.x, up.y, up.z);
+	}
+
+	void AudioScene::SetListener(const Camera& camera) {
+		// the rows of the view rotation are the camera's axes
+		const glm::fmat4 view = camera.GetViewMatrix();
+		SetListener(
+			camera.GetPosition(),
+			-glm::fvec3{ view[0][2], view[1][2], view[2][2] },
+			glm::fvec3{ view[0][1], view[1][1], view[2][1] });
+	}
+
+	EmitterHandle AudioScene::AddEmitter(
+		const std::shared_ptr<const sf::SoundBuffer>& buffer,
+		const glm::fvec3& position,
+		bool loop,
+		int priority) {
+		if (!buffer) return EmitterHandle{};
+		std::uint32_t index;
+		if (!free_.empty()) {
+			index = free_.back();
+			free_.pop_back();
+		}
+		else {
+			index = static_cast<std::uint32_t>(slots_.size());
+			slots_.push_back(Slot{ SoundEmitter{}, 1, false, false });
+		}
+		Slot& slot = slots_[index];
+		slot.emitter = SoundEmitter{
+			buffer,
+			position,
+			position,
+			glm::fvec3{ 0.0f },
+			100.0f,
+			1.0f,
+			1.0f,
+			100.0f,
+			1.0f,
+			priority,
+			loop,
+			false,
+			false,
+			0.0f,
+			0.0f,
+			kNoVoice,
+			false };
+		slot.used = true;
+		slot.selected = false;
+		++emitter_count_;
+		return EmitterHandle{ index, slot.generation };
+	}
+
+	bool AudioScene::PlayOneShot(
+		const std::shared_ptr<const sf::SoundBuffer>& buffer,
+		const glm::fvec3& position,
+		float volume,
+		float pitch,
+		int priority) {
+		SoundEmitter probe{};
+		probe.position = position;
+		probe.volume = volume;
+		probe.min_distance = 1.0f;
+		probe.max_distance = 100.0f;
+		probe.attenuation = 1.0f;
+		// too far to hear at all, not worth an emitter
+		if (!buffer || GetGain(probe) < kAudibleGain) return false;
+
+		const EmitterHandle handle = AddEmitter(buffer, position, false, priority);
+		SoundEmitter& emitter = Get(handle);
+		emitter.volume = volume;
+		emitter.pitch = pitch;
+		emitter.one_shot = true;
+		emitter.playing = true;
+		return true;
+	}
+
+	void AudioScene::RemoveEmitter(EmitterHandle handle) {
+		if (!IsValid(handle)) return;
+		const std::uint32_t index = handle.GetIndex();
+		Slot& slot = slots_[index];
+		if (slot.emitter.voice != kNoVoice) Virtualize(slot.emitter);
+		slot.emitter.buffer.reset();
+		slot.used = false;
+		// generation 0 is kept for null handles
+		slot.generation = (slot.generation + 1) & EmitterHandle::kGenerationMask;
+		if (slot.generation == 0) slot.generation = 1;
+		free_.push_back(index);
+		--emitter_count_;
+	}
+
+	bool AudioScene::IsValid(EmitterHandle handle) const {
+		return handle.GetIndex() < slots_.size() &&
+			slots_[handle.GetIndex()].used &&
+			slots_[handle.GetIndex()].generation == handle.GetGeneration();
+	}
+
+	SoundEmitter& AudioScene::Get(EmitterHandle handle) {
+		assert(IsValid(handle) && "stale or null emitter handle");
+		return slots_[handle.GetIndex()].emitter;
+	}
+
+	const SoundEmitter& AudioScene::GetEmitter(EmitterHandle handle) const {
+		assert(IsValid(handle) && "stale or null emitter handle");
+		return slots_[handle.GetIndex()].emitter;
+	}
+
+	void AudioScene::Play(EmitterHandle handle) {
+		if (!IsValid(handle)) return;
+		Get(handle).playing = true;
+	}
+
+	void AudioScene::Stop(EmitterHandle handle) {
+		if (!IsValid(handle)) return;
+		SoundEmitter& emitter = Get(handle);
+		if (emitter.voice != kNoVoice) Virtualize(emitter);
+		emitter.playing = false;
+		emitter.cursor = 0.0f;
+	}
+
+	void AudioScene::SetPosition(EmitterHandle handle, const glm::fvec3& position) {
+		if (!IsValid(handle)) return;
+		SoundEmitter& emitter = Get(handle);
+		emitter.position = position;
+		if (!emitter.updated) emitter.previous_position = position;
+	}
+
+	void AudioScene::SetVolume(EmitterHandle handle, float volume) {
+		if (IsValid(handle)) Get(handle).volume = std::min(std::max(volume, 0.0f), 100.0f);
+	}
+
+	void AudioScene::SetPitch(EmitterHandle handle, float pitch) {
+		if (IsValid(handle)) Get(handle).pitch = pitch;
+	}
+
+	void AudioScene::SetRange(EmitterHandle handle, float min_distance, float max_distance, float attenuation) {
+		if (!IsValid(handle)) return;
+		SoundEmitter& emitter = Get(handle);
+		emitter.min_distance = std::max(min_distance, 0.001f);
+		emitter.max_distance = std::max(max_distance, emitter.min_distance);
+		emitter.attenuation = std::max(attenuation, 0.0f);
+	}
+
+	float AudioScene::GetGain(const SoundEmitter& emitter) const {
+		// OpenAL's clamped inverse distance model, which is what SFML sets up
+		const float distance = glm::length(emitter.position - listener_position_);
+		if (distance > emitter.max_distance) return 0.0f;
+		const float clamped = std::max(distance, emitter.min_distance);
+		const float falloff = emitter.min_distance /
+			(emitter.min_distance + emitter.attenuation * (clamped - emitter.min_distance));
+		return emitter.volume / 100.0f * falloff;
+	}
+
+	float AudioScene::GetDopplerShift(const SoundEmitter& emitter) const {
+		if (doppler_factor_ <= 0.0f) return 1.0f;
+		const glm::fvec3 to_listener = listener_position_ - emitter.position;
+		const float distance = glm::length(to_listener);
+		if (distance <= 0.0f) return 1.0f;
+		const glm::fvec3 direction = to_listener / distance;
+		// speeds towards the listener, capped like OpenAL at the speed of sound
+		const float limit = kSpeedOfSound / doppler_factor_;
+		const float listener_speed = std::min(glm::dot(listener_velocity_, direction), limit);
+		const float source_speed = std::min(glm::dot(emitter.velocity, direction), limit);
+		return (kSpeedOfSound - doppler_factor_ * listener_speed) /
+			std::max(kSpeedOfSound - doppler_factor_ * source_speed, 1.0f);
+	}
+
+	void AudioScene::Finish(std::uint32_t index) {
+		SoundEmitter& emitter = slots_[index].emitter;
+		if (emitter.one_shot) {
+			RemoveEmitter(EmitterHandle{ index, slots_[index].generation });
+			return;
+		}
+		if (emitter.voice != kNoVoice) Virtualize(emitter);
+		emitter.playing = false;
+		emitter.cursor = 0.0f;
+	}
+
+	void AudioScene::Virtualize(SoundEmitter& emitter) {
+		Voice& voice = voices_[emitter.voice];
+		if (voice.sound.getStatus() != sf::Sound::Stopped) {
+			emitter.cursor = voice.sound.getPlayingOffset().asSeconds();
+		}
+		voice.sound.stop();
+		voice.emitter = kNoVoice;
+		emitter.voice = kNoVoice;
+	}
+
+	void AudioScene::Realize(SoundEmitter& emitter, std::uint32_t index) {
+		// Update released every voice it does not keep, so one is free
+		auto free_voice = std::find_if(voices_.begin(), voices_.end(), [](const Voice& voice) { return voice.emitter == kNoVoice; });
+		assert(free_voice != voices_.end());
+		Voice& voice = *free_voice;
+		if (voice.buffer != emitter.buffer) {
+			// bound first, the previous buffer may go away with the reference
+			voice.sound.setBuffer(*emitter.buffer);
+			voice.buffer = emitter.buffer;
+		}
+		voice.emitter = index;
+		emitter.voice = static_cast<size_t>(free_voice - voices_.begin());
+
+		voice.sound.setLoop(emitter.loop);
+		voice.sound.setRelativeToListener(false);
+		voice.sound.setMinDistance(emitter.min_distance);
+		voice.sound.setAttenuation(emitter.attenuation);
+		UpdateVoice(emitter);
+		voice.sound.play();
+		voice.sound.setPlayingOffset(sf::seconds(emitter.cursor));
+	}
+
+	void AudioScene::UpdateVoice(const SoundEmitter& emitter) {
+		sf::Sound& sound = voices_[emitter.voice].sound;
+		sound.setPosition(emitter.position.x, emitter.position.y, emitter.position.z);
+		sound.setVolume(emitter.volume);
+		sound.setPitch(emitter.pitch * GetDopplerShift(emitter));
+	}
+
+	void AudioScene::Update(float dt) {
+		const float inverse_dt = dt > 0.0f ? 1.0f / dt : 0.0f;
+		listener_velocity_ = (listener_position_ - previous_listener_position_) * inverse_dt;
+		previous_listener_position_ = listener_position_;
+
+		candidates_.clear();
+		for (std::uint32_t index{}; index < slots_.size(); ++index) {
+			Slot& slot = slots_[index];
+			if (!slot.used) continue;
+			SoundEmitter& emitter = slot.emitter;
+			slot.selected = false;
+			emitter.velocity = (emitter.position - emitter.previous_position) * inverse_dt;
+			emitter.previous_position = emitter.position;
+			emitter.updated = true;
+			if (!emitter.playing) continue;
+
+			const float duration = emitter.buffer->getDuration().asSeconds();
+			if (emitter.voice != kNoVoice) {
+				const sf::Sound& sound = voices_[emitter.voice].sound;
+				if (sound.getStatus() == sf::Sound::Stopped) {
+					Finish(index);
+					continue;
+				}
+				emitter.cursor = sound.getPlayingOffset().asSeconds();
+			}
+			else {
+				// what a voice would have played meanwhile, doppler aside
+				emitter.cursor += dt * emitter.pitch;
+				if (emitter.cursor >= duration) {
+					if (!emitter.loop || duration <= 0.0f) {
+						Finish(index);
+						continue;
+					}
+					emitter.cursor = std::fmod(emitter.cursor, duration);
+				}
+			}
+
+			emitter.gain = GetGain(emitter);
+			if (emitter.gain >= kAudibleGain) candidates_.push_back(index);
+		}
+
+		// the most important first, then the loudest
+		const size_t real_count = std::min(candidates_.size(), voice_budget_);
+		std::partial_sort(
+			candidates_.begin(),
+			candidates_.begin() + real_count,
+			candidates_.end(),
+			[this](std::uint32_t a, std::uint32_t b) {
+			const SoundEmitter& lhs = slots_[a].emitter;
+			const SoundEmitter& rhs = slots_[b].emitter;
+			if (lhs.priority != rhs.priority) return lhs.priority > rhs.priority;
+			return lhs.gain > rhs.gain;
+		});
+		for (size_t i{}; i < real_count; ++i) slots_[candidates_[i]].selected = true;
+
+		// voices are freed before any is handed out
+		size_t playing_count{};
+		for (Slot& slot : slots_) {
+			if (!slot.used || !slot.emitter.playing) continue;
+			++playing_count;
+			if (slot.emitter.voice != kNoVoice && !slot.selected) Virtualize(slot.emitter);
+		}
+		for (size_t i{}; i < real_count; ++i) {
+			SoundEmitter& emitter = slots_[candidates_[i]].emitter;
+			if (emitter.voice == kNoVoice) Realize(emitter, candidates_[i]);
+			else UpdateVoice(emitter);
+		}
+
+		real_count_ = real_count;
+		virtual_count_ = playing_count - real_count;
+	}
+}
@@ -0,0 +1,164 @@
+#ifndef AUDIO_SCENE_HPP_
+#define AUDIO_SCENE_HPP_
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <SFML/Audio.hpp>
+
+#include "camera.hpp"
+#include "resource_registry.hpp"
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// a sound placed in the scene, see AudioScene
+	struct SoundEmitter {
+		std::shared_ptr<const sf::SoundBuffer> buffer;
+		glm::fvec3 position;
+		glm::fvec3 previous_position;
+		glm::fvec3 velocity;
+		float volume;
+		float pitch;
+		// full volume up to min_distance, falling off by attenuation after
+		// it and silent past max_distance
+		float min_distance;
+		float max_distance;
+		float attenuation;
+		int priority;
+		bool loop;
+		bool playing;
+		// removed once it stops
+		bool one_shot;
+		// seconds into the buffer, advanced by Update while virtual
+		float cursor;
+		// of the last Update, volume and distance attenuation together
+		float gain;
+		size_t voice;
+		// until an Update has seen it, SetPosition places it without moving
+		bool updated;
+	};
+
+	using EmitterHandle = Handle<SoundEmitter>;
+
+	// Positional sounds heard from a listener, normally the camera.
+	//
+	// Emitters are cheap; only the ones worth hearing are mixed. Each Update
+	// ranks the playing emitters by priority and then by gain, and gives a
+	// voice to the first GetVoiceBudget of those above kAudibleGain. The
+	// rest are virtual: they hold no voice and cost nothing to the mixer,
+	// but their cursor keeps moving, so one that becomes audible again
+	// resumes where it would have been.
+	//
+	// Attenuation and panning are SFML's and need mono buffers. SFML does
+	// not expose source velocities, so the doppler shift is applied to the
+	// pitch here with the formula OpenAL would use. Main thread only.
+	class AudioScene : public NonCopyable, public NonMoveable {
+	public:
+		static constexpr size_t kVoiceCount{ 32 };
+		// gain below which an emitter is not worth a voice
+		static constexpr float kAudibleGain{ 0.01f };
+		// units per second, with one unit taken as a metre
+		static constexpr float kSpeedOfSound{ 343.3f };
+
+		static AudioScene& Instance();
+
+		void SetListener(const glm::fvec3& position, const glm::fvec3& front, const glm::fvec3& up);
+		void SetListener(const Camera& camera);
+		const glm::fvec3& GetListenerPosition() const { return listener_position_; }
+
+		// stopped until Play
+		EmitterHandle AddEmitter(
+			const std::shared_ptr<const sf::SoundBuffer>& buffer,
+			const glm::fvec3& position,
+			bool loop = true,
+			int priority = 0);
+		// a single play at position, removed once it ends; false when it
+		// could not be heard from where the listener is
+		bool PlayOneShot(
+			const std::shared_ptr<const sf::SoundBuffer>& buffer,
+			const glm::fvec3& position,
+			float volume = 100.0f,
+			float pitch = 1.0f,
+			int priority = 0);
+		void RemoveEmitter(EmitterHandle handle);
+		bool IsValid(EmitterHandle handle) const;
+
+		void Play(EmitterHandle handle);
+		// rewinds as well
+		void Stop(EmitterHandle handle);
+		void SetPosition(EmitterHandle handle, const glm::fvec3& position);
+		void SetVolume(EmitterHandle handle, float volume);
+		void SetPitch(EmitterHandle handle, float pitch);
+		void SetRange(EmitterHandle handle, float min_distance, float max_distance, float attenuation = 1.0f);
+		const SoundEmitter& GetEmitter(EmitterHandle handle) const;
+
+		// voices mixed at once, at most kVoiceCount
+		void SetVoiceBudget(size_t budget) { voice_budget_ = std::min(budget, size_t{ kVoiceCount }); }
+		size_t GetVoiceBudget() const { return voice_budget_; }
+		// 0 turns the doppler shift off
+		void SetDopplerFactor(float factor) { doppler_factor_ = std::max(factor, 0.0f); }
+
+		// dt is the time since the last Update, emitter and listener
+		// velocities are taken from how far they moved in it. Set positions
+		// on every step that calls Update, one set less often reads as
+		// standing still in between
+		void Update(float dt);
+
+		size_t GetEmitterCount() const { return emitter_count_; }
+		// playing emitters with and without a voice after the last Update
+		size_t GetRealCount() const { return real_count_; }
+		size_t GetVirtualCount() const { return virtual_count_; }
+	private:
+		static constexpr size_t kNoVoice{ std::numeric_limits<size_t>::max() };
+
+		struct Slot {
+			SoundEmitter emitter;
+			std::uint32_t generation;
+			bool used;
+			// picked for a voice by the running Update
+			bool selected;
+		};
+
+		struct Voice {
+			// before the sound, which is destroyed first
+			std::shared_ptr<const sf::SoundBuffer> buffer;
+			sf::Sound sound;
+			size_t emitter{ kNoVoice };
+		};
+
+		std::vector<Slot> slots_;
+		std::vector<std::uint32_t> free_;
+		// reused by every Update
+		std::vector<std::uint32_t> candidates_;
+		std::array<Voice, kVoiceCount> voices_;
+		glm::fvec3 listener_position_;
+		glm::fvec3 previous_listener_position_;
+		glm::fvec3 listener_velocity_;
+		// the first SetListener places the listener without moving it
+		bool listener_placed_;
+		size_t voice_budget_;
+		float doppler_factor_;
+		size_t emitter_count_;
+		size_t real_count_;
+		size_t virtual_count_;
+
+		AudioScene();
+		SoundEmitter& Get(EmitterHandle handle);
+		float GetGain(const SoundEmitter& emitter) const;
+		float GetDopplerShift(const SoundEmitter& emitter) const;
+		void Finish(std::uint32_t index);
+		void Virtualize(SoundEmitter& emitter);
+		void Realize(SoundEmitter& emitter, std::uint32_t index);
+		void UpdateVoice(const SoundEmitter& emitter);
+	};
+}
+
+#endif // AUDIO_SCENE_HPP_
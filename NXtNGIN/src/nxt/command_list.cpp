@@ -0,0 +1,52 @@
+#include "command_list.hpp"
+
+namespace nxt {
+	unsigned char* CommandList::Allocate(size_t command_size) {
+		const size_t size = GetStride(sizeof(Header)) + command_size;
+		while (current_ < blocks_.size() && blocks_[current_].capacity - blocks_[current_].used < size) {
+			// blocks after current_ are empty, a large command may skip some
+			++current_;
+		}
+		if (current_ == blocks_.size()) {
+			const size_t capacity = std::max(size, size_t{ kBlockSize });
+			blocks_.push_back(Block{ std::unique_ptr<unsigned char[]>(new unsigned char[capacity]), capacity, 0 });
+		}
+		Block& block = blocks_[current_];
+		unsigned char *memory = block.memory.get() + block.used;
+		block.used += size;
+		return memory;
+	}
+
+	template <typename Visit>
+	void CommandList::ForEach(Visit visit) {
+		for (size_t i{}; i < blocks_.size() && i <= current_; ++i) {
+			Block& block = blocks_[i];
+			for (size_t offset{}; offset < block.used;) {
+				Header *header = reinterpret_cast<Header*>(block.memory.get() + offset);
+				const size_t size = header->size;
+				visit(*header, block.memory.get() + offset + GetStride(sizeof(Header)));
+				offset += GetStride(sizeof(Header)) + size;
+			}
+			block.used = 0;
+		}
+		current_ = 0;
+		count_ = 0;
+	}
+
+	void CommandList::Execute() {
+		ForEach([](const Header& header, void *command) {
+			header.invoke(command);
+			header.destroy(command);
+		});
+	}
+
+	void CommandList::Clear() {
+		ForEach([](const Header& header, void *command) { header.destroy(command); });
+	}
+
+	size_t CommandList::GetSize() const {
+		size_t size{};
+		for (const Block& block : blocks_) size += block.used;
+		return size;
+	}
+}
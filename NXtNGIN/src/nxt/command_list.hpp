@@ -0,0 +1,82 @@
+#ifndef COMMAND_LIST_HPP_
+#define COMMAND_LIST_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+
+#include "non_copyable.hpp"
+
+namespace nxt {
+	// Closures recorded on one thread and run in order on another. Every
+	// command is stored in place in blocks kept from frame to frame, so
+	// recording allocates nothing once the list has reached its usual size.
+	// Capture whatever a command needs by value: the recording thread moves
+	// on to the next frame while this one is executed.
+	class CommandList : public NonCopyable {
+	public:
+		static constexpr size_t kBlockSize{ 64 * 1024 };
+
+		CommandList() = default;
+		~CommandList() { Clear(); }
+
+		template <typename F>
+		void Record(F&& command) {
+			using Command = typename std::decay<F>::type;
+			static_assert(alignof(Command) <= alignof(std::max_align_t), "over aligned command");
+			unsigned char *memory = Allocate(GetStride(sizeof(Command)));
+			new (memory + GetStride(sizeof(Header))) Command(std::forward<F>(command));
+			new (memory) Header{ &Invoke<Command>, &Destroy<Command>, GetStride(sizeof(Command)) };
+			++count_;
+		}
+
+		// runs every command in recording order and empties the list
+		void Execute();
+		// drops the commands without running them
+		void Clear();
+
+		size_t GetCount() const { return count_; }
+		bool IsEmpty() const { return count_ == 0; }
+		// bytes in use by the recorded commands
+		size_t GetSize() const;
+	private:
+		struct Header {
+			void(*invoke)(void*);
+			void(*destroy)(void*);
+			// of the command alone, the header comes first
+			size_t size;
+		};
+
+		struct Block {
+			std::unique_ptr<unsigned char[]> memory;
+			size_t capacity;
+			size_t used;
+		};
+
+		std::vector<Block> blocks_;
+		// the block being filled
+		size_t current_{};
+		size_t count_{};
+
+		static size_t GetStride(size_t size) {
+			return (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+		}
+
+		template <typename Command>
+		static void Invoke(void *command) { (*static_cast<Command*>(command))(); }
+
+		template <typename Command>
+		static void Destroy(void *command) { static_cast<Command*>(command)->~Command(); }
+
+		// room for a header and command_size bytes after it
+		unsigned char* Allocate(size_t command_size);
+		template <typename Visit>
+		void ForEach(Visit visit);
+	};
+}
+
+#endif // COMMAND_LIST_HPP_
@@ -0,0 +1,416 @@
+#define STB_DXT_IMPLEMENTATION
+#include <stb-master/stb_dxt.h>
+
+#include "compressed_image.hpp"
+
+namespace nxt {
+	namespace {
+		constexpr std::uint32_t kDDSMagic{ 0x20534444 }; // "DDS "
+		constexpr std::uint32_t kFourCCDXT1{ 0x31545844 };
+		constexpr std::uint32_t kFourCCDXT5{ 0x35545844 };
+		constexpr std::uint32_t kFourCCDX10{ 0x30315844 };
+		constexpr std::uint32_t kDXGIBC1{ 71 };
+		constexpr std::uint32_t kDXGIBC3{ 77 };
+		constexpr std::uint32_t kDXGIBC7{ 98 };
+		constexpr unsigned char kKTXIdentifier[12]{ 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+		struct DDSPixelFormat {
+			std::uint32_t size;
+			std::uint32_t flags;
+			std::uint32_t four_cc;
+			std::uint32_t rgb_bit_count;
+			std::uint32_t bit_masks[4];
+		};
+
+		struct DDSHeader {
+			std::uint32_t size;
+			std::uint32_t flags;
+			std::uint32_t height;
+			std::uint32_t width;
+			std::uint32_t pitch_or_linear_size;
+			std::uint32_t depth;
+			std::uint32_t mip_map_count;
+			std::uint32_t reserved1[11];
+			DDSPixelFormat pixel_format;
+			std::uint32_t caps[4];
+			std::uint32_t reserved2;
+		};
+
+		struct DDSHeaderDX10 {
+			std::uint32_t dxgi_format;
+			std::uint32_t resource_dimension;
+			std::uint32_t misc_flag;
+			std::uint32_t array_size;
+			std::uint32_t misc_flags2;
+		};
+
+		struct KTXHeader {
+			std::uint32_t endianness;
+			std::uint32_t gl_type;
+			std::uint32_t gl_type_size;
+			std::uint32_t gl_format;
+			std::uint32_t gl_internal_format;
+			std::uint32_t gl_base_internal_format;
+			std::uint32_t pixel_width;
+			std::uint32_t pixel_height;
+			std::uint32_t pixel_depth;
+			std::uint32_t array_elements;
+			std::uint32_t faces;
+			std::uint32_t mip_levels;
+			std::uint32_t key_value_bytes;
+		};
+
+		static_assert(sizeof(DDSHeader) == 124, "DDSHeader must match the file layout");
+
+		// least significant bit first, as BC7 blocks are laid out
+		class BitWriter {
+		public:
+			explicit BitWriter(unsigned char *dest) : dest_{ dest }, position_{} { std::memset(dest_, 0, 16); }
+			void Write(std::uint32_t value, int bits) {
+				for (int i{}; i < bits; ++i, ++position_) {
+					if (value & (1u << i)) dest_[position_ >> 3] |= static_cast<unsigned char>(1u << (position_ & 7));
+				}
+			}
+		private:
+			unsigned char *dest_;
+			int position_;
+		};
+
+		// BC7 mode 6: one subset, 7 bit RGBA endpoints with a p-bit each and
+		// 4 bit indices. Endpoints follow the principal axis of the block.
+		void EncodeBC7Block(unsigned char *dest, const unsigned char *src) {
+			constexpr int kWeights[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			float mean[4]{};
+			for (int i{}; i < 16; ++i) {
+				for (int c{}; c < 4; ++c) mean[c] += src[i * 4 + c] / 16.0f;
+			}
+			float covariance[4][4]{};
+			for (int i{}; i < 16; ++i) {
+				for (int a{}; a < 4; ++a) {
+					for (int b{}; b < 4; ++b) {
+						covariance[a][b] += (src[i * 4 + a] - mean[a]) * (src[i * 4 + b] - mean[b]);
+					}
+				}
+			}
+			float axis[4]{ 1.0f, 1.0f, 1.0f, 1.0f };
+			for (int iteration{}; iteration < 8; ++iteration) {
+				float next[4]{};
+				for (int a{}; a < 4; ++a) {
+					for (int b{}; b < 4; ++b) next[a] += covariance[a][b] * axis[b];
+				}
+				const float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+				if (length < 1e-6f) break;
+				for (int c{}; c < 4; ++c) axis[c] = next[c] / length;
+			}
+
+			float t_min{ 0.0f }, t_max{ 0.0f };
+			for (int i{}; i < 16; ++i) {
+				float t{};
+				for (int c{}; c < 4; ++c) t += (src[i * 4 + c] - mean[c]) * axis[c];
+				t_min = std::min(t_min, t);
+				t_max = std::max(t_max, t);
+			}
+
+			// quantize both endpoints, picking the p-bit with the smaller error
+			int quantized[2][4];
+			int p_bits[2];
+			int decoded[2][4];
+			for (int e{}; e < 2; ++e) {
+				const float t = e ? t_max : t_min;
+				int best_error{ INT_MAX };
+				for (int p{}; p < 2; ++p) {
+					int q[4], error{};
+					for (int c{}; c < 4; ++c) {
+						const float value = std::min(std::max(mean[c] + axis[c] * t, 0.0f), 255.0f);
+						q[c] = std::min(std::max(static_cast<int>((value - p) / 2.0f + 0.5f), 0), 127);
+						const int d = ((q[c] << 1) | p) - static_cast<int>(value + 0.5f);
+						error += d * d;
+					}
+					if (error < best_error) {
+						best_error = error;
+						p_bits[e] = p;
+						for (int c{}; c < 4; ++c) quantized[e][c] = q[c];
+					}
+				}
+				for (int c{}; c < 4; ++c) decoded[e][c] = (quantized[e][c] << 1) | p_bits[e];
+			}
+
+			int indices[16];
+			for (int i{}; i < 16; ++i) {
+				int best_error{ INT_MAX };
+				for (int w{}; w < 16; ++w) {
+					int error{};
+					for (int c{}; c < 4; ++c) {
+						const int value = ((64 - kWeights[w]) * decoded[0][c] + kWeights[w] * decoded[1][c] + 32) >> 6;
+						const int d = value - src[i * 4 + c];
+						error += d * d;
+					}
+					if (error < best_error) {
+						best_error = error;
+						indices[i] = w;
+					}
+				}
+			}
+
+			// the anchor index is stored without its top bit, so it must be below 8
+			if (indices[0] & 8) {
+				for (int c{}; c < 4; ++c) std::swap(quantized[0][c], quantized[1][c]);
+				std::swap(p_bits[0], p_bits[1]);
+				for (int &index : indices) index = 15 - index;
+			}
+
+			BitWriter writer{ dest };
+			writer.Write(1u << 6, 7);
+			for (int c{}; c < 4; ++c) {
+				writer.Write(static_cast<std::uint32_t>(quantized[0][c]), 7);
+				writer.Write(static_cast<std::uint32_t>(quantized[1][c]), 7);
+			}
+			writer.Write(static_cast<std::uint32_t>(p_bits[0]), 1);
+			writer.Write(static_cast<std::uint32_t>(p_bits[1]), 1);
+			writer.Write(static_cast<std::uint32_t>(indices[0]), 3);
+			for (int i{ 1 }; i < 16; ++i) writer.Write(static_cast<std::uint32_t>(indices[i]), 4);
+		}
+	}
+
+	size_t CompressedImage::GetBlockBytes(GLenum internal_format) {
+		switch (internal_format) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGB8_ETC2:
+			return 8;
+		default:
+			return 16;
+		}
+	}
+
+	size_t CompressedImage::GetLevelSize(GLenum internal_format, int width, int height) {
+		const size_t blocks_x = std::max((width + 3) / 4, 1);
+		const size_t blocks_y = std::max((height + 3) / 4, 1);
+		return blocks_x * blocks_y * GetBlockBytes(internal_format);
+	}
+
+	bool CompressedImage::IsSupported(GLenum internal_format) {
+		switch (internal_format) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			return GLEW_EXT_texture_compression_s3tc != 0;
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			return (GLEW_ARB_texture_compression_bptc || GLEW_VERSION_4_2);
+		case GL_COMPRESSED_RGB8_ETC2:
+		case GL_COMPRESSED_RGBA8_ETC2_EAC:
+			return (GLEW_ARB_ES3_compatibility || GLEW_VERSION_4_3);
+		default:
+			return false;
+		}
+	}
+
+	void CompressedImage::AddLevel(int width, int height) {
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.offset = levels_.empty() ? 0 : levels_.back().offset + levels_.back().size;
+		level.size = GetLevelSize(internal_format_, width, height);
+		levels_.push_back(level);
+	}
+
+	bool CompressedImage::Load(const std::string& file_name) {
+		levels_.clear();
+		data_.clear();
+		const FileBufferPtr packed = FileSystem::Instance().GetBuffer(file_name);
+		std::unique_ptr<std::istream> stream;
+		if (packed) {
+			stream.reset(new boost::interprocess::ibufferstream(packed->GetData(), packed->GetSize(), std::ios::in | std::ios::binary));
+		}
+		else {
+			stream.reset(new std::ifstream(file_name, std::ios::in | std::ios::binary));
+		}
+		std::istream& ifs = *stream;
+		if (!ifs) {
+			std::cerr << "ERROR LOADING COMPRESSED TEXTURE '" << file_name << "'" << std::endl;
+			return false;
+		}
+
+		unsigned char identifier[12]{};
+		ifs.read(reinterpret_cast<char*>(identifier), sizeof(identifier));
+		std::uint32_t magic{};
+		std::memcpy(&magic, identifier, sizeof(magic));
+		if (magic == kDDSMagic) {
+			ifs.seekg(sizeof(magic));
+			return LoadDDS(ifs, file_name);
+		}
+		if (std::memcmp(identifier, kKTXIdentifier, sizeof(identifier)) == 0) {
+			return LoadKTX(ifs, file_name);
+		}
+		std::cerr << "UNKNOWN COMPRESSED TEXTURE CONTAINER '" << file_name << "'" << std::endl;
+		return false;
+	}
+
+	bool CompressedImage::LoadDDS(std::istream& ifs, const std::string& file_name) {
+		DDSHeader header{};
+		ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!ifs || header.size != sizeof(DDSHeader)) {
+			std::cerr << "ERROR LOADING COMPRESSED TEXTURE '" << file_name << "'" << std::endl;
+			return false;
+		}
+
+		std::uint32_t format = header.pixel_format.four_cc;
+		if (format == kFourCCDX10) {
+			DDSHeaderDX10 header_dx10{};
+			ifs.read(reinterpret_cast<char*>(&header_dx10), sizeof(header_dx10));
+			format = header_dx10.dxgi_format;
+		}
+		switch (format) {
+		case kFourCCDXT1: case kDXGIBC1: internal_format_ = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
+		case kFourCCDXT5: case kDXGIBC3: internal_format_ = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+		case kDXGIBC7: internal_format_ = GL_COMPRESSED_RGBA_BPTC_UNORM; break;
+		default:
+			std::cerr << "UNSUPPORTED DDS FORMAT IN '" << file_name << "'" << std::endl;
+			return false;
+		}
+
+		const std::uint32_t level_count = std::max<std::uint32_t>(header.mip_map_count, 1);
+		for (std::uint32_t level{}; level < level_count; ++level) {
+			AddLevel(
+				std::max(static_cast<int>(header.width >> level), 1),
+				std::max(static_cast<int>(header.height >> level), 1));
+		}
+		data_.resize(levels_.back().offset + levels_.back().size);
+		ifs.read(reinterpret_cast<char*>(data_.data()), static_cast<std::streamsize>(data_.size()));
+		if (!ifs) {
+			std::cerr << "TRUNCATED COMPRESSED TEXTURE '" << file_name << "'" << std::endl;
+			levels_.clear();
+			return false;
+		}
+		return true;
+	}
+
+	bool CompressedImage::LoadKTX(std::istream& ifs, const std::string& file_name) {
+		KTXHeader header{};
+		ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!ifs || header.endianness != 0x04030201 || header.gl_type != 0 || header.faces > 1 || header.pixel_depth > 1) {
+			std::cerr << "UNSUPPORTED KTX TEXTURE '" << file_name << "'" << std::endl;
+			return false;
+		}
+		internal_format_ = header.gl_internal_format;
+		ifs.seekg(header.key_value_bytes, std::ios::cur);
+
+		const std::uint32_t level_count = std::max<std::uint32_t>(header.mip_levels, 1);
+		for (std::uint32_t level{}; level < level_count; ++level) {
+			std::uint32_t image_size{};
+			ifs.read(reinterpret_cast<char*>(&image_size), sizeof(image_size));
+			AddLevel(
+				std::max(static_cast<int>(header.pixel_width >> level), 1),
+				std::max(static_cast<int>(header.pixel_height >> level), 1));
+			if (!ifs || image_size != levels_.back().size) {
+				std::cerr << "ERROR LOADING COMPRESSED TEXTURE '" << file_name << "'" << std::endl;
+				levels_.clear();
+				return false;
+			}
+			data_.resize(levels_.back().offset + image_size);
+			ifs.read(reinterpret_cast<char*>(data_.data() + levels_.back().offset), image_size);
+			// levels are padded to four bytes
+			ifs.seekg((4 - image_size % 4) % 4, std::ios::cur);
+		}
+		return true;
+	}
+
+	bool CompressedImage::SaveDDS(const std::string& file_name) const {
+		if (levels_.empty()) return false;
+		std::ofstream ofs(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!ofs) {
+			std::cerr << "ERROR WRITING COMPRESSED TEXTURE '" << file_name << "'" << std::endl;
+			return false;
+		}
+
+		DDSHeader header{};
+		header.size = sizeof(DDSHeader);
+		// caps, height, width, pixel format, mip map count and linear size
+		header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;
+		header.height = static_cast<std::uint32_t>(levels_[0].height);
+		header.width = static_cast<std::uint32_t>(levels_[0].width);
+		header.pitch_or_linear_size = static_cast<std::uint32_t>(levels_[0].size);
+		header.mip_map_count = static_cast<std::uint32_t>(levels_.size());
+		header.pixel_format.size = sizeof(DDSPixelFormat);
+		header.pixel_format.flags = 0x4; // four cc
+		// texture, plus complex and mip map when there is a chain
+		header.caps[0] = 0x1000 | (levels_.size() > 1 ? 0x8 | 0x400000 : 0);
+
+		DDSHeaderDX10 header_dx10{ kDXGIBC7, 3, 0, 1, 0 };
+		switch (internal_format_) {
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: header.pixel_format.four_cc = kFourCCDXT1; break;
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: header.pixel_format.four_cc = kFourCCDXT5; break;
+		case GL_COMPRESSED_RGBA_BPTC_UNORM: header.pixel_format.four_cc = kFourCCDX10; break;
+		default: return false;
+		}
+
+		ofs.write(reinterpret_cast<const char*>(&kDDSMagic), sizeof(kDDSMagic));
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		if (header.pixel_format.four_cc == kFourCCDX10) {
+			ofs.write(reinterpret_cast<const char*>(&header_dx10), sizeof(header_dx10));
+		}
+		ofs.write(reinterpret_cast<const char*>(data_.data()), static_cast<std::streamsize>(data_.size()));
+		return static_cast<bool>(ofs);
+	}
+
+	bool CompressedImage::Encode(const Image& image, GLenum internal_format, bool gen_mipmaps) {
+		if (image.Empty() || image.GetComponents() != 4) return false;
+		if (internal_format != GL_COMPRESSED_RGBA_S3TC_DXT1_EXT &&
+			internal_format != GL_COMPRESSED_RGBA_S3TC_DXT5_EXT &&
+			internal_format != GL_COMPRESSED_RGBA_BPTC_UNORM) return false;
+
+		internal_format_ = internal_format;
+		levels_.clear();
+		const int level_count = gen_mipmaps ? Image::GetLevelCount(image.GetWidth(), image.GetHeight()) : 1;
+		for (int level{}; level < level_count; ++level) {
+			AddLevel(std::max(image.GetWidth() >> level, 1), std::max(image.GetHeight() >> level, 1));
+		}
+		data_.resize(levels_.back().offset + levels_.back().size);
+
+		// stb_dxt builds its tables on first use, do that before going wide
+		unsigned char warm_up[64]{}, block[16];
+		stb_compress_dxt_block(block, warm_up, 1, STB_DXT_NORMAL);
+
+		EncodeLevel(image, 0);
+		Image level_image;
+		for (size_t level{ 1 }; level < levels_.size(); ++level) {
+			level_image = (level == 1) ? image.Downsample() : level_image.Downsample();
+			EncodeLevel(level_image, level);
+		}
+		return true;
+	}
+
+	void CompressedImage::EncodeLevel(const Image& image, size_t level) {
+		const int width = image.GetWidth();
+		const int height = image.GetHeight();
+		const int blocks_x = std::max((width + 3) / 4, 1);
+		const int blocks_y = std::max((height + 3) / 4, 1);
+		const size_t block_bytes = GetBlockBytes(internal_format_);
+		unsigned char *dest = data_.data() + levels_[level].offset;
+		const unsigned char *pixels = image.GetData();
+		const GLenum format = internal_format_;
+
+		ThreadPool::Instance().ParallelFor(
+			static_cast<size_t>(blocks_y),
+			4,
+			[=](size_t begin, size_t end) {
+			unsigned char block[64];
+			for (size_t block_y{ begin }; block_y < end; ++block_y) {
+				for (int block_x{}; block_x < blocks_x; ++block_x) {
+					// edge blocks repeat the last row and column
+					for (int y{}; y < 4; ++y) {
+						const int row = std::min(static_cast<int>(block_y) * 4 + y, height - 1);
+						for (int x{}; x < 4; ++x) {
+							const int column = std::min(block_x * 4 + x, width - 1);
+							std::memcpy(block + (y * 4 + x) * 4, pixels + (static_cast<size_t>(row) * width + column) * 4, 4);
+						}
+					}
+					unsigned char *out = dest + (block_y * blocks_x + block_x) * block_bytes;
+					if (format == GL_COMPRESSED_RGBA_BPTC_UNORM) EncodeBC7Block(out, block);
+					else stb_compress_dxt_block(out, block, format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, STB_DXT_HIGHQUAL);
+				}
+			}
+		});
+	}
+}
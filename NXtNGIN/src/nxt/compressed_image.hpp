@@ -0,0 +1,63 @@
+#ifndef COMPRESSED_IMAGE_HPP_
+#define COMPRESSED_IMAGE_HPP_
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include <boost/interprocess/streams/bufferstream.hpp>
+
+#include "image.hpp"
+#include "thread_pool.hpp"
+
+namespace nxt {
+	// Block compressed mip chain as read from DDS or KTX (version 1) files.
+	// Files written by Encode/SaveDDS keep the engine's bottom row first
+	// order, so they need no flip on upload like every other texture.
+	class CompressedImage {
+	public:
+		struct Level {
+			int width;
+			int height;
+			size_t offset;
+			size_t size;
+		};
+
+		bool Load(const std::string& file_name);
+		bool SaveDDS(const std::string& file_name) const;
+
+		// BC1, BC3 or BC7 of an RGBA image, blocks are spread over the thread pool
+		bool Encode(const Image& image, GLenum internal_format, bool gen_mipmaps = true);
+
+		GLenum GetInternalFormat() const { return internal_format_; }
+		size_t GetLevelCount() const { return levels_.size(); }
+		const Level& GetLevel(size_t level) const { return levels_[level]; }
+		const unsigned char* GetLevelData(size_t level) const { return data_.data() + levels_[level].offset; }
+		size_t GetSize() const { return data_.size(); }
+		bool Empty() const { return levels_.empty(); }
+
+		// requires a current context, false when the driver cannot sample the format
+		static bool IsSupported(GLenum internal_format);
+		static size_t GetBlockBytes(GLenum internal_format);
+		static size_t GetLevelSize(GLenum internal_format, int width, int height);
+	private:
+		GLenum internal_format_{};
+		std::vector<Level> levels_;
+		std::vector<unsigned char> data_;
+
+		bool LoadDDS(std::istream& ifs, const std::string& file_name);
+		bool LoadKTX(std::istream& ifs, const std::string& file_name);
+		void AddLevel(int width, int height);
+		void EncodeLevel(const Image& image, size_t level);
+	};
+}
+
+#endif // COMPRESSED_IMAGE_HPP_
@@ -78,6 +78,8 @@ namespace nxt {
 		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, static_cast<int>(debug));
 	}
 
+	void Context::SetVSync(bool vsync) const { glfwSwapInterval(vsync ? 1 : 0); }
+
 	void Context::SetCursorMode(bool cursor_enabled) {
 		if (cursor_enabled) {
 			glfwSetInputMode(handle_, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
@@ -30,6 +30,8 @@ namespace nxt {
 		void Create(const context::Config &config);
 		void SetCloseFlag();
 		void SetCursorMode(bool cursor_enabled);
+		// waits for the display refresh in SwapBuffers, needs the context current
+		void SetVSync(bool vsync) const;
 		void SetIcon(const std::string& file) const;
 		void SetCursorPos(float xpos, float ypos);
 		void UpdateVideoMode();
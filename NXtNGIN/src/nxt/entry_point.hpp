@@ -4,12 +4,16 @@
 extern nxt::Application* nxt::CreateApplication();
 
 int main(int argc, const char **argv) {
+	// pins the main thread for jobs::Scheduler::RunOnMainThread
+	nxt::jobs::Scheduler::Instance();
 	auto app = nxt::CreateApplication();
 	app->Init();
 	app->SetCallbacks();
 	app->Run();
 
 	delete app;
+	// anything still live here was never released
+	nxt::MemoryTracker::Instance().WriteJson("nxt_memory.json");
 	return 0;
 }
 
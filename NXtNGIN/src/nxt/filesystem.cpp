@@ -1,6 +1,14 @@
 #include "filesystem.hpp"
+#include "asset_pack.hpp"
+#include "async_io.hpp"
+#include "memory_tracker.hpp"
 
 namespace nxt {
+	FileBuffer::FileBuffer(size_t size) :
+		storage_{ new char[size + kAlignment] },
+		data_{ storage_.get() + (kAlignment - reinterpret_cast<std::uintptr_t>(storage_.get()) % kAlignment) % kAlignment },
+		size_{ size } {}
+
 	FileSystem& FileSystem::Instance() {
 		static std::unique_ptr<FileSystem> instance{ std::unique_ptr<FileSystem>(new FileSystem()) };
 		return *instance;
@@ -8,6 +16,8 @@ namespace nxt {
 
 	FileSystem::FileSystem() : resource_root_dir_{ bf::current_path().parent_path() } {}
 
+	FileSystem::~FileSystem() = default;
+
 	bool FileSystem::IsDirectory(const bf::path &path) { return bf::is_directory(path); }
 
 	bool FileSystem::IsFile(const bf::path &path) { return bf::is_regular_file(path); }
@@ -24,23 +34,20 @@ namespace nxt {
 	}
 
 	std::string FileSystem::GetContent(bf::path path) {
-		if (IsFile(path) && Exists(path)) {
-			std::ifstream ifs;
-			std::ostringstream ss;
-			try {
-				ifs.open(path.generic_string(), std::ifstream::in);
+		MemoryScope scope{ MemoryTag::FILESYSTEM };
+		if (const FileBufferPtr buffer = GetBuffer(path)) return buffer->GetView().to_string();
 
-				if (!ifs.fail()) {
-					ss << ifs.rdbuf();
-				}
-
-				ifs.close();
-			}
-			catch (const std::exception ex) {
-				std::cout << "EXCEPTION: LOADING SHADER SOURCE" << std::endl;
-				std::cout << ex.what() << std::endl;
+		if (IsFile(path) && Exists(path)) {
+			// sized up front and read straight into the result
+			std::ifstream ifs(path.string(), std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+			if (ifs.fail()) return "";
+			std::string content(static_cast<size_t>(ifs.tellg()), '\0');
+			ifs.seekg(0);
+			if (!content.empty() && !ifs.read(&content[0], static_cast<std::streamsize>(content.size()))) {
+				std::cerr << "ERROR READING '" << path.string() << "'" << std::endl;
+				return "";
 			}
-			return ss.str();
+			return content;
 		}
 		return "";
 	}
@@ -49,6 +56,111 @@ namespace nxt {
 		return GetContent(bf::path(path));
 	}
 
+	bool FileSystem::MountPack(const std::string &file) {
+		MemoryScope scope{ MemoryTag::FILESYSTEM };
+		std::unique_ptr<AssetPack> pack{ new AssetPack() };
+		if (!pack->Open(file)) return false;
+		packs_.push_back(std::move(pack));
+		return true;
+	}
+
+	void FileSystem::UnmountPacks() {
+		packs_.clear();
+	}
+
+	std::string FileSystem::GetPackKey(const bf::path &path) const {
+		if (packs_.empty()) return "";
+		const bf::path relative = bf::absolute(path).lexically_normal().lexically_relative(resource_root_dir_.lexically_normal());
+		if (relative.empty() || *relative.begin() == "..") return "";
+		return relative.generic_string();
+	}
+
+	bool FileSystem::IsPacked(const bf::path &path) const {
+		const std::string key = GetPackKey(path);
+		if (key.empty()) return false;
+		for (const std::unique_ptr<AssetPack> &pack : packs_) {
+			if (pack->Contains(key)) return true;
+		}
+		return false;
+	}
+
+	std::string FileSystem::FindCooked(const bf::path &source, const bf::path &cooked) const {
+		if (IsPacked(cooked)) return cooked.string();
+		boost::system::error_code error;
+		if (!bf::is_regular_file(cooked, error)) return "";
+		const std::time_t cooked_time = bf::last_write_time(cooked, error);
+		if (error) return "";
+		// a source that is not there as a loose file cannot be newer
+		const std::time_t source_time = bf::last_write_time(source, error);
+		if (!error && source_time > cooked_time) return "";
+		return cooked.string();
+	}
+
+	std::string FileSystem::GetOverlayKey(const bf::path &path) {
+		return bf::absolute(path).lexically_normal().generic_string();
+	}
+
+	void FileSystem::AddOverlay(const bf::path &path, FileBufferPtr buffer) {
+		const std::string key = GetOverlayKey(path);
+		std::lock_guard<std::mutex> lock{ overlay_mutex_ };
+		// the first buffer is kept, callers may already decode from it
+		Overlay& overlay = overlays_[key];
+		if (overlay.count++ == 0) overlay.buffer = std::move(buffer);
+	}
+
+	void FileSystem::RemoveOverlay(const bf::path &path) {
+		const std::string key = GetOverlayKey(path);
+		std::lock_guard<std::mutex> lock{ overlay_mutex_ };
+		auto it = overlays_.find(key);
+		if (it != overlays_.end() && --it->second.count == 0) overlays_.erase(it);
+	}
+
+	std::future<FileBufferPtr> FileSystem::ReadAsync(const bf::path &path) {
+		auto promise = std::make_shared<std::promise<FileBufferPtr>>();
+		std::future<FileBufferPtr> result = promise->get_future();
+		ReadAsync(path, [promise](FileBufferPtr buffer) { promise->set_value(std::move(buffer)); });
+		return result;
+	}
+
+	void FileSystem::ReadAsync(const bf::path &path, std::function<void(FileBufferPtr)> callback) {
+		ReadAsync(std::vector<std::string>{ path.string() }, [callback](size_t, FileBufferPtr buffer) { callback(std::move(buffer)); });
+	}
+
+	void FileSystem::ReadAsync(const std::vector<std::string> &files, std::function<void(size_t, FileBufferPtr)> callback) {
+		std::vector<std::string> reads;
+		std::vector<size_t> indices;
+		for (size_t i{}; i < files.size(); ++i) {
+			FileBufferPtr buffer = GetBuffer(files[i]);
+			if (buffer) {
+				ThreadPool::Instance().Submit([callback, i, buffer]() { callback(i, buffer); });
+				continue;
+			}
+			reads.push_back(files[i]);
+			indices.push_back(i);
+		}
+		if (reads.empty()) return;
+		AsyncIO::Instance().Read(reads, [callback, indices](size_t index, FileBufferPtr buffer) {
+			callback(indices[index], std::move(buffer));
+		});
+	}
+
+	FileBufferPtr FileSystem::GetBuffer(const bf::path &path) const {
+		{
+			std::lock_guard<std::mutex> lock{ overlay_mutex_ };
+			if (!overlays_.empty()) {
+				auto it = overlays_.find(GetOverlayKey(path));
+				if (it != overlays_.end()) return it->second.buffer;
+			}
+		}
+		const std::string key = GetPackKey(path);
+		if (key.empty()) return nullptr;
+		for (auto it = packs_.rbegin(); it != packs_.rend(); ++it) {
+			boost::string_view view;
+			if ((*it)->Find(key, view)) return std::make_shared<const FileBuffer>(view);
+		}
+		return nullptr;
+	}
+
 	const bf::path& FileSystem::SetResourceRootDir(bf::path path) {
 		resource_root_dir_ /= path;
 		assert(Exists(resource_root_dir_) && IsDirectory(resource_root_dir_));
@@ -58,7 +170,8 @@ namespace nxt {
 	const bf::path& FileSystem::SetResourceSubDir(const std::string &name) {
 		directories_[name] = resource_root_dir_;
 		directories_[name] /= (bf::path(name) += "/");
-		assert(Exists(directories_[name]) && IsDirectory(directories_[name]));
+		// a mounted pack may hold the only copy
+		assert(!packs_.empty() || (Exists(directories_[name]) && IsDirectory(directories_[name])));
 		return directories_[name];
 	}
 
@@ -7,22 +7,82 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <future>
+#include <functional>
+
+#include <boost/utility/string_view.hpp>
 
 #define BOOST_FILESYSTEM_NO_DEPRECATED
 #include <boost/filesystem.hpp>
 namespace bf = boost::filesystem;
 
+#include "non_copyable.hpp"
+
 namespace nxt {
+	class AssetPack;
+
+	// the bytes of one file as read by FileSystem::ReadAsync, owned and page
+	// aligned or a view into a mounted pack
+	class FileBuffer : public NonCopyable {
+	public:
+		static constexpr size_t kAlignment{ 4096 };
+
+		explicit FileBuffer(size_t size);
+		explicit FileBuffer(boost::string_view view) : data_{ const_cast<char*>(view.data()) }, size_{ view.size() } {}
+
+		// owned buffers only
+		char* GetData() { return storage_ ? data_ : nullptr; }
+		const char* GetData() const { return data_; }
+		size_t GetSize() const { return size_; }
+		boost::string_view GetView() const { return boost::string_view(data_, size_); }
+	private:
+		std::unique_ptr<char[]> storage_;
+		char *data_;
+		size_t size_;
+	};
+
+	using FileBufferPtr = std::shared_ptr<const FileBuffer>;
+
 	class FileSystem {
 	public:
 		static FileSystem& Instance();
+		~FileSystem();
 		bf::path GetPath(const std::string &subdirname);
 		std::string GetPathString(const std::string &subdirname);
 
 		std::string GetContent(bf::path path);
 		std::string GetContent(const std::string &path);
 
+		// packs mounted later take precedence, loose files come last; mount
+		// before anything is loaded from other threads
+		bool MountPack(const std::string &file);
+		void UnmountPacks();
+		bool IsPacked(const bf::path &path) const;
+		// cooked when it is packed or a loose file no older than source, empty
+		// otherwise so an edited source is loaded until it is cooked again
+		std::string FindCooked(const bf::path &source, const bf::path &cooked) const;
+		// the bytes of path from an overlay or a pack, null when neither holds
+		// it and the file has to be read. Overlays are shared with the caller,
+		// pack views stay valid while the pack is mounted
+		FileBufferPtr GetBuffer(const bf::path &path) const;
+
+		// reads on the AsyncIO service without blocking, packed files resolve
+		// without any I/O. Callbacks run on a ThreadPool worker, with null
+		// when the file cannot be read, so they can decode right away
+		std::future<FileBufferPtr> ReadAsync(const bf::path &path);
+		void ReadAsync(const bf::path &path, std::function<void(FileBufferPtr)> callback);
+		// submitted together, callback gets the index into files
+		void ReadAsync(const std::vector<std::string> &files, std::function<void(size_t, FileBufferPtr)> callback);
+
+		// serves buffer through GetBuffer for path until removed, so loaders
+		// that take a file name decode what was read ahead. Counted per path,
+		// one that is added twice stays until it is removed twice
+		void AddOverlay(const bf::path &path, FileBufferPtr buffer);
+		void RemoveOverlay(const bf::path &path);
+
 		const bf::path& SetResourceRootDir(bf::path path);
+		const bf::path& GetResourceRootDir() const { return resource_root_dir_; }
 		const bf::path& SetResourceSubDir(const std::string &name);
 
 		void InitSubDirs(const std::vector<std::string> &sub_dir_list);
@@ -30,6 +90,17 @@ namespace nxt {
 		FileSystem();
 		std::map<std::string, bf::path> directories_;
 		bf::path resource_root_dir_;
+		std::vector<std::unique_ptr<AssetPack>> packs_;
+		struct Overlay {
+			FileBufferPtr buffer;
+			size_t count;
+		};
+
+		std::map<std::string, Overlay> overlays_;
+		mutable std::mutex overlay_mutex_;
+
+		std::string GetPackKey(const bf::path &path) const;
+		static std::string GetOverlayKey(const bf::path &path);
 
 		bool IsDirectory(const bf::path &path);
 		bool IsFile(const bf::path &path);
@@ -0,0 +1,88 @@
+#include "frame_arena.hpp"
+
+namespace nxt {
+	std::atomic<std::uint64_t> FrameArena::frame_{ 0 };
+
+	FrameArena& FrameArena::Get() {
+		thread_local FrameArena arena;
+		return arena;
+	}
+
+	FrameArena::FrameArena() : frame_seen_{ frame_ }, peak_{} {
+		for (Region& region : regions_) {
+			region.offset = 0;
+			region.spilled = 0;
+		}
+	}
+
+	FrameArena::Region& FrameArena::GetRegion() {
+		const std::uint64_t frame = frame_.load(std::memory_order_relaxed);
+		if (frame != frame_seen_) {
+			// the other region still holds last frame's allocations, unless
+			// this thread has not allocated since
+			if (frame - frame_seen_ > 1) Rewind(regions_[(frame + 1) % 2]);
+			Rewind(regions_[frame % 2]);
+			frame_seen_ = frame;
+		}
+		return regions_[frame_seen_ % 2];
+	}
+
+	void FrameArena::Rewind(Region& region) {
+		if (region.blocks.size() > 1) {
+			size_t total{};
+			for (size_t capacity : region.capacities) total += capacity;
+			region.blocks.clear();
+			region.capacities.clear();
+			AddBlock(region, total);
+		}
+		region.offset = 0;
+		region.spilled = 0;
+	}
+
+	void FrameArena::AddBlock(Region& region, size_t capacity) {
+		region.blocks.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[capacity]));
+		region.capacities.push_back(capacity);
+		region.offset = 0;
+	}
+
+	void* FrameArena::Allocate(size_t bytes, size_t alignment) {
+		Region& region = GetRegion();
+		if (region.blocks.empty()) AddBlock(region, kInitialSize);
+
+		const auto align = [alignment](const unsigned char *base, size_t offset) {
+			const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(base) + offset;
+			return offset + ((alignment - address % alignment) % alignment);
+		};
+		size_t begin = align(region.blocks.back().get(), region.offset);
+		if (begin + bytes > region.capacities.back()) {
+			region.spilled += region.offset;
+			AddBlock(region, std::max(region.capacities.back() * 2, bytes + alignment));
+			begin = align(region.blocks.back().get(), 0);
+		}
+		region.offset = begin + bytes;
+		peak_ = std::max(peak_, region.spilled + region.offset);
+		return region.blocks.back().get() + begin;
+	}
+
+	boost::string_view FrameArena::Format(const char *format, ...) {
+		va_list args;
+		va_start(args, format);
+		va_list sizing;
+		va_copy(sizing, args);
+		const int length = std::vsnprintf(nullptr, 0, format, sizing);
+		va_end(sizing);
+		if (length < 0) {
+			va_end(args);
+			return boost::string_view();
+		}
+		char *text = static_cast<char*>(Allocate(static_cast<size_t>(length) + 1, 1));
+		std::vsnprintf(text, static_cast<size_t>(length) + 1, format, args);
+		va_end(args);
+		return boost::string_view(text, static_cast<size_t>(length));
+	}
+
+	size_t FrameArena::GetUsed() const {
+		const Region& region = regions_[frame_seen_ % 2];
+		return frame_ == frame_seen_ ? region.spilled + region.offset : 0;
+	}
+}
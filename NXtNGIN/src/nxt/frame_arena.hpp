@@ -0,0 +1,110 @@
+#ifndef FRAME_ARENA_HPP_
+#define FRAME_ARENA_HPP_
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdio>
+#include <cstdarg>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/utility/string_view.hpp>
+#include <boost/container/pmr/memory_resource.hpp>
+
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// Bump allocator for memory that only lives for a frame, one per thread.
+	// Allocating moves a pointer, deallocating does nothing, and the whole
+	// region is rewound at once. There are two regions used in turn, so an
+	// allocation stays valid until the end of the frame after the one it was
+	// made in; commands recorded for the RenderThread may point into it.
+	//
+	// Application::Run calls NextFrame once per frame, each thread's arena
+	// rewinds on its first use after that. A region that ran out during a
+	// frame is replaced by one large enough for all of it, so a steady frame
+	// allocates nothing from the heap.
+	//
+	// As a boost::container::pmr::memory_resource it backs pmr containers,
+	// FrameAllocator and the Frame* aliases below do the same for std ones.
+	class FrameArena : public boost::container::pmr::memory_resource, public NonCopyable, public NonMoveable {
+	public:
+		static constexpr size_t kInitialSize{ 64 * 1024 };
+
+		// the calling thread's arena
+		static FrameArena& Get();
+		static void NextFrame() { ++frame_; }
+		static std::uint64_t GetFrame() { return frame_; }
+
+		FrameArena();
+
+		void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+		template <typename T>
+		T* Allocate(size_t count) { return static_cast<T*>(Allocate(count * sizeof(T), alignof(T))); }
+
+		// printf into the arena, for text drawn this frame
+		boost::string_view Format(const char *format, ...);
+
+		// bytes handed out in the current frame and the most in any frame
+		size_t GetUsed() const;
+		size_t GetPeak() const { return peak_; }
+	protected:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override { return Allocate(bytes, alignment); }
+		void do_deallocate(void*, std::size_t, std::size_t) override {}
+		bool do_is_equal(const memory_resource& other) const BOOST_NOEXCEPT override { return this == &other; }
+	private:
+		struct Region {
+			// the first block is the one kept, the others only exist until
+			// the next rewind
+			std::vector<std::unique_ptr<unsigned char[]>> blocks;
+			std::vector<size_t> capacities;
+			size_t offset;
+			// of every block but the last
+			size_t spilled;
+		};
+
+		static std::atomic<std::uint64_t> frame_;
+
+		Region regions_[2];
+		std::uint64_t frame_seen_;
+		size_t peak_;
+
+		Region& GetRegion();
+		static void Rewind(Region& region);
+		static void AddBlock(Region& region, size_t capacity);
+	};
+
+	// std allocator over a FrameArena, the calling thread's by default
+	template <typename T>
+	class FrameAllocator {
+	public:
+		using value_type = T;
+
+		FrameAllocator() : arena_{ &FrameArena::Get() } {}
+		explicit FrameAllocator(FrameArena& arena) : arena_{ &arena } {}
+		template <typename U>
+		FrameAllocator(const FrameAllocator<U>& other) : arena_{ other.GetArena() } {}
+
+		T* allocate(size_t count) { return arena_->Allocate<T>(count); }
+		void deallocate(T*, size_t) {}
+
+		FrameArena* GetArena() const { return arena_; }
+	private:
+		FrameArena *arena_;
+	};
+
+	template <typename T, typename U>
+	bool operator==(const FrameAllocator<T>& lhs, const FrameAllocator<U>& rhs) { return lhs.GetArena() == rhs.GetArena(); }
+	template <typename T, typename U>
+	bool operator!=(const FrameAllocator<T>& lhs, const FrameAllocator<U>& rhs) { return !(lhs == rhs); }
+
+	template <typename T>
+	using FrameVector = std::vector<T, FrameAllocator<T>>;
+	using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+}
+
+#endif // FRAME_ARENA_HPP_
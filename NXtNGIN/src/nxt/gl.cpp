@@ -47,6 +47,11 @@ namespace nxt {
 
 		void ResetSpriteMode() { glDepthFunc(GL_LESS); }
 
+		// overlapping particles share a depth, keep them from rejecting each other
+		void SetParticleMode() { glDepthMask(GL_FALSE); }
+
+		void ResetParticleMode() { glDepthMask(GL_TRUE); }
+
 		void EnableCullFace() { glEnable(GL_CULL_FACE); }
 
 		void DisableCullFace() { glDisable(GL_CULL_FACE); }
@@ -5,8 +5,23 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "non_copyable.hpp"
+
 namespace nxt {
 	namespace opengl {
+		// GL_UNPACK_ALIGNMENT for the uploads of a scope, the previous value
+		// is restored when it ends
+		class UnpackAlignmentScope : public NonCopyable {
+		public:
+			explicit UnpackAlignmentScope(GLint alignment) : previous_{ 4 } {
+				glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+			}
+			~UnpackAlignmentScope() { glPixelStorei(GL_UNPACK_ALIGNMENT, previous_); }
+		private:
+			GLint previous_;
+		};
+
 		bool Init();
 		bool SetDefaultSetting();
 		void SetViewport(
@@ -23,6 +38,8 @@ namespace nxt {
 		void FillMode();
 		void SetSpriteMode();
 		void ResetSpriteMode();
+		void SetParticleMode();
+		void ResetParticleMode();
 		void SetCubeMapMode();
 		void ResetCubeMapMode();
 		void EnableCullFace();
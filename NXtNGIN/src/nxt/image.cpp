@@ -0,0 +1,111 @@
+#define STB_IMAGE_IMPLEMENTATION
+#if defined(NXT_TRACK_ALLOCATIONS)
+#include "memory_tracker.hpp"
+#define STBI_MALLOC(size) nxt::MemoryTracker::Allocate(size)
+#define STBI_REALLOC(memory, size) nxt::MemoryTracker::Reallocate(memory, size)
+#define STBI_FREE(memory) nxt::MemoryTracker::Free(memory)
+#endif
+#include "image.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NXT_IMAGE_SSE2
+#endif
+
+namespace nxt {
+	Image::Image(int width, int height, int components) :
+		width_{ width }, height_{ height }, components_{ components },
+		pixels_{ static_cast<unsigned char*>(STBI_MALLOC(static_cast<size_t>(width) * height * components)) } {}
+
+	Image::Image(int width, int height, int components, unsigned char* pixels, std::shared_ptr<const void> owner) :
+		width_{ width }, height_{ height }, components_{ components },
+		pixels_{ pixels, Deleter{ std::move(owner) } } {}
+
+	bool Image::Load(const std::string& file_name, int desired_components, bool flip_vertically) {
+		int width, height, components;
+		const FileBufferPtr packed = FileSystem::Instance().GetBuffer(file_name);
+		unsigned char *data = packed ?
+			stbi_load_from_memory(
+				reinterpret_cast<const stbi_uc*>(packed->GetData()),
+				static_cast<int>(packed->GetSize()),
+				&width,
+				&height,
+				&components,
+				desired_components) :
+			stbi_load(
+				file_name.c_str(),
+				&width,
+				&height,
+				&components,
+				desired_components
+			);
+		if (data == nullptr) return false;
+
+		pixels_.reset(data);
+		width_ = width;
+		height_ = height;
+		components_ = desired_components ? desired_components : components;
+		if (flip_vertically) FlipVertically();
+		return true;
+	}
+
+	void Image::FlipVertically() {
+		if (!pixels_) return;
+		const size_t row_size = static_cast<size_t>(width_) * components_;
+		unsigned char *top = pixels_.get();
+		unsigned char *bottom = top + (static_cast<size_t>(height_) - 1) * row_size;
+		for (; top < bottom; top += row_size, bottom -= row_size) {
+			std::swap_ranges(top, top + row_size, bottom);
+		}
+	}
+
+	Image Image::Downsample() const {
+		Image result{ std::max(width_ / 2, 1), std::max(height_ / 2, 1), components_ };
+		const unsigned char *src = pixels_.get();
+		unsigned char *dst = result.pixels_.get();
+		const size_t src_row = static_cast<size_t>(width_) * components_;
+		for (int y{}; y < result.height_; ++y) {
+			const unsigned char *row0 = src + static_cast<size_t>(std::min(2 * y, height_ - 1)) * src_row;
+			const unsigned char *row1 = src + static_cast<size_t>(std::min(2 * y + 1, height_ - 1)) * src_row;
+			int x{};
+#if defined(NXT_IMAGE_SSE2)
+			// widen to 16 bits, add the rows, then the neighbouring texels
+			if (components_ == 4 && width_ > 1) {
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i round = _mm_set1_epi16(2);
+				for (; x + 4 <= result.width_; x += 4) {
+					const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+					const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8 + 16));
+					const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+					const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8 + 16));
+					const __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+					const __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+					const __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+					const __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+					__m128i h0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+					__m128i h1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+					h0 = _mm_srli_epi16(_mm_add_epi16(h0, round), 2);
+					h1 = _mm_srli_epi16(_mm_add_epi16(h1, round), 2);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(h0, h1));
+					dst += 16;
+				}
+			}
+#endif
+			for (; x < result.width_; ++x) {
+				const size_t x0 = static_cast<size_t>(std::min(2 * x, width_ - 1)) * components_;
+				const size_t x1 = static_cast<size_t>(std::min(2 * x + 1, width_ - 1)) * components_;
+				for (int c{}; c < components_; ++c) {
+					*dst++ = static_cast<unsigned char>(
+						(row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+				}
+			}
+		}
+		return result;
+	}
+
+	int Image::GetLevelCount(int width, int height) {
+		int levels{ 1 };
+		for (int size{ std::max(width, height) }; size > 1; size >>= 1) ++levels;
+		return levels;
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef IMAGE_HPP_
+#define IMAGE_HPP_
+
+#include <memory>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+#include <stb-master/stb_image.h>
+
+#include "filesystem.hpp"
+
+namespace nxt {
+	// decoded 8 bit pixels, safe to load from any thread since it never
+	// touches stb_image's global flip setting
+	class Image {
+	public:
+		Image() = default;
+		// uninitialized pixels, allocated so stbi_image_free can release them
+		Image(int width, int height, int components);
+		// pixels owned by something else, such as a mapped cache file, which
+		// stays alive as long as the image does
+		Image(int width, int height, int components, unsigned char* pixels, std::shared_ptr<const void> owner);
+		Image(Image&&) = default;
+		Image& operator=(Image&&) = default;
+
+		// desired_components 0 keeps the file's channel count, flipped images
+		// start with the bottom row like every Texture2D upload expects
+		bool Load(const std::string& file_name, int desired_components = 0, bool flip_vertically = true);
+		void FlipVertically();
+		// next mip level, 2x2 box filter, odd edges repeat their last texel;
+		// rgba rows are filtered four texels at a time with SSE2
+		Image Downsample() const;
+		// levels of a full mip chain down to 1x1
+		static int GetLevelCount(int width, int height);
+
+		const unsigned char* GetData() const { return pixels_.get(); }
+		unsigned char* GetData() { return pixels_.get(); }
+		int GetWidth() const { return width_; }
+		int GetHeight() const { return height_; }
+		int GetComponents() const { return components_; }
+		size_t GetSize() const { return static_cast<size_t>(width_) * height_ * components_; }
+		bool Empty() const { return pixels_ == nullptr; }
+	private:
+		struct Deleter {
+			std::shared_ptr<const void> owner;
+			void operator()(unsigned char* pixels) const { if (!owner) stbi_image_free(pixels); }
+		};
+
+		int width_{};
+		int height_{};
+		int components_{};
+		std::unique_ptr<unsigned char, Deleter> pixels_;
+	};
+}
+
+#endif // IMAGE_HPP_
@@ -10,10 +10,12 @@ namespace nxt {
 			reinterpret_cast<const GLvoid*>(data),
 			GL_STATIC_DRAW
 		);
+		MemoryTracker::Instance().AddGpu(GpuResource::INDEX_BUFFER, 0, count_ * sizeof(GLuint));
 	}
 
 	IndexBuffer::~IndexBuffer() {
 		glDeleteBuffers(1, &handle_);
+		MemoryTracker::Instance().RemoveGpu(GpuResource::INDEX_BUFFER, 0, count_ * sizeof(GLuint));
 	}
 
 	void IndexBuffer::Bind() const {
@@ -3,6 +3,8 @@
 
 #include <GL/glew.h>
 
+#include "memory_tracker.hpp"
+
 namespace nxt {
 	class IndexBuffer {
 	public:
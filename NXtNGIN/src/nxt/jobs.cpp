@@ -0,0 +1,271 @@
+#include "jobs.hpp"
+
+namespace nxt {
+	namespace jobs {
+		struct Task {
+			Job job;
+			Counter *counter;
+		};
+
+		namespace {
+			// attempts at finding work before a worker goes to sleep
+			constexpr int kSpinCount{ 64 };
+
+			thread_local const Scheduler *current_scheduler{};
+			thread_local size_t current_worker{};
+		}
+
+		WorkStealingQueue::WorkStealingQueue() : top_{ 0 }, bottom_{ 0 } {
+			for (std::atomic<Task*> &task : tasks_) task.store(nullptr, std::memory_order_relaxed);
+		}
+
+		bool WorkStealingQueue::Push(Task *task) {
+			const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+			const std::int64_t top = top_.load(std::memory_order_acquire);
+			if (bottom - top >= kCapacity) return false;
+			tasks_[bottom & (kCapacity - 1)].store(task, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom_.store(bottom + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		Task* WorkStealingQueue::Pop() {
+			const std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+			bottom_.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			std::int64_t top = top_.load(std::memory_order_relaxed);
+			if (top > bottom) {
+				bottom_.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+			Task *task = tasks_[bottom & (kCapacity - 1)].load(std::memory_order_relaxed);
+			if (top == bottom) {
+				// the last one, race the thieves for it
+				if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					task = nullptr;
+				}
+				bottom_.store(bottom + 1, std::memory_order_relaxed);
+			}
+			return task;
+		}
+
+		Task* WorkStealingQueue::Steal() {
+			std::int64_t top = top_.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+			if (top >= bottom) return nullptr;
+			Task *task = tasks_[top & (kCapacity - 1)].load(std::memory_order_relaxed);
+			if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return nullptr;
+			}
+			return task;
+		}
+
+		bool WorkStealingQueue::IsEmpty() const {
+			return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+		}
+
+		Scheduler& Scheduler::Instance() {
+			static std::unique_ptr<Scheduler> instance{ std::unique_ptr<Scheduler>(
+				new Scheduler(std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1)) };
+			return *instance;
+		}
+
+		Scheduler::Scheduler(size_t worker_count) :
+			main_thread_{ std::this_thread::get_id() },
+			context_thread_{ main_thread_ },
+			stop_{ false },
+			pending_{ 0 },
+			sleeping_{ 0 },
+			shared_size_{ 0 },
+			job_count_{ 0 },
+			steal_count_{ 0 } {
+			// every deque exists before the first worker starts stealing
+			for (size_t i{}; i < worker_count; ++i) {
+				workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+			}
+			for (size_t i{}; i < worker_count; ++i) {
+				workers_[i]->thread = std::thread(&Scheduler::WorkerLoop, this, i);
+			}
+		}
+
+		Scheduler::~Scheduler() {
+			{
+				std::lock_guard<std::mutex> lock{ sleep_mutex_ };
+				stop_ = true;
+			}
+			wake_.notify_all();
+			for (std::unique_ptr<Worker> &worker : workers_) worker->thread.join();
+			for (Task *task : main_thread_jobs_) delete task;
+		}
+
+		Scheduler::Worker* Scheduler::GetCurrentWorker() const {
+			return current_scheduler == this ? workers_[current_worker].get() : nullptr;
+		}
+
+		void Scheduler::Run(Job job, Counter *counter) {
+			if (counter) counter->value_.fetch_add(1, std::memory_order_relaxed);
+			Push(new Task{ std::move(job), counter });
+		}
+
+		void Scheduler::RunAfter(Counter& dependency, Job job, Counter *counter) {
+			if (counter) counter->value_.fetch_add(1, std::memory_order_relaxed);
+			Task *task = new Task{ std::move(job), counter };
+			{
+				std::lock_guard<std::mutex> lock{ dependency.mutex_ };
+				if (!dependency.IsDone()) {
+					dependency.continuations_.push_back(task);
+					return;
+				}
+			}
+			Push(task);
+		}
+
+		void Scheduler::Wait(Counter& counter) {
+			Worker *self = GetCurrentWorker();
+			// GL jobs only where the context is current
+			const bool context_thread = IsContextThread();
+			std::minstd_rand random{ static_cast<std::minstd_rand::result_type>(
+				std::hash<std::thread::id>()(std::this_thread::get_id())) };
+			while (!counter.IsDone()) {
+				if (context_thread && RunMainThreadJobs() != 0) continue;
+				Task *task = Take(self, random);
+				if (task) Execute(task);
+				else std::this_thread::yield();
+			}
+			// the job that finished the counter may still be inside Finish
+			std::lock_guard<std::mutex> lock{ counter.mutex_ };
+		}
+
+		void Scheduler::ParallelFor(
+			size_t count,
+			size_t min_grain,
+			const std::function<void(size_t begin, size_t end)> &body) {
+			if (count == 0) return;
+
+			const size_t target_ranges = (workers_.size() + 1) * kRangesPerThread;
+			const size_t grain = std::max({ min_grain, (count + target_ranges - 1) / target_ranges, size_t{ 1 } });
+			const size_t ranges = (count + grain - 1) / grain;
+			if (ranges == 1) {
+				body(0, count);
+				return;
+			}
+
+			// ranges are handed out in order to whoever asks next, helpers
+			// that start late find nothing left and return
+			std::atomic<size_t> next{ 0 };
+			const auto work = [&body, &next, ranges, grain, count]() {
+				for (size_t range = next++; range < ranges; range = next++) {
+					const size_t begin = range * grain;
+					body(begin, std::min(begin + grain, count));
+				}
+			};
+			Counter counter;
+			const size_t helpers = std::min(workers_.size(), ranges - 1);
+			for (size_t i{}; i < helpers; ++i) Run(work, &counter);
+			work();
+			Wait(counter);
+		}
+
+		void Scheduler::RunOnMainThread(Job job, Counter *counter) {
+			if (counter) counter->value_.fetch_add(1, std::memory_order_relaxed);
+			std::lock_guard<std::mutex> lock{ main_mutex_ };
+			main_thread_jobs_.push_back(new Task{ std::move(job), counter });
+		}
+
+		size_t Scheduler::RunMainThreadJobs() {
+			std::deque<Task*> tasks;
+			{
+				std::lock_guard<std::mutex> lock{ main_mutex_ };
+				tasks.swap(main_thread_jobs_);
+			}
+			// jobs queued meanwhile wait for the next call
+			for (Task *task : tasks) Execute(task);
+			return tasks.size();
+		}
+
+		void Scheduler::Push(Task *task) {
+			++job_count_;
+			pending_.fetch_add(1);
+			Worker *self = GetCurrentWorker();
+			if (!self || !self->queue.Push(task)) {
+				std::lock_guard<std::mutex> lock{ shared_mutex_ };
+				shared_.push_back(task);
+				shared_size_.fetch_add(1);
+			}
+			if (sleeping_.load() != 0) {
+				// a worker between its last check and the wait still holds the
+				// mutex, taking it first makes sure that worker gets the notify
+				{ std::lock_guard<std::mutex> lock{ sleep_mutex_ }; }
+				wake_.notify_one();
+			}
+		}
+
+		Task* Scheduler::Take(Worker *self, std::minstd_rand& random) {
+			Task *task = self ? self->queue.Pop() : nullptr;
+			if (!task && shared_size_.load() != 0) {
+				std::lock_guard<std::mutex> lock{ shared_mutex_ };
+				if (!shared_.empty()) {
+					task = shared_.front();
+					shared_.pop_front();
+					shared_size_.fetch_sub(1);
+				}
+			}
+			if (!task && !workers_.empty()) {
+				const size_t first = random() % workers_.size();
+				for (size_t i{}; i < workers_.size() && !task; ++i) {
+					Worker *victim = workers_[(first + i) % workers_.size()].get();
+					if (victim == self) continue;
+					task = victim->queue.Steal();
+					if (task) ++steal_count_;
+				}
+			}
+			if (task) pending_.fetch_sub(1);
+			return task;
+		}
+
+		void Scheduler::Execute(Task *task) {
+			task->job();
+			Counter *counter = task->counter;
+			delete task;
+			Finish(counter);
+		}
+
+		void Scheduler::Finish(Counter *counter) {
+			if (!counter) return;
+			std::vector<Task*> ready;
+			{
+				std::lock_guard<std::mutex> lock{ counter->mutex_ };
+				if (counter->value_.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+				ready.swap(counter->continuations_);
+			}
+			for (Task *task : ready) Push(task);
+		}
+
+		void Scheduler::WorkerLoop(size_t index) {
+			current_scheduler = this;
+			current_worker = index;
+			Worker *self = workers_[index].get();
+			std::minstd_rand random{ static_cast<std::minstd_rand::result_type>(index + 1) };
+			int idle{};
+			for (;;) {
+				Task *task = Take(self, random);
+				if (task) {
+					Execute(task);
+					idle = 0;
+					continue;
+				}
+				if (++idle < kSpinCount || pending_.load() != 0) {
+					std::this_thread::yield();
+					continue;
+				}
+				std::unique_lock<std::mutex> lock{ sleep_mutex_ };
+				++sleeping_;
+				wake_.wait(lock, [this]() { return stop_ || pending_.load() != 0; });
+				--sleeping_;
+				if (stop_ && pending_.load() == 0) return;
+				idle = 0;
+			}
+		}
+	}
+}
@@ -0,0 +1,165 @@
+#ifndef JOBS_HPP_
+#define JOBS_HPP_
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <cstdint>
+
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	namespace jobs {
+		using Job = std::function<void()>;
+
+		struct Task;
+
+		// Counts the jobs still to run that were started with it. Jobs queued
+		// with Scheduler::RunAfter start once it drops to zero. Only destroy or
+		// reuse a counter after Wait on it has returned.
+		class Counter : public NonCopyable, public NonMoveable {
+		public:
+			Counter() : value_{ 0 } {}
+
+			bool IsDone() const { return value_.load(std::memory_order_acquire) == 0; }
+			size_t GetValue() const { return value_.load(std::memory_order_acquire); }
+		private:
+			friend class Scheduler;
+
+			std::atomic<size_t> value_;
+			std::mutex mutex_;
+			// RunAfter jobs waiting for zero, guarded by mutex_
+			std::vector<Task*> continuations_;
+		};
+
+		// Chase-Lev deque of a fixed capacity. The owning worker pushes and
+		// pops at the bottom, any other thread steals from the top.
+		class WorkStealingQueue : public NonCopyable, public NonMoveable {
+		public:
+			static constexpr std::int64_t kCapacity{ 4096 };
+
+			WorkStealingQueue();
+
+			// owner only, false when full
+			bool Push(Task *task);
+			// owner only
+			Task* Pop();
+			// any thread, null when empty or when another thief won
+			Task* Steal();
+			bool IsEmpty() const;
+		private:
+			std::atomic<std::int64_t> top_;
+			std::atomic<std::int64_t> bottom_;
+			std::atomic<Task*> tasks_[kCapacity];
+		};
+
+		// Work stealing scheduler with one worker per hardware thread but the
+		// main one. Jobs started on a worker go to its own deque and are taken
+		// back newest first, idle workers steal the oldest from the others.
+		// Jobs started from other threads go through a shared queue.
+		//
+		// Waiting never blocks a thread that could run jobs: Wait keeps
+		// running queued jobs until the counter is done, so jobs may start and
+		// wait on further jobs. GL work goes to RunOnMainThread and runs when
+		// the thread holding the context calls RunMainThreadJobs or waits on a
+		// counter; that is the main thread unless SetContextThread moved it.
+		class Scheduler : public NonCopyable, public NonMoveable {
+		public:
+			// ranges per thread ParallelFor aims for, so early finishers can
+			// pick up the ranges of slow ones
+			static constexpr size_t kRangesPerThread{ 4 };
+
+			// the thread calling this first becomes the main thread, entry
+			// point does so before the application is created
+			static Scheduler& Instance();
+
+			explicit Scheduler(size_t worker_count);
+			~Scheduler();
+
+			// counter, if any, counts the job until it has run
+			void Run(Job job, Counter *counter = nullptr);
+			// job starts once dependency is done, right away if it already is
+			void RunAfter(Counter& dependency, Job job, Counter *counter = nullptr);
+			// runs queued jobs on the calling thread until counter is done
+			void Wait(Counter& counter);
+
+			// splits [0, count) into ranges of at least min_grain elements,
+			// sized for kRangesPerThread each, and returns once all are done;
+			// the calling thread works on ranges too
+			void ParallelFor(
+				size_t count,
+				size_t min_grain,
+				const std::function<void(size_t begin, size_t end)> &body);
+
+			void RunOnMainThread(Job job, Counter *counter = nullptr);
+			// context thread only, returns the number of jobs run
+			size_t RunMainThreadJobs();
+			bool IsMainThread() const { return std::this_thread::get_id() == main_thread_; }
+			// where RunOnMainThread jobs may run, for a render thread taking
+			// the GL context over
+			void SetContextThread(std::thread::id thread) { context_thread_ = thread; }
+			bool IsContextThread() const { return std::this_thread::get_id() == context_thread_.load(); }
+			bool IsWorkerThread() const { return GetCurrentWorker() != nullptr; }
+
+			size_t GetWorkerCount() const { return workers_.size(); }
+			std::uint64_t GetJobCount() const { return job_count_; }
+			std::uint64_t GetStealCount() const { return steal_count_; }
+		private:
+			struct Worker {
+				WorkStealingQueue queue;
+				std::thread thread;
+			};
+
+			std::thread::id main_thread_;
+			std::atomic<std::thread::id> context_thread_;
+			std::vector<std::unique_ptr<Worker>> workers_;
+			std::atomic<bool> stop_;
+			// queued jobs not yet taken, what sleeping workers wait for
+			std::atomic<size_t> pending_;
+			std::atomic<size_t> sleeping_;
+			std::mutex sleep_mutex_;
+			std::condition_variable wake_;
+
+			std::mutex shared_mutex_;
+			std::deque<Task*> shared_;
+			// lets Take skip the lock while shared_ is empty
+			std::atomic<size_t> shared_size_;
+			std::mutex main_mutex_;
+			std::deque<Task*> main_thread_jobs_;
+
+			std::atomic<std::uint64_t> job_count_;
+			std::atomic<std::uint64_t> steal_count_;
+
+			Worker* GetCurrentWorker() const;
+			void Push(Task *task);
+			Task* Take(Worker *self, std::minstd_rand& random);
+			void Execute(Task *task);
+			void Finish(Counter *counter);
+			void WorkerLoop(size_t index);
+		};
+
+		// the shared scheduler
+		inline void Run(Job job, Counter *counter = nullptr) {
+			Scheduler::Instance().Run(std::move(job), counter);
+		}
+
+		inline void Wait(Counter& counter) { Scheduler::Instance().Wait(counter); }
+
+		inline void ParallelFor(
+			size_t count,
+			size_t min_grain,
+			const std::function<void(size_t begin, size_t end)> &body) {
+			Scheduler::Instance().ParallelFor(count, min_grain, body);
+		}
+	}
+}
+
+#endif // JOBS_HPP_
@@ -0,0 +1,141 @@
+#include "lz4.hpp"
+
+namespace nxt {
+	namespace lz4 {
+		namespace {
+			constexpr size_t kMinMatch{ 4 };
+			// the format ends in literals, and the last match starts this far before the end
+			constexpr size_t kLastLiterals{ 5 };
+			constexpr size_t kMatchLimit{ 12 };
+			constexpr size_t kMaxOffset{ 65535 };
+			constexpr int kHashBits{ 16 };
+
+			std::uint32_t Read32(const unsigned char* p) {
+				std::uint32_t value;
+				std::memcpy(&value, p, sizeof(value));
+				return value;
+			}
+
+			std::uint32_t Hash(std::uint32_t sequence) {
+				return (sequence * 2654435761u) >> (32 - kHashBits);
+			}
+
+			// 15 in the token, then 255 per byte until the remainder
+			bool WriteLength(size_t length, unsigned char*& op, const unsigned char* op_end) {
+				for (; length >= 255; length -= 255) {
+					if (op >= op_end) return false;
+					*op++ = 255;
+				}
+				if (op >= op_end) return false;
+				*op++ = static_cast<unsigned char>(length);
+				return true;
+			}
+
+			bool ReadLength(size_t& length, const unsigned char*& ip, const unsigned char* ip_end) {
+				unsigned char byte;
+				do {
+					if (ip >= ip_end) return false;
+					byte = *ip++;
+					length += byte;
+				} while (byte == 255);
+				return true;
+			}
+
+			bool WriteSequence(
+				const unsigned char* literals,
+				size_t literal_length,
+				size_t offset,
+				size_t match_length,
+				unsigned char*& op,
+				const unsigned char* op_end) {
+
+				if (op >= op_end) return false;
+				unsigned char *token = op++;
+				*token = static_cast<unsigned char>(std::min<size_t>(literal_length, 15) << 4);
+				if (literal_length >= 15 && !WriteLength(literal_length - 15, op, op_end)) return false;
+				if (static_cast<size_t>(op_end - op) < literal_length) return false;
+				std::memcpy(op, literals, literal_length);
+				op += literal_length;
+				if (match_length == 0) return true;
+
+				if (op_end - op < 2) return false;
+				*op++ = static_cast<unsigned char>(offset & 0xFF);
+				*op++ = static_cast<unsigned char>(offset >> 8);
+				const size_t extra = match_length - kMinMatch;
+				*token |= static_cast<unsigned char>(std::min<size_t>(extra, 15));
+				return extra < 15 || WriteLength(extra - 15, op, op_end);
+			}
+		}
+
+		size_t GetMaxCompressedSize(size_t size) {
+			return size + size / 255 + 16;
+		}
+
+		size_t Compress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity) {
+			const unsigned char *ip = src;
+			const unsigned char *anchor = src;
+			const unsigned char *end = src + size;
+			unsigned char *op = dst;
+			const unsigned char *op_end = dst + capacity;
+
+			if (size > kMatchLimit) {
+				const unsigned char *match_start_limit = end - kMatchLimit;
+				const unsigned char *match_end_limit = end - kLastLiterals;
+				// positions plus one, zero is empty
+				std::vector<std::uint32_t> table(size_t{ 1 } << kHashBits);
+				while (ip < match_start_limit) {
+					const std::uint32_t sequence = Read32(ip);
+					std::uint32_t& slot = table[Hash(sequence)];
+					const unsigned char *match = slot ? src + slot - 1 : nullptr;
+					slot = static_cast<std::uint32_t>(ip - src) + 1;
+					if (!match || static_cast<size_t>(ip - match) > kMaxOffset || Read32(match) != sequence) {
+						++ip;
+						continue;
+					}
+
+					size_t length{ kMinMatch };
+					while (ip + length < match_end_limit && ip[length] == match[length]) ++length;
+					if (!WriteSequence(anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - match), length, op, op_end)) return 0;
+					ip += length;
+					anchor = ip;
+				}
+			}
+			if (!WriteSequence(anchor, static_cast<size_t>(end - anchor), 0, 0, op, op_end)) return 0;
+			return static_cast<size_t>(op - dst);
+		}
+
+		bool Decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t dst_size) {
+			const unsigned char *ip = src;
+			const unsigned char *ip_end = src + size;
+			unsigned char *op = dst;
+			unsigned char *op_end = dst + dst_size;
+
+			while (ip < ip_end) {
+				const unsigned char token = *ip++;
+				size_t literal_length = token >> 4;
+				if (literal_length == 15 && !ReadLength(literal_length, ip, ip_end)) return false;
+				if (static_cast<size_t>(ip_end - ip) < literal_length ||
+					static_cast<size_t>(op_end - op) < literal_length) return false;
+				std::memcpy(op, ip, literal_length);
+				ip += literal_length;
+				op += literal_length;
+				// the last sequence has no match
+				if (ip == ip_end) break;
+
+				if (ip_end - ip < 2) return false;
+				const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+				ip += 2;
+				if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+				size_t match_length = token & 0x0F;
+				if (match_length == 15 && !ReadLength(match_length, ip, ip_end)) return false;
+				match_length += kMinMatch;
+				if (static_cast<size_t>(op_end - op) < match_length) return false;
+				// overlapping copies repeat the last offset bytes
+				const unsigned char *match = op - offset;
+				for (size_t i{}; i < match_length; ++i) op[i] = match[i];
+				op += match_length;
+			}
+			return op == op_end;
+		}
+	}
+}
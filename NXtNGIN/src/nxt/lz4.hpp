@@ -0,0 +1,26 @@
+#ifndef LZ4_HPP_
+#define LZ4_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+namespace nxt {
+	// LZ4 block format, compatible with LZ4_compress_default and
+	// LZ4_decompress_safe. Greedy and single pass, meant for assets packed
+	// offline and unpacked once at load time.
+	namespace lz4 {
+		// a length byte extends a match by 255 bytes at most, so a block never
+		// unpacks to more than that many times its size
+		constexpr std::uint64_t kMaxRatio{ 255 };
+
+		size_t GetMaxCompressedSize(size_t size);
+		// bytes written to dst, 0 when they would not fit into capacity
+		size_t Compress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity);
+		// false unless src decodes to exactly dst_size bytes
+		bool Decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t dst_size);
+	}
+}
+
+#endif // LZ4_HPP_
@@ -0,0 +1,298 @@
+#include <new>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+
+#include "memory_tracker.hpp"
+
+namespace nxt {
+	namespace {
+		// plain atomics, zero before any constructor runs, as operator new
+		// may be called before main and after the tracker is destroyed
+		struct Counter {
+			std::atomic<size_t> live_bytes;
+			std::atomic<size_t> peak_bytes;
+			std::atomic<size_t> live_count;
+			std::atomic<size_t> total_count;
+			std::atomic<size_t> frame_count;
+			std::atomic<size_t> last_frame_count;
+		};
+
+		struct BlockHeader {
+			size_t size;
+			MemoryTag tag;
+		};
+
+		constexpr size_t kTagCount{ static_cast<size_t>(MemoryTag::COUNT) };
+		constexpr size_t kResourceCount{ static_cast<size_t>(GpuResource::COUNT) };
+		// keeps the block after the header aligned like one from malloc
+		constexpr size_t kHeaderSize{
+			(sizeof(BlockHeader) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1) };
+
+		Counter heap_counters[kTagCount];
+		Counter heap_total;
+		Counter gpu_counters[kResourceCount];
+		Counter gpu_total;
+
+		thread_local MemoryTag current_tag{ MemoryTag::GENERAL };
+
+		void Add(Counter& counter, size_t bytes) {
+			const size_t live = counter.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+			size_t peak = counter.peak_bytes.load(std::memory_order_relaxed);
+			while (live > peak && !counter.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+			counter.live_count.fetch_add(1, std::memory_order_relaxed);
+			counter.total_count.fetch_add(1, std::memory_order_relaxed);
+			counter.frame_count.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void Remove(Counter& counter, size_t bytes) {
+			counter.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+			counter.live_count.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		MemoryStats Snapshot(const Counter& counter) {
+			return MemoryStats{
+				counter.live_bytes.load(std::memory_order_relaxed),
+				counter.peak_bytes.load(std::memory_order_relaxed),
+				counter.live_count.load(std::memory_order_relaxed),
+				counter.total_count.load(std::memory_order_relaxed),
+				counter.last_frame_count.load(std::memory_order_relaxed) };
+		}
+
+		void EndFrame(Counter& counter) {
+			counter.last_frame_count.store(counter.frame_count.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+
+		void WriteStats(std::ostream& stream, const MemoryStats& stats) {
+			stream << "{ \"live_bytes\": " << stats.live_bytes
+				<< ", \"peak_bytes\": " << stats.peak_bytes
+				<< ", \"live_count\": " << stats.live_count
+				<< ", \"total_count\": " << stats.total_count
+				<< ", \"frame_count\": " << stats.frame_count << " }";
+		}
+	}
+
+	MemoryTracker& MemoryTracker::Instance() {
+		// never destroyed, static resources still report what they free
+		// after main returns
+		static MemoryTracker *instance{ new MemoryTracker() };
+		return *instance;
+	}
+
+	const char* MemoryTracker::GetName(MemoryTag tag) {
+		switch (tag) {
+		case MemoryTag::GENERAL: return "general";
+		case MemoryTag::MESH: return "mesh";
+		case MemoryTag::TEXTURE: return "texture";
+		case MemoryTag::TEXT: return "text";
+		case MemoryTag::AUDIO: return "audio";
+		case MemoryTag::FILESYSTEM: return "filesystem";
+		default: return "unknown";
+		}
+	}
+
+	const char* MemoryTracker::GetName(GpuResource resource) {
+		switch (resource) {
+		case GpuResource::VERTEX_BUFFER: return "vertex_buffer";
+		case GpuResource::INDEX_BUFFER: return "index_buffer";
+		case GpuResource::PIXEL_BUFFER: return "pixel_buffer";
+		case GpuResource::TEXTURE: return "texture";
+		default: return "unknown";
+		}
+	}
+
+	const char* MemoryTracker::GetFormatName(GLenum internal_format) {
+		switch (internal_format) {
+		case GL_R8: return "R8";
+		case GL_RGB8: return "RGB8";
+		case GL_RGBA8: return "RGBA8";
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return "DXT1_RGB";
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: return "DXT1_RGBA";
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return "DXT5";
+		case GL_COMPRESSED_RGBA_BPTC_UNORM: return "BC7";
+		case GL_COMPRESSED_RGB8_ETC2: return "ETC2_RGB";
+		case GL_COMPRESSED_RGBA8_ETC2_EAC: return "ETC2_RGBA";
+		default: return nullptr;
+		}
+	}
+
+	bool MemoryTracker::IsTrackingAllocations() {
+#if defined(NXT_TRACK_ALLOCATIONS)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void* MemoryTracker::Allocate(size_t bytes) {
+		void *block = std::malloc(kHeaderSize + bytes);
+		if (!block) return nullptr;
+		const MemoryTag tag = current_tag;
+		new (block) BlockHeader{ bytes, tag };
+		Add(heap_counters[static_cast<size_t>(tag)], bytes);
+		Add(heap_total, bytes);
+		return static_cast<unsigned char*>(block) + kHeaderSize;
+	}
+
+	void* MemoryTracker::Reallocate(void *memory, size_t bytes) {
+		if (!memory) return Allocate(bytes);
+		void *block = static_cast<unsigned char*>(memory) - kHeaderSize;
+		const BlockHeader header = *static_cast<BlockHeader*>(block);
+		void *moved = std::realloc(block, kHeaderSize + bytes);
+		if (!moved) return nullptr;
+		// the block keeps the tag it was first allocated with
+		static_cast<BlockHeader*>(moved)->size = bytes;
+		Counter& counter = heap_counters[static_cast<size_t>(header.tag)];
+		Remove(counter, header.size);
+		Remove(heap_total, header.size);
+		Add(counter, bytes);
+		Add(heap_total, bytes);
+		return static_cast<unsigned char*>(moved) + kHeaderSize;
+	}
+
+	void MemoryTracker::Free(void *memory) {
+		if (!memory) return;
+		void *block = static_cast<unsigned char*>(memory) - kHeaderSize;
+		const BlockHeader& header = *static_cast<BlockHeader*>(block);
+		Remove(heap_counters[static_cast<size_t>(header.tag)], header.size);
+		Remove(heap_total, header.size);
+		std::free(block);
+	}
+
+	MemoryTag MemoryTracker::GetCurrentTag() {
+		return current_tag;
+	}
+
+	MemoryTag MemoryTracker::SetCurrentTag(MemoryTag tag) {
+		const MemoryTag previous = current_tag;
+		current_tag = tag;
+		return previous;
+	}
+
+	void MemoryTracker::AddGpu(GpuResource resource, GLenum internal_format, size_t bytes) {
+		Add(gpu_counters[static_cast<size_t>(resource)], bytes);
+		Add(gpu_total, bytes);
+		if (resource == GpuResource::TEXTURE) {
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			texture_formats_[internal_format] += bytes;
+		}
+	}
+
+	void MemoryTracker::RemoveGpu(GpuResource resource, GLenum internal_format, size_t bytes) {
+		Remove(gpu_counters[static_cast<size_t>(resource)], bytes);
+		Remove(gpu_total, bytes);
+		if (resource == GpuResource::TEXTURE) {
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			auto format = texture_formats_.find(internal_format);
+			if (format == texture_formats_.end()) return;
+			format->second -= std::min(format->second, bytes);
+			if (format->second == 0) texture_formats_.erase(format);
+		}
+	}
+
+	void MemoryTracker::NextFrame() {
+		for (Counter& counter : heap_counters) EndFrame(counter);
+		for (Counter& counter : gpu_counters) EndFrame(counter);
+		EndFrame(heap_total);
+		EndFrame(gpu_total);
+	}
+
+	MemoryStats MemoryTracker::GetStats(MemoryTag tag) const {
+		return Snapshot(heap_counters[static_cast<size_t>(tag)]);
+	}
+
+	MemoryStats MemoryTracker::GetStats(GpuResource resource) const {
+		return Snapshot(gpu_counters[static_cast<size_t>(resource)]);
+	}
+
+	MemoryStats MemoryTracker::GetHeapTotal() const {
+		return Snapshot(heap_total);
+	}
+
+	MemoryStats MemoryTracker::GetGpuTotal() const {
+		return Snapshot(gpu_total);
+	}
+
+	size_t MemoryTracker::GetTextureBytes(GLenum internal_format) const {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		auto format = texture_formats_.find(internal_format);
+		return format != texture_formats_.end() ? format->second : 0;
+	}
+
+	bool MemoryTracker::WriteJson(const std::string& file_name) const {
+		std::ofstream ofs(file_name, std::ios::out | std::ios::trunc);
+		WriteJson(ofs);
+		ofs.close();
+		if (!ofs) {
+			std::cerr << "ERROR WRITING MEMORY STATS '" << file_name << "'" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	void MemoryTracker::WriteJson(std::ostream& stream) const {
+		stream << "{\n";
+		stream << "\t\"tracking_allocations\": " << (IsTrackingAllocations() ? "true" : "false") << ",\n";
+
+		stream << "\t\"heap\": {\n\t\t\"total\": ";
+		WriteStats(stream, GetHeapTotal());
+		for (size_t tag{}; tag < kTagCount; ++tag) {
+			stream << ",\n\t\t\"" << GetName(static_cast<MemoryTag>(tag)) << "\": ";
+			WriteStats(stream, GetStats(static_cast<MemoryTag>(tag)));
+		}
+		stream << "\n\t},\n";
+
+		stream << "\t\"gpu\": {\n\t\t\"total\": ";
+		WriteStats(stream, GetGpuTotal());
+		for (size_t resource{}; resource < kResourceCount; ++resource) {
+			stream << ",\n\t\t\"" << GetName(static_cast<GpuResource>(resource)) << "\": ";
+			WriteStats(stream, GetStats(static_cast<GpuResource>(resource)));
+		}
+		stream << ",\n\t\t\"texture_formats\": {";
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			bool first{ true };
+			for (const auto& format : texture_formats_) {
+				const char *name = GetFormatName(format.first);
+				char unknown[16];
+				if (!name) {
+					std::snprintf(unknown, sizeof(unknown), "0x%04X", format.first);
+					name = unknown;
+				}
+				stream << (first ? "\n" : ",\n") << "\t\t\t\"" << name << "\": " << format.second;
+				first = false;
+			}
+			if (!first) stream << "\n\t\t";
+		}
+		stream << "}\n\t}\n}\n";
+	}
+}
+
+#if defined(NXT_TRACK_ALLOCATIONS)
+// every new and delete of the program goes through the tracker, the
+// replacements only have to be linked in once
+void* operator new(std::size_t size) {
+	void *memory = nxt::MemoryTracker::Allocate(size ? size : 1);
+	if (!memory) throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	return nxt::MemoryTracker::Allocate(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return nxt::MemoryTracker::Allocate(size ? size : 1);
+}
+
+void operator delete(void *memory) noexcept { nxt::MemoryTracker::Free(memory); }
+void operator delete[](void *memory) noexcept { nxt::MemoryTracker::Free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { nxt::MemoryTracker::Free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { nxt::MemoryTracker::Free(memory); }
+void operator delete(void *memory, const std::nothrow_t&) noexcept { nxt::MemoryTracker::Free(memory); }
+void operator delete[](void *memory, const std::nothrow_t&) noexcept { nxt::MemoryTracker::Free(memory); }
+#endif
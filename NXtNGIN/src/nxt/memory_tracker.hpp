@@ -0,0 +1,111 @@
+#ifndef MEMORY_TRACKER_HPP_
+#define MEMORY_TRACKER_HPP_
+
+#include <map>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <cstddef>
+
+#include <GL/glew.h>
+
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// the subsystem heap memory is counted against, see MemoryScope
+	enum class MemoryTag {
+		GENERAL,
+		MESH,
+		TEXTURE,
+		TEXT,
+		AUDIO,
+		FILESYSTEM,
+		COUNT
+	};
+
+	enum class GpuResource {
+		VERTEX_BUFFER,
+		INDEX_BUFFER,
+		PIXEL_BUFFER,
+		TEXTURE,
+		COUNT
+	};
+
+	struct MemoryStats {
+		size_t live_bytes;
+		size_t peak_bytes;
+		size_t live_count;
+		// allocations ever made and those made in the last complete frame
+		size_t total_count;
+		size_t frame_count;
+	};
+
+	// Counts memory per subsystem and video memory per kind of GL object.
+	//
+	// Heap memory is counted when the engine is built with
+	// NXT_TRACK_ALLOCATIONS: operator new and stb_image then allocate through
+	// Allocate, which keeps the size and the tag of the calling thread's
+	// innermost MemoryScope in front of each block. Without it the heap
+	// stats stay at zero and nothing is added to an allocation.
+	//
+	// Video memory is always counted, by the GL wrappers themselves. Sizes
+	// are what the storage needs, textures every level and layer in their
+	// internal format, not what the driver actually reserves.
+	class MemoryTracker : public NonCopyable, public NonMoveable {
+	public:
+		static MemoryTracker& Instance();
+
+		static const char* GetName(MemoryTag tag);
+		static const char* GetName(GpuResource resource);
+		static const char* GetFormatName(GLenum internal_format);
+		static bool IsTrackingAllocations();
+
+		// the tracked heap, blocks from Allocate must go back through Free
+		static void* Allocate(size_t bytes);
+		static void* Reallocate(void *memory, size_t bytes);
+		static void Free(void *memory);
+		// tag of the calling thread, Allocate counts against it
+		static MemoryTag GetCurrentTag();
+		// returns the tag it replaces
+		static MemoryTag SetCurrentTag(MemoryTag tag);
+
+		// bytes of a GL object in internal_format, 0 for buffers
+		void AddGpu(GpuResource resource, GLenum internal_format, size_t bytes);
+		void RemoveGpu(GpuResource resource, GLenum internal_format, size_t bytes);
+
+		// ends the frame the per-frame counts are taken over
+		void NextFrame();
+
+		MemoryStats GetStats(MemoryTag tag) const;
+		MemoryStats GetStats(GpuResource resource) const;
+		// sums over every tag and every resource, peaks are of the sum
+		MemoryStats GetHeapTotal() const;
+		MemoryStats GetGpuTotal() const;
+		// live texture bytes in internal_format
+		size_t GetTextureBytes(GLenum internal_format) const;
+
+		bool WriteJson(const std::string& file_name) const;
+		void WriteJson(std::ostream& stream) const;
+	private:
+		mutable std::mutex mutex_;
+		std::map<GLenum, size_t> texture_formats_;
+
+		MemoryTracker() = default;
+	};
+
+	// Counts the heap allocations of the calling thread against tag until it
+	// goes out of scope. Scopes nest, a job running on a worker opens its own.
+	class MemoryScope : public NonCopyable {
+	public:
+		explicit MemoryScope(MemoryTag tag) : previous_{ MemoryTracker::SetCurrentTag(tag) } {}
+		~MemoryScope() { MemoryTracker::SetCurrentTag(previous_); }
+	private:
+		MemoryTag previous_;
+	};
+}
+
+#endif // MEMORY_TRACKER_HPP_
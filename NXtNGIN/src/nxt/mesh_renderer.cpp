@@ -1,10 +1,43 @@
 #include "mesh_renderer.hpp"
 
 namespace nxt {
+	namespace {
+		constexpr std::uint32_t kCookedMagic{ 0x4D54584E }; // "NXTM"
+		constexpr std::uint32_t kCookedVersion{ 1 };
+
+		struct CookedHeader {
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t is_face_quad;
+			std::uint32_t reserved;
+			std::uint64_t face_count;
+			std::uint64_t vertex_count;
+			std::uint64_t index_count;
+			float bounds_min[3];
+			float bounds_max[3];
+		};
+	}
+
 	MeshRenderer::MeshRenderer(std::shared_ptr<Shader> shader) :
-		shader_{ shader }, loaded_{ false }, face_count_{} {}
+		face_count_{}, vertex_count_{}, index_count_{}, keep_geometry_{ false }, loaded_{ false }, shader_{ shader } {}
+
+	MeshRenderer::~MeshRenderer() {
+		ResidencyManager::Instance().Unregister(this);
+	}
+
+	MemorySize MeshRenderer::GetMemorySize() const {
+		return MemorySize{
+			vertices_.capacity() * sizeof(Vertex) + indices_.capacity() * sizeof(GLuint),
+			loaded_ ? vertex_count_ * sizeof(Vertex) + index_count_ * sizeof(GLuint) : 0 };
+	}
 
-	MeshRenderer::~MeshRenderer() {}
+	void MeshRenderer::Unload() {
+		va_.reset();
+		ib_.reset();
+		std::vector<Vertex>().swap(vertices_);
+		std::vector<GLuint>().swap(indices_);
+		loaded_ = false;
+	}
 
 	std::vector<GLuint> MeshRenderer::Split(
 		std::string value,
@@ -51,15 +84,41 @@ namespace nxt {
 
 	bool MeshRenderer::Load(
 		const std::string& filename,
-		bool is_face_quad) {
+		bool is_face_quad,
+		bool keep_geometry) {
+
+		MeshData data;
+		if (!Parse(filename, is_face_quad, data)) return false;
+		return Load(filename, std::move(data), keep_geometry);
+	}
+
+	bool MeshRenderer::Parse(
+		const std::string& filename,
+		bool is_face_quad,
+		MeshData& data,
+		bool use_cooked) {
+		MemoryScope scope{ MemoryTag::MESH };
+
+		const std::string cooked_file = use_cooked ? FindCooked(filename) : "";
+		if (!cooked_file.empty() && LoadCooked(cooked_file, is_face_quad, data)) return true;
 
-		is_face_quad_ = is_face_quad;
+		data = MeshData{};
+		data.is_face_quad = is_face_quad;
 		std::vector<size_t> vertex_indices, uv_indices, normal_indices;
 		std::vector<glm::fvec3> temp_vertices, temp_normals;
 		std::vector<glm::fvec2> temp_uvs;
 
 		if (filename.find(".obj") != std::string::npos) {
-			std::ifstream file_input(filename, std::ios::in);
+			// parsed in place when the file comes from a pack
+			const FileBufferPtr packed = FileSystem::Instance().GetBuffer(filename);
+			std::unique_ptr<std::istream> file_stream;
+			if (packed) {
+				file_stream.reset(new boost::interprocess::ibufferstream(packed->GetData(), packed->GetSize()));
+			}
+			else {
+				file_stream.reset(new std::ifstream(filename, std::ios::in));
+			}
+			std::istream& file_input = *file_stream;
 			if (!file_input) {
 				std::cerr << "CANNOT OPEN " << filename << std::endl;
 				return false;
@@ -93,8 +152,8 @@ namespace nxt {
 				}
 				else if (type_mesh == "f") {
 					std::vector<GLuint> face = Split(iss.str());
-					FaceType face_type = EvalSplitRes(face, is_face_quad_);
-					const size_t kVertPerFace = is_face_quad_ ? 4 : 3;
+					FaceType face_type = EvalSplitRes(face, is_face_quad);
+					const size_t kVertPerFace = is_face_quad ? 4 : 3;
 
 					if (face_type == FaceType::NOT_DEFINED) break;
 
@@ -121,10 +180,10 @@ namespace nxt {
 						return false;
 					}
 
-					++face_count_;
+					++data.face_count;
 				}
 			}
-			file_input.close();
+			file_stream.reset();
 
 			for (size_t i{ 0 }; i < vertex_indices.size(); i++) {
 				Vertex mesh_vertex;
@@ -142,57 +201,147 @@ namespace nxt {
 					mesh_vertex.tex_coords = uv;
 				}
 
-				vertices_.push_back(std::move(mesh_vertex));
+				data.vertices.push_back(std::move(mesh_vertex));
+			}
+
+			if (!temp_vertices.empty()) {
+				data.bounds_min = data.bounds_max = temp_vertices[0];
+				for (const glm::fvec3& vertex : temp_vertices) {
+					data.bounds_min = glm::min(data.bounds_min, vertex);
+					data.bounds_max = glm::max(data.bounds_max, vertex);
+				}
 			}
 
-			if (is_face_quad_) {
-				indices_ = { 0, 1, 2, 0, 2, 3 };
+			if (is_face_quad) {
+				data.indices = { 0, 1, 2, 0, 2, 3 };
 			}
 			else {
-				indices_ = { 0, 1, 2 };
+				data.indices = { 0, 1, 2 };
 			}
-			InitIndices();
-			InitBuffers();
-			return (loaded_ = true);
+			InitIndices(data.indices, data.face_count, is_face_quad);
+			return true;
 		}
 		return false;
 	}
 
-	void MeshRenderer::InitIndices() {
-		std::vector<GLuint>::iterator it{};
-		std::vector<GLuint> input{};
-
-		if (is_face_quad_) {
-			for (size_t i{ 1 }; i < face_count_; ++i) {
-				it = indices_.end();
-				input = {
-					*(it - 6) + kQuadStride,
-					*(it - 5) + kQuadStride,
-					*(it - 4) + kQuadStride,
-					*(it - 3) + kQuadStride,
-					*(it - 2) + kQuadStride,
-					*(it - 1) + kQuadStride
-				};
-
-				indices_.insert(
-					indices_.end(),
-					input.begin(),
-					input.end());
-			}
+	std::string MeshRenderer::GetCookedPath(const std::string& filename) {
+		return bf::path(filename).replace_extension(".nxtmesh").string();
+	}
+
+	std::string MeshRenderer::FindCooked(const std::string& filename) {
+		return FileSystem::Instance().FindCooked(filename, GetCookedPath(filename));
+	}
+
+	bool MeshRenderer::SaveCooked(const std::string& cooked_file, const MeshData& data) {
+		CookedHeader header{};
+		header.magic = kCookedMagic;
+		header.version = kCookedVersion;
+		header.is_face_quad = data.is_face_quad ? 1u : 0u;
+		header.face_count = data.face_count;
+		header.vertex_count = data.vertices.size();
+		header.index_count = data.indices.size();
+		for (int i{}; i < 3; ++i) {
+			header.bounds_min[i] = data.bounds_min[i];
+			header.bounds_max[i] = data.bounds_max[i];
+		}
+
+		std::ofstream ofs(cooked_file, std::ios::out | std::ios::binary | std::ios::trunc);
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		ofs.write(reinterpret_cast<const char*>(data.vertices.data()), static_cast<std::streamsize>(data.vertices.size() * sizeof(Vertex)));
+		ofs.write(reinterpret_cast<const char*>(data.indices.data()), static_cast<std::streamsize>(data.indices.size() * sizeof(GLuint)));
+		ofs.close();
+		if (!ofs) {
+			std::cerr << "ERROR WRITING COOKED MESH '" << cooked_file << "'" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool MeshRenderer::LoadCooked(const std::string& cooked_file, bool is_face_quad, MeshData& data) {
+		const FileBufferPtr packed = FileSystem::Instance().GetBuffer(cooked_file);
+		boost::string_view bytes;
+		std::string content;
+		if (packed) {
+			bytes = packed->GetView();
 		}
 		else {
-			for (size_t i{ 1 }; i < face_count_; ++i) {
-				it = indices_.end();
-				input = {
-					*(it - 3) + kTriangleStride,
-					*(it - 2) + kTriangleStride,
-					*(it - 1) + kTriangleStride
-				};
-
-				indices_.insert(
-					indices_.end(),
-					input.begin(),
-					input.end());
+			content = FileSystem::Instance().GetContent(bf::path(cooked_file));
+			bytes = content;
+		}
+
+		CookedHeader header{};
+		if (bytes.size() >= sizeof(header)) std::memcpy(&header, bytes.data(), sizeof(header));
+		const std::uint64_t vertex_bytes = header.vertex_count * sizeof(Vertex);
+		const std::uint64_t index_bytes = header.index_count * sizeof(GLuint);
+		if (bytes.size() < sizeof(header) || header.magic != kCookedMagic || header.version != kCookedVersion ||
+			sizeof(header) + vertex_bytes + index_bytes != bytes.size()) {
+			std::cerr << "INVALID COOKED MESH '" << cooked_file << "'" << std::endl;
+			return false;
+		}
+		if ((header.is_face_quad != 0) != is_face_quad) return false;
+
+		data = MeshData{};
+		data.is_face_quad = is_face_quad;
+		data.face_count = static_cast<size_t>(header.face_count);
+		data.bounds_min = glm::fvec3{ header.bounds_min[0], header.bounds_min[1], header.bounds_min[2] };
+		data.bounds_max = glm::fvec3{ header.bounds_max[0], header.bounds_max[1], header.bounds_max[2] };
+		data.vertices.resize(static_cast<size_t>(header.vertex_count));
+		data.indices.resize(static_cast<size_t>(header.index_count));
+		std::memcpy(data.vertices.data(), bytes.data() + sizeof(header), static_cast<size_t>(vertex_bytes));
+		std::memcpy(data.indices.data(), bytes.data() + sizeof(header) + vertex_bytes, static_cast<size_t>(index_bytes));
+		return true;
+	}
+
+	bool MeshRenderer::Load(
+		const std::string& filename,
+		MeshData data,
+		bool keep_geometry) {
+		MemoryScope scope{ MemoryTag::MESH };
+
+		if (data.vertices.empty() || data.indices.empty()) return false;
+		vertices_ = std::move(data.vertices);
+		indices_ = std::move(data.indices);
+		bounds_min_ = data.bounds_min;
+		bounds_max_ = data.bounds_max;
+		face_count_ = data.face_count;
+		is_face_quad_ = data.is_face_quad;
+		keep_geometry_ = keep_geometry;
+
+		InitBuffers();
+		vertex_count_ = vertices_.size();
+		index_count_ = indices_.size();
+		if (!keep_geometry_) {
+			std::vector<Vertex>().swap(vertices_);
+			std::vector<GLuint>().swap(indices_);
+		}
+		loaded_ = true;
+
+		filename_ = filename;
+		ResidencyManager::Instance().Register(
+			this,
+			ResourceType::MESH,
+			[this]() { return GetMemorySize(); },
+			[this]() { Unload(); return true; },
+			[this]() { return Load(filename_, is_face_quad_, keep_geometry_); });
+		return true;
+	}
+
+	void MeshRenderer::InitIndices(
+		std::vector<GLuint>& indices,
+		size_t face_count,
+		bool is_face_quad) {
+
+		// each face repeats the one before it, shifted by a face's vertices
+		const size_t face_size = is_face_quad ? 6 : 3;
+		const GLuint stride = is_face_quad ? GLuint{ kQuadStride } : GLuint{ kTriangleStride };
+		if (face_count < 2 || indices.size() < face_size) return;
+
+		// reserved up front, so appending never invalidates what is read
+		indices.reserve(indices.size() + (face_count - 1) * face_size);
+		for (size_t i{ 1 }; i < face_count; ++i) {
+			const size_t previous = indices.size() - face_size;
+			for (size_t j{}; j < face_size; ++j) {
+				indices.push_back(indices[previous + j] + stride);
 			}
 		}
 	}
@@ -220,8 +369,8 @@ namespace nxt {
 
 	void MeshRenderer::Draw(
 		GLsizei count,
-		std::shared_ptr<Shader> shader) const {
-		if (!loaded_) return;
+		std::shared_ptr<Shader> shader) {
+		if (!ResidencyManager::Instance().Touch(this) || !loaded_) return;
 		if (shader.get() != nullptr) {
 			Renderer::Render(*va_, *ib_, *shader, count);
 		}
@@ -9,11 +9,18 @@
 #include <utility>
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include <boost/interprocess/streams/bufferstream.hpp>
+
 #include "renderer.hpp"
+#include "residency_manager.hpp"
+#include "filesystem.hpp"
+#include "memory_tracker.hpp"
 
 namespace nxt {
 	struct Vertex {
@@ -29,16 +36,33 @@ namespace nxt {
 		NOT_DEFINED
 	};
 
+	// an OBJ file parsed without touching GL, see MeshRenderer::Parse
+	struct MeshData {
+		std::vector<Vertex> vertices;
+		std::vector<GLuint> indices;
+		glm::fvec3 bounds_min;
+		glm::fvec3 bounds_max;
+		size_t face_count;
+		bool is_face_quad;
+	};
+
 	class MeshRenderer {
 	private:
 		static constexpr GLuint kVerticesPerQuad{ 6 };
 		static constexpr GLuint kTriangleStride{ 3 };
 		static constexpr GLuint kQuadStride{ 4 };
 
+		// only kept after upload with keep_geometry
 		std::vector<Vertex> vertices_;
 		std::vector<GLuint> indices_;
+		std::string filename_;
 		size_t face_count_;
+		size_t vertex_count_;
+		size_t index_count_;
+		glm::fvec3 bounds_min_{};
+		glm::fvec3 bounds_max_{};
 		bool is_face_quad_;
+		bool keep_geometry_;
 		bool loaded_;
 
 		std::shared_ptr<Shader> shader_;
@@ -51,18 +75,54 @@ namespace nxt {
 		static std::vector<GLuint> Split(
 			std::string value,
 			char delimiter = '/');
-		void InitIndices();
+		static void InitIndices(
+			std::vector<GLuint>& indices,
+			size_t face_count,
+			bool is_face_quad);
 		void InitBuffers();
+		void Unload();
 	public:
 		MeshRenderer(std::shared_ptr<Shader>);
 		~MeshRenderer();
 
+		// the vertices and indices are dropped once uploaded unless
+		// keep_geometry is set; evicted meshes are read again on their next Draw
 		bool Load(
 			const std::string& filename,
-			bool is_face_quad = true);
+			bool is_face_quad = true,
+			bool keep_geometry = false);
+		// the file work of Load, safe on any thread; reads the cooked
+		// .nxtmesh next to filename instead of the OBJ when there is one
+		// and use_cooked is set
+		static bool Parse(
+			const std::string& filename,
+			bool is_face_quad,
+			MeshData& data,
+			bool use_cooked = true);
+		// binary MeshData as written by nxt_cook
+		static std::string GetCookedPath(const std::string& filename);
+		// GetCookedPath when that file exists and is no older than the source,
+		// otherwise empty
+		static std::string FindCooked(const std::string& filename);
+		static bool SaveCooked(const std::string& cooked_file, const MeshData& data);
+		// false when the file is damaged or was cooked with the other face type
+		static bool LoadCooked(const std::string& cooked_file, bool is_face_quad, MeshData& data);
+		// the upload left after Parse, filename is read again after an eviction
+		bool Load(
+			const std::string& filename,
+			MeshData data,
+			bool keep_geometry = false);
 		void Draw(
 			GLsizei count = 1,
-			std::shared_ptr<Shader> shader = std::shared_ptr<Shader>{ nullptr }) const;
+			std::shared_ptr<Shader> shader = std::shared_ptr<Shader>{ nullptr });
+
+		const std::vector<Vertex>& GetVertices() const { return vertices_; }
+		const std::vector<GLuint>& GetIndices() const { return indices_; }
+		MemorySize GetMemorySize() const;
+
+		// bounding sphere of the loaded vertices in model space
+		glm::fvec3 GetBoundsCenter() const { return (bounds_min_ + bounds_max_) * 0.5f; }
+		float GetBoundsRadius() const { return glm::length(bounds_max_ - bounds_min_) * 0.5f; }
 	};
 }
 
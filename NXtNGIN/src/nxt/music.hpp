@@ -2,17 +2,25 @@
 #define MUSIC_HPP_
 
 #include "audio.hpp"
+#include "music_stream.hpp"
 
 namespace nxt {
+	// A long track played from a MusicStream, decoded ahead on a thread of
+	// its own while it plays.
 	class Music final : public Audio {
 	public:
 		Music() {
-			handle_ = std::unique_ptr<sf::Music>(new sf::Music());
+			handle_ = std::unique_ptr<MusicStream>(new MusicStream());
+			// not positional, AudioScene places sounds in the world
+			handle_->setRelativeToListener(true);
 		}
 
-		bool Open(const std::string& file) final override { return (handle_->openFromFile(file)); }
+		// packed music streams straight from the mapping, keep the pack mounted while it plays
+		bool Open(const std::string& file) final override { return (handle_->Open(file)); }
+		// from the start, the stop rewinds the reader unless it is there already
 		void Play(bool loop) final override {
-			handle_->setLoop(loop);
+			handle_->stop();
+			handle_->SetLoop(loop);
 			handle_->play();
 		}
 		void Stop() final override { handle_->stop(); }
@@ -22,7 +30,7 @@ namespace nxt {
 		void Pitch(float pitch) final override { handle_->setPitch(pitch); }
 
 	private:
-		std::unique_ptr<sf::Music> handle_;
+		std::unique_ptr<MusicStream> handle_;
 
 	};
 }
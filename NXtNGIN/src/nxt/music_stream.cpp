@@ -0,0 +1,178 @@
+#include "music_stream.hpp"
+
+namespace nxt {
+	constexpr std::chrono::milliseconds MusicStream::kMaxWait;
+
+	MusicStream::MusicStream() :
+		read_{ 0 },
+		count_{ 0 },
+		chunk_size_{ 0 },
+		samples_per_second_{ 0 },
+		duration_{ 0.0f },
+		seek_generation_{ 0 },
+		seek_pending_{ false },
+		rewound_{ false },
+		end_{ true },
+		stop_{ false },
+		loop_{ false },
+		underrun_count_{ 0 } {}
+
+	MusicStream::~MusicStream() {
+		// the streaming thread calls into this class, it has to end first
+		Close();
+	}
+
+	bool MusicStream::Open(const std::string& file) {
+		MemoryScope scope{ MemoryTag::AUDIO };
+		Close();
+		packed_ = FileSystem::Instance().GetBuffer(file);
+		const bool opened = packed_ ?
+			file_.openFromMemory(packed_->GetData(), packed_->GetSize()) :
+			file_.openFromFile(file);
+		if (!opened || file_.getSampleCount() == 0) {
+			std::cerr << "ERROR OPENING MUSIC '" << file << "'" << std::endl;
+			return false;
+		}
+
+		const unsigned int channel_count = file_.getChannelCount();
+		samples_per_second_ = static_cast<size_t>(file_.getSampleRate()) * channel_count;
+		duration_ = file_.getDuration().asSeconds();
+		// whole frames, so a chunk never splits the channels of a sample
+		const size_t frames = std::max(static_cast<size_t>(file_.getSampleRate() * kChunkSeconds), size_t{ 1 });
+		chunk_size_ = frames * channel_count;
+		const size_t chunk_count = std::max(static_cast<size_t>(kPrefetchSeconds / kChunkSeconds), size_t{ 2 });
+		ring_.assign(chunk_size_ * chunk_count, 0);
+		decoded_.assign(chunk_size_, 0);
+		chunk_.reserve(chunk_size_);
+		read_ = 0;
+		count_ = 0;
+		seek_pending_ = false;
+		rewound_ = true;
+		end_ = false;
+		stop_ = false;
+		initialize(channel_count, file_.getSampleRate());
+
+		// starts filling right away, a Play after Open finds the ring full
+		reader_ = std::thread(&MusicStream::ReadLoop, this);
+		return true;
+	}
+
+	void MusicStream::Close() {
+		stop();
+		if (!reader_.joinable()) return;
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			stop_ = true;
+		}
+		condition_.notify_all();
+		reader_.join();
+		reader_ = std::thread();
+		count_ = 0;
+		rewound_ = false;
+		end_ = true;
+	}
+
+	void MusicStream::SetLoop(bool loop) {
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			loop_ = loop;
+			// a reader that stopped at the end wraps around now
+			if (loop && !stop_) end_ = false;
+		}
+		condition_.notify_one();
+	}
+
+	float MusicStream::GetBufferedSeconds() const {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		return samples_per_second_ ? static_cast<float>(count_) / samples_per_second_ : 0.0f;
+	}
+
+	void MusicStream::Push(const sf::Int16 *samples, size_t count) {
+		// the reader only decodes a chunk when there is room for it
+		const size_t write = (read_ + count_) % ring_.size();
+		const size_t first = std::min(count, ring_.size() - write);
+		std::copy(samples, samples + first, ring_.begin() + write);
+		std::copy(samples + first, samples + count, ring_.begin());
+		count_ += count;
+	}
+
+	void MusicStream::ReadLoop() {
+		for (;;) {
+			std::uint64_t generation;
+			bool seek;
+			sf::Time offset;
+			{
+				std::unique_lock<std::mutex> lock{ mutex_ };
+				condition_.wait(lock, [this]() {
+					return stop_ || seek_pending_ || (!end_ && ring_.size() - count_ >= chunk_size_);
+				});
+				if (stop_) return;
+				seek = seek_pending_;
+				offset = seek_offset_;
+				seek_pending_ = false;
+				generation = seek_generation_;
+			}
+
+			// decoded outside the lock, the streaming thread keeps reading meanwhile
+			if (seek) file_.seek(offset);
+			size_t count = static_cast<size_t>(file_.read(decoded_.data(), chunk_size_));
+			bool end = count < chunk_size_;
+			if (end && loop_) {
+				// the rest of the chunk comes from the start on the next pass
+				file_.seek(sf::Time::Zero);
+				end = false;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex_ };
+				// a seek came in while decoding
+				if (generation != seek_generation_) continue;
+				Push(decoded_.data(), count);
+				end_ = end;
+			}
+			filled_.notify_all();
+		}
+	}
+
+	bool MusicStream::onGetData(Chunk& data) {
+		std::unique_lock<std::mutex> lock{ mutex_ };
+		if (count_ == 0 && !end_ && !filled_.wait_for(lock, kMaxWait, [this]() { return count_ > 0 || end_; })) {
+			++underrun_count_;
+			chunk_.assign(chunk_size_, 0);
+			data.samples = chunk_.data();
+			data.sampleCount = chunk_.size();
+			return true;
+		}
+		if (count_ == 0) return false;
+
+		const size_t count = std::min(count_, chunk_size_);
+		const size_t first = std::min(count, ring_.size() - read_);
+		chunk_.assign(ring_.begin() + read_, ring_.begin() + read_ + first);
+		chunk_.insert(chunk_.end(), ring_.begin(), ring_.begin() + (count - first));
+		read_ = (read_ + count) % ring_.size();
+		count_ -= count;
+		rewound_ = false;
+		lock.unlock();
+		condition_.notify_one();
+
+		data.samples = chunk_.data();
+		data.sampleCount = chunk_.size();
+		return true;
+	}
+
+	void MusicStream::onSeek(sf::Time offset) {
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			// every stop rewinds, what was read ahead is kept when it is still right
+			if (offset == sf::Time::Zero && rewound_) return;
+			rewound_ = offset == sf::Time::Zero;
+			read_ = 0;
+			count_ = 0;
+			end_ = false;
+			seek_offset_ = offset;
+			seek_pending_ = true;
+			++seek_generation_;
+		}
+		condition_.notify_one();
+	}
+}
@@ -0,0 +1,92 @@
+#ifndef MUSIC_STREAM_HPP_
+#define MUSIC_STREAM_HPP_
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+#include <condition_variable>
+
+#include <SFML/Audio.hpp>
+
+#include "filesystem.hpp"
+#include "memory_tracker.hpp"
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// A long track decoded ahead of playback. A reader thread of its own
+	// keeps up to kPrefetchSeconds of samples in a ring buffer, and SFML's
+	// streaming thread only copies out of it, so neither the main loop nor
+	// the mixer ever waits on the disk or on the decoder. The one wait is
+	// right after a seek, and then on the streaming thread for at most
+	// kMaxWait before silence is played and counted as an underrun.
+	//
+	// Loop with SetLoop: the reader wraps around itself so the loop point
+	// is seamless. sf::SoundStream::setLoop would refill from a seek.
+	class MusicStream final : public sf::SoundStream, public NonCopyable, public NonMoveable {
+	public:
+		// handed to SFML at a time
+		static constexpr float kChunkSeconds{ 0.25f };
+		static constexpr float kPrefetchSeconds{ 2.0f };
+		static constexpr std::chrono::milliseconds kMaxWait{ 100 };
+
+		MusicStream();
+		~MusicStream();
+
+		// packed files are decoded straight from the mapping, keep the pack
+		// mounted while it plays
+		bool Open(const std::string& file);
+		void Close();
+
+		void SetLoop(bool loop);
+		bool GetLoop() const { return loop_; }
+		float GetDuration() const { return duration_; }
+		// decoded and not played yet
+		float GetBufferedSeconds() const;
+		size_t GetUnderrunCount() const { return underrun_count_; }
+	private:
+		// what file_ decodes from when the track is packed or read ahead,
+		// declared first so it outlives file_
+		FileBufferPtr packed_;
+		sf::InputSoundFile file_;
+		std::thread reader_;
+		mutable std::mutex mutex_;
+		// wakes the reader on free space, a seek or Close
+		std::condition_variable condition_;
+		// wakes the streaming thread on new samples
+		std::condition_variable filled_;
+		std::vector<sf::Int16> ring_;
+		size_t read_;
+		size_t count_;
+		// reader thread only
+		std::vector<sf::Int16> decoded_;
+		// what SFML plays from until the next onGetData
+		std::vector<sf::Int16> chunk_;
+		size_t chunk_size_;
+		size_t samples_per_second_;
+		float duration_;
+		// samples read before the last seek are dropped
+		std::uint64_t seek_generation_;
+		sf::Time seek_offset_;
+		bool seek_pending_;
+		// the ring holds the track from its start and none of it was played
+		bool rewound_;
+		bool end_;
+		bool stop_;
+		std::atomic<bool> loop_;
+		std::atomic<size_t> underrun_count_;
+
+		bool onGetData(Chunk& data) final override;
+		void onSeek(sf::Time offset) final override;
+		void ReadLoop();
+		void Push(const sf::Int16 *samples, size_t count);
+	};
+}
+
+#endif // MUSIC_STREAM_HPP_
@@ -7,15 +7,27 @@ namespace nxt {
 		std::shared_ptr<SpriteRenderer> p_sprite_renderer,
 		const glm::fvec2 &context_dimensions) :
 		p_sprite_renderer_{ p_sprite_renderer },
-		context_dimensions_{ context_dimensions }{}
+		context_dimensions_{ context_dimensions },
+		mode_{ ParallaxMode::SPRITES },
+		drawn_layers_{} {}
 
 	ParallaxRenderer::~ParallaxRenderer() {}
 
 	void ParallaxRenderer::Init(
 		const std::shared_ptr<Shader> &p_shader,
-		std::vector<std::string> image_path_list) {
+		std::vector<std::string> image_path_list,
+		ParallaxMode mode) {
+		mode_ = mode;
+		if (mode_ == ParallaxMode::TEXTURE_ARRAY) {
+			p_shader_ = p_shader;
+			p_layer_array_ = std::make_shared<Texture2D>(p_shader_);
+			p_layer_array_->LoadArray(image_path_list, true, &v_opaque_layers_);
+			InitArrayRenderData();
+			return;
+		}
+
 		for (const std::string &path : image_path_list) {
-			v_texture_list_.push_back(std::move(std::make_shared<Texture2D>(p_shader, path)));
+			v_texture_list_.push_back(ResourceManager::ShareTexture(p_shader, path));
 		}
 	}
 
@@ -23,6 +35,18 @@ namespace nxt {
 		float perspective_coefficient,
 		const glm::fvec2 &actor_pos) {
 		perspective_coefficient = glm::clamp<float>(perspective_coefficient, 0.0f, kMaxParallaxCoefficient);
+
+		if (mode_ == ParallaxMode::TEXTURE_ARRAY) {
+			DrawArray(perspective_coefficient, actor_pos);
+		}
+		else {
+			DrawSprites(perspective_coefficient, actor_pos);
+		}
+	}
+
+	void ParallaxRenderer::DrawSprites(
+		float perspective_coefficient,
+		const glm::fvec2 &actor_pos) {
 		float delta_perspective = perspective_coefficient / v_texture_list_.size();
 		perspective_coefficient = 0.0f;
 		glm::vec2 screen_pos{};
@@ -37,6 +61,68 @@ namespace nxt {
 				context_dimensions_ * (perspective_coefficient + 1.0f));
 			perspective_coefficient += delta_perspective;
 		}
+		drawn_layers_ = v_texture_list_.size();
+	}
+
+	void ParallaxRenderer::DrawArray(
+		float perspective_coefficient,
+		const glm::fvec2 &actor_pos) {
+		const size_t layer_count = static_cast<size_t>(p_layer_array_->GetLayerCount());
+		if (layer_count == 0) return;
+		float delta_perspective = perspective_coefficient / layer_count;
+
+		// layers wrap horizontally, so an opaque layer hides everything behind
+		// it as soon as it spans the screen vertically
+		size_t first_layer{};
+		for (size_t i{ layer_count }; i-- > 0;) {
+			if (!v_opaque_layers_[i]) continue;
+			float coefficient = delta_perspective * i;
+			float top = -coefficient * actor_pos.y;
+			float bottom = top + context_dimensions_.y * (coefficient + 1.0f);
+			if (top <= 0.0f && bottom >= context_dimensions_.y) {
+				first_layer = i;
+				break;
+			}
+		}
+
+		p_shader_->SetVec2("actor_pos", actor_pos);
+		p_shader_->SetFloat("delta_perspective", delta_perspective);
+		p_shader_->SetInt("first_layer", static_cast<GLint>(first_layer));
+
+		p_layer_array_->BindUnit(0);
+		Renderer::Render(*p_va_, *p_ib_, *p_shader_, static_cast<GLsizei>(layer_count - first_layer));
+		p_layer_array_->Unbind(0);
+		drawn_layers_ = layer_count - first_layer;
+	}
+
+	void ParallaxRenderer::InitArrayRenderData() {
+		// unit quad stretched over the screen in the vertex shader
+		std::vector<GLfloat> vertices{
+			1.0f, 0.0f,
+			0.0f, 0.0f,
+			0.0f, 1.0f,
+			1.0f, 1.0f,
+		};
+		std::vector<GLuint> indices{ 0, 1, 2, 0, 2, 3 };
+		VertexBuffer vb{
+			reinterpret_cast<const GLvoid*>(vertices.data()),
+			static_cast<GLuint>(sizeof(GLfloat)) * static_cast<GLuint>(vertices.size())
+		};
+		VertexBufferLayout vbl{};
+		vbl.Push<GLfloat>(2);
+		p_va_ = std::make_shared<VertexArray>(vb, vbl);
+		p_ib_ = std::make_shared<IndexBuffer>(indices.data(), static_cast<GLuint>(indices.size()));
+		p_ib_->Unbind();
+		vb.Unbind();
+		p_va_->Unbind();
 
+		projection_ = glm::ortho<float>(
+			0.0f,
+			context_dimensions_.x,
+			context_dimensions_.y,
+			0.0f);
+		p_shader_->SetMat4("projection", projection_);
+		p_shader_->SetVec2("context_dimensions", context_dimensions_);
+		p_shader_->SetInt("layer_sampler", 0);
 	}
 } // namespace nxt
@@ -2,8 +2,14 @@
 #define PARALLAX_RENDERER_HPP_
 
 #include "sprite_renderer.hpp"
+#include "resource_manager.hpp"
 
 namespace nxt {
+	enum class ParallaxMode {
+		SPRITES,       // one SpriteRenderer draw per layer
+		TEXTURE_ARRAY  // all visible layers in one instanced draw, wrapping horizontally
+	};
+
 	class ParallaxRenderer {
 	public:
 		ParallaxRenderer(
@@ -11,18 +17,38 @@ namespace nxt {
 			const glm::fvec2 &context_dimensions);
 		~ParallaxRenderer();
 
+		// layers are ordered back to front, in TEXTURE_ARRAY mode p_shader
+		// has to be the parallax shader and all layers must share one size
 		void Init(
 			const std::shared_ptr<Shader> &p_shader,
-			std::vector<std::string> image_path_list);
+			std::vector<std::string> image_path_list,
+			ParallaxMode mode = ParallaxMode::SPRITES);
 
 		void Draw(
 			float perspective_coefficient,
 			const glm::fvec2 &actor_pos);
+
+		// layers drawn by the last Draw call, hidden ones are skipped
+		size_t GetDrawnLayerCount() const { return drawn_layers_; }
 	private:
 		std::shared_ptr<SpriteRenderer> p_sprite_renderer_;
 		std::vector<std::shared_ptr<Texture2D>> v_texture_list_;
 		glm::fvec2 context_dimensions_;
+		ParallaxMode mode_;
+		size_t drawn_layers_;
 		static float kMaxParallaxCoefficient;
+
+		// TEXTURE_ARRAY mode
+		std::shared_ptr<Shader> p_shader_;
+		std::shared_ptr<Texture2D> p_layer_array_;
+		std::shared_ptr<VertexArray> p_va_;
+		std::shared_ptr<IndexBuffer> p_ib_;
+		std::vector<bool> v_opaque_layers_;
+		glm::fmat4 projection_;
+
+		void InitArrayRenderData();
+		void DrawSprites(float perspective_coefficient, const glm::fvec2 &actor_pos);
+		void DrawArray(float perspective_coefficient, const glm::fvec2 &actor_pos);
 	};
 }
 
@@ -0,0 +1,278 @@
+#include "particle_system.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define NXT_PARTICLE_AVX
+#define NXT_PARTICLE_SSE
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define NXT_PARTICLE_SSE
+#endif
+
+namespace nxt {
+	static_assert(sizeof(ParticleInstance) == 4 * sizeof(GLfloat), "ParticleInstance must be tightly packed");
+
+	namespace {
+		template <typename T>
+		T SampleCurve(const std::vector<std::pair<GLfloat, T>> &keys, GLfloat t) {
+			if (t <= keys.front().first) return keys.front().second;
+			for (size_t i{ 1 }; i < keys.size(); ++i) {
+				if (t <= keys[i].first) {
+					const GLfloat span = keys[i].first - keys[i - 1].first;
+					const GLfloat weight = span > 0.0f ? (t - keys[i - 1].first) / span : 1.0f;
+					return keys[i - 1].second + (keys[i].second - keys[i - 1].second) * weight;
+				}
+			}
+			return keys.back().second;
+		}
+
+		std::uint32_t PackColor(const glm::fvec4 &color) {
+			const glm::fvec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+			return static_cast<std::uint32_t>(c.r)
+				| (static_cast<std::uint32_t>(c.g) << 8)
+				| (static_cast<std::uint32_t>(c.b) << 16)
+				| (static_cast<std::uint32_t>(c.a) << 24);
+		}
+	}
+
+	ParticleSystem::ParticleSystem(
+		const std::shared_ptr<Shader> &shader,
+		const GLfloat &width,
+		const GLfloat &height,
+		const std::shared_ptr<Texture2D> &texture,
+		size_t capacity) :
+		indices_{ 0, 1, 2, 0, 2, 3 },
+		gravity_{},
+		capacity_{ std::max<size_t>(capacity, 1) },
+		count_{},
+		thread_threshold_{ 4 * kBatchSize },
+		shader_{ shader },
+		texture_{ texture } {
+		projection_ = glm::ortho<float>(
+			0.0f,
+			width,
+			height,
+			0.0f);
+
+		// padded to whole simd blocks
+		const size_t padded = (capacity_ + 7) & ~static_cast<size_t>(7);
+		position_x_.resize(padded);
+		position_y_.resize(padded);
+		velocity_x_.resize(padded);
+		velocity_y_.resize(padded);
+		age_.resize(padded);
+		inverse_lifetime_.resize(padded);
+		instances_.resize(capacity_);
+
+		SetColorCurve({ { 0.0f, glm::fvec4{ 1.0f } }, { 1.0f, glm::fvec4{ 1.0f, 1.0f, 1.0f, 0.0f } } });
+		SetSizeCurve({ { 0.0f, 8.0f }, { 1.0f, 8.0f } });
+
+		InitRenderData();
+		shader_->SetMat4("projection", projection_);
+		shader_->SetInt("image_sampler", 0);
+	}
+
+	ParticleSystem::~ParticleSystem() {}
+
+	size_t ParticleSystem::AddEmitter(const ParticleEmitter &emitter) {
+		emitters_.push_back(emitter);
+		spawn_debt_.push_back(0.0f);
+		return emitters_.size() - 1;
+	}
+
+	GLfloat ParticleSystem::Random(GLfloat variance) {
+		if (variance == 0.0f) return 0.0f;
+		std::uniform_real_distribution<GLfloat> distribution{ -variance, variance };
+		return distribution(random_);
+	}
+
+	void ParticleSystem::Emit(const ParticleEmitter &emitter, size_t count) {
+		count = std::min(count, capacity_ - count_);
+		for (size_t i{ count_ }; i < count_ + count; ++i) {
+			position_x_[i] = emitter.position.x + Random(emitter.position_variance.x);
+			position_y_[i] = emitter.position.y + Random(emitter.position_variance.y);
+			velocity_x_[i] = emitter.velocity.x + Random(emitter.velocity_variance.x);
+			velocity_y_[i] = emitter.velocity.y + Random(emitter.velocity_variance.y);
+			age_[i] = 0.0f;
+			inverse_lifetime_[i] = 1.0f / std::max(emitter.lifetime + Random(emitter.lifetime_variance), 0.001f);
+		}
+		count_ += count;
+	}
+
+	void ParticleSystem::SetColorCurve(const std::vector<std::pair<GLfloat, glm::fvec4>> &keys) {
+		assert(!keys.empty());
+		color_curve_.resize(kCurveSamples);
+		for (size_t i{}; i < kCurveSamples; ++i) {
+			color_curve_[i] = PackColor(SampleCurve(keys, static_cast<GLfloat>(i) / (kCurveSamples - 1)));
+		}
+	}
+
+	void ParticleSystem::SetSizeCurve(const std::vector<std::pair<GLfloat, GLfloat>> &keys) {
+		assert(!keys.empty());
+		size_curve_.resize(kCurveSamples);
+		for (size_t i{}; i < kCurveSamples; ++i) {
+			size_curve_[i] = SampleCurve(keys, static_cast<GLfloat>(i) / (kCurveSamples - 1));
+		}
+	}
+
+	void ParticleSystem::Update(GLfloat dt) {
+		ForEachRange([this, dt](size_t begin, size_t end) { Integrate(begin, end, dt); });
+		Kill();
+
+		for (size_t i{}; i < emitters_.size(); ++i) {
+			if (!emitters_[i].active || emitters_[i].rate <= 0.0f) continue;
+			spawn_debt_[i] += emitters_[i].rate * dt;
+			const size_t spawn = static_cast<size_t>(spawn_debt_[i]);
+			spawn_debt_[i] -= static_cast<GLfloat>(spawn);
+			Emit(emitters_[i], spawn);
+		}
+	}
+
+	// velocity, position and age of [begin, end), begin is a multiple of 8
+	void ParticleSystem::Integrate(size_t begin, size_t end, GLfloat dt) {
+		GLfloat *px = position_x_.data();
+		GLfloat *py = position_y_.data();
+		GLfloat *vx = velocity_x_.data();
+		GLfloat *vy = velocity_y_.data();
+		GLfloat *age = age_.data();
+		const glm::fvec2 dv = gravity_ * dt;
+		size_t i{ begin };
+
+#if defined(NXT_PARTICLE_AVX)
+		{
+			const __m256 dt8 = _mm256_set1_ps(dt);
+			const __m256 dvx8 = _mm256_set1_ps(dv.x);
+			const __m256 dvy8 = _mm256_set1_ps(dv.y);
+			for (; i + 8 <= end; i += 8) {
+				const __m256 new_vx = _mm256_add_ps(_mm256_load_ps(vx + i), dvx8);
+				const __m256 new_vy = _mm256_add_ps(_mm256_load_ps(vy + i), dvy8);
+				_mm256_store_ps(vx + i, new_vx);
+				_mm256_store_ps(vy + i, new_vy);
+				_mm256_store_ps(px + i, _mm256_add_ps(_mm256_load_ps(px + i), _mm256_mul_ps(new_vx, dt8)));
+				_mm256_store_ps(py + i, _mm256_add_ps(_mm256_load_ps(py + i), _mm256_mul_ps(new_vy, dt8)));
+				_mm256_store_ps(age + i, _mm256_add_ps(_mm256_load_ps(age + i), dt8));
+			}
+		}
+#endif
+#if defined(NXT_PARTICLE_SSE)
+		{
+			const __m128 dt4 = _mm_set1_ps(dt);
+			const __m128 dvx4 = _mm_set1_ps(dv.x);
+			const __m128 dvy4 = _mm_set1_ps(dv.y);
+			for (; i + 4 <= end; i += 4) {
+				const __m128 new_vx = _mm_add_ps(_mm_load_ps(vx + i), dvx4);
+				const __m128 new_vy = _mm_add_ps(_mm_load_ps(vy + i), dvy4);
+				_mm_store_ps(vx + i, new_vx);
+				_mm_store_ps(vy + i, new_vy);
+				_mm_store_ps(px + i, _mm_add_ps(_mm_load_ps(px + i), _mm_mul_ps(new_vx, dt4)));
+				_mm_store_ps(py + i, _mm_add_ps(_mm_load_ps(py + i), _mm_mul_ps(new_vy, dt4)));
+				_mm_store_ps(age + i, _mm_add_ps(_mm_load_ps(age + i), dt4));
+			}
+		}
+#endif
+		for (; i < end; ++i) {
+			vx[i] += dv.x;
+			vy[i] += dv.y;
+			px[i] += vx[i] * dt;
+			py[i] += vy[i] * dt;
+			age[i] += dt;
+		}
+	}
+
+	// swaps expired particles with the last live one, order is not preserved
+	void ParticleSystem::Kill() {
+		size_t i{};
+		while (i < count_) {
+			if (age_[i] * inverse_lifetime_[i] < 1.0f) {
+				++i;
+				continue;
+			}
+			--count_;
+			position_x_[i] = position_x_[count_];
+			position_y_[i] = position_y_[count_];
+			velocity_x_[i] = velocity_x_[count_];
+			velocity_y_[i] = velocity_y_[count_];
+			age_[i] = age_[count_];
+			inverse_lifetime_[i] = inverse_lifetime_[count_];
+		}
+	}
+
+	void ParticleSystem::FillInstances(size_t begin, size_t end) {
+		constexpr GLfloat kLastSample{ static_cast<GLfloat>(kCurveSamples - 1) };
+		for (size_t i{ begin }; i < end; ++i) {
+			const GLfloat t = std::min(age_[i] * inverse_lifetime_[i], 1.0f);
+			const size_t sample = static_cast<size_t>(t * kLastSample);
+			ParticleInstance &instance = instances_[i];
+			instance.position = glm::fvec2{ position_x_[i], position_y_[i] };
+			instance.size = size_curve_[sample];
+			instance.color = color_curve_[sample];
+		}
+	}
+
+	void ParticleSystem::ForEachRange(const std::function<void(size_t begin, size_t end)> &body) {
+		if (count_ < thread_threshold_) {
+			body(0, count_);
+			return;
+		}
+		// split on 8 particle blocks to keep every range simd aligned
+		const size_t count = count_;
+		ThreadPool::Instance().ParallelFor(
+			(count + 7) / 8,
+			kBatchSize / 8,
+			[&body, count](size_t begin, size_t end) { body(begin * 8, std::min(end * 8, count)); });
+	}
+
+	void ParticleSystem::Draw() {
+		if (count_ == 0) return;
+		ForEachRange([this](size_t begin, size_t end) { FillInstances(begin, end); });
+
+		instance_vb_->Bind();
+		// orphan last frame's store so the driver does not stall on pending draws
+		instance_vb_->BufferData(
+			nullptr,
+			static_cast<GLuint>(capacity_ * sizeof(ParticleInstance)),
+			DrawType::STREAM);
+		instance_vb_->BufferSubData(
+			reinterpret_cast<const GLvoid*>(instances_.data()),
+			static_cast<GLuint>(count_ * sizeof(ParticleInstance)));
+		instance_vb_->Unbind();
+
+		opengl::SetParticleMode();
+		texture_->BindUnit(0);
+		Renderer::Render(*va_, *ib_, *shader_, static_cast<GLsizei>(count_));
+		texture_->Unbind(0);
+		opengl::ResetParticleMode();
+		va_->Unbind();
+	}
+
+	void ParticleSystem::InitRenderData() {
+		constexpr GLubyte kNumberComponents{ 4 }; //position and texture coordinate
+		std::vector<GLfloat> vertices{
+			1.0f, 0.0f, 1.0f, 1.0f,
+			0.0f, 0.0f, 0.0f, 1.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			1.0f, 1.0f, 1.0f, 0.0f,
+		};
+		quad_vb_ = std::make_shared<VertexBuffer>(
+			reinterpret_cast<const GLvoid*>(vertices.data()),
+			static_cast<GLuint>(sizeof(GLfloat)) * static_cast<GLuint>(vertices.size()));
+		VertexBufferLayout vbl{};
+		vbl.Push<GLfloat>(kNumberComponents);
+		va_ = std::make_shared<VertexArray>(*quad_vb_, vbl);
+
+		instance_vb_ = std::make_shared<VertexBuffer>(
+			nullptr,
+			static_cast<GLuint>(capacity_ * sizeof(ParticleInstance)),
+			DrawType::STREAM);
+		// position and size, normalized color
+		VertexBufferLayout instance_layout{ 1 };
+		instance_layout.Push<GLfloat>(3);
+		instance_layout.Push<GLubyte>(4);
+		va_->AddBuffer(*instance_vb_, instance_layout);
+
+		ib_ = std::make_shared<IndexBuffer>(indices_.data(), static_cast<GLuint>(indices_.size()));
+		ib_->Unbind();
+		instance_vb_->Unbind();
+		va_->Unbind();
+	}
+}
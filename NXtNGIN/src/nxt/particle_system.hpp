@@ -0,0 +1,112 @@
+#ifndef PARTICLE_SYSTEM_HPP_
+#define PARTICLE_SYSTEM_HPP_
+
+#include <vector>
+#include <memory>
+#include <random>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <boost/align/aligned_allocator.hpp>
+
+#include "texture2d.hpp"
+#include "renderer.hpp"
+#include "thread_pool.hpp"
+#include "gl.hpp"
+
+namespace nxt {
+	struct ParticleEmitter {
+		glm::fvec2 position{};
+		glm::fvec2 position_variance{}; // half extents of the spawn area
+		glm::fvec2 velocity{};
+		glm::fvec2 velocity_variance{};
+		GLfloat lifetime{ 1.0f }; // seconds
+		GLfloat lifetime_variance{};
+		GLfloat rate{}; // particles per second, 0 only emits on Emit()
+		bool active{ true };
+	};
+
+	// per instance attributes, layout must match particle_vert_shader.glsl
+	struct ParticleInstance {
+		glm::fvec2 position;
+		GLfloat size;
+		std::uint32_t color; // RGBA8
+	};
+
+	class ParticleSystem {
+	public:
+		ParticleSystem(
+			const std::shared_ptr<Shader> &shader,
+			const GLfloat &width,
+			const GLfloat &height,
+			const std::shared_ptr<Texture2D> &texture,
+			size_t capacity);
+		~ParticleSystem();
+
+		size_t AddEmitter(const ParticleEmitter &emitter);
+		ParticleEmitter& GetEmitter(size_t index) { return emitters_[index]; }
+		// spawns count particles at once, drops what does not fit
+		void Emit(const ParticleEmitter &emitter, size_t count);
+
+		// keys are (normalized age, value) pairs sorted by age
+		void SetColorCurve(const std::vector<std::pair<GLfloat, glm::fvec4>> &keys);
+		void SetSizeCurve(const std::vector<std::pair<GLfloat, GLfloat>> &keys);
+		void SetGravity(const glm::fvec2 &gravity) { gravity_ = gravity; }
+		// particle count from which updates are spread across the thread pool
+		void SetThreadThreshold(size_t threshold) { thread_threshold_ = threshold; }
+
+		void Update(GLfloat dt);
+		void Draw();
+
+		size_t GetParticleCount() const { return count_; }
+		size_t GetCapacity() const { return capacity_; }
+	private:
+		using FloatArray = std::vector<GLfloat, boost::alignment::aligned_allocator<GLfloat, 32>>;
+		static constexpr size_t kCurveSamples{ 64 };
+		static constexpr size_t kBatchSize{ 16384 };
+
+		std::vector<GLuint> indices_;
+		glm::fmat4 projection_;
+		glm::fvec2 gravity_;
+		size_t capacity_;
+		size_t count_;
+		size_t thread_threshold_;
+
+		// particle state, one array per attribute
+		FloatArray position_x_;
+		FloatArray position_y_;
+		FloatArray velocity_x_;
+		FloatArray velocity_y_;
+		FloatArray age_;
+		FloatArray inverse_lifetime_;
+
+		std::vector<ParticleEmitter> emitters_;
+		std::vector<GLfloat> spawn_debt_;
+		std::minstd_rand random_;
+
+		// curves sampled over the normalized age
+		std::vector<std::uint32_t> color_curve_;
+		std::vector<GLfloat> size_curve_;
+
+		std::vector<ParticleInstance> instances_;
+		std::shared_ptr<Shader> shader_;
+		std::shared_ptr<Texture2D> texture_;
+		std::shared_ptr<IndexBuffer> ib_;
+		std::shared_ptr<VertexArray> va_;
+		std::shared_ptr<VertexBuffer> quad_vb_;
+		std::shared_ptr<VertexBuffer> instance_vb_;
+
+		void InitRenderData();
+		GLfloat Random(GLfloat variance);
+		void Integrate(size_t begin, size_t end, GLfloat dt);
+		void Kill();
+		void FillInstances(size_t begin, size_t end);
+		void ForEachRange(const std::function<void(size_t begin, size_t end)> &body);
+	};
+}
+
+#endif // PARTICLE_SYSTEM_HPP_
@@ -0,0 +1,83 @@
+#include "pixel_buffer_pool.hpp"
+
+namespace nxt {
+	bool IsFenceSignaled(GLsync fence) {
+		const GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		return (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED);
+	}
+
+	PixelBufferPool::PixelBufferPool(GLsizeiptr buffer_size, size_t buffer_count) :
+		buffer_size_{ buffer_size }, staged_{ buffer_count }, next_{},
+		buffers_(buffer_count, Buffer{ 0, nullptr }) {
+		for (Buffer& buffer : buffers_) {
+			glGenBuffers(1, &buffer.handle);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.handle);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, buffer_size_, nullptr, GL_STREAM_DRAW);
+			MemoryTracker::Instance().AddGpu(GpuResource::PIXEL_BUFFER, 0, static_cast<size_t>(buffer_size_));
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	PixelBufferPool::~PixelBufferPool() {
+		for (Buffer& buffer : buffers_) {
+			if (buffer.fence) glDeleteSync(buffer.fence);
+			glDeleteBuffers(1, &buffer.handle);
+			MemoryTracker::Instance().RemoveGpu(GpuResource::PIXEL_BUFFER, 0, static_cast<size_t>(buffer_size_));
+		}
+	}
+
+	bool PixelBufferPool::Stage(const void* data, GLsizeiptr size) {
+		assert(size <= buffer_size_);
+		assert(staged_ == buffers_.size());
+		Reclaim();
+
+		// round robin keeps the oldest upload the most likely to have finished
+		for (size_t i{}; i < buffers_.size(); ++i) {
+			const size_t index = (next_ + i) % buffers_.size();
+			Buffer& buffer = buffers_[index];
+			if (buffer.fence) continue;
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.handle);
+			void *mapped = glMapBufferRange(
+				GL_PIXEL_UNPACK_BUFFER,
+				0,
+				size,
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+			if (mapped == nullptr) {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				return false;
+			}
+			std::memcpy(mapped, data, static_cast<size_t>(size));
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+			staged_ = index;
+			next_ = (index + 1) % buffers_.size();
+			return true;
+		}
+		return false;
+	}
+
+	void PixelBufferPool::Submit() {
+		assert(staged_ < buffers_.size());
+		buffers_[staged_].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		staged_ = buffers_.size();
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	void PixelBufferPool::Reclaim() {
+		for (Buffer& buffer : buffers_) {
+			if (buffer.fence && IsFenceSignaled(buffer.fence)) {
+				glDeleteSync(buffer.fence);
+				buffer.fence = nullptr;
+			}
+		}
+	}
+
+	size_t PixelBufferPool::GetFreeCount() const {
+		size_t count{};
+		for (const Buffer& buffer : buffers_) {
+			if (!buffer.fence) ++count;
+		}
+		return count;
+	}
+}
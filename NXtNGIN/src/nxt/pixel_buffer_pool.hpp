@@ -0,0 +1,52 @@
+#ifndef PIXEL_BUFFER_POOL_HPP_
+#define PIXEL_BUFFER_POOL_HPP_
+
+#include <vector>
+#include <cstring>
+#include <cassert>
+
+#include <GL/glew.h>
+
+#include "memory_tracker.hpp"
+
+namespace nxt {
+	// Ring of pixel unpack buffers for asynchronous texture uploads. A staged
+	// buffer is reused only after the fence placed behind its upload signaled,
+	// so writing into it never waits for the GPU.
+	class PixelBufferPool {
+	public:
+		static constexpr GLsizeiptr kDefaultBufferSize{ 4 << 20 };
+
+		PixelBufferPool(GLsizeiptr buffer_size = kDefaultBufferSize, size_t buffer_count = 4);
+		~PixelBufferPool();
+
+		PixelBufferPool(const PixelBufferPool&) = delete;
+		PixelBufferPool& operator=(const PixelBufferPool&) = delete;
+
+		// copies size bytes into a free buffer and leaves it bound to
+		// GL_PIXEL_UNPACK_BUFFER, false when every buffer is still in flight
+		bool Stage(const void* data, GLsizeiptr size);
+		// fences the staged buffer behind the upload calls reading from it
+		void Submit();
+		// frees buffers whose uploads the GPU has finished
+		void Reclaim();
+
+		GLsizeiptr GetBufferSize() const { return buffer_size_; }
+		size_t GetFreeCount() const;
+	private:
+		struct Buffer {
+			GLuint handle;
+			GLsync fence;
+		};
+
+		GLsizeiptr buffer_size_;
+		size_t staged_;
+		size_t next_;
+		std::vector<Buffer> buffers_;
+	};
+
+	// true once the commands before the fence completed, does not block
+	bool IsFenceSignaled(GLsync fence);
+}
+
+#endif // PIXEL_BUFFER_POOL_HPP_
@@ -0,0 +1,100 @@
+#include "render_thread.hpp"
+
+namespace nxt {
+	constexpr std::chrono::milliseconds RenderThread::kJobPollInterval;
+
+	RenderThread& RenderThread::Instance() {
+		static std::unique_ptr<RenderThread> instance{ std::unique_ptr<RenderThread>(new RenderThread()) };
+		return *instance;
+	}
+
+	RenderThread::RenderThread() :
+		window_{ nullptr },
+		submitted_{ 0 },
+		completed_{ 0 },
+		stop_{ false },
+		execute_time_{ 0.0f },
+		wait_time_{ 0.0f } {}
+
+	void RenderThread::Start(GLFWwindow *window) {
+		if (IsRunning()) return;
+		window_ = window;
+		stop_ = false;
+		// a context is current on one thread at a time
+		glfwMakeContextCurrent(nullptr);
+		thread_ = std::thread(&RenderThread::RenderLoop, this);
+		jobs::Scheduler::Instance().SetContextThread(thread_.get_id());
+	}
+
+	void RenderThread::Stop() {
+		if (!IsRunning()) return;
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			stop_ = true;
+		}
+		condition_.notify_all();
+		thread_.join();
+		thread_ = std::thread();
+		glfwMakeContextCurrent(window_);
+		jobs::Scheduler::Instance().SetContextThread(std::this_thread::get_id());
+	}
+
+	void RenderThread::Submit() {
+		if (!IsRunning()) {
+			const auto begin = std::chrono::steady_clock::now();
+			GetCommandList().Execute();
+			execute_time_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			wait_time_ = 0.0f;
+			return;
+		}
+
+		const std::uint64_t frame = submitted_.load(std::memory_order_relaxed) + 1;
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			submitted_.store(frame, std::memory_order_release);
+		}
+		condition_.notify_all();
+
+		// the list of frame - 1 is recorded into next
+		const auto begin = std::chrono::steady_clock::now();
+		if (completed_.load(std::memory_order_acquire) + 1 < frame) {
+			std::unique_lock<std::mutex> lock{ mutex_ };
+			condition_.wait(lock, [this, frame]() { return completed_.load(std::memory_order_acquire) + 1 >= frame; });
+		}
+		wait_time_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	void RenderThread::RenderLoop() {
+		glfwMakeContextCurrent(window_);
+		for (;;) {
+			std::uint64_t frame = completed_.load(std::memory_order_relaxed);
+			bool stop{ false };
+			while (submitted_.load(std::memory_order_acquire) == frame) {
+				{
+					std::unique_lock<std::mutex> lock{ mutex_ };
+					const bool woken = condition_.wait_for(lock, kJobPollInterval, [this, frame]() {
+						return stop_ || submitted_.load(std::memory_order_acquire) != frame;
+					});
+					// frames submitted before Stop are still executed
+					stop = stop_ && submitted_.load(std::memory_order_acquire) == frame;
+					if (woken) break;
+				}
+				// the main thread may be waiting on GL jobs queued since the last frame
+				jobs::Scheduler::Instance().RunMainThreadJobs();
+			}
+			if (stop) break;
+
+			++frame;
+			const auto begin = std::chrono::steady_clock::now();
+			lists_[(frame - 1) % 2].Execute();
+			execute_time_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			{
+				std::lock_guard<std::mutex> lock{ mutex_ };
+				completed_.store(frame, std::memory_order_release);
+			}
+			condition_.notify_all();
+		}
+		glFinish();
+		glfwMakeContextCurrent(nullptr);
+	}
+}
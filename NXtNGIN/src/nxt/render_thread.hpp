@@ -0,0 +1,82 @@
+#ifndef RENDER_THREAD_HPP_
+#define RENDER_THREAD_HPP_
+
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "command_list.hpp"
+#include "jobs.hpp"
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// Runs the GL side of a frame on its own thread. The main thread records
+	// frame N + 1 into one CommandList while the render thread, which holds
+	// the context, executes frame N from the other. The lists are handed
+	// over by two frame counters under a mutex and a condition variable;
+	// either side only sleeps when the other one is a frame behind.
+	//
+	// Until Start and after Stop, Submit executes the frame on the calling
+	// thread, so an application records the same way in both modes. Once
+	// started, anything calling GL must be recorded. GL work queued with
+	// jobs::Scheduler::RunOnMainThread runs on the render thread, between
+	// frames too, so the main thread may wait on it. Events are still polled
+	// on the main thread.
+	class RenderThread : public NonCopyable, public NonMoveable {
+	public:
+		// how often an idle render thread looks for GL jobs
+		static constexpr std::chrono::milliseconds kJobPollInterval{ 1 };
+
+		static RenderThread& Instance();
+
+		RenderThread();
+		~RenderThread() { Stop(); }
+
+		// hands window's context, current on the calling thread, to a new
+		// render thread
+		void Start(GLFWwindow *window);
+		// waits for the frames in flight and makes the context current on
+		// the calling thread again
+		void Stop();
+		bool IsRunning() const { return thread_.joinable(); }
+		bool IsRenderThread() const { return std::this_thread::get_id() == thread_.get_id(); }
+
+		// the list of the frame being recorded, recording thread only
+		CommandList& GetCommandList() { return lists_[submitted_.load(std::memory_order_relaxed) % 2]; }
+		template <typename F>
+		void Record(F&& command) { GetCommandList().Record(std::forward<F>(command)); }
+
+		// ends the frame being recorded; returns once the frame before it is
+		// done, as its list is recorded into next
+		void Submit();
+
+		std::uint64_t GetFrameCount() const { return completed_; }
+		// milliseconds of the last frame executed and of the last wait in Submit
+		float GetExecuteTime() const { return execute_time_; }
+		float GetWaitTime() const { return wait_time_; }
+	private:
+		GLFWwindow *window_;
+		std::thread thread_;
+		CommandList lists_[2];
+		// frame N is recorded into lists_[(N - 1) % 2]
+		std::atomic<std::uint64_t> submitted_;
+		std::atomic<std::uint64_t> completed_;
+		std::atomic<bool> stop_;
+		std::atomic<float> execute_time_;
+		std::atomic<float> wait_time_;
+		std::mutex mutex_;
+		std::condition_variable condition_;
+
+		void RenderLoop();
+	};
+}
+
+#endif // RENDER_THREAD_HPP_
@@ -0,0 +1,146 @@
+#include "residency_manager.hpp"
+
+namespace nxt {
+	namespace {
+		const char* GetTypeName(ResourceType type) {
+			switch (type) {
+			case ResourceType::MESH: return "MESHES";
+			case ResourceType::TEXTURE: return "TEXTURES";
+			case ResourceType::FONT: return "FONTS";
+			default: return "UNKNOWN";
+			}
+		}
+
+		bool Fits(const MemorySize& size, const MemorySize& budget) {
+			return size.cpu_bytes <= budget.cpu_bytes && size.gpu_bytes <= budget.gpu_bytes;
+		}
+	}
+
+	ResidencyManager& ResidencyManager::Instance() {
+		static std::unique_ptr<ResidencyManager> instance{ std::unique_ptr<ResidencyManager>(new ResidencyManager()) };
+		return *instance;
+	}
+
+	ResidencyManager::ResidencyManager() : evictions_{}, reloads_{}, frame_{ 1 } {
+		budgets_[static_cast<size_t>(ResourceType::MESH)] = MemorySize{ 128u << 20, 256u << 20 };
+		budgets_[static_cast<size_t>(ResourceType::TEXTURE)] = MemorySize{ 128u << 20, 512u << 20 };
+		budgets_[static_cast<size_t>(ResourceType::FONT)] = MemorySize{ 16u << 20, 32u << 20 };
+	}
+
+	void ResidencyManager::Register(
+		const void* resource,
+		ResourceType type,
+		std::function<MemorySize()> get_size,
+		std::function<bool()> evict,
+		std::function<bool()> reload,
+		std::weak_ptr<const void> owner) {
+
+		Entry& entry = entries_[resource];
+		entry.type = type;
+		entry.size = get_size();
+		entry.last_used = frame_;
+		entry.resident = true;
+		entry.has_owner = !owner.expired();
+		entry.owner = std::move(owner);
+		entry.get_size = std::move(get_size);
+		entry.evict = std::move(evict);
+		entry.reload = std::move(reload);
+	}
+
+	void ResidencyManager::Unregister(const void* resource) {
+		entries_.erase(resource);
+	}
+
+	bool ResidencyManager::Touch(const void* resource) {
+		auto it = entries_.find(resource);
+		if (it == entries_.end()) return true;
+		it->second.last_used = frame_;
+		if (it->second.resident) return true;
+
+		// reload may register the resource again, look it up afterwards
+		const std::function<bool()> reload = it->second.reload;
+		const ResourceType type = it->second.type;
+		if (!reload()) return false;
+		++reloads_[static_cast<size_t>(type)];
+		it = entries_.find(resource);
+		if (it == entries_.end()) return true;
+		it->second.size = it->second.get_size();
+		it->second.last_used = frame_;
+		it->second.resident = true;
+		return true;
+	}
+
+	void ResidencyManager::Update() {
+		for (auto it = entries_.begin(); it != entries_.end();) {
+			if (it->second.has_owner && it->second.owner.expired()) it = entries_.erase(it);
+			else ++it;
+		}
+		for (size_t type{}; type < kTypeCount; ++type) {
+			Evict(static_cast<ResourceType>(type));
+		}
+		++frame_;
+	}
+
+	void ResidencyManager::Evict(ResourceType type) {
+		const MemorySize& budget = budgets_[static_cast<size_t>(type)];
+		MemorySize used = GetUsage(type).resident;
+		if (Fits(used, budget)) return;
+
+		// oldest first, whatever was used this frame stays
+		std::vector<std::pair<size_t, const void*>> candidates;
+		for (const auto& entry : entries_) {
+			if (entry.second.type == type && entry.second.resident && entry.second.last_used < frame_) {
+				candidates.emplace_back(entry.second.last_used, entry.first);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		for (const auto& candidate : candidates) {
+			if (Fits(used, budget)) break;
+			Entry& entry = entries_[candidate.second];
+			if (!entry.evict()) continue;
+			used.cpu_bytes -= std::min(used.cpu_bytes, entry.size.cpu_bytes);
+			used.gpu_bytes -= std::min(used.gpu_bytes, entry.size.gpu_bytes);
+			entry.size = MemorySize{};
+			entry.resident = false;
+			++evictions_[static_cast<size_t>(type)];
+		}
+	}
+
+	void ResidencyManager::SetBudget(ResourceType type, MemorySize budget) {
+		budgets_[static_cast<size_t>(type)] = budget;
+	}
+
+	MemorySize ResidencyManager::GetBudget(ResourceType type) const {
+		return budgets_[static_cast<size_t>(type)];
+	}
+
+	ResidencyManager::Usage ResidencyManager::GetUsage(ResourceType type) const {
+		Usage usage{};
+		for (const auto& entry : entries_) {
+			if (entry.second.type != type) continue;
+			if (entry.second.resident) {
+				usage.resident.cpu_bytes += entry.second.size.cpu_bytes;
+				usage.resident.gpu_bytes += entry.second.size.gpu_bytes;
+				++usage.resident_count;
+			}
+			else {
+				++usage.evicted_count;
+			}
+		}
+		usage.evictions = evictions_[static_cast<size_t>(type)];
+		usage.reloads = reloads_[static_cast<size_t>(type)];
+		return usage;
+	}
+
+	void ResidencyManager::Report(std::ostream& os) const {
+		for (size_t type{}; type < kTypeCount; ++type) {
+			const Usage usage = GetUsage(static_cast<ResourceType>(type));
+			os << GetTypeName(static_cast<ResourceType>(type)) << ": "
+				<< usage.resident_count << " RESIDENT, " << usage.evicted_count << " EVICTED, "
+				<< usage.resident.cpu_bytes / 1024 << "/" << budgets_[type].cpu_bytes / 1024 << " KB SYSTEM, "
+				<< usage.resident.gpu_bytes / 1024 << "/" << budgets_[type].gpu_bytes / 1024 << " KB VIDEO, "
+				<< usage.evictions << " EVICTIONS, " << usage.reloads << " RELOADS" << std::endl;
+		}
+	}
+}
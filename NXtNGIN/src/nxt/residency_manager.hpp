@@ -0,0 +1,97 @@
+#ifndef RESIDENCY_MANAGER_HPP_
+#define RESIDENCY_MANAGER_HPP_
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	enum class ResourceType {
+		MESH,
+		TEXTURE,
+		FONT,
+		COUNT
+	};
+
+	struct MemorySize {
+		size_t cpu_bytes;
+		size_t gpu_bytes;
+	};
+
+	// Tracks the system and video memory each kind of resource holds and the
+	// frame each resource was last used in. Once a type is over its budget,
+	// Update evicts its least recently used resources that were not used this
+	// frame; the next Touch loads them again. GL thread only.
+	class ResidencyManager : public NonCopyable, public NonMoveable {
+	public:
+		static constexpr size_t kTypeCount{ static_cast<size_t>(ResourceType::COUNT) };
+
+		struct Usage {
+			MemorySize resident;
+			size_t resident_count;
+			size_t evicted_count;
+			// since startup
+			size_t evictions;
+			size_t reloads;
+		};
+
+		static ResidencyManager& Instance();
+
+		// evict frees the memory and returns false when the resource cannot
+		// go right now, reload brings it back. With an owner the entry is
+		// dropped once the owner expires, otherwise Unregister must be called.
+		// Registering again replaces the entry and marks it resident.
+		void Register(
+			const void* resource,
+			ResourceType type,
+			std::function<MemorySize()> get_size,
+			std::function<bool()> evict,
+			std::function<bool()> reload,
+			std::weak_ptr<const void> owner = std::weak_ptr<const void>{});
+		void Unregister(const void* resource);
+		bool IsRegistered(const void* resource) const { return entries_.count(resource) != 0; }
+
+		// marks the resource used this frame, loading it again first when it
+		// was evicted; false when that failed. Unregistered resources pass.
+		bool Touch(const void* resource);
+
+		// call once a frame after drawing
+		void Update();
+
+		void SetBudget(ResourceType type, MemorySize budget);
+		MemorySize GetBudget(ResourceType type) const;
+		Usage GetUsage(ResourceType type) const;
+		void Report(std::ostream& os = std::cout) const;
+	private:
+		struct Entry {
+			ResourceType type;
+			MemorySize size;
+			size_t last_used;
+			bool resident;
+			bool has_owner;
+			std::weak_ptr<const void> owner;
+			std::function<MemorySize()> get_size;
+			std::function<bool()> evict;
+			std::function<bool()> reload;
+		};
+
+		std::unordered_map<const void*, Entry> entries_;
+		std::array<MemorySize, kTypeCount> budgets_;
+		std::array<size_t, kTypeCount> evictions_;
+		std::array<size_t, kTypeCount> reloads_;
+		size_t frame_;
+
+		ResidencyManager();
+		void Evict(ResourceType type);
+	};
+}
+
+#endif // RESIDENCY_MANAGER_HPP_
@@ -4,13 +4,222 @@ namespace nxt {
 	std::map<std::string, std::shared_ptr<Shader>> ResourceManager::shaders;
 	std::map<std::string, std::shared_ptr<Texture2D>> ResourceManager::textures;
 	std::map<std::string, std::shared_ptr<TextRenderer>> ResourceManager::text_renderers;
+	std::map<std::string, std::weak_ptr<Texture2D>> ResourceManager::shared_textures;
+	std::map<std::string, std::weak_ptr<Shader>> ResourceManager::shared_shaders;
+	size_t ResourceManager::reused_texture_count{};
+	size_t ResourceManager::reused_texture_bytes{};
+	size_t ResourceManager::reused_shader_count{};
+	ResourceRegistry<Shader> ResourceManager::shader_registry;
+	ResourceRegistry<Texture2D> ResourceManager::texture_registry;
+	ResourceRegistry<TextRenderer> ResourceManager::text_renderer_registry;
+	std::map<std::string, ShaderHandle> ResourceManager::shader_handles;
+	std::map<std::string, TextureHandle> ResourceManager::texture_handles;
+	std::map<std::string, TextRendererHandle> ResourceManager::text_renderer_handles;
+
+	namespace {
+		// the references ResourceManager holds itself, in its map and its registry
+		constexpr long kManagerReferences{ 2 };
+
+		// keeps the name's handle when a resource is loaded over it
+		template <typename T>
+		const std::shared_ptr<T>& Store(
+			std::map<std::string, std::shared_ptr<T>>& resources,
+			std::map<std::string, Handle<T>>& handles,
+			ResourceRegistry<T>& registry,
+			const std::string& name,
+			std::shared_ptr<T> resource) {
+			// whoever still holds the previous one uses it without Get
+			auto previous = resources.find(name);
+			if (previous != resources.end() && previous->second != resource) {
+				ResidencyManager::Instance().Unregister(previous->second.get());
+			}
+			auto it = handles.find(name);
+			if (it != handles.end() && registry.IsValid(it->second)) registry.Replace(it->second, resource);
+			else handles[name] = registry.Add(resource);
+			return (resources[name] = std::move(resource));
+		}
+
+		// asserts on an unknown name, an empty pointer in release builds
+		template <typename T>
+		const std::shared_ptr<T>& Find(
+			const std::map<std::string, std::shared_ptr<T>>& resources,
+			const std::string& name) {
+			static const std::shared_ptr<T> missing;
+			auto it = resources.find(name);
+			assert(it != resources.end());
+			return it == resources.end() ? missing : it->second;
+		}
+
+		template <typename T>
+		void Unload(
+			std::map<std::string, std::shared_ptr<T>>& resources,
+			std::map<std::string, Handle<T>>& handles,
+			ResourceRegistry<T>& registry,
+			const std::string& name) {
+			auto previous = resources.find(name);
+			if (previous != resources.end()) ResidencyManager::Instance().Unregister(previous->second.get());
+			auto it = handles.find(name);
+			if (it != handles.end()) {
+				registry.Remove(it->second);
+				handles.erase(it);
+			}
+			resources.erase(name);
+		}
+
+		// evicted and loaded again in place, so handles and references stay valid
+		template <typename T>
+		void TrackResidency(
+			const std::shared_ptr<T>& resource,
+			ResourceType type,
+			std::function<bool(T&)> reload) {
+			std::weak_ptr<T> weak{ resource };
+			ResidencyManager::Instance().Register(
+				resource.get(),
+				type,
+				[weak]() {
+					std::shared_ptr<T> locked = weak.lock();
+					return MemorySize{ 0, locked ? locked->GetMemorySize() : 0 };
+				},
+				[weak]() {
+					std::shared_ptr<T> locked = weak.lock();
+					if (!locked || locked.use_count() > kManagerReferences + 1) return false;
+					locked->Unload();
+					return true;
+				},
+				[weak, reload]() {
+					std::shared_ptr<T> locked = weak.lock();
+					return locked && reload(*locked);
+				},
+				resource);
+		}
+
+		template <typename T>
+		Handle<T> FindHandle(const std::map<std::string, Handle<T>>& handles, const std::string& name) {
+			auto it = handles.find(name);
+			assert(it != handles.end());
+			return it == handles.end() ? Handle<T>{} : it->second;
+		}
+
+		// the textures loaded for a key, a different shader gets its own
+		// Texture2D sampling the same GL object
+		std::shared_ptr<Texture2D> FindSharedTexture(
+			const std::string& key,
+			const std::shared_ptr<Shader>& shader) {
+			if (key.empty()) return nullptr;
+			auto it = ResourceManager::shared_textures.find(key);
+			if (it == ResourceManager::shared_textures.end()) return nullptr;
+			std::shared_ptr<Texture2D> texture = it->second.lock();
+			if (!texture) return nullptr;
+			++ResourceManager::reused_texture_count;
+			ResourceManager::reused_texture_bytes += texture->GetMemorySize();
+			if (texture->GetShader() == shader) return texture;
+			return std::make_shared<Texture2D>(shader, texture);
+		}
+
+		// a program linked from the binary of one loaded for key, so shaders
+		// with the same sources skip the compiler but keep their own uniforms
+		std::shared_ptr<Shader> FindSharedShader(const std::string& key) {
+			if (key.empty()) return nullptr;
+			auto it = ResourceManager::shared_shaders.find(key);
+			if (it == ResourceManager::shared_shaders.end()) return nullptr;
+			const std::shared_ptr<Shader> linked = it->second.lock();
+			if (!linked) return nullptr;
+			std::shared_ptr<Shader> shader = Shader::Relink(*linked);
+			if (shader) ++ResourceManager::reused_shader_count;
+			return shader;
+		}
+
+		std::string GetShaderSourceKey(const std::string& vert_file, const std::string& frag_file) {
+			const std::string vert_key = ResourceManager::GetContentKey(vert_file);
+			const std::string frag_key = ResourceManager::GetContentKey(frag_file);
+			return (vert_key.empty() || frag_key.empty()) ? "" : vert_key + "|" + frag_key;
+		}
+
+		std::string GetTextureKey(const std::string& file_name, bool gen_mipmaps) {
+			const std::string content_key = ResourceManager::GetContentKey(file_name);
+			return content_key.empty() ? "" : (gen_mipmaps ? "2d|mip|" : "2d|") + content_key;
+		}
+
+		std::string GetFacesKey(const std::vector<std::string>& faces) {
+			std::string key{ "cube" };
+			for (const std::string& face : faces) {
+				const std::string face_key = ResourceManager::GetContentKey(face);
+				if (face_key.empty()) return "";
+				key += "|" + face_key;
+			}
+			return key;
+		}
+
+		std::string GetShaderKey(const std::shared_ptr<Shader>& shader) {
+			return shader ? std::to_string(shader->GetId()) : "0";
+		}
+	}
+
+	std::string ResourceManager::GetContentKey(const std::string& file_name) {
+		static std::map<std::string, std::pair<std::time_t, std::uint64_t>> hashes;
+		static std::map<std::string, std::uint64_t> packed_hashes;
+
+		std::uint64_t content_hash{};
+		if (FileSystem::Instance().IsPacked(file_name)) {
+			// packed files never change while mounted
+			std::uint64_t& hash = packed_hashes[file_name];
+			if (hash == 0) hash = TextureCache::HashFile(file_name);
+			content_hash = hash;
+		}
+		else {
+			boost::system::error_code error;
+			const bf::path path = bf::canonical(file_name, error);
+			if (error) return "";
+			const std::time_t write_time = bf::last_write_time(path, error);
+			if (error) return "";
+
+			std::pair<std::time_t, std::uint64_t>& hash = hashes[path.string()];
+			if (hash.second == 0 || hash.first != write_time) {
+				hash = std::make_pair(write_time, TextureCache::HashFile(path.string()));
+			}
+			content_hash = hash.second;
+		}
+		if (content_hash == 0) return "";
+		char key[32];
+		std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(content_hash));
+		return key;
+	}
+
+	size_t ResourceManager::GetSharedTextureBytes() {
+		return reused_texture_bytes;
+	}
+
+	void ResourceManager::ReportSharing(std::ostream& os) {
+		os << "RESOURCES SHARED: " << reused_texture_count << " TEXTURES ("
+			<< GetSharedTextureBytes() / 1024 << " KB OF VIDEO MEMORY SAVED), "
+			<< reused_shader_count << " SHADERS RELINKED" << std::endl;
+	}
+
+	const std::shared_ptr<Shader>& ResourceManager::LoadShader(
+		const std::string& vert_file,
+		const std::string& frag_file,
+		std::string name) {
+
+		if (std::shared_ptr<Shader> shader = FindSharedShader(GetShaderSourceKey(vert_file, frag_file))) {
+			return Store(shaders, shader_handles, shader_registry, name, std::move(shader));
+		}
+		return LoadShader(vert_file, frag_file, ShaderSource::Read(vert_file, frag_file), std::move(name));
+	}
 
 	const std::shared_ptr<Shader>& ResourceManager::LoadShader(
 		const std::string& vert_file,
 		const std::string& frag_file,
+		const ShaderSource& source,
 		std::string name) {
 
-		return (shaders[name] = std::move(std::make_shared<Shader>(vert_file, frag_file)));
+		const std::string key = GetShaderSourceKey(vert_file, frag_file);
+		if (std::shared_ptr<Shader> shader = FindSharedShader(key)) {
+			return Store(shaders, shader_handles, shader_registry, name, std::move(shader));
+		}
+
+		std::shared_ptr<Shader> shader = std::make_shared<Shader>(source);
+		if (!key.empty()) shared_shaders[key] = shader;
+		return Store(shaders, shader_handles, shader_registry, name, std::move(shader));
 	}
 
 	const std::shared_ptr<Texture2D>& ResourceManager::LoadTexture(
@@ -19,7 +228,47 @@ namespace nxt {
 		std::string name,
 		bool gen_mipmaps) {
 
-		return (textures[name] = std::move(std::make_shared<Texture2D>(shader, file_name, gen_mipmaps)));
+		if (std::shared_ptr<Texture2D> texture = FindSharedTexture(GetTextureKey(file_name, gen_mipmaps), shader)) {
+			return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+		}
+		TextureData data;
+		Texture2D::Decode(file_name, gen_mipmaps, data);
+		return LoadTexture(shader, file_name, data, std::move(name), gen_mipmaps);
+	}
+
+	const std::shared_ptr<Texture2D>& ResourceManager::LoadTexture(
+		const std::shared_ptr<Shader>& shader,
+		const std::string& file_name,
+		const TextureData& data,
+		std::string name,
+		bool gen_mipmaps) {
+
+		const std::string key = GetTextureKey(file_name, gen_mipmaps);
+		if (std::shared_ptr<Texture2D> texture = FindSharedTexture(key, shader)) {
+			return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+		}
+
+		std::shared_ptr<Texture2D> texture = std::make_shared<Texture2D>(shader);
+		texture->Load(data);
+		TrackResidency<Texture2D>(texture, ResourceType::TEXTURE, [file_name, gen_mipmaps](Texture2D& evicted) {
+			return evicted.Load(file_name, gen_mipmaps);
+		});
+		if (!key.empty()) shared_textures[key] = texture;
+		return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+	}
+
+	std::shared_ptr<Texture2D> ResourceManager::ShareTexture(
+		const std::shared_ptr<Shader>& shader,
+		const std::string& file_name,
+		bool gen_mipmaps) {
+
+		const std::string key = GetTextureKey(file_name, gen_mipmaps);
+		if (std::shared_ptr<Texture2D> texture = FindSharedTexture(key, shader)) return texture;
+
+		std::shared_ptr<Texture2D> texture = std::make_shared<Texture2D>(shader);
+		texture->Load(file_name, gen_mipmaps);
+		if (!key.empty()) shared_textures[key] = texture;
+		return texture;
 	}
 
 	const std::shared_ptr<Texture2D>& ResourceManager::LoadTexture(
@@ -27,7 +276,83 @@ namespace nxt {
 		const std::vector<std::string>& faces,
 		std::string name) {
 
-		return (textures[name] = std::move(std::make_shared<Texture2D>(shader, faces)));
+		if (std::shared_ptr<Texture2D> texture = FindSharedTexture(GetFacesKey(faces), shader)) {
+			return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+		}
+		TextureData data;
+		Texture2D::Decode(faces, data);
+		return LoadTexture(shader, faces, data, std::move(name));
+	}
+
+	const std::shared_ptr<Texture2D>& ResourceManager::LoadTexture(
+		const std::shared_ptr<Shader>& shader,
+		const std::vector<std::string>& faces,
+		const TextureData& data,
+		std::string name) {
+
+		const std::string key = GetFacesKey(faces);
+		if (std::shared_ptr<Texture2D> texture = FindSharedTexture(key, shader)) {
+			return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+		}
+
+		std::shared_ptr<Texture2D> texture = std::make_shared<Texture2D>(shader);
+		texture->Load(data);
+		TrackResidency<Texture2D>(texture, ResourceType::TEXTURE, [faces](Texture2D& evicted) {
+			return evicted.Load(faces);
+		});
+		if (!key.empty()) shared_textures[key] = texture;
+		return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+	}
+
+	const std::shared_ptr<Texture2D>& ResourceManager::LoadTextureAsync(
+		const std::shared_ptr<Shader>& shader,
+		const std::string& file_name,
+		std::string name,
+		bool gen_mipmaps) {
+
+		// the GL object is replaced once uploaded, so only the same shader can share
+		const std::string content_key = GetContentKey(file_name);
+		const std::string key = content_key.empty() ? ""
+			: (gen_mipmaps ? "async|mip|" : "async|") + GetShaderKey(shader) + "|" + content_key;
+		if (std::shared_ptr<Texture2D> texture = FindSharedTexture(key, shader)) {
+			return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+		}
+
+		std::shared_ptr<Texture2D> texture = TextureLoader::Instance().Load(shader, file_name, gen_mipmaps);
+		if (!key.empty()) shared_textures[key] = texture;
+		return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+	}
+
+	const std::shared_ptr<Texture2D>& ResourceManager::LoadTextureAsync(
+		const std::shared_ptr<Shader>& shader,
+		const std::vector<std::string>& faces,
+		std::string name) {
+
+		const std::string faces_key = GetFacesKey(faces);
+		const std::string key = faces_key.empty() ? "" : "async|" + GetShaderKey(shader) + "|" + faces_key;
+		if (std::shared_ptr<Texture2D> texture = FindSharedTexture(key, shader)) {
+			return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+		}
+
+		std::shared_ptr<Texture2D> texture = TextureLoader::Instance().Load(shader, faces);
+		if (!key.empty()) shared_textures[key] = texture;
+		return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+	}
+
+	const std::shared_ptr<Texture2D>& ResourceManager::LoadTextureStreamed(
+		const std::shared_ptr<Shader>& shader,
+		const std::string& file_name,
+		std::string name) {
+
+		const std::string content_key = GetContentKey(file_name);
+		const std::string key = content_key.empty() ? "" : "stream|" + GetShaderKey(shader) + "|" + content_key;
+		if (std::shared_ptr<Texture2D> texture = FindSharedTexture(key, shader)) {
+			return Store(textures, texture_handles, texture_registry, name, std::move(texture));
+		}
+
+		std::shared_ptr<Texture2D> texture = TextureStreamer::Instance().Load(shader, file_name, name);
+		if (!key.empty()) shared_textures[key] = texture;
+		return Store(textures, texture_handles, texture_registry, name, std::move(texture));
 	}
 
 	const std::shared_ptr<TextRenderer>& ResourceManager::LoadTextRenderer(
@@ -38,23 +363,63 @@ namespace nxt {
 		const std::string& file_name,
 		std::string name) {
 
-		text_renderers[name] = std::move(std::make_shared<TextRenderer>(shader, width, height));
-		text_renderers[name]->SetFileName(file_name, pixel_size);
-		return text_renderers[name];
+		std::shared_ptr<TextRenderer> text_renderer = std::make_shared<TextRenderer>(shader, width, height);
+		text_renderer->SetFileName(file_name, pixel_size);
+		TrackResidency<TextRenderer>(text_renderer, ResourceType::FONT, [](TextRenderer& evicted) {
+			return evicted.Reload();
+		});
+		return Store(text_renderers, text_renderer_handles, text_renderer_registry, name, std::move(text_renderer));
 	}
 
 	const std::shared_ptr<Shader>& ResourceManager::GetShader(const std::string& name) {
-		if (shaders.find(name) == shaders.end()) assert(false);
-		return shaders[name];
+		return Find(shaders, name);
 	}
 
 	const std::shared_ptr<Texture2D>& ResourceManager::GetTexture(const std::string& name) {
-		if (textures.find(name) == textures.end()) assert(false);
-		return textures[name];
+		const std::shared_ptr<Texture2D>& texture = Find(textures, name);
+		if (texture) ResidencyManager::Instance().Touch(texture.get());
+		return texture;
 	}
 
 	const std::shared_ptr<TextRenderer>& ResourceManager::GetTextRenderer(const std::string& name) {
-		if (text_renderers.find(name) == text_renderers.end()) assert(false);
-		return text_renderers[name];
+		const std::shared_ptr<TextRenderer>& text_renderer = Find(text_renderers, name);
+		if (text_renderer) ResidencyManager::Instance().Touch(text_renderer.get());
+		return text_renderer;
+	}
+
+	Texture2D& ResourceManager::Get(TextureHandle handle) {
+		Texture2D& texture = texture_registry.Get(handle);
+		ResidencyManager::Instance().Touch(&texture);
+		return texture;
+	}
+
+	TextRenderer& ResourceManager::Get(TextRendererHandle handle) {
+		TextRenderer& text_renderer = text_renderer_registry.Get(handle);
+		ResidencyManager::Instance().Touch(&text_renderer);
+		return text_renderer;
+	}
+
+	ShaderHandle ResourceManager::GetShaderHandle(const std::string& name) {
+		return FindHandle(shader_handles, name);
+	}
+
+	TextureHandle ResourceManager::GetTextureHandle(const std::string& name) {
+		return FindHandle(texture_handles, name);
+	}
+
+	TextRendererHandle ResourceManager::GetTextRendererHandle(const std::string& name) {
+		return FindHandle(text_renderer_handles, name);
+	}
+
+	void ResourceManager::UnloadShader(const std::string& name) {
+		Unload(shaders, shader_handles, shader_registry, name);
+	}
+
+	void ResourceManager::UnloadTexture(const std::string& name) {
+		Unload(textures, texture_handles, texture_registry, name);
+	}
+
+	void ResourceManager::UnloadTextRenderer(const std::string& name) {
+		Unload(text_renderers, text_renderer_handles, text_renderer_registry, name);
 	}
 }
@@ -4,15 +4,29 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 #include <utility>
+#include <ctime>
+#include <cstdio>
+#include <iostream>
 
 #include <GL/glew.h>
 
 #include "shader.hpp"
 #include "texture2d.hpp"
+#include "texture_loader.hpp"
+#include "texture_streamer.hpp"
+#include "texture_cache.hpp"
+#include "filesystem.hpp"
 #include "text_renderer.hpp"
+#include "resource_registry.hpp"
+#include "residency_manager.hpp"
 
 namespace nxt {
+	using ShaderHandle = Handle<Shader>;
+	using TextureHandle = Handle<Texture2D>;
+	using TextRendererHandle = Handle<TextRenderer>;
+
 	struct ResourceManager {
 		ResourceManager() = delete;
 
@@ -20,14 +34,54 @@ namespace nxt {
 		static std::map<std::string, std::shared_ptr<Texture2D>> textures;
 		static std::map<std::string, std::shared_ptr<TextRenderer>> text_renderers;
 
+		// everything loaded by name also gets a slot here; look the handle up
+		// once after loading and resolve it per frame instead of the name.
+		// Loading again under a name keeps its handle, unloading makes it stale.
+		static ResourceRegistry<Shader> shader_registry;
+		static ResourceRegistry<Texture2D> texture_registry;
+		static ResourceRegistry<TextRenderer> text_renderer_registry;
+		static std::map<std::string, ShaderHandle> shader_handles;
+		static std::map<std::string, TextureHandle> texture_handles;
+		static std::map<std::string, TextRendererHandle> text_renderer_handles;
+
+		// content key -> loaded object; loads of identical sources with the same
+		// parameters share it, whatever path or name they were requested under.
+		// Shaders are not shared but relinked from the first one's binary, so
+		// each keeps its own uniform values.
+		static std::map<std::string, std::weak_ptr<Texture2D>> shared_textures;
+		static std::map<std::string, std::weak_ptr<Shader>> shared_shaders;
+		// handed out again instead of being loaded twice, the bytes are the
+		// video memory of each texture when it was shared
+		static size_t reused_texture_count;
+		static size_t reused_texture_bytes;
+		static size_t reused_shader_count;
+
+		static const std::shared_ptr<Shader>& LoadShader(
+			const std::string& vert_file,
+			const std::string& frag_file,
+			std::string name
+		);
+		// the overloads taking decoded data only create the GL objects, for
+		// loaders reading and decoding files on other threads
 		static const std::shared_ptr<Shader>& LoadShader(
 			const std::string& vert_file,
 			const std::string& frag_file,
+			const ShaderSource& source,
 			std::string name
 		);
+		// textures loaded from files and fonts are tracked by the
+		// ResidencyManager: evicted in place when unused and over budget while
+		// only ResourceManager refers to them, loaded again by the next Get
+		static const std::shared_ptr<Texture2D>& LoadTexture(
+			const std::shared_ptr<Shader>& shader,
+			const std::string& file_name,
+			std::string name,
+			bool gen_mipmaps = true
+		);
 		static const std::shared_ptr<Texture2D>& LoadTexture(
 			const std::shared_ptr<Shader>& shader,
 			const std::string& file_name,
+			const TextureData& data,
 			std::string name,
 			bool gen_mipmaps = true
 		);
@@ -36,6 +90,37 @@ namespace nxt {
 			const std::vector<std::string>& faces,
 			std::string name
 		);
+		static const std::shared_ptr<Texture2D>& LoadTexture(
+			const std::shared_ptr<Shader>& shader,
+			const std::vector<std::string>& faces,
+			const TextureData& data,
+			std::string name
+		);
+		// shared by content like LoadTexture but under no name, so neither Get
+		// nor the ResidencyManager know it; it lives as long as its holders
+		static std::shared_ptr<Texture2D> ShareTexture(
+			const std::shared_ptr<Shader>& shader,
+			const std::string& file_name,
+			bool gen_mipmaps = true
+		);
+		// usable right away, decoded by the TextureLoader and uploaded in its Update()
+		static const std::shared_ptr<Texture2D>& LoadTextureAsync(
+			const std::shared_ptr<Shader>& shader,
+			const std::string& file_name,
+			std::string name,
+			bool gen_mipmaps = true
+		);
+		static const std::shared_ptr<Texture2D>& LoadTextureAsync(
+			const std::shared_ptr<Shader>& shader,
+			const std::vector<std::string>& faces,
+			std::string name
+		);
+		// mip levels follow TextureStreamer::Request, see TextureStreamer
+		static const std::shared_ptr<Texture2D>& LoadTextureStreamed(
+			const std::shared_ptr<Shader>& shader,
+			const std::string& file_name,
+			std::string name
+		);
 		static const std::shared_ptr<TextRenderer>& LoadTextRenderer(
 			const std::shared_ptr<Shader>& shader,
 			size_t width,
@@ -45,9 +130,29 @@ namespace nxt {
 			std::string name
 		);
 
+		// hash of the file's bytes, remembered per canonical path until the file
+		// changes; empty when the file cannot be read
+		static std::string GetContentKey(const std::string& file_name);
+		// video memory of the textures that were shared instead of loaded again
+		static size_t GetSharedTextureBytes();
+		static void ReportSharing(std::ostream& os = std::cout);
+
 		static const std::shared_ptr<Shader>& GetShader(const std::string& name);
 		static const std::shared_ptr<Texture2D>& GetTexture(const std::string& name);
 		static const std::shared_ptr<TextRenderer>& GetTextRenderer(const std::string& name);
+
+		static ShaderHandle GetShaderHandle(const std::string& name);
+		static TextureHandle GetTextureHandle(const std::string& name);
+		static TextRendererHandle GetTextRendererHandle(const std::string& name);
+
+		static Shader& Get(ShaderHandle handle) { return shader_registry.Get(handle); }
+		// textures and fonts count as used, see ResidencyManager
+		static Texture2D& Get(TextureHandle handle);
+		static TextRenderer& Get(TextRendererHandle handle);
+
+		static void UnloadShader(const std::string& name);
+		static void UnloadTexture(const std::string& name);
+		static void UnloadTextRenderer(const std::string& name);
 	};
 }
 
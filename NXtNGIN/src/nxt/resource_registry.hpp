@@ -0,0 +1,108 @@
+#ifndef RESOURCE_REGISTRY_HPP_
+#define RESOURCE_REGISTRY_HPP_
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace nxt {
+	// 32 bit reference into a ResourceRegistry, the slot index in the low bits
+	// and the slot's generation at the time it was handed out above them.
+	// A default constructed handle is null.
+	template <typename T>
+	class Handle {
+	public:
+		static constexpr std::uint32_t kIndexBits{ 20 };
+		static constexpr std::uint32_t kIndexMask{ (1u << kIndexBits) - 1 };
+		static constexpr std::uint32_t kGenerationMask{ (1u << (32 - kIndexBits)) - 1 };
+
+		Handle() = default;
+		Handle(std::uint32_t index, std::uint32_t generation) :
+			id_{ (generation << kIndexBits) | (index & kIndexMask) } {}
+
+		std::uint32_t GetIndex() const { return id_ & kIndexMask; }
+		std::uint32_t GetGeneration() const { return id_ >> kIndexBits; }
+		std::uint32_t GetId() const { return id_; }
+
+		explicit operator bool() const { return id_ != 0; }
+		bool operator==(const Handle& other) const { return id_ == other.id_; }
+		bool operator!=(const Handle& other) const { return id_ != other.id_; }
+	private:
+		std::uint32_t id_{};
+	};
+
+	// Owns resources in a dense slot array. Get is an index and, in debug
+	// builds, a generation compare; a removed slot bumps its generation so
+	// handles still pointing at it are caught instead of resolving to whatever
+	// reuses the slot.
+	template <typename T>
+	class ResourceRegistry {
+	public:
+		Handle<T> Add(std::shared_ptr<T> resource) {
+			std::uint32_t index;
+			if (!free_.empty()) {
+				index = free_.back();
+				free_.pop_back();
+			}
+			else {
+				index = static_cast<std::uint32_t>(slots_.size());
+				assert(index <= Handle<T>::kIndexMask && "resource registry is full");
+				slots_.push_back(Slot{ nullptr, 1, nullptr });
+			}
+			Slot& slot = slots_[index];
+			slot.raw = resource.get();
+			slot.resource = std::move(resource);
+			return Handle<T>{ index, slot.generation };
+		}
+
+		// the handle stays valid and resolves to the new resource
+		void Replace(Handle<T> handle, std::shared_ptr<T> resource) {
+			assert(IsValid(handle) && "stale resource handle");
+			Slot& slot = slots_[handle.GetIndex()];
+			slot.raw = resource.get();
+			slot.resource = std::move(resource);
+		}
+
+		void Remove(Handle<T> handle) {
+			if (!IsValid(handle)) return;
+			Slot& slot = slots_[handle.GetIndex()];
+			slot.raw = nullptr;
+			slot.resource.reset();
+			// generation 0 is kept for null handles
+			slot.generation = (slot.generation + 1) & Handle<T>::kGenerationMask;
+			if (slot.generation == 0) slot.generation = 1;
+			free_.push_back(handle.GetIndex());
+		}
+
+		bool IsValid(Handle<T> handle) const {
+			return handle.GetIndex() < slots_.size() &&
+				slots_[handle.GetIndex()].generation == handle.GetGeneration() &&
+				slots_[handle.GetIndex()].raw != nullptr;
+		}
+
+		T& Get(Handle<T> handle) const {
+			assert(IsValid(handle) && "stale or null resource handle");
+			return *slots_[handle.GetIndex()].raw;
+		}
+
+		const std::shared_ptr<T>& GetShared(Handle<T> handle) const {
+			assert(IsValid(handle) && "stale or null resource handle");
+			return slots_[handle.GetIndex()].resource;
+		}
+
+		size_t GetCount() const { return slots_.size() - free_.size(); }
+	private:
+		struct Slot {
+			// read on every Get, kept ahead of the owning pointer
+			T *raw;
+			std::uint32_t generation;
+			std::shared_ptr<T> resource;
+		};
+
+		std::vector<Slot> slots_;
+		std::vector<std::uint32_t> free_;
+	};
+}
+
+#endif // RESOURCE_REGISTRY_HPP_
@@ -1,27 +1,116 @@
 #include "shader.hpp"
 
 namespace nxt {
+	std::atomic<std::uint64_t> Shader::next_id_{ 0 };
+
 	Shader& Shader::operator=(const Shader &shader) {
 		if (this == &shader) return *this;
 		handle_ = shader.GetHandle();
 		return *this;
 	}
 
-	GLint Shader::GetUniformLocation(const std::string &name) {
-		if (uniform_locs_.find(name) != uniform_locs_.end()) {
-			return uniform_locs_[name];
+	GLint Shader::GetUniformLocation(boost::string_view name) {
+		const auto it = uniform_locs_.find(name);
+		if (it != uniform_locs_.end()) return it->second;
+		// the copy also terminates the name for GL, once per uniform
+		std::string key{ name.data(), name.size() };
+		const GLint location = glGetUniformLocation(handle_, key.c_str());
+		assert(location != -1);
+		uniform_locs_.emplace(std::move(key), location);
+		return location;
+	}
+
+	ShaderSource ShaderSource::Read(const std::string &vert_file, const std::string &frag_file) {
+		return ShaderSource{ ReadStage(vert_file), ReadStage(frag_file) };
+	}
+
+	std::string ShaderSource::ReadStage(const std::string &file) {
+		const std::string cooked_file = FindCooked(file);
+		if (!cooked_file.empty()) return FileSystem::Instance().GetContent(bf::path(cooked_file));
+		std::string source;
+		if (!Preprocess(file, source)) return "";
+		return source;
+	}
+
+	std::string ShaderSource::GetCookedPath(const std::string &file) {
+		return bf::path(file).replace_extension(".nxtglsl").string();
+	}
+
+	std::string ShaderSource::FindCooked(const std::string &file) {
+		return FileSystem::Instance().FindCooked(file, GetCookedPath(file));
+	}
+
+	bool ShaderSource::Preprocess(const std::string &file, std::string &output) {
+		std::vector<std::string> stack;
+		output.clear();
+		return Preprocess(bf::path(file), stack, output);
+	}
+
+	bool ShaderSource::Preprocess(const bf::path &file, std::vector<std::string> &stack, std::string &output) {
+		const std::string key = bf::absolute(file).lexically_normal().generic_string();
+		if (std::find(stack.begin(), stack.end(), key) != stack.end()) {
+			std::cerr << "ERROR SHADER INCLUDE CYCLE THROUGH '" << file.string() << "'" << std::endl;
+			return false;
+		}
+		boost::system::error_code error;
+		if (!FileSystem::Instance().IsPacked(file) && !bf::is_regular_file(file, error)) {
+			std::cerr << "ERROR SHADER SOURCE '" << file.string() << "' NOT FOUND" << std::endl;
+			return false;
+		}
+		const std::string source = FileSystem::Instance().GetContent(file);
+		stack.push_back(key);
+
+		bool in_comment{ false };
+		std::istringstream lines{ source };
+		std::string line;
+		while (std::getline(lines, line)) {
+			std::string code;
+			for (size_t i{}; i < line.size(); ++i) {
+				if (in_comment) {
+					if (line.compare(i, 2, "*/") == 0) {
+						in_comment = false;
+						++i;
+					}
+				}
+				else if (line.compare(i, 2, "/*") == 0) {
+					in_comment = true;
+					++i;
+				}
+				else if (line.compare(i, 2, "//") == 0) {
+					break;
+				}
+				else {
+					code += line[i];
+				}
+			}
+			const size_t end = code.find_last_not_of(" \t\r");
+			if (end == std::string::npos) continue;
+			code.erase(end + 1);
+
+			const size_t begin = code.find_first_not_of(" \t");
+			if (code.compare(begin, 8, "#include") == 0) {
+				const size_t open = code.find('"', begin);
+				const size_t close = open == std::string::npos ? open : code.find('"', open + 1);
+				if (close == std::string::npos) {
+					std::cerr << "ERROR MALFORMED #include IN '" << file.string() << "': " << code << std::endl;
+					return false;
+				}
+				if (!Preprocess(file.parent_path() / code.substr(open + 1, close - open - 1), stack, output)) return false;
+				continue;
+			}
+			output += code;
+			output += '\n';
 		}
-		uniform_locs_[name] = glGetUniformLocation(handle_, name.c_str());
-		assert(uniform_locs_[name] != -1);
-		return (uniform_locs_[name]);
+		stack.pop_back();
+		return true;
 	}
 
-	Shader::Shader(const std::string &vert_file, const std::string &frag_file) {
-		std::string vertex_string = FileSystem::Instance().GetContent(vert_file);
-		std::string fragment_string = FileSystem::Instance().GetContent(frag_file);
+	Shader::Shader(const std::string &vert_file, const std::string &frag_file) :
+		Shader{ ShaderSource::Read(vert_file, frag_file) } {}
 
-		const GLchar* vertex_src = vertex_string.c_str();
-		const GLchar* fragment_src = fragment_string.c_str();
+	Shader::Shader(const ShaderSource& source) {
+		const GLchar* vertex_src = source.vertex.c_str();
+		const GLchar* fragment_src = source.fragment.c_str();
 
 		GLuint vert_shader = glCreateShader(GL_VERTEX_SHADER);
 		glShaderSource(vert_shader, 1, &vertex_src, nullptr);
@@ -34,6 +123,8 @@ namespace nxt {
 		CheckCompileErrors(frag_shader, Type::FRAGMENT);
 
 		handle_ = glCreateProgram();
+		// lets Relink read the binary back
+		if (GLEW_ARB_get_program_binary) glProgramParameteri(handle_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 		glAttachShader(handle_, vert_shader);
 		glAttachShader(handle_, frag_shader);
 		glLinkProgram(handle_);
@@ -43,23 +134,57 @@ namespace nxt {
 		glDeleteShader(frag_shader);
 	}
 
+	std::shared_ptr<Shader> Shader::Relink(const Shader& linked) {
+		if (!GLEW_ARB_get_program_binary) return nullptr;
+		GLint length{};
+		glGetProgramiv(linked.handle_, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) return nullptr;
+		std::vector<GLubyte> binary(static_cast<size_t>(length));
+		GLenum format{};
+		glGetProgramBinary(linked.handle_, length, nullptr, &format, binary.data());
+
+		std::shared_ptr<Shader> shader{ new Shader() };
+		shader->handle_ = glCreateProgram();
+		glProgramBinary(shader->handle_, format, binary.data(), length);
+		GLint status{};
+		glGetProgramiv(shader->handle_, GL_LINK_STATUS, &status);
+		// the driver may refuse its own binary, the caller compiles then
+		return status == GL_TRUE ? shader : nullptr;
+	}
+
+	bool Shader::Validate(GLenum type, const std::string &source, std::string &log) {
+		const GLchar *source_data = source.c_str();
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source_data, nullptr);
+		glCompileShader(shader);
+		GLint success{};
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		GLint length{};
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+		log.assign(static_cast<size_t>(std::max(length, 1)), '\0');
+		glGetShaderInfoLog(shader, length, nullptr, &log[0]);
+		log.resize(std::strlen(log.c_str()));
+		glDeleteShader(shader);
+		return success != GL_FALSE;
+	}
+
 	// shader uniform methods
-	void Shader::SetBool(const std::string &name, GLboolean value) {
+	void Shader::SetBool(boost::string_view name, GLboolean value) {
 		Bind();
 		glUniform1i(GetUniformLocation(name), static_cast<GLint>(value));
 	}
 
-	void Shader::SetInt(const std::string &name, GLint value) {
+	void Shader::SetInt(boost::string_view name, GLint value) {
 		Bind();
 		glUniform1i(GetUniformLocation(name), value);
 	}
 
-	void Shader::SetFloat(const std::string &name, GLfloat value) {
+	void Shader::SetFloat(boost::string_view name, GLfloat value) {
 		Bind();
 		glUniform1f(GetUniformLocation(name), value);
 	}
 
-	void Shader::SetVec2(const std::string &name, const glm::fvec2 &value) {
+	void Shader::SetVec2(boost::string_view name, const glm::fvec2 &value) {
 		Bind();
 		glUniform2fv(
 			GetUniformLocation(name),
@@ -68,12 +193,21 @@ namespace nxt {
 		);
 	}
 
-	void Shader::SetVec2(const std::string &name, GLfloat x, GLfloat y) {
+	void Shader::SetVec2(boost::string_view name, GLfloat x, GLfloat y) {
 		Bind();
 		glUniform2f(GetUniformLocation(name), x, y);
 	}
 
-	void Shader::SetVec3(const std::string &name, const glm::fvec3 &value) {
+	void Shader::SetVec2Array(boost::string_view name, const glm::fvec2 *values, GLsizei count) {
+		Bind();
+		glUniform2fv(
+			GetUniformLocation(name),
+			count,
+			reinterpret_cast<const GLfloat*>(values)
+		);
+	}
+
+	void Shader::SetVec3(boost::string_view name, const glm::fvec3 &value) {
 		Bind();
 		glUniform3fv(
 			GetUniformLocation(name),
@@ -82,12 +216,12 @@ namespace nxt {
 		);
 	}
 
-	void Shader::SetVec3(const std::string &name, GLfloat x, GLfloat y, GLfloat z) {
+	void Shader::SetVec3(boost::string_view name, GLfloat x, GLfloat y, GLfloat z) {
 		Bind();
 		glUniform3f(GetUniformLocation(name), x, y, z);
 	}
 
-	void Shader::SetVec4(const std::string &name, const glm::fvec4 &value) {
+	void Shader::SetVec4(boost::string_view name, const glm::fvec4 &value) {
 		Bind();
 		glUniform4fv(
 			GetUniformLocation(name),
@@ -96,12 +230,12 @@ namespace nxt {
 		);
 	}
 
-	void Shader::SetVec4(const std::string &name, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+	void Shader::SetVec4(boost::string_view name, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
 		Bind();
 		glUniform4f(GetUniformLocation(name), x, y, z, w);
 	}
 
-	void Shader::SetMat2(const std::string &name, const glm::fmat2 &mat) {
+	void Shader::SetMat2(boost::string_view name, const glm::fmat2 &mat) {
 		Bind();
 		glUniformMatrix2fv(
 			GetUniformLocation(name),
@@ -111,7 +245,7 @@ namespace nxt {
 		);
 	}
 
-	void Shader::SetMat3(const std::string &name, const glm::fmat3 &mat) {
+	void Shader::SetMat3(boost::string_view name, const glm::fmat3 &mat) {
 		Bind();
 		glUniformMatrix3fv(
 			GetUniformLocation(name),
@@ -121,7 +255,7 @@ namespace nxt {
 		);
 	}
 
-	void Shader::SetMat4(const std::string &name, const glm::fmat4 &mat) {
+	void Shader::SetMat4(boost::string_view name, const glm::fmat4 &mat) {
 		Bind();
 		glUniformMatrix4fv(
 			GetUniformLocation(name),
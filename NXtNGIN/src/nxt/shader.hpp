@@ -2,44 +2,91 @@
 #define SHADER_HPP_
 
 #include <map>
+#include <vector>
+#include <string>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <memory>
+#include <atomic>
+#include <cstdint>
 #include <GL/glew.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <boost/utility/string_view.hpp>
 
 #include "filesystem.hpp"
 
 namespace nxt {
+	struct ShaderSource {
+		std::string vertex;
+		std::string fragment;
+
+		// reads both files, safe on any thread; cooked .nxtglsl files next to
+		// them are taken as they are, sources go through Preprocess
+		static ShaderSource Read(const std::string& vert_file, const std::string& frag_file);
+
+		// resolves #include "file" relative to the including file and strips
+		// comments and blank lines; false on a missing file or an include cycle
+		static bool Preprocess(const std::string& file, std::string& output);
+		static std::string GetCookedPath(const std::string& file);
+		// GetCookedPath when that file exists and is no older than the source,
+		// otherwise empty
+		static std::string FindCooked(const std::string& file);
+	private:
+		static bool Preprocess(const bf::path& file, std::vector<std::string>& stack, std::string& output);
+		static std::string ReadStage(const std::string& file);
+	};
+
 	class Shader {
 	public:
 		Shader(const std::string&, const std::string&);
+		explicit Shader(const ShaderSource& source);
 		~Shader() { glDeleteProgram(handle_); }
 		Shader& operator=(const Shader&);
 
 		void Bind() const { glUseProgram(handle_); }
 		void Unbind() const { glUseProgram(0); }
 		GLuint GetHandle() const { return handle_; }
+		// never reused, unlike handles and addresses
+		std::uint64_t GetId() const { return id_; }
+
+		// a program of its own loaded from linked's binary, so nothing is
+		// compiled again and no uniform state is shared; nullptr when the
+		// driver hands out no program binaries
+		static std::shared_ptr<Shader> Relink(const Shader& linked);
+
+		// compiles one stage in the current context and throws it away,
+		// log holds the compiler output
+		static bool Validate(GLenum type, const std::string& source, std::string& log);
 
 		// shader uniform methods
-		void SetBool(const std::string &name, GLboolean value);
-		void SetInt(const std::string &name, GLint value);
-		void SetFloat(const std::string &name, GLfloat value);
-		void SetVec2(const std::string &name, const glm::fvec2 &value);
-		void SetVec2(const std::string &name, GLfloat x, GLfloat y);
-		void SetVec3(const std::string &name, const glm::fvec3 &value);
-		void SetVec3(const std::string &name, GLfloat x, GLfloat y, GLfloat z);
-		void SetVec4(const std::string &name, const glm::fvec4 &value);
-		void SetVec4(const std::string &name, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
-		void SetMat2(const std::string &name, const glm::fmat2 &mat);
-		void SetMat3(const std::string &name, const glm::fmat3 &mat);
-		void SetMat4(const std::string &name, const glm::fmat4 &mat);
+		void SetBool(boost::string_view name, GLboolean value);
+		void SetInt(boost::string_view name, GLint value);
+		void SetFloat(boost::string_view name, GLfloat value);
+		void SetVec2(boost::string_view name, const glm::fvec2 &value);
+		void SetVec2(boost::string_view name, GLfloat x, GLfloat y);
+		// count elements of the uniform array name, starting at its first
+		void SetVec2Array(boost::string_view name, const glm::fvec2 *values, GLsizei count);
+		void SetVec3(boost::string_view name, const glm::fvec3 &value);
+		void SetVec3(boost::string_view name, GLfloat x, GLfloat y, GLfloat z);
+		void SetVec4(boost::string_view name, const glm::fvec4 &value);
+		void SetVec4(boost::string_view name, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+		void SetMat2(boost::string_view name, const glm::fmat2 &mat);
+		void SetMat3(boost::string_view name, const glm::fmat3 &mat);
+		void SetMat4(boost::string_view name, const glm::fmat4 &mat);
 	private:
+		static std::atomic<std::uint64_t> next_id_;
+
 		GLuint handle_{};
-		std::map<std::string, GLint> uniform_locs_;
+		std::uint64_t id_{ ++next_id_ };
+		// std::less<> finds names given as string views without a copy
+		std::map<std::string, GLint, std::less<>> uniform_locs_;
 		enum class Type { VERTEX, FRAGMENT, PROGRAM };
 		bool CheckCompileErrors(GLuint, Type) const;
-		GLint GetUniformLocation(const std::string &name);
+		GLint GetUniformLocation(boost::string_view name);
+
+		Shader() = default;
 	};
 }
 
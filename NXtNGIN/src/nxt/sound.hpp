@@ -2,32 +2,60 @@
 #define SOUND_HPP_
 
 #include "audio.hpp"
+#include "sound_buffer_cache.hpp"
+#include "voice_pool.hpp"
 
 namespace nxt {
+	// An effect decoded once into the SoundBufferCache. Single plays go to
+	// the VoicePool and may overlap, looped ones keep a voice of their own
+	// so Stop can end them. Stop also ends the single plays of this Sound,
+	// but not those of others sharing the buffer.
 	class Sound final : public Audio {
 	public:
-		Sound() {
+		Sound() : owner_{ VoicePool::Instance().NewOwner() }, volume_{ kMaxVolume }, pitch_{ 1.0f }, priority_{ 0 } {
 			handle_ = std::unique_ptr<sf::Sound>(new sf::Sound());
+			// not positional, AudioScene places sounds in the world
+			handle_->setRelativeToListener(true);
 		}
 
+		// a file opened before is not read again
 		bool Open(const std::string& file) final override {
-			buffer_ = std::unique_ptr<sf::SoundBuffer>(new sf::SoundBuffer());
-			return (buffer_->loadFromFile(file));
+			buffer_ = SoundBufferCache::Instance().Load(file);
+			return (buffer_ != nullptr);
 		}
 		void Play(bool loop) final override {
-			handle_->setLoop(loop);
-			handle_->setBuffer(*buffer_);
+			if (!buffer_) return;
+			if (!loop) {
+				VoicePool::Instance().PlayOneShot(buffer_, volume_, pitch_, priority_, owner_);
+				return;
+			}
+			handle_->setLoop(true);
+			if (handle_->getBuffer() != buffer_.get()) handle_->setBuffer(*buffer_);
 			handle_->play();
 		}
-		void Stop() final override { handle_->stop(); }
+		void Stop() final override {
+			handle_->stop();
+			VoicePool::Instance().Stop(owner_);
+		}
 		void Volume(float volume) final override {
-			handle_->setVolume(Clamp(volume, kMaxVolume, kMinVolume));
+			volume_ = Clamp(volume, kMaxVolume, kMinVolume);
+			handle_->setVolume(volume_);
+		}
+		void Pitch(float pitch) final override {
+			pitch_ = pitch;
+			handle_->setPitch(pitch_);
 		}
-		void Pitch(float pitch) final override { handle_->setPitch(pitch); }
+		// single plays of a higher priority take the voices of lower ones
+		void Priority(int priority) { priority_ = priority; }
 
 	private:
+		std::shared_ptr<const sf::SoundBuffer> buffer_;
 		std::unique_ptr<sf::Sound> handle_;
-		std::unique_ptr<sf::SoundBuffer> buffer_;
+		// tags the single plays in the VoicePool
+		std::uint64_t owner_;
+		float volume_;
+		float pitch_;
+		int priority_;
 	};
 }
 
@@ -0,0 +1,155 @@
+#include "sound_buffer_cache.hpp"
+
+namespace bi = boost::interprocess;
+
+namespace nxt {
+	namespace {
+		constexpr std::uint32_t kCookedMagic{ 0x4154584E }; // "NXTA"
+		constexpr std::uint32_t kCookedVersion{ 1 };
+
+		struct CookedHeader {
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t channel_count;
+			std::uint32_t sample_rate;
+			std::uint64_t sample_count;
+		};
+	}
+
+	SoundBufferCache& SoundBufferCache::Instance() {
+		static std::unique_ptr<SoundBufferCache> instance{ std::unique_ptr<SoundBufferCache>(new SoundBufferCache()) };
+		return *instance;
+	}
+
+	std::shared_ptr<const sf::SoundBuffer> SoundBufferCache::Load(const std::string& file) {
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			auto cached = buffers_.find(file);
+			if (cached != buffers_.end()) return cached->second;
+		}
+
+		// decoded outside the lock so other files load meanwhile
+		MemoryScope scope{ MemoryTag::AUDIO };
+		std::shared_ptr<sf::SoundBuffer> buffer = std::make_shared<sf::SoundBuffer>();
+		const std::string cooked_file = FindCooked(file);
+		bool loaded = !cooked_file.empty() && LoadCooked(cooked_file, *buffer);
+		if (!loaded) {
+			const FileBufferPtr packed = FileSystem::Instance().GetBuffer(file);
+			loaded = packed ?
+				buffer->loadFromMemory(packed->GetData(), packed->GetSize()) :
+				buffer->loadFromFile(file);
+		}
+		if (!loaded) {
+			std::cerr << "ERROR LOADING SOUND '" << file << "'" << std::endl;
+			return nullptr;
+		}
+
+		// a thread that decoded the same file first wins
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		return buffers_.emplace(file, std::move(buffer)).first->second;
+	}
+
+	std::shared_ptr<const sf::SoundBuffer> SoundBufferCache::Find(const std::string& file) const {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		auto cached = buffers_.find(file);
+		return cached != buffers_.end() ? cached->second : nullptr;
+	}
+
+	size_t SoundBufferCache::Trim() {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		size_t count{};
+		for (auto it = buffers_.begin(); it != buffers_.end();) {
+			if (it->second.use_count() == 1) {
+				it = buffers_.erase(it);
+				++count;
+			}
+			else ++it;
+		}
+		return count;
+	}
+
+	void SoundBufferCache::Clear() {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		buffers_.clear();
+	}
+
+	size_t SoundBufferCache::GetCount() const {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		return buffers_.size();
+	}
+
+	size_t SoundBufferCache::GetMemorySize() const {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		size_t size{};
+		for (const auto& buffer : buffers_) {
+			size += static_cast<size_t>(buffer.second->getSampleCount()) * sizeof(sf::Int16);
+		}
+		return size;
+	}
+
+	std::string SoundBufferCache::GetCookedPath(const std::string& file) {
+		return bf::path(file).replace_extension(".nxtpcm").string();
+	}
+
+	std::string SoundBufferCache::FindCooked(const std::string& file) {
+		return FileSystem::Instance().FindCooked(file, GetCookedPath(file));
+	}
+
+	bool SoundBufferCache::SaveCooked(const std::string& cooked_file, const sf::SoundBuffer& buffer) {
+		const CookedHeader header{
+			kCookedMagic,
+			kCookedVersion,
+			buffer.getChannelCount(),
+			buffer.getSampleRate(),
+			buffer.getSampleCount() };
+
+		std::ofstream ofs(cooked_file, std::ios::out | std::ios::binary | std::ios::trunc);
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		ofs.write(reinterpret_cast<const char*>(buffer.getSamples()), static_cast<std::streamsize>(header.sample_count * sizeof(sf::Int16)));
+		ofs.close();
+		if (!ofs) {
+			std::cerr << "ERROR WRITING COOKED SOUND '" << cooked_file << "'" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool SoundBufferCache::LoadCooked(const std::string& cooked_file, sf::SoundBuffer& buffer) {
+		// packed files are mapped already, loose ones only for as long as the copy takes
+		const FileBufferPtr packed = FileSystem::Instance().GetBuffer(cooked_file);
+		boost::string_view bytes;
+		bi::file_mapping mapping;
+		bi::mapped_region region;
+		if (packed) {
+			bytes = packed->GetView();
+		}
+		else {
+			try {
+				mapping = bi::file_mapping(cooked_file.c_str(), bi::read_only);
+				region = bi::mapped_region(mapping, bi::read_only);
+			}
+			catch (const bi::interprocess_exception& ex) {
+				std::cerr << "ERROR MAPPING COOKED SOUND '" << cooked_file << "': " << ex.what() << std::endl;
+				return false;
+			}
+			bytes = boost::string_view(static_cast<const char*>(region.get_address()), region.get_size());
+		}
+
+		CookedHeader header{};
+		if (bytes.size() >= sizeof(header)) std::memcpy(&header, bytes.data(), sizeof(header));
+		// sample_count comes from the file, checked against the size before it is multiplied
+		if (bytes.size() < sizeof(header) || header.magic != kCookedMagic || header.version != kCookedVersion ||
+			header.channel_count == 0 ||
+			header.sample_count > (bytes.size() - sizeof(header)) / sizeof(sf::Int16) ||
+			sizeof(header) + header.sample_count * sizeof(sf::Int16) != bytes.size()) {
+			std::cerr << "INVALID COOKED SOUND '" << cooked_file << "'" << std::endl;
+			return false;
+		}
+		// the header keeps the samples 2 byte aligned in the file and in packs
+		return buffer.loadFromSamples(
+			reinterpret_cast<const sf::Int16*>(bytes.data() + sizeof(header)),
+			header.sample_count,
+			header.channel_count,
+			header.sample_rate);
+	}
+}
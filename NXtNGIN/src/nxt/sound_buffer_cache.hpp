@@ -0,0 +1,65 @@
+#ifndef SOUND_BUFFER_CACHE_HPP_
+#define SOUND_BUFFER_CACHE_HPP_
+
+#include <map>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <SFML/Audio.hpp>
+
+#include "filesystem.hpp"
+#include "memory_tracker.hpp"
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// Decoded sound effects shared by file name, each file is read and
+	// decoded once however many Sounds open it. Entries stay until Trim or
+	// Clear, so effects loaded up front never touch the disk again. Safe to
+	// use from several threads at once.
+	//
+	// nxt_cook decodes effects up to kMaxCookedDuration long into a
+	// .nxtpcm next to them, raw samples behind a small header. Load maps
+	// that file and copies the samples as they are instead of decoding.
+	class SoundBufferCache : public NonCopyable, public NonMoveable {
+	public:
+		// longer files are music and streamed, see MusicStream
+		static constexpr float kMaxCookedDuration{ 10.0f };
+
+		static SoundBufferCache& Instance();
+
+		// decodes on the calling thread on a miss, nullptr when it fails
+		std::shared_ptr<const sf::SoundBuffer> Load(const std::string& file);
+		// never loads, nullptr on a miss
+		std::shared_ptr<const sf::SoundBuffer> Find(const std::string& file) const;
+
+		// drops the buffers nothing outside the cache refers to
+		size_t Trim();
+		void Clear();
+
+		size_t GetCount() const;
+		// bytes of decoded samples
+		size_t GetMemorySize() const;
+
+		static std::string GetCookedPath(const std::string& file);
+		// GetCookedPath when that file exists and is no older than the source,
+		// otherwise empty
+		static std::string FindCooked(const std::string& file);
+		static bool SaveCooked(const std::string& cooked_file, const sf::SoundBuffer& buffer);
+		static bool LoadCooked(const std::string& cooked_file, sf::SoundBuffer& buffer);
+	private:
+		mutable std::mutex mutex_;
+		std::map<std::string, std::shared_ptr<const sf::SoundBuffer>> buffers_;
+
+		SoundBufferCache() = default;
+	};
+}
+
+#endif // SOUND_BUFFER_CACHE_HPP_
@@ -0,0 +1,250 @@
+#include "sprite_batch.hpp"
+
+namespace nxt {
+	static_assert(sizeof(SpriteInstance) == 14 * sizeof(GLfloat), "SpriteInstance must be tightly packed");
+
+	SpriteBatch::SpriteBatch(
+		const std::shared_ptr<Shader> &shader,
+		const GLfloat &width,
+		const GLfloat &height,
+		size_t capacity) :
+		indices_{ 0, 1, 2, 0, 2, 3 },
+		sort_mode_{ SpriteSortMode::TEXTURE },
+		in_batch_{ false },
+		capacity_{ std::max<size_t>(capacity, 1) },
+		draw_calls_{},
+		last_texture_id_{},
+		depth_captured_{ false },
+		depth_test_{ GL_TRUE },
+		depth_func_{ GL_LESS },
+		depth_mask_{ GL_TRUE },
+		shader_{ shader },
+		instance_layout_{ 1 },
+		instance_attrib_{} {
+		projection_ = glm::ortho<float>(
+			0.0f,
+			width,
+			height,
+			0.0f);
+		InitRenderData();
+		shader_->SetMat4("projection", projection_);
+		shader_->SetInt("image_sampler", 0);
+	}
+
+	SpriteBatch::~SpriteBatch() {}
+
+	void SpriteBatch::Begin(SpriteSortMode sort_mode) {
+		assert(!in_batch_);
+		in_batch_ = true;
+		sort_mode_ = sort_mode;
+		instances_.clear();
+		texture_ids_.clear();
+		textures_.clear();
+		runs_.clear();
+	}
+
+	void SpriteBatch::Draw(
+		const std::shared_ptr<Texture2D> &texture,
+		const glm::fvec2 &position,
+		glm::fvec2 size,
+		GLfloat rotate,
+		glm::fvec4 color,
+		GLfloat layer,
+		glm::fvec4 uv_rect) {
+
+		assert(in_batch_);
+		SpriteInstance instance;
+		instance.position_size = glm::fvec4{ position, size };
+		instance.uv_rect = uv_rect;
+		instance.color = color;
+		instance.rotation_layer = glm::fvec2{ glm::radians<float>(rotate), layer };
+
+		instances_.push_back(instance);
+		texture_ids_.push_back(GetTextureId(texture.get()));
+	}
+
+	void SpriteBatch::Draw(
+		const TextureAtlas &atlas,
+		const AtlasRegion &region,
+		const glm::fvec2 &position,
+		glm::fvec2 size,
+		GLfloat rotate,
+		glm::fvec4 color,
+		GLfloat layer) {
+
+		Draw(atlas.GetTexture(), position, size, rotate, color, layer, region.uv_rect);
+	}
+
+	void SpriteBatch::End() {
+		assert(in_batch_);
+		in_batch_ = false;
+		draw_calls_ = 0;
+		if (instances_.empty()) return;
+
+		switch (sort_mode_) {
+		case SpriteSortMode::TEXTURE:
+			SortByTexture();
+			Upload(sorted_);
+			break;
+		case SpriteSortMode::LAYER:
+			SortByLayer();
+			Upload(sorted_);
+			break;
+		case SpriteSortMode::DEFERRED:
+			for (std::uint16_t id : texture_ids_) AppendRun(id);
+			Upload(instances_);
+			break;
+		}
+		Flush();
+	}
+
+	std::uint16_t SpriteBatch::GetTextureId(const Texture2D *texture) {
+		assert(texture != nullptr);
+		if (!textures_.empty() && textures_[last_texture_id_] == texture) return last_texture_id_;
+
+		auto it = std::find(textures_.begin(), textures_.end(), texture);
+		if (it == textures_.end()) {
+			assert(textures_.size() < UINT16_MAX);
+			textures_.push_back(texture);
+			it = textures_.end() - 1;
+		}
+		last_texture_id_ = static_cast<std::uint16_t>(it - textures_.begin());
+		return last_texture_id_;
+	}
+
+	// counting sort, linear in the number of sprites and stable within a texture
+	void SpriteBatch::SortByTexture() {
+		histogram_.assign(textures_.size() + 1, 0);
+		for (std::uint16_t id : texture_ids_) ++histogram_[id + 1];
+		for (size_t i{ 1 }; i < histogram_.size(); ++i) {
+			if (histogram_[i] > 0) AppendRun(static_cast<std::uint16_t>(i - 1), histogram_[i]);
+			histogram_[i] += histogram_[i - 1];
+		}
+
+		sorted_.resize(instances_.size());
+		for (size_t i{}; i < instances_.size(); ++i) {
+			sorted_[histogram_[texture_ids_[i]]++] = instances_[i];
+		}
+	}
+
+	void SpriteBatch::SortByLayer() {
+		keys_.resize(instances_.size());
+		for (size_t i{}; i < instances_.size(); ++i) {
+			// map the float onto an unsigned integer with the same ordering
+			GLfloat layer{ instances_[i].rotation_layer.y };
+			std::uint32_t bits{};
+			std::memcpy(&bits, &layer, sizeof(bits));
+			bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+			keys_[i] = std::make_pair(
+				(static_cast<std::uint64_t>(bits) << 16) | texture_ids_[i],
+				static_cast<std::uint32_t>(i));
+		}
+		std::sort(keys_.begin(), keys_.end());
+
+		sorted_.resize(instances_.size());
+		for (size_t i{}; i < keys_.size(); ++i) {
+			sorted_[i] = instances_[keys_[i].second];
+			AppendRun(texture_ids_[keys_[i].second]);
+		}
+	}
+
+	void SpriteBatch::AppendRun(std::uint16_t texture_id, size_t count) {
+		if (!runs_.empty() && runs_.back().first == texture_id) {
+			runs_.back().second += count;
+		}
+		else {
+			runs_.push_back(std::make_pair(texture_id, count));
+		}
+	}
+
+	void SpriteBatch::Upload(const std::vector<SpriteInstance> &instances) {
+		while (capacity_ < instances.size()) capacity_ *= 2;
+
+		instance_vb_->Bind();
+		// orphan last frame's store so the driver does not stall on pending draws
+		instance_vb_->BufferData(
+			nullptr,
+			static_cast<GLuint>(capacity_ * sizeof(SpriteInstance)),
+			DrawType::STREAM);
+		instance_vb_->BufferSubData(
+			reinterpret_cast<const GLvoid*>(instances.data()),
+			static_cast<GLuint>(instances.size() * sizeof(SpriteInstance)));
+		instance_vb_->Unbind();
+	}
+
+	void SpriteBatch::CaptureDepthState() {
+		// reading GL state back stalls, so not on every flush
+		depth_test_ = glIsEnabled(GL_DEPTH_TEST);
+		glGetIntegerv(GL_DEPTH_FUNC, &depth_func_);
+		glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_mask_);
+		depth_captured_ = true;
+	}
+
+	void SpriteBatch::Flush() {
+		if (!depth_captured_) CaptureDepthState();
+		// TEXTURE draws out of layer order and needs the depth test, the other
+		// modes draw back to front and must not be clipped by it
+		if (sort_mode_ == SpriteSortMode::TEXTURE) {
+			glEnable(GL_DEPTH_TEST);
+			// sprites of one layer overlap in submission order
+			glDepthFunc(GL_LEQUAL);
+			glDepthMask(GL_TRUE);
+		}
+		else {
+			glDisable(GL_DEPTH_TEST);
+		}
+
+		size_t first{};
+		for (const std::pair<std::uint16_t, size_t> &run : runs_) {
+			va_->SetBufferOffset(
+				*instance_vb_,
+				instance_layout_,
+				instance_attrib_,
+				static_cast<GLintptr>(first * sizeof(SpriteInstance)));
+			textures_[run.first]->BindUnit(0);
+			Renderer::Render(*va_, *ib_, *shader_, static_cast<GLsizei>(run.second));
+			++draw_calls_;
+			first += run.second;
+		}
+		textures_[runs_.back().first]->Unbind(0);
+		instance_vb_->Unbind();
+		va_->Unbind();
+
+		if (depth_test_) glEnable(GL_DEPTH_TEST);
+		else glDisable(GL_DEPTH_TEST);
+		glDepthFunc(static_cast<GLenum>(depth_func_));
+		glDepthMask(depth_mask_);
+	}
+
+	void SpriteBatch::InitRenderData() {
+		constexpr GLubyte kNumberComponents{ 4 }; //position and texture coordinate
+		std::vector<GLfloat> vertices{
+			1.0f, 0.0f, 1.0f, 1.0f,
+			0.0f, 0.0f, 0.0f, 1.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			1.0f, 1.0f, 1.0f, 0.0f,
+		};
+		quad_vb_ = std::make_shared<VertexBuffer>(
+			reinterpret_cast<const GLvoid*>(vertices.data()),
+			static_cast<GLuint>(sizeof(GLfloat)) * static_cast<GLuint>(vertices.size()));
+		VertexBufferLayout vbl{};
+		vbl.Push<GLfloat>(kNumberComponents);
+		va_ = std::make_shared<VertexArray>(*quad_vb_, vbl);
+
+		instance_vb_ = std::make_shared<VertexBuffer>(
+			nullptr,
+			static_cast<GLuint>(capacity_ * sizeof(SpriteInstance)),
+			DrawType::STREAM);
+		// position and size, uv rectangle, color, rotation and layer
+		instance_layout_.Push<GLfloat>(4);
+		instance_layout_.Push<GLfloat>(4);
+		instance_layout_.Push<GLfloat>(4);
+		instance_layout_.Push<GLfloat>(2);
+		instance_attrib_ = va_->AddBuffer(*instance_vb_, instance_layout_);
+
+		ib_ = std::make_shared<IndexBuffer>(indices_.data(), static_cast<GLuint>(indices_.size()));
+		ib_->Unbind();
+		instance_vb_->Unbind();
+		va_->Unbind();
+	}
+}
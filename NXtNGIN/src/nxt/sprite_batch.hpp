@@ -0,0 +1,116 @@
+#ifndef SPRITE_BATCH_HPP_
+#define SPRITE_BATCH_HPP_
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "texture2d.hpp"
+#include "texture_atlas.hpp"
+#include "renderer.hpp"
+
+namespace nxt {
+	enum class SpriteSortMode {
+		DEFERRED, // submission order, neighbouring sprites sharing a texture are merged
+		TEXTURE,  // fewest draw calls, layers are resolved by the depth test the batch enables
+		LAYER     // back to front by layer, then by texture within a layer
+	};
+
+	// per instance attributes, layout must match sprite_batch_vert_shader.glsl
+	struct SpriteInstance {
+		glm::fvec4 position_size;
+		glm::fvec4 uv_rect;
+		glm::fvec4 color;
+		glm::fvec2 rotation_layer;
+	};
+
+	class SpriteBatch {
+	public:
+		SpriteBatch(
+			const std::shared_ptr<Shader> &shader,
+			const GLfloat &width,
+			const GLfloat &height,
+			size_t capacity = kDefaultCapacity);
+		~SpriteBatch();
+
+		void Begin(SpriteSortMode sort_mode = SpriteSortMode::TEXTURE);
+		// textures have to stay alive until End(), layers range from -1.0 to 1.0
+		// and higher layers are drawn on top
+		void Draw(
+			const std::shared_ptr<Texture2D> &texture,
+			const glm::fvec2 &position,
+			glm::fvec2 size = glm::fvec2{ 10.0f, 10.0f },
+			GLfloat rotate = 0.0f,
+			glm::fvec4 color = glm::fvec4{ 1.0f },
+			GLfloat layer = 0.0f,
+			glm::fvec4 uv_rect = glm::fvec4{ 0.0f, 0.0f, 1.0f, 1.0f });
+		// sprites of one atlas share a texture and end up in the same draw call
+		void Draw(
+			const TextureAtlas &atlas,
+			const AtlasRegion &region,
+			const glm::fvec2 &position,
+			glm::fvec2 size = glm::fvec2{ 10.0f, 10.0f },
+			GLfloat rotate = 0.0f,
+			glm::fvec4 color = glm::fvec4{ 1.0f },
+			GLfloat layer = 0.0f);
+		void End();
+
+		// the depth state around the batch is read back on the first End and
+		// restored after every one; call again after changing it
+		void CaptureDepthState();
+
+		size_t GetSpriteCount() const { return instances_.size(); }
+		size_t GetDrawCallCount() const { return draw_calls_; }
+	private:
+		static constexpr size_t kDefaultCapacity{ 1024 };
+
+		std::vector<GLuint> indices_;
+		glm::fmat4 projection_;
+		SpriteSortMode sort_mode_;
+		bool in_batch_;
+		size_t capacity_;
+		size_t draw_calls_;
+		std::uint16_t last_texture_id_;
+		// what Flush restores, see CaptureDepthState
+		bool depth_captured_;
+		GLboolean depth_test_;
+		GLint depth_func_;
+		GLboolean depth_mask_;
+
+		// submitted sprites, texture_ids_ index into textures_
+		std::vector<SpriteInstance> instances_;
+		std::vector<std::uint16_t> texture_ids_;
+		std::vector<const Texture2D*> textures_;
+		// sprites in upload order and the texture runs they form
+		std::vector<SpriteInstance> sorted_;
+		std::vector<std::pair<std::uint64_t, std::uint32_t>> keys_;
+		// (texture id, sprite count) per draw call
+		std::vector<std::pair<std::uint16_t, size_t>> runs_;
+		std::vector<size_t> histogram_;
+
+		std::shared_ptr<Shader> shader_;
+		std::shared_ptr<IndexBuffer> ib_;
+		std::shared_ptr<VertexArray> va_;
+		std::shared_ptr<VertexBuffer> quad_vb_;
+		std::shared_ptr<VertexBuffer> instance_vb_;
+		VertexBufferLayout instance_layout_;
+		GLuint instance_attrib_;
+
+		void InitRenderData();
+		std::uint16_t GetTextureId(const Texture2D *texture);
+		void SortByTexture();
+		void SortByLayer();
+		void AppendRun(std::uint16_t texture_id, size_t count = 1);
+		void Upload(const std::vector<SpriteInstance> &instances);
+		void Flush();
+	};
+}
+
+#endif // SPRITE_BATCH_HPP_
@@ -43,10 +43,17 @@ namespace nxt {
 		const std::shared_ptr<Texture2D> &texture, const glm::fvec2 &position,
 		const std::vector<glm::fvec2> &offsets, glm::fvec2 size,
 		GLfloat rotate, glm::fvec3 color) {
+		Draw(texture, position, offsets.data(), offsets.size(), size, rotate, color);
+	}
+
+	void SpriteRenderer::Draw(
+		const std::shared_ptr<Texture2D> &texture, const glm::fvec2 &position,
+		const glm::fvec2 *offsets, size_t offset_count, glm::fvec2 size,
+		GLfloat rotate, glm::fvec3 color) {
 
-		size_t i{};
-		for (const glm::fvec2 &offset : offsets) {
-			shader_->SetVec2("offset[" + std::to_string(i++) + "]", offset);
+		// the whole array in one call, no per element uniform names
+		if (offset_count != 0) {
+			shader_->SetVec2Array("offset", offsets, static_cast<GLsizei>(offset_count));
 		}
 
 		glm::fmat4 model{};
@@ -63,7 +70,7 @@ namespace nxt {
 		texture->Bind("image_sampler", 0);
 		Renderer::Render(
 			*va_, *ib_,
-			*shader_, static_cast<GLsizei>(offsets.size()) + 1);
+			*shader_, static_cast<GLsizei>(offset_count) + 1);
 		texture->Unbind(0);
 	}
 
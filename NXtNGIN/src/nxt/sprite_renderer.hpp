@@ -42,6 +42,15 @@ namespace nxt {
 			glm::fvec2 size = glm::fvec2{ 10.0f, 10.0f },
 			GLfloat rotate = 0.0f,
 			glm::fvec3 color = glm::fvec3{ 1.0f });
+		// offsets may live in a FrameVector or any other contiguous storage
+		void Draw(
+			const std::shared_ptr<Texture2D> &texture,
+			const glm::fvec2 &position,
+			const glm::fvec2 *offsets,
+			size_t offset_count,
+			glm::fvec2 size = glm::fvec2{ 10.0f, 10.0f },
+			GLfloat rotate = 0.0f,
+			glm::fvec3 color = glm::fvec3{ 1.0f });
 	};
 }
 
@@ -1,56 +1,203 @@
 #include "text_renderer.hpp"
 
 namespace nxt {
-	void TextRenderer::LoadFonts() {
-		characters_.clear();
+	namespace {
+		constexpr std::uint32_t kAtlasMagic{ 0x46545850 }; // "PXTF"
+		constexpr std::uint32_t kAtlasVersion{ 1 };
+		// more than ASCII set to also get further glyphs
+		constexpr std::uint32_t kGlyphCount{ 170 };
+		// keeps linear filtering from bleeding into the neighbours
+		constexpr int kGlyphPadding{ 1 };
+
+		struct AtlasHeader {
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t pixel_size;
+			std::uint32_t glyph_count;
+			std::int32_t width;
+			std::int32_t height;
+		};
+	}
+
+	bool GlyphAtlas::Save(const std::string& file_name) const {
+		const AtlasHeader header{
+			kAtlasMagic,
+			kAtlasVersion,
+			pixel_size,
+			static_cast<std::uint32_t>(glyphs.size()),
+			width,
+			height };
+		std::ofstream ofs(file_name, std::ios::out | std::ios::binary | std::ios::trunc);
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		ofs.write(reinterpret_cast<const char*>(glyphs.data()), static_cast<std::streamsize>(glyphs.size() * sizeof(Glyph)));
+		ofs.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+		ofs.close();
+		if (!ofs) {
+			std::cerr << "ERROR WRITING GLYPH ATLAS '" << file_name << "'" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool GlyphAtlas::Load(const std::string& file_name) {
+		const FileBufferPtr packed = FileSystem::Instance().GetBuffer(file_name);
+		boost::string_view bytes;
+		std::string content;
+		if (packed) {
+			bytes = packed->GetView();
+		}
+		else {
+			content = FileSystem::Instance().GetContent(bf::path(file_name));
+			bytes = content;
+		}
+
+		AtlasHeader header{};
+		if (bytes.size() >= sizeof(header)) std::memcpy(&header, bytes.data(), sizeof(header));
+		const size_t glyph_bytes = header.glyph_count * sizeof(Glyph);
+		const size_t pixel_bytes = static_cast<size_t>(std::max(header.width, 0)) * static_cast<size_t>(std::max(header.height, 0));
+		if (bytes.size() < sizeof(header) || header.magic != kAtlasMagic || header.version != kAtlasVersion ||
+			sizeof(header) + glyph_bytes + pixel_bytes != bytes.size()) {
+			std::cerr << "INVALID GLYPH ATLAS '" << file_name << "'" << std::endl;
+			return false;
+		}
+		pixel_size = header.pixel_size;
+		width = header.width;
+		height = header.height;
+		glyphs.resize(header.glyph_count);
+		std::memcpy(glyphs.data(), bytes.data() + sizeof(header), glyph_bytes);
+		pixels.assign(bytes.data() + sizeof(header) + glyph_bytes, bytes.data() + bytes.size());
+		return true;
+	}
+
+	bool TextRenderer::Rasterize(const std::string& font_file, unsigned int pixel_size, GlyphAtlas& atlas) {
+		atlas = GlyphAtlas{};
+		atlas.pixel_size = pixel_size;
 		FT_Library ft;
 		if (FT_Init_FreeType(&ft)) {
 			std::cerr << "ERROR::FREETYPE: COULD NOT INIT FREETYPE LIBRARY" << std::endl;
+			return false;
 		}
 		FT_Face face;
-		if (FT_New_Face(ft, filename_.c_str(), 0, &face)) {
+		const FileBufferPtr packed = FileSystem::Instance().GetBuffer(font_file);
+		const FT_Error error = packed ?
+			FT_New_Memory_Face(ft, reinterpret_cast<const FT_Byte*>(packed->GetData()), static_cast<FT_Long>(packed->GetSize()), 0, &face) :
+			FT_New_Face(ft, font_file.c_str(), 0, &face);
+		if (error) {
 			std::cerr << "ERROR::FREETYPE: FAILED TO LOAD FONT" << std::endl;
+			FT_Done_FreeType(ft);
+			return false;
 		}
-		FT_Set_Pixel_Sizes(face, 0, default_pixel_size_);
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		FT_Set_Pixel_Sizes(face, 0, pixel_size);
 
-		// more than ASCII set to also get further glyphs
-		for (GLubyte c = 0; c < 170; c++) {
+		std::vector<std::vector<unsigned char>> bitmaps;
+		for (std::uint32_t c{}; c < kGlyphCount; ++c) {
 			if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
 				std::cerr << "ERROR::FREETYTPE: FAILED TO LOAD GLYPH" << std::endl;
 				continue;
 			}
+			const FT_Bitmap& bitmap = face->glyph->bitmap;
+			GlyphAtlas::Glyph glyph{};
+			glyph.code = c;
+			glyph.size = glm::ivec2(bitmap.width, bitmap.rows);
+			glyph.bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+			glyph.advance = static_cast<std::uint32_t>(face->glyph->advance.x);
+			atlas.glyphs.push_back(glyph);
 
-			GLuint texture;
-			glGenTextures(1, &texture);
-			glBindTexture(GL_TEXTURE_2D, texture);
-			glTexImage2D(
-				GL_TEXTURE_2D,
-				0,
-				GL_RED,
-				face->glyph->bitmap.width,
-				face->glyph->bitmap.rows,
-				0,
-				GL_RED,
-				GL_UNSIGNED_BYTE,
-				face->glyph->bitmap.buffer
-			);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			bitmaps.emplace_back(static_cast<size_t>(bitmap.width) * bitmap.rows);
+			for (unsigned int row{}; row < bitmap.rows; ++row) {
+				std::memcpy(
+					bitmaps.back().data() + static_cast<size_t>(row) * bitmap.width,
+					bitmap.buffer + static_cast<std::ptrdiff_t>(row) * bitmap.pitch,
+					bitmap.width);
+			}
+		}
+		FT_Done_Face(face);
+		FT_Done_FreeType(ft);
+
+		// rows of glyphs in code order, as wide as a square of their area
+		size_t area{};
+		for (const GlyphAtlas::Glyph& glyph : atlas.glyphs) {
+			area += static_cast<size_t>(glyph.size.x + kGlyphPadding) * (glyph.size.y + kGlyphPadding);
+		}
+		atlas.width = 64;
+		while (static_cast<size_t>(atlas.width) * atlas.width < area) atlas.width *= 2;
+		glm::ivec2 cursor{ kGlyphPadding };
+		int row_height{};
+		for (GlyphAtlas::Glyph& glyph : atlas.glyphs) {
+			if (cursor.x + glyph.size.x + kGlyphPadding > atlas.width) {
+				cursor = glm::ivec2{ kGlyphPadding, cursor.y + row_height + kGlyphPadding };
+				row_height = 0;
+			}
+			glyph.position = cursor;
+			cursor.x += glyph.size.x + kGlyphPadding;
+			row_height = std::max(row_height, glyph.size.y);
+		}
+		atlas.height = cursor.y + row_height + kGlyphPadding;
+		atlas.pixels.assign(static_cast<size_t>(atlas.width) * atlas.height, 0);
+		for (size_t i{}; i < atlas.glyphs.size(); ++i) {
+			const GlyphAtlas::Glyph& glyph = atlas.glyphs[i];
+			for (int row{}; row < glyph.size.y; ++row) {
+				std::memcpy(
+					atlas.pixels.data() + static_cast<size_t>(glyph.position.y + row) * atlas.width + glyph.position.x,
+					bitmaps[i].data() + static_cast<size_t>(row) * glyph.size.x,
+					static_cast<size_t>(glyph.size.x));
+			}
+		}
+		return true;
+	}
+
+	std::string TextRenderer::GetCookedPath(const std::string& font_file, unsigned int pixel_size) {
+		return bf::path(font_file).replace_extension("." + std::to_string(pixel_size) + ".nxtfont").string();
+	}
+
+	std::string TextRenderer::FindCooked(const std::string& font_file, unsigned int pixel_size) {
+		return FileSystem::Instance().FindCooked(font_file, GetCookedPath(font_file, pixel_size));
+	}
+
+	void TextRenderer::LoadFonts() {
+		MemoryScope scope{ MemoryTag::TEXT };
+		Unload();
+		GlyphAtlas atlas;
+		const std::string cooked_file = FindCooked(filename_, default_pixel_size_);
+		if ((cooked_file.empty() || !atlas.Load(cooked_file)) &&
+			!Rasterize(filename_, default_pixel_size_, atlas)) return;
 
+		glGenTextures(1, &atlas_texture_);
+		glBindTexture(GL_TEXTURE_2D, atlas_texture_);
+		const opengl::UnpackAlignmentScope unpack_alignment{ 1 };
+		glTexImage2D(
+			GL_TEXTURE_2D,
+			0,
+			GL_RED,
+			atlas.width,
+			atlas.height,
+			0,
+			GL_RED,
+			GL_UNSIGNED_BYTE,
+			atlas.pixels.data()
+		);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		const glm::fvec2 texel{ 1.0f / atlas.width, 1.0f / atlas.height };
+		for (const GlyphAtlas::Glyph& glyph : atlas.glyphs) {
 			Character character = {
-				texture,
-				glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-				glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-				static_cast<GLuint>(face->glyph->advance.x)
+				glm::fvec4(
+					glyph.position.x * texel.x,
+					glyph.position.y * texel.y,
+					(glyph.position.x + glyph.size.x) * texel.x,
+					(glyph.position.y + glyph.size.y) * texel.y),
+				glyph.size,
+				glyph.bearing,
+				static_cast<GLuint>(glyph.advance)
 			};
-			characters_.insert(std::pair<GLchar, Character>(c, character));
+			characters_.insert(std::pair<GLchar, Character>(static_cast<GLchar>(glyph.code), character));
 		}
-		glBindTexture(GL_TEXTURE_2D, 0);
-		FT_Done_Face(face);
-		FT_Done_FreeType(ft);
+		memory_size_ = atlas.pixels.size();
+		MemoryTracker::Instance().AddGpu(GpuResource::TEXTURE, GL_R8, memory_size_);
 	}
 
 	void TextRenderer::InitBuffers() {
@@ -73,7 +220,7 @@ namespace nxt {
 	}
 
 	TextRenderer::TextRenderer(std::shared_ptr<Shader> shader, size_t width, size_t height) :
-		shader_{ shader }, indices_{ 0, 1, 2, 0, 2, 3 }, default_pixel_size_{} {
+		default_pixel_size_{}, indices_{ 0, 1, 2, 0, 2, 3 }, atlas_texture_{}, memory_size_{}, shader_{ shader } {
 		projection_ = glm::ortho<float>(
 			0.0f,
 			static_cast<GLfloat>(width),
@@ -84,9 +231,22 @@ namespace nxt {
 	}
 
 	TextRenderer::~TextRenderer() {
-		for (std::map<GLchar, Character>::iterator it{ begin(characters_) }; it != end(characters_); ++it) {
-			glDeleteTextures(1, &(it->second.texture_id));
+		Unload();
+	}
+
+	void TextRenderer::Unload() {
+		if (atlas_texture_) {
+			glDeleteTextures(1, &atlas_texture_);
+			MemoryTracker::Instance().RemoveGpu(GpuResource::TEXTURE, GL_R8, memory_size_);
 		}
+		atlas_texture_ = 0;
+		characters_.clear();
+		memory_size_ = 0;
+	}
+
+	bool TextRenderer::Reload() {
+		LoadFonts();
+		return IsLoaded();
 	}
 
 	void TextRenderer::SetFileName(std::string filename, unsigned int pixel_size) {
@@ -96,7 +256,7 @@ namespace nxt {
 	}
 
 	void TextRenderer::Draw(
-		std::string text,
+		boost::string_view text,
 		GLfloat x,
 		GLfloat y,
 		GLfloat scale,
@@ -112,24 +272,28 @@ namespace nxt {
 			shader_->SetVec3("text_color", color);
 		}
 		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, atlas_texture_);
 
-		std::string::const_iterator c;
-		for (c = text.begin(); c != text.end(); ++c) {
-			Character ch = characters_[*c];
+		const auto reference = characters_.find('H');
+		const GLfloat top = reference != characters_.end() ? static_cast<GLfloat>(reference->second.bearing.y) : 0.0f;
+		for (const char c : text) {
+			// glyphs missing from the atlas are skipped, not inserted
+			const auto glyph = characters_.find(c);
+			if (glyph == characters_.end()) continue;
+			const Character& ch = glyph->second;
 
 			GLfloat xpos = x + ch.bearing.x * scale;
-			GLfloat ypos = y + (characters_['H'].bearing.y - ch.bearing.y) * scale;
+			GLfloat ypos = y + (top - ch.bearing.y) * scale;
 
 			GLfloat w = ch.character_size.x * scale;
 			GLfloat h = ch.character_size.y * scale;
 
 			GLfloat vertices[kVerticesPerQuad][kPositionAndTexture] = {
-				{ xpos,     ypos + h, 0.0f, 1.0f },
-				{ xpos + w, ypos + h, 1.0f, 1.0f },
-				{ xpos + w, ypos,     1.0f, 0.0f },
-				{ xpos,     ypos,     0.0f, 0.0f },
+				{ xpos,     ypos + h, ch.uv_rect.x, ch.uv_rect.w },
+				{ xpos + w, ypos + h, ch.uv_rect.z, ch.uv_rect.w },
+				{ xpos + w, ypos,     ch.uv_rect.z, ch.uv_rect.y },
+				{ xpos,     ypos,     ch.uv_rect.x, ch.uv_rect.y },
 			};
-			glBindTexture(GL_TEXTURE_2D, ch.texture_id);
 
 			vb_->Bind();
 			vb_->BufferSubData(vertices, sizeof(vertices));
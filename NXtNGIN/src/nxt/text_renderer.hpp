@@ -4,6 +4,10 @@
 #include <map>
 #include <vector>
 #include <memory>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <iostream>
 #include <GL/glew.h>
 
@@ -11,25 +15,55 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <boost/utility/string_view.hpp>
+
 #include "renderer.hpp"
+#include "gl.hpp"
+#include "filesystem.hpp"
+#include "memory_tracker.hpp"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 namespace nxt {
 	struct Character {
-		GLuint texture_id;
+		// texture coordinates in the glyph atlas, left, top, right, bottom
+		glm::fvec4 uv_rect;
 		glm::ivec2 character_size;
 		glm::ivec2 bearing;
 		GLuint advance;
 	};
 
+	// the glyphs of a font at one pixel size in a single red channel image,
+	// rendered by TextRenderer::Rasterize or read from a cooked .nxtfont
+	struct GlyphAtlas {
+		struct Glyph {
+			std::uint32_t code;
+			glm::ivec2 size;
+			glm::ivec2 bearing;
+			std::uint32_t advance;
+			glm::ivec2 position;
+		};
+
+		unsigned int pixel_size;
+		int width;
+		int height;
+		std::vector<Glyph> glyphs;
+		// top row first
+		std::vector<unsigned char> pixels;
+
+		bool Save(const std::string& file_name) const;
+		bool Load(const std::string& file_name);
+	};
+
 	class TextRenderer {
 	private:
 		std::string filename_;
 		unsigned int default_pixel_size_;
 		std::vector<GLuint> indices_;
 		std::map<GLchar, Character> characters_;
+		GLuint atlas_texture_;
+		size_t memory_size_;
 		static constexpr GLuint kVerticesPerQuad{ 4 };
 		static constexpr GLuint kPositionAndTexture{ 4 };
 
@@ -47,9 +81,27 @@ namespace nxt {
 		TextRenderer(std::shared_ptr<Shader>, size_t width, size_t height);
 		~TextRenderer();
 		// pixel size of 112 is maximum for many Google fonts
+		// takes the cooked atlas next to filename when there is one
 		void SetFileName(std::string filename, unsigned int pixel_size = 48);
+		// frees the glyph atlas, Reload builds it again
+		void Unload();
+		bool Reload();
+		bool IsLoaded() const { return !characters_.empty(); }
+		// video memory of the glyph atlas
+		size_t GetMemorySize() const { return memory_size_; }
+
+		// renders the first glyphs of font_file with FreeType, safe on any thread
+		static bool Rasterize(const std::string& font_file, unsigned int pixel_size, GlyphAtlas& atlas);
+		// <font>.<pixel_size>.nxtfont as written by nxt_cook
+		static std::string GetCookedPath(const std::string& font_file, unsigned int pixel_size);
+		// GetCookedPath when that file exists and is no older than the source,
+		// otherwise empty
+		static std::string FindCooked(const std::string& font_file, unsigned int pixel_size);
+
+		// text only has to live until the call returns, FrameArena::Format
+		// builds it without touching the heap
 		void Draw(
-			std::string text,
+			boost::string_view text,
 			GLfloat x,
 			GLfloat y,
 			GLfloat scale = 1.0f,
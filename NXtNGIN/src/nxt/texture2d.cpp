@@ -1,46 +1,233 @@
-#define STB_IMAGE_IMPLEMENTATION
 #include "texture2d.hpp"
 
 namespace nxt {
-	bool Texture2D::Load(const std::string& file_name, bool gen_mipmaps) {
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLenum Texture2D::GetFormat(int components) {
+		switch (components) {
+		case 1: return GL_RED;
+		case 3: return GL_RGB;
+		case 4: return GL_RGBA;
+		default: return GL_RGBA;
+		}
+	}
 
-		GLenum format;
-		int width, height, components;
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char *image_data = stbi_load(
-			file_name.c_str(),
-			&width,
-			&height,
-			&components,
-			0
-		);
+	GLenum Texture2D::GetInternalFormat(int components) {
+		switch (components) {
+		case 1: return GL_R8;
+		case 3: return GL_RGB8;
+		case 4: return GL_RGBA8;
+		default: return GL_RGBA8;
+		}
+	}
+
+	Texture2D::Texture2D(std::shared_ptr<Shader> shader, std::shared_ptr<Texture2D> storage) :
+		handle_{ storage->handle_ },
+		target_{ storage->target_ },
+		width_{ storage->width_ },
+		height_{ storage->height_ },
+		layers_{ storage->layers_ },
+		levels_{ storage->levels_ },
+		internal_format_{ storage->internal_format_ },
+		placeholder_{ storage->placeholder_ },
+		shader_{ shader },
+		storage_{ storage } {}
+
+	void Texture2D::Detach() {
+		// loading into a shared texture must not overwrite its storage
+		if (!storage_) return;
+		handle_ = 0;
+		storage_.reset();
+	}
+
+	void Texture2D::Unload() {
+		if (storage_) Detach();
+		else if (handle_) glDeleteTextures(1, &handle_);
+		handle_ = 0;
+		UpdateMemoryStats();
+	}
+
+	size_t Texture2D::GetMemorySize() const {
+		if (!handle_) return 0;
+		size_t size{};
+		for (GLsizei level{}; level < levels_; ++level) {
+			const GLsizei width = std::max(width_ >> level, 1);
+			const GLsizei height = std::max(height_ >> level, 1);
+			switch (internal_format_) {
+			case GL_R8: size += static_cast<size_t>(width) * height; break;
+			case GL_RGB8:
+			case GL_RGBA8: size += static_cast<size_t>(width) * height * 4; break;
+			default: size += CompressedImage::GetLevelSize(internal_format_, width, height); break;
+			}
+		}
+		return size * layers_;
+	}
 
-		if (image_data == NULL) {
+	void Texture2D::UpdateMemoryStats() {
+		// textures sharing another one's storage are counted with that one
+		const size_t size = storage_ ? 0 : GetMemorySize();
+		if (size == tracked_size_ && internal_format_ == tracked_format_) return;
+		if (tracked_size_) MemoryTracker::Instance().RemoveGpu(GpuResource::TEXTURE, tracked_format_, tracked_size_);
+		if (size) MemoryTracker::Instance().AddGpu(GpuResource::TEXTURE, internal_format_, size);
+		tracked_size_ = size;
+		tracked_format_ = internal_format_;
+	}
+
+	std::string Texture2D::FindCompressed(const std::string& file_name) {
+		for (const char* extension : { ".dds", ".ktx" }) {
+			bf::path path{ file_name };
+			path.replace_extension(extension);
+			const std::string compressed_file = FileSystem::Instance().FindCooked(file_name, path);
+			if (!compressed_file.empty()) return compressed_file;
+		}
+		return "";
+	}
+
+	bool Texture2D::Decode(const std::string& file_name, bool gen_mipmaps, TextureData& data) {
+		MemoryScope scope{ MemoryTag::TEXTURE };
+		data = TextureData{};
+		const std::string compressed_file = FindCompressed(file_name);
+		if (!compressed_file.empty() && data.compressed.Load(compressed_file) &&
+			CompressedImage::IsSupported(data.compressed.GetInternalFormat())) return true;
+
+		data.compressed = CompressedImage{};
+		if (!TextureCache::Instance().Load(file_name, gen_mipmaps, data.images)) {
 			std::cerr << "ERROR LOADING TEXTURE '" << file_name << "'" << std::endl;
 			return false;
 		}
-		else {
-			switch (components) {
-			case 1:
-				format = GL_RED;
-				break;
-			case 3:
-				format = GL_RGB;
-				break;
-			case 4:
-				format = GL_RGBA;
-				break;
+		return true;
+	}
+
+	bool Texture2D::Decode(const std::vector<std::string>& faces, TextureData& data) {
+		MemoryScope scope{ MemoryTag::TEXTURE };
+		data = TextureData{};
+		bool result{ true };
+		for (size_t i = 0; i < faces.size(); i++) {
+			auto first = std::find(faces.begin(), faces.begin() + i, faces[i]);
+			if (first != faces.begin() + i) {
+				data.faces.push_back(data.faces[first - faces.begin()]);
+				continue;
+			}
+			// cube map faces keep their top-down row order
+			data.images.emplace_back();
+			if (!data.images.back().Load(faces[i], 0, false)) {
+				std::cerr << "CUBEMAP TEXTURE FAILED TO LOAD AT PATH: " << faces[i] << std::endl;
+				result = false;
 			}
+			data.faces.push_back(data.images.size() - 1);
 		}
+		return result;
+	}
 
-		glGenTextures(1, &handle_);
+	bool Texture2D::Load(const TextureData& data) {
+		if (!data.faces.empty()) {
+			std::vector<const Image*> face_images;
+			for (size_t face : data.faces) face_images.push_back(&data.images[face]);
+			return LoadFaces(face_images);
+		}
+		if (!data.compressed.Empty()) return Load(data.compressed);
+		return LoadMipChain(data.images);
+	}
+
+	bool Texture2D::Load(const std::string& file_name, bool gen_mipmaps) {
+		TextureData data;
+		if (!Decode(file_name, gen_mipmaps, data)) return false;
+		return Load(data);
+	}
+
+	bool Texture2D::LoadMipChain(const std::vector<Image>& levels) {
+		if (levels.empty() || levels[0].Empty()) return false;
+		Allocate(
+			TextureTarget::TEXTURE_2D,
+			levels[0].GetWidth(),
+			levels[0].GetHeight(),
+			levels[0].GetComponents(),
+			static_cast<GLsizei>(levels.size()));
+
+		const opengl::UnpackAlignmentScope unpack_alignment{ 1 };
+		glBindTexture(GL_TEXTURE_2D, handle_);
+		for (size_t level{}; level < levels.size(); ++level) {
+			glTexSubImage2D(
+				GL_TEXTURE_2D,
+				static_cast<GLint>(level),
+				0, 0,
+				levels[level].GetWidth(),
+				levels[level].GetHeight(),
+				GetFormat(levels[level].GetComponents()),
+				GL_UNSIGNED_BYTE,
+				levels[level].GetData()
+			);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return true;
+	}
+
+	bool Texture2D::LoadCompressed(const std::string& file_name) {
+		CompressedImage image;
+		if (!image.Load(file_name)) return false;
+		return Load(image);
+	}
+
+	bool Texture2D::Load(const CompressedImage& image) {
+		const GLenum internal_format = image.GetInternalFormat();
+		if (image.Empty() || !CompressedImage::IsSupported(internal_format)) return false;
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		target_ = GL_TEXTURE_2D;
+		width_ = image.GetLevel(0).width;
+		height_ = image.GetLevel(0).height;
+		layers_ = 1;
+		levels_ = static_cast<GLsizei>(image.GetLevelCount());
+		internal_format_ = internal_format;
+		placeholder_ = false;
+
+		Detach();
+		if (!handle_) glGenTextures(1, &handle_);
+		glBindTexture(GL_TEXTURE_2D, handle_);
+		for (size_t level{}; level < image.GetLevelCount(); ++level) {
+			const CompressedImage::Level& info = image.GetLevel(level);
+			glCompressedTexImage2D(
+				GL_TEXTURE_2D,
+				static_cast<GLint>(level),
+				internal_format,
+				info.width,
+				info.height,
+				0,
+				static_cast<GLsizei>(info.size),
+				image.GetLevelData(level)
+			);
+		}
+		SetStorageParameters();
+		glBindTexture(GL_TEXTURE_2D, 0);
+		UpdateMemoryStats();
+		return true;
+	}
+
+	bool Texture2D::Load(
+		const unsigned char* data,
+		int width,
+		int height,
+		int components,
+		bool gen_mipmaps) {
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		GLenum format = GetFormat(components);
+		target_ = GL_TEXTURE_2D;
+		width_ = width;
+		height_ = height;
+		layers_ = 1;
+		levels_ = gen_mipmaps ? Image::GetLevelCount(width, height) : 1;
+		internal_format_ = GetInternalFormat(components);
+		placeholder_ = false;
+
+		Detach();
+		if (!handle_) glGenTextures(1, &handle_);
 		glBindTexture(GL_TEXTURE_2D, handle_);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gen_mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		const opengl::UnpackAlignmentScope unpack_alignment{ 1 };
 
 		glTexImage2D(
 			GL_TEXTURE_2D,
@@ -51,90 +238,322 @@ namespace nxt {
 			0,
 			format,
 			GL_UNSIGNED_BYTE,
-			image_data
+			data
 		);
 
 		if (gen_mipmaps) { glGenerateMipmap(GL_TEXTURE_2D); }
 
-		stbi_image_free(image_data);
 		glBindTexture(GL_TEXTURE_2D, 0);
+		UpdateMemoryStats();
 		return true;
 	}
 
 	bool Texture2D::Load(const std::vector<std::string>& faces) {
-		is_cube_map_ = true;
-		glGenTextures(1, &handle_);
+		TextureData data;
+		Decode(faces, data);
+		return Load(data);
+	}
+
+	bool Texture2D::Load(const std::vector<Image>& faces) {
+		std::vector<const Image*> face_images;
+		for (const Image& face : faces) face_images.push_back(&face);
+		return LoadFaces(face_images);
+	}
+
+	bool Texture2D::LoadFaces(const std::vector<const Image*>& faces) {
+		target_ = GL_TEXTURE_CUBE_MAP;
+		layers_ = static_cast<GLsizei>(faces.size());
+		levels_ = 1;
+		placeholder_ = false;
+		Detach();
+		if (!handle_) glGenTextures(1, &handle_);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, handle_);
+		const opengl::UnpackAlignmentScope unpack_alignment{ 1 };
 
-		GLenum format;
-		int width, height, components;
 		for (size_t i = 0; i < faces.size(); i++) {
-			unsigned char *data = stbi_load(
-				faces[i].c_str(),
-				&width,
-				&height,
-				&components,
-				0
+			if (faces[i]->Empty()) continue;
+			GLenum format = GetFormat(faces[i]->GetComponents());
+			width_ = faces[i]->GetWidth();
+			height_ = faces[i]->GetHeight();
+			internal_format_ = GetInternalFormat(faces[i]->GetComponents());
+			glTexImage2D(
+				GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i),
+				0,
+				format,
+				width_,
+				height_,
+				0,
+				format,
+				GL_UNSIGNED_BYTE,
+				faces[i]->GetData()
 			);
+		}
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		UpdateMemoryStats();
+		return true;
+	}
+
+	bool Texture2D::LoadPlaceholder(TextureTarget target) {
+		const unsigned char white[]{ 255, 255, 255, 255 };
+		if (target == TextureTarget::CUBE_MAP) {
+			Detach();
+			if (!handle_) glGenTextures(1, &handle_);
+			target_ = GL_TEXTURE_CUBE_MAP;
+			width_ = height_ = 1;
+			layers_ = 6;
+			levels_ = 1;
+			internal_format_ = GL_RGBA8;
+			glBindTexture(GL_TEXTURE_CUBE_MAP, handle_);
+			for (GLenum face{}; face < 6; ++face) {
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+			}
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+			UpdateMemoryStats();
+		}
+		else {
+			assert(target == TextureTarget::TEXTURE_2D);
+			Load(white, 1, 1, 4, false);
+		}
+		placeholder_ = true;
+		return true;
+	}
+
+	bool Texture2D::Allocate(
+		TextureTarget target,
+		GLsizei width,
+		GLsizei height,
+		int components,
+		GLsizei levels) {
+		assert(target != TextureTarget::TEXTURE_2D_ARRAY);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		target_ = (target == TextureTarget::CUBE_MAP) ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+		width_ = width;
+		height_ = height;
+		layers_ = (target == TextureTarget::CUBE_MAP) ? 6 : 1;
+		levels_ = levels;
+		placeholder_ = false;
+		internal_format_ = GetInternalFormat(components);
 
-			switch (components) {
-			case 1:
-				format = GL_RED;
-				break;
-			case 3:
-				format = GL_RGB;
-				break;
-			case 4:
-				format = GL_RGBA;
-				break;
+		Detach();
+		if (handle_) glDeleteTextures(1, &handle_);
+		glGenTextures(1, &handle_);
+		glBindTexture(target_, handle_);
+
+		const GLenum internal_format = internal_format_;
+		if (GLEW_ARB_texture_storage) {
+			glTexStorage2D(target_, levels, internal_format, width, height);
+		}
+		else {
+			const GLenum format = GetFormat(components);
+			for (GLsizei level{}; level < levels; ++level) {
+				const GLsizei level_width = std::max(width >> level, 1);
+				const GLsizei level_height = std::max(height >> level, 1);
+				for (GLsizei layer{}; layer < layers_; ++layer) {
+					const GLenum image_target = (target_ == GL_TEXTURE_CUBE_MAP)
+						? GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(layer)
+						: GL_TEXTURE_2D;
+					glTexImage2D(image_target, level, internal_format, level_width, level_height,
+						0, format, GL_UNSIGNED_BYTE, nullptr);
+				}
 			}
+		}
+
+		SetStorageParameters();
+		glBindTexture(target_, 0);
+		UpdateMemoryStats();
+		return true;
+	}
 
-			if (data) {
-				glTexImage2D(
-					GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i),
+	bool Texture2D::AllocateCompressed(
+		GLsizei width,
+		GLsizei height,
+		GLenum internal_format,
+		GLsizei levels) {
+		if (!CompressedImage::IsSupported(internal_format)) return false;
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		target_ = GL_TEXTURE_2D;
+		width_ = width;
+		height_ = height;
+		layers_ = 1;
+		levels_ = levels;
+		placeholder_ = false;
+		internal_format_ = internal_format;
+
+		Detach();
+		if (handle_) glDeleteTextures(1, &handle_);
+		glGenTextures(1, &handle_);
+		glBindTexture(GL_TEXTURE_2D, handle_);
+
+		if (GLEW_ARB_texture_storage) {
+			glTexStorage2D(GL_TEXTURE_2D, levels, internal_format, width, height);
+		}
+		else {
+			for (GLsizei level{}; level < levels; ++level) {
+				const GLsizei level_width = std::max(width >> level, 1);
+				const GLsizei level_height = std::max(height >> level, 1);
+				glCompressedTexImage2D(GL_TEXTURE_2D, level, internal_format, level_width, level_height, 0,
+					static_cast<GLsizei>(CompressedImage::GetLevelSize(internal_format, level_width, level_height)), nullptr);
+			}
+		}
+
+		SetStorageParameters();
+		glBindTexture(GL_TEXTURE_2D, 0);
+		UpdateMemoryStats();
+		return true;
+	}
+
+	void Texture2D::SetStorageParameters() const {
+		const GLint wrap = (target_ == GL_TEXTURE_CUBE_MAP) ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+		glTexParameteri(target_, GL_TEXTURE_WRAP_S, wrap);
+		glTexParameteri(target_, GL_TEXTURE_WRAP_T, wrap);
+		glTexParameteri(target_, GL_TEXTURE_WRAP_R, wrap);
+		glTexParameteri(target_, GL_TEXTURE_MIN_FILTER, levels_ > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(target_, GL_TEXTURE_MAX_LEVEL, levels_ - 1);
+	}
+
+	void Texture2D::SetBaseLevel(GLint level) const {
+		glBindTexture(target_, handle_);
+		glTexParameteri(target_, GL_TEXTURE_BASE_LEVEL, level);
+		glBindTexture(target_, 0);
+	}
+
+	void Texture2D::Swap(Texture2D& other) {
+		std::swap(handle_, other.handle_);
+		std::swap(target_, other.target_);
+		std::swap(width_, other.width_);
+		std::swap(height_, other.height_);
+		std::swap(layers_, other.layers_);
+		std::swap(levels_, other.levels_);
+		std::swap(internal_format_, other.internal_format_);
+		std::swap(placeholder_, other.placeholder_);
+		std::swap(storage_, other.storage_);
+		// the counted storage moves with the GL object
+		std::swap(tracked_size_, other.tracked_size_);
+		std::swap(tracked_format_, other.tracked_format_);
+	}
+
+	bool Texture2D::LoadArray(
+		const std::vector<std::string>& layer_files,
+		bool gen_mipmaps,
+		std::vector<bool>* opaque_layers) {
+		MemoryScope scope{ MemoryTag::TEXTURE };
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		if (opaque_layers) opaque_layers->assign(layer_files.size(), false);
+		if (layer_files.empty()) return false;
+
+		target_ = GL_TEXTURE_2D_ARRAY;
+		layers_ = static_cast<GLsizei>(layer_files.size());
+		levels_ = 1;
+		internal_format_ = GL_RGBA8;
+		placeholder_ = false;
+		width_ = 0;
+		height_ = 0;
+		Detach();
+		if (!handle_) glGenTextures(1, &handle_);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, handle_);
+		const opengl::UnpackAlignmentScope unpack_alignment{ 1 };
+
+		// layers are expanded to RGBA so they can share one internal format
+		for (size_t i = 0; i < layer_files.size(); ++i) {
+			Image image;
+			if (!image.Load(layer_files[i], 4)) {
+				std::cerr << "ERROR LOADING TEXTURE ARRAY LAYER '" << layer_files[i] << "'" << std::endl;
+				continue;
+			}
+			const int width = image.GetWidth();
+			const int height = image.GetHeight();
+			const unsigned char *data = image.GetData();
+			// sized by the first layer that loads, a missing one stays empty
+			if (width_ == 0) {
+				width_ = width;
+				height_ = height;
+				if (gen_mipmaps) levels_ = Image::GetLevelCount(width, height);
+				glTexImage3D(
+					GL_TEXTURE_2D_ARRAY,
 					0,
-					format,
-					width,
-					height,
+					GL_RGBA8,
+					width_,
+					height_,
+					layers_,
 					0,
-					format,
+					GL_RGBA,
 					GL_UNSIGNED_BYTE,
-					data
+					nullptr
 				);
 			}
+			if (width != width_ || height != height_) {
+				std::cerr << "TEXTURE ARRAY LAYER '" << layer_files[i] << "' DOES NOT MATCH THE SIZE OF THE FIRST LAYER LOADED" << std::endl;
+			}
 			else {
-				std::cerr << "CUBEMAP TEXTURE FAILED TO LOAD AT PATH: " << faces[i] << std::endl;
+				if (opaque_layers) {
+					const size_t texel_count = static_cast<size_t>(width) * height;
+					bool opaque{ true };
+					for (size_t texel{}; texel < texel_count && opaque; ++texel) {
+						opaque = (data[texel * 4 + 3] == 255);
+					}
+					(*opaque_layers)[i] = opaque;
+				}
+				glTexSubImage3D(
+					GL_TEXTURE_2D_ARRAY,
+					0,
+					0, 0, static_cast<GLint>(i),
+					width,
+					height,
+					1,
+					GL_RGBA,
+					GL_UNSIGNED_BYTE,
+					data
+				);
 			}
-			stbi_image_free(data);
 		}
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-		return true;
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, gen_mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		if (gen_mipmaps) { glGenerateMipmap(GL_TEXTURE_2D_ARRAY); }
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		UpdateMemoryStats();
+		return (width_ > 0);
 	}
 
 	void Texture2D::Bind(const GLchar* uniform, GLuint texunit) const {
 		assert(texunit >= 0 && texunit < MAX_NUMBER_TEX_UNITS);
 		shader_->SetInt(uniform, texunit);
+		BindUnit(texunit);
+	}
+
+	void Texture2D::BindUnit(GLuint texunit) const {
+		assert(texunit < MAX_NUMBER_TEX_UNITS);
 		glActiveTexture(GL_TEXTURE0 + texunit);
-		if (is_cube_map_) {
-			glBindTexture(GL_TEXTURE_CUBE_MAP, handle_);
-		}
-		else {
-			glBindTexture(GL_TEXTURE_2D, handle_);
-		}
+		glBindTexture(target_, handle_);
 	}
 
 	void Texture2D::Unbind(GLuint texunit) const {
 		assert(texunit >= 0 && texunit < MAX_NUMBER_TEX_UNITS);
 		glActiveTexture(GL_TEXTURE0 + texunit);
-		if (is_cube_map_) {
-			glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-		}
-		else {
-			glBindTexture(GL_TEXTURE_2D, 0);
+		glBindTexture(target_, 0);
+	}
+
+	TextureTarget Texture2D::GetTarget() const {
+		switch (target_) {
+		case GL_TEXTURE_CUBE_MAP: return TextureTarget::CUBE_MAP;
+		case GL_TEXTURE_2D_ARRAY: return TextureTarget::TEXTURE_2D_ARRAY;
+		default: return TextureTarget::TEXTURE_2D;
 		}
 	}
 }
@@ -7,26 +7,79 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <utility>
+#include <algorithm>
 
-#include <stb-master/stb_image.h>
 #include <GL/glew.h>
 
 #include "shader.hpp"
+#include "image.hpp"
+#include "compressed_image.hpp"
+#include "texture_cache.hpp"
+#include "gl.hpp"
+#include "filesystem.hpp"
+#include "memory_tracker.hpp"
 
 namespace nxt {
+	enum class TextureTarget {
+		TEXTURE_2D,
+		CUBE_MAP,
+		TEXTURE_2D_ARRAY
+	};
+
+	// a texture read and decoded without touching GL, see Texture2D::Decode
+	struct TextureData {
+		CompressedImage compressed;
+		// the mip chain finest first, or the distinct cube map faces
+		std::vector<Image> images;
+		// cube maps only, the image each face samples
+		std::vector<size_t> faces;
+	};
+
 	class Texture2D {
 	private:
 		GLuint handle_{};
-		bool is_cube_map_{ false };
+		GLenum target_{ GL_TEXTURE_2D };
+		GLsizei width_{};
+		GLsizei height_{};
+		GLsizei layers_{ 1 };
+		GLsizei levels_{ 1 };
+		GLenum internal_format_{ GL_RGBA8 };
+		bool placeholder_{ false };
 		std::shared_ptr<Shader> shader_;
+		// set for textures sharing the GL object of another one
+		std::shared_ptr<Texture2D> storage_;
+		// what MemoryTracker was last told about this texture's storage
+		size_t tracked_size_{};
+		GLenum tracked_format_{};
+
+		void SetStorageParameters() const;
+		void UpdateMemoryStats();
+		void Detach();
+		bool LoadFaces(const std::vector<const Image*>& faces);
+
 	public:
+		static GLenum GetFormat(int components);
+		static GLenum GetInternalFormat(int components);
+		// cooked .dds or .ktx next to the source image, empty when there is none
+		// or it is older than the image
+		static std::string FindCompressed(const std::string& file_name);
+		// the file and decode work of Load, safe on any thread
+		static bool Decode(const std::string& file_name, bool gen_mipmaps, TextureData& data);
+		static bool Decode(const std::vector<std::string>& faces, TextureData& data);
+
 		Texture2D(std::shared_ptr<Shader> shader) : shader_{ shader } {}
 		Texture2D() : Texture2D{ nullptr } {}
+		// binds through shader but samples the already loaded storage, which
+		// stays alive as long as this texture does
+		Texture2D(std::shared_ptr<Shader> shader, std::shared_ptr<Texture2D> storage);
 		Texture2D(
 			std::shared_ptr<Shader> shader,
-			const std::vector<std::string>& faces)
+			const std::vector<std::string>& files,
+			TextureTarget target = TextureTarget::CUBE_MAP)
 			: Texture2D(shader) {
-			Load(faces);
+			if (target == TextureTarget::TEXTURE_2D_ARRAY) LoadArray(files);
+			else Load(files);
 		}
 		Texture2D(
 			std::shared_ptr<Shader> shader,
@@ -38,13 +91,73 @@ namespace nxt {
 
 		Texture2D(const Texture2D&) = delete;
 		Texture2D& operator=(const Texture2D&) = delete;
-		~Texture2D() { glDeleteTextures(1, &handle_); }
+		~Texture2D() { Unload(); }
 
+		// prefers a cooked sibling the driver can sample, then the TextureCache,
+		// over decoding the source
 		bool Load(const std::string& file_name, bool gen_mipmaps = true);
+		bool LoadCompressed(const std::string& file_name);
+		bool Load(const CompressedImage& image);
+		// levels finest first, each half the size of the one before
+		bool LoadMipChain(const std::vector<Image>& levels);
+		// faces naming the same file are decoded once
 		bool Load(const std::vector<std::string>& faces);
+		bool Load(const std::vector<Image>& faces);
+		// the upload left after Decode
+		bool Load(const TextureData& data);
+		// rows are uploaded as given, the first row ends up at v = 0
+		bool Load(
+			const unsigned char* data,
+			int width,
+			int height,
+			int components,
+			bool gen_mipmaps = true);
+		// equal-size layers sampled by index through a sampler2DArray,
+		// opaque_layers optionally receives which layers have no transparent texel
+		bool LoadArray(
+			const std::vector<std::string>& layer_files,
+			bool gen_mipmaps = true,
+			std::vector<bool>* opaque_layers = nullptr);
+
+		// 1x1 white stand-in until the real data is uploaded into the same handle
+		bool LoadPlaceholder(TextureTarget target = TextureTarget::TEXTURE_2D);
+		// storage for every level without data, immutable where the driver
+		// supports texture storage; filled with glTexSubImage2D afterwards
+		bool Allocate(
+			TextureTarget target,
+			GLsizei width,
+			GLsizei height,
+			int components,
+			GLsizei levels = 1);
+		bool AllocateCompressed(
+			GLsizei width,
+			GLsizei height,
+			GLenum internal_format,
+			GLsizei levels = 1);
+		// finest level the sampler may use, for textures streamed coarse to fine
+		void SetBaseLevel(GLint level) const;
+		// exchanges the GL objects, so a texture filled in the background can
+		// replace a placeholder that is already referenced elsewhere
+		void Swap(Texture2D& other);
+		// frees the GL object, any Load afterwards creates a new one
+		void Unload();
+		GLuint GetHandle() const { return handle_; }
 
 		void Bind(const GLchar* uniform, GLuint texunit = 0) const;
+		// binds without touching a sampler uniform, for renderers owning their shader
+		void BindUnit(GLuint texunit = 0) const;
 		void Unbind(GLuint texunit = 0) const;
+
+		TextureTarget GetTarget() const;
+		GLsizei GetWidth() const { return width_; }
+		GLsizei GetHeight() const { return height_; }
+		GLsizei GetLayerCount() const { return layers_; }
+		GLsizei GetLevelCount() const { return levels_; }
+		GLenum GetStorageFormat() const { return internal_format_; }
+		// video memory of every level and layer, rgb8 counted as padded to four bytes
+		size_t GetMemorySize() const;
+		const std::shared_ptr<Shader>& GetShader() const { return shader_; }
+		bool IsPlaceholder() const { return placeholder_; }
 	};
 }
 
@@ -0,0 +1,226 @@
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <stb-master/stb_rect_pack.h>
+#ifdef _MSC_VER
+#define STBI_MSC_SECURE_CRT
+#endif
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb-master/stb_image_write.h>
+
+#include "texture_atlas.hpp"
+
+namespace nxt {
+	TextureAtlas::TextureAtlas(
+		std::shared_ptr<Shader> shader,
+		int max_size,
+		int padding) :
+		max_size_{ max_size }, padding_{ padding },
+		width_{}, height_{}, shader_{ shader } {}
+
+	TextureAtlas::~TextureAtlas() {}
+
+	bool TextureAtlas::Add(const std::string& name, const std::string& file_name) {
+		Image image;
+		if (!image.Load(file_name, kComponents)) {
+			std::cerr << "ERROR LOADING ATLAS IMAGE '" << file_name << "'" << std::endl;
+			return false;
+		}
+		return Add(name, image.GetData(), image.GetWidth(), image.GetHeight());
+	}
+
+	bool TextureAtlas::Add(
+		const std::string& name,
+		const unsigned char* rgba,
+		int width,
+		int height) {
+		for (const PendingImage& image : pending_) {
+			if (image.name == name) return false;
+		}
+		if (width + 2 * padding_ > max_size_ || height + 2 * padding_ > max_size_) {
+			std::cerr << "ATLAS IMAGE '" << name << "' EXCEEDS THE MAXIMUM ATLAS SIZE" << std::endl;
+			return false;
+		}
+		PendingImage image{ name, width, height, {} };
+		image.pixels.assign(rgba, rgba + static_cast<size_t>(width) * height * kComponents);
+		pending_.push_back(std::move(image));
+		return true;
+	}
+
+	bool TextureAtlas::Build(bool gen_mipmaps) {
+		if (!Layout()) return false;
+		texture_ = std::make_shared<Texture2D>(shader_);
+		return texture_->Load(pixels_.data(), width_, height_, kComponents, gen_mipmaps);
+	}
+
+	bool TextureAtlas::Layout() {
+		if (pending_.empty()) return false;
+
+		// smallest power of two square that holds the summed area, doubled
+		// along alternating axes until everything fits
+		size_t area{};
+		for (const PendingImage& image : pending_) {
+			area += static_cast<size_t>(image.width + 2 * padding_) * (image.height + 2 * padding_);
+		}
+		int width{ 1 }, height{ 1 };
+		while (static_cast<size_t>(width) * height < area) {
+			if (width <= height) width *= 2;
+			else height *= 2;
+		}
+		if (width > max_size_ || height > max_size_) {
+			std::cerr << "ATLAS IMAGES DO NOT FIT INTO " << max_size_ << "x" << max_size_ << std::endl;
+			return false;
+		}
+
+		std::vector<glm::ivec2> positions;
+		while (!Pack(positions, width, height)) {
+			if (width >= max_size_ && height >= max_size_) {
+				std::cerr << "ATLAS IMAGES DO NOT FIT INTO " << max_size_ << "x" << max_size_ << std::endl;
+				return false;
+			}
+			if (width <= height && width < max_size_) width *= 2;
+			else height *= 2;
+		}
+
+		width_ = width;
+		height_ = height;
+		Compose(positions);
+		pending_.clear();
+		return true;
+	}
+
+	bool TextureAtlas::Pack(std::vector<glm::ivec2>& positions, int width, int height) const {
+		std::vector<stbrp_node> nodes(width);
+		std::vector<stbrp_rect> rects(pending_.size());
+		for (size_t i{}; i < pending_.size(); ++i) {
+			rects[i].id = static_cast<int>(i);
+			rects[i].w = static_cast<stbrp_coord>(pending_[i].width + 2 * padding_);
+			rects[i].h = static_cast<stbrp_coord>(pending_[i].height + 2 * padding_);
+		}
+
+		stbrp_context context;
+		stbrp_init_target(&context, width, height, nodes.data(), static_cast<int>(nodes.size()));
+		if (!stbrp_pack_rects(&context, rects.data(), static_cast<int>(rects.size()))) return false;
+
+		positions.resize(pending_.size());
+		for (const stbrp_rect& rect : rects) {
+			positions[rect.id] = glm::ivec2{ rect.x + padding_, rect.y + padding_ };
+		}
+		return true;
+	}
+
+	void TextureAtlas::Compose(const std::vector<glm::ivec2>& positions) {
+		pixels_.assign(static_cast<size_t>(width_) * height_ * kComponents, 0);
+		regions_.clear();
+
+		for (size_t i{}; i < pending_.size(); ++i) {
+			const PendingImage& image = pending_[i];
+			const glm::ivec2& position = positions[i];
+			// images are stored bottom row first, so a region placed at the
+			// top-left position y starts at buffer row height - y - image height
+			const int first_row = height_ - position.y - image.height;
+			const size_t row_size = static_cast<size_t>(image.width) * kComponents;
+			for (int row{ -padding_ }; row < image.height + padding_; ++row) {
+				// rows and columns of the padding repeat the nearest edge
+				const int source_row = std::min(std::max(row, 0), image.height - 1);
+				const auto source = image.pixels.begin() + source_row * row_size;
+				const auto target = pixels_.begin() + ((static_cast<size_t>(first_row + row)) * width_ + position.x) * kComponents;
+				std::copy(source, source + row_size, target);
+				for (int column{ 1 }; column <= padding_; ++column) {
+					std::copy(source, source + kComponents, target - column * kComponents);
+					std::copy(source + row_size - kComponents, source + row_size, target + row_size + (column - 1) * kComponents);
+				}
+			}
+			AddRegion(image.name, glm::ivec4{ position.x, position.y, image.width, image.height });
+		}
+	}
+
+	void TextureAtlas::AddRegion(const std::string& name, const glm::ivec4& pixel_rect) {
+		AtlasRegion region;
+		region.pixel_rect = pixel_rect;
+		region.uv_rect = glm::fvec4{
+			static_cast<float>(pixel_rect.x) / width_,
+			1.0f - static_cast<float>(pixel_rect.y + pixel_rect.w) / height_,
+			static_cast<float>(pixel_rect.z) / width_,
+			static_cast<float>(pixel_rect.w) / height_
+		};
+		regions_[name] = region;
+	}
+
+	bool TextureAtlas::Save(const std::string& image_file, const std::string& table_file) const {
+		if (pixels_.empty()) return false;
+
+		stbi_flip_vertically_on_write(1);
+		int written = stbi_write_png(
+			image_file.c_str(),
+			width_,
+			height_,
+			kComponents,
+			pixels_.data(),
+			width_ * kComponents);
+		stbi_flip_vertically_on_write(0);
+		if (!written) {
+			std::cerr << "ERROR WRITING ATLAS IMAGE '" << image_file << "'" << std::endl;
+			return false;
+		}
+
+		std::ofstream ofs(table_file, std::ios::out | std::ios::trunc);
+		if (!ofs) {
+			std::cerr << "ERROR WRITING ATLAS TABLE '" << table_file << "'" << std::endl;
+			return false;
+		}
+		ofs << "atlas " << width_ << " " << height_ << "\n";
+		for (const auto& region : regions_) {
+			ofs << region.second.pixel_rect.x << " "
+				<< region.second.pixel_rect.y << " "
+				<< region.second.pixel_rect.z << " "
+				<< region.second.pixel_rect.w << " "
+				<< region.first << "\n";
+		}
+		return true;
+	}
+
+	bool TextureAtlas::Load(const std::string& image_file, const std::string& table_file, bool gen_mipmaps) {
+		// parses the packed table in place, or the loose file
+		const FileBufferPtr packed = FileSystem::Instance().GetBuffer(table_file);
+		std::unique_ptr<std::istream> stream;
+		if (packed) {
+			stream.reset(new boost::interprocess::ibufferstream(packed->GetData(), packed->GetSize()));
+		}
+		else {
+			stream.reset(new std::ifstream(table_file, std::ios::in));
+		}
+		std::istream& ifs = *stream;
+		std::string tag;
+		if (!ifs || !(ifs >> tag >> width_ >> height_) || tag != "atlas") {
+			std::cerr << "ERROR LOADING ATLAS TABLE '" << table_file << "'" << std::endl;
+			return false;
+		}
+
+		texture_ = std::make_shared<Texture2D>(shader_);
+		if (!texture_->Load(image_file, gen_mipmaps)) return false;
+		if (texture_->GetWidth() != width_ || texture_->GetHeight() != height_) {
+			std::cerr << "ATLAS IMAGE '" << image_file << "' DOES NOT MATCH ITS TABLE" << std::endl;
+			return false;
+		}
+
+		regions_.clear();
+		std::string name;
+		glm::ivec4 pixel_rect;
+		// the name is the rest of the line after the one separating space
+		while (ifs >> pixel_rect.x >> pixel_rect.y >> pixel_rect.z >> pixel_rect.w &&
+			ifs.ignore(1) && std::getline(ifs, name)) {
+			if (!name.empty() && name.back() == '\r') name.pop_back();
+			AddRegion(name, pixel_rect);
+		}
+		return true;
+	}
+
+	bool TextureAtlas::HasRegion(const std::string& name) const {
+		return (regions_.find(name) != regions_.end());
+	}
+
+	const AtlasRegion& TextureAtlas::GetRegion(const std::string& name) const {
+		auto it = regions_.find(name);
+		assert(it != regions_.end());
+		return it->second;
+	}
+}
@@ -0,0 +1,85 @@
+#ifndef TEXTURE_ATLAS_HPP_
+#define TEXTURE_ATLAS_HPP_
+
+#include <map>
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include <boost/interprocess/streams/bufferstream.hpp>
+
+#include "texture2d.hpp"
+
+namespace nxt {
+	struct AtlasRegion {
+		// top-left origin in atlas pixels, as written to the lookup table
+		glm::ivec4 pixel_rect;
+		// (u, v, width, height) in the convention of SpriteBatch::Draw
+		glm::fvec4 uv_rect;
+	};
+
+	class TextureAtlas {
+	public:
+		TextureAtlas(
+			std::shared_ptr<Shader> shader,
+			int max_size = 4096,
+			int padding = 2);
+		~TextureAtlas();
+
+		// queue images for packing, a name can only be added once. The
+		// padding around each repeats its edge texels, so filtering and mip
+		// levels do not pull in the neighbours or the empty space
+		bool Add(const std::string& name, const std::string& file_name);
+		bool Add(
+			const std::string& name,
+			const unsigned char* rgba,
+			int width,
+			int height);
+		// packs the queued images, composes the atlas and uploads it
+		bool Build(bool gen_mipmaps = false);
+		// Build without the upload, all Save needs and no GL context required
+		bool Layout();
+
+		// offline output: atlas image (png) plus a plain text uv lookup table,
+		// one "x y width height name" line per region so names may hold spaces
+		bool Save(const std::string& image_file, const std::string& table_file) const;
+		// runtime input of a previously saved atlas, no packing involved
+		bool Load(const std::string& image_file, const std::string& table_file, bool gen_mipmaps = false);
+
+		bool HasRegion(const std::string& name) const;
+		const AtlasRegion& GetRegion(const std::string& name) const;
+		const std::map<std::string, AtlasRegion>& GetRegions() const { return regions_; }
+		const std::shared_ptr<Texture2D>& GetTexture() const { return texture_; }
+		glm::ivec2 GetSize() const { return glm::ivec2{ width_, height_ }; }
+	private:
+		struct PendingImage {
+			std::string name;
+			int width;
+			int height;
+			// RGBA, bottom row first like every Texture2D upload
+			std::vector<unsigned char> pixels;
+		};
+		static constexpr int kComponents{ 4 };
+
+		int max_size_;
+		int padding_;
+		int width_;
+		int height_;
+		std::vector<PendingImage> pending_;
+		std::vector<unsigned char> pixels_;
+		std::map<std::string, AtlasRegion> regions_;
+		std::shared_ptr<Shader> shader_;
+		std::shared_ptr<Texture2D> texture_;
+
+		bool Pack(std::vector<glm::ivec2>& positions, int width, int height) const;
+		void Compose(const std::vector<glm::ivec2>& positions);
+		void AddRegion(const std::string& name, const glm::ivec4& pixel_rect);
+	};
+}
+
+#endif // TEXTURE_ATLAS_HPP_
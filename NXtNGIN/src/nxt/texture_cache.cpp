@@ -0,0 +1,210 @@
+#include "texture_cache.hpp"
+#include "memory_tracker.hpp"
+
+namespace bi = boost::interprocess;
+
+namespace nxt {
+	namespace {
+		constexpr std::uint64_t kFNVOffset{ 0xcbf29ce484222325ull };
+		constexpr std::uint64_t kFNVPrime{ 0x100000001b3ull };
+
+		std::uint64_t Mix(std::uint64_t hash, std::uint64_t value) {
+			for (int i{}; i < 8; ++i, value >>= 8) {
+				hash = (hash ^ (value & 0xFF)) * kFNVPrime;
+			}
+			return hash;
+		}
+
+		// keeps the mapping alive for the images pointing into it
+		struct Mapping {
+			bi::file_mapping file;
+			bi::mapped_region region;
+		};
+
+		std::uint64_t Align(std::uint64_t offset) { return (offset + 15) & ~static_cast<std::uint64_t>(15); }
+	}
+
+	TextureCache& TextureCache::Instance() {
+		static std::unique_ptr<TextureCache> instance{ std::unique_ptr<TextureCache>(new TextureCache()) };
+		return *instance;
+	}
+
+	TextureCache::TextureCache() : enabled_{ true }, budget_{ kDefaultBudget } {
+		boost::system::error_code error;
+		directory_ = bf::temp_directory_path(error) / "nxt_texture_cache";
+	}
+
+	void TextureCache::SetDirectory(const std::string& directory) {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		directory_ = directory;
+	}
+
+	bf::path TextureCache::GetEntryPath(std::uint64_t key) const {
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.nxtc", static_cast<unsigned long long>(key));
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		return directory_ / name;
+	}
+
+	std::uint64_t TextureCache::HashFile(const std::string& file_name) {
+		if (const FileBufferPtr packed = FileSystem::Instance().GetBuffer(file_name)) {
+			std::uint64_t hash{ kFNVOffset };
+			for (const char c : packed->GetView()) {
+				hash = (hash ^ static_cast<unsigned char>(c)) * kFNVPrime;
+			}
+			return hash;
+		}
+
+		std::ifstream ifs(file_name, std::ios::in | std::ios::binary);
+		if (!ifs) return 0;
+		std::uint64_t hash{ kFNVOffset };
+		std::vector<char> buffer(1 << 16);
+		while (ifs) {
+			ifs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			const std::streamsize count = ifs.gcount();
+			for (std::streamsize i{}; i < count; ++i) {
+				hash = (hash ^ static_cast<unsigned char>(buffer[i])) * kFNVPrime;
+			}
+		}
+		return hash;
+	}
+
+	bool TextureCache::Load(const std::string& file_name, bool gen_mipmaps, std::vector<Image>& levels) {
+		MemoryScope scope{ MemoryTag::TEXTURE };
+		levels.clear();
+		bf::path entry_path;
+		if (enabled_) {
+			const std::uint64_t hash = HashFile(file_name);
+			if (hash == 0) return false;
+			entry_path = GetEntryPath(Mix(Mix(hash, gen_mipmaps ? 1 : 0), kVersion));
+			if (Read(entry_path, levels)) return true;
+		}
+
+		Image image;
+		if (!image.Load(file_name)) return false;
+		const int level_count = gen_mipmaps ? Image::GetLevelCount(image.GetWidth(), image.GetHeight()) : 1;
+		levels.push_back(std::move(image));
+		for (int level{ 1 }; level < level_count; ++level) {
+			levels.push_back(levels.back().Downsample());
+		}
+		if (enabled_ && Write(entry_path, levels)) Prune(entry_path);
+		return true;
+	}
+
+	bool TextureCache::Read(const bf::path& path, std::vector<Image>& levels) const {
+		boost::system::error_code error;
+		if (!bf::is_regular_file(path, error)) return false;
+		// the last use orders pruning
+		bf::last_write_time(path, std::time(nullptr), error);
+
+		auto mapping = std::make_shared<Mapping>();
+		try {
+			// copy on write, so the pixels stay writable like decoded ones
+			mapping->file = bi::file_mapping(path.string().c_str(), bi::read_only);
+			mapping->region = bi::mapped_region(mapping->file, bi::copy_on_write);
+		}
+		catch (const bi::interprocess_exception& ex) {
+			std::cerr << "ERROR MAPPING TEXTURE CACHE '" << path.string() << "': " << ex.what() << std::endl;
+			return false;
+		}
+
+		unsigned char *base = static_cast<unsigned char*>(mapping->region.get_address());
+		const std::uint64_t size = mapping->region.get_size();
+		if (size < sizeof(Header)) return false;
+		Header header;
+		std::memcpy(&header, base, sizeof(header));
+		if (header.magic != kMagic || header.version != kVersion ||
+			header.components == 0 || header.components > 4 ||
+			sizeof(Header) + header.level_count * sizeof(LevelHeader) > size) return false;
+
+		std::vector<Image> result;
+		for (std::uint32_t level{}; level < header.level_count; ++level) {
+			LevelHeader level_header;
+			std::memcpy(&level_header, base + sizeof(Header) + level * sizeof(LevelHeader), sizeof(level_header));
+			const std::uint64_t level_size =
+				static_cast<std::uint64_t>(level_header.width) * level_header.height * header.components;
+			if (level_header.offset + level_size > size) return false;
+			result.emplace_back(
+				static_cast<int>(level_header.width),
+				static_cast<int>(level_header.height),
+				static_cast<int>(header.components),
+				base + level_header.offset,
+				mapping);
+		}
+		levels = std::move(result);
+		return !levels.empty();
+	}
+
+	bool TextureCache::Write(const bf::path& path, const std::vector<Image>& levels) const {
+		boost::system::error_code error;
+		bf::create_directories(path.parent_path(), error);
+
+		Header header{ kMagic, kVersion, static_cast<std::uint32_t>(levels[0].GetComponents()), static_cast<std::uint32_t>(levels.size()) };
+		std::vector<LevelHeader> level_headers;
+		std::uint64_t offset = Align(sizeof(Header) + levels.size() * sizeof(LevelHeader));
+		for (const Image& level : levels) {
+			level_headers.push_back(LevelHeader{
+				static_cast<std::uint32_t>(level.GetWidth()),
+				static_cast<std::uint32_t>(level.GetHeight()),
+				offset });
+			offset = Align(offset + level.GetSize());
+		}
+
+		// written aside and renamed, readers never see half an entry
+		const bf::path temp_path = path.parent_path() / bf::unique_path("%%%%-%%%%-%%%%.tmp", error);
+		{
+			std::ofstream ofs(temp_path.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!ofs) return false;
+			ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			ofs.write(reinterpret_cast<const char*>(level_headers.data()),
+				static_cast<std::streamsize>(level_headers.size() * sizeof(LevelHeader)));
+			const char padding[16]{};
+			for (size_t i{}; i < levels.size(); ++i) {
+				const std::uint64_t position = static_cast<std::uint64_t>(ofs.tellp());
+				ofs.write(padding, static_cast<std::streamsize>(level_headers[i].offset - position));
+				ofs.write(reinterpret_cast<const char*>(levels[i].GetData()), static_cast<std::streamsize>(levels[i].GetSize()));
+			}
+			if (!ofs) {
+				ofs.close();
+				bf::remove(temp_path, error);
+				return false;
+			}
+		}
+		bf::rename(temp_path, path, error);
+		if (error) {
+			bf::remove(temp_path, error);
+			return false;
+		}
+		return true;
+	}
+
+	void TextureCache::Prune(const bf::path& keep) const {
+		std::lock_guard<std::mutex> lock{ prune_mutex_ };
+		struct Entry {
+			bf::path path;
+			std::uintmax_t size;
+			std::time_t last_used;
+		};
+
+		boost::system::error_code error;
+		std::vector<Entry> entries;
+		std::uintmax_t total{};
+		for (bf::directory_iterator it{ keep.parent_path(), error }, end; !error && it != end; it.increment(error)) {
+			const bf::path& path = it->path();
+			if (path.extension() != ".nxtc" || !bf::is_regular_file(path, error)) continue;
+			Entry entry{ path, bf::file_size(path, error), bf::last_write_time(path, error) };
+			if (error) continue;
+			total += entry.size;
+			entries.push_back(entry);
+		}
+		if (total <= budget_) return;
+
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.last_used < b.last_used; });
+		for (const Entry& entry : entries) {
+			if (total <= budget_) break;
+			if (entry.path == keep) continue;
+			// entries still mapped elsewhere may refuse, they go next time
+			if (bf::remove(entry.path, error) && !error) total -= entry.size;
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef TEXTURE_CACHE_HPP_
+#define TEXTURE_CACHE_HPP_
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <algorithm>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "image.hpp"
+#include "filesystem.hpp"
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// Decoded mip chains on disk, keyed by a hash of the source file's bytes
+	// and the load options. Entries are raw texels behind a small level table,
+	// mapped back in without copying, so a warm start skips decoding as well as
+	// mip generation. Entries past the size budget are pruned oldest first,
+	// a hit refreshes the modification time of its file. Safe to use from
+	// several threads at once.
+	class TextureCache : public NonCopyable, public NonMoveable {
+	public:
+		static constexpr std::uintmax_t kDefaultBudget{ 1ull << 30 };
+
+		static TextureCache& Instance();
+
+		// defaults to nxt_texture_cache in the temp directory, created on first write
+		void SetDirectory(const std::string& directory);
+		void SetEnabled(bool enabled) { enabled_ = enabled; }
+		bool IsEnabled() const { return enabled_; }
+		// bytes the directory may hold, checked after each write
+		void SetBudget(std::uintmax_t bytes) { budget_ = bytes; }
+		std::uintmax_t GetBudget() const { return budget_; }
+
+		// bottom row first levels of file_name, one without gen_mipmaps, mapped
+		// from the cache when the source is unchanged; otherwise decoded and
+		// filtered on the calling thread, then written back
+		bool Load(const std::string& file_name, bool gen_mipmaps, std::vector<Image>& levels);
+
+		// 64 bit FNV-1a of the file's contents, 0 when it cannot be read
+		static std::uint64_t HashFile(const std::string& file_name);
+	private:
+		static constexpr std::uint32_t kMagic{ 0x4354584E }; // "NXTC"
+		static constexpr std::uint32_t kVersion{ 1 };
+
+		struct Header {
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t components;
+			std::uint32_t level_count;
+		};
+		struct LevelHeader {
+			std::uint32_t width;
+			std::uint32_t height;
+			std::uint64_t offset;
+		};
+
+		mutable std::mutex mutex_;
+		// one prune at a time, the others would only race for the same files
+		mutable std::mutex prune_mutex_;
+		bf::path directory_;
+		std::atomic<bool> enabled_;
+		std::atomic<std::uintmax_t> budget_;
+
+		TextureCache();
+		bf::path GetEntryPath(std::uint64_t key) const;
+		bool Read(const bf::path& path, std::vector<Image>& levels) const;
+		bool Write(const bf::path& path, const std::vector<Image>& levels) const;
+		// removes the least recently used entries but keep until under budget
+		void Prune(const bf::path& keep) const;
+	};
+}
+
+#endif // TEXTURE_CACHE_HPP_
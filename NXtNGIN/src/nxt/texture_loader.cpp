@@ -0,0 +1,279 @@
+#include "texture_loader.hpp"
+
+namespace nxt {
+	TextureLoader& TextureLoader::Instance() {
+		static std::unique_ptr<TextureLoader> instance{ std::unique_ptr<TextureLoader>(new TextureLoader()) };
+		return *instance;
+	}
+
+	TextureLoader::TextureLoader() : pending_{ 0 }, decoding_{ 0 } {}
+
+	TextureLoader::~TextureLoader() {
+		// decode tasks still running on the pool refer to this loader
+		while (decoding_ > 0) std::this_thread::yield();
+	}
+
+	std::shared_ptr<Texture2D> TextureLoader::Load(
+		const std::shared_ptr<Shader>& shader,
+		const std::string& file_name,
+		bool gen_mipmaps) {
+		auto job = std::make_shared<Job>();
+		job->texture = std::make_shared<Texture2D>(shader);
+		job->texture->LoadPlaceholder(TextureTarget::TEXTURE_2D);
+		job->files.push_back(file_name);
+		job->cube_map = false;
+		job->gen_mipmaps = gen_mipmaps;
+		job->failed = false;
+		job->started = false;
+		job->visible = false;
+		job->next_image = 0;
+		job->next_row = 0;
+		Enqueue(job);
+		return job->texture;
+	}
+
+	std::shared_ptr<Texture2D> TextureLoader::Load(
+		const std::shared_ptr<Shader>& shader,
+		const std::vector<std::string>& faces) {
+		auto job = std::make_shared<Job>();
+		job->texture = std::make_shared<Texture2D>(shader);
+		job->texture->LoadPlaceholder(TextureTarget::CUBE_MAP);
+		job->files = faces;
+		job->cube_map = true;
+		job->gen_mipmaps = false;
+		job->failed = false;
+		job->started = false;
+		job->visible = false;
+		job->next_image = 0;
+		job->next_row = 0;
+		Enqueue(job);
+		return job->texture;
+	}
+
+	void TextureLoader::Enqueue(const std::shared_ptr<Job>& job) {
+		++pending_;
+		++decoding_;
+		ThreadPool::Instance().Submit([this, job]() {
+			Decode(*job);
+			{
+				std::lock_guard<std::mutex> lock{ mutex_ };
+				decoded_.push_back(job);
+			}
+			--decoding_;
+		});
+	}
+
+	void TextureLoader::Decode(Job& job) const {
+		MemoryScope scope{ MemoryTag::TEXTURE };
+		if (!job.cube_map) {
+			const std::string compressed_file = Texture2D::FindCompressed(job.files[0]);
+			if (!compressed_file.empty() && job.compressed.Load(compressed_file)) {
+				if (CompressedImage::IsSupported(job.compressed.GetInternalFormat())) return;
+				job.compressed = CompressedImage{};
+			}
+		}
+
+		if (!job.cube_map) {
+			// mapped from the cache, or decoded and filtered right here
+			if (!TextureCache::Instance().Load(job.files[0], job.gen_mipmaps, job.images)) {
+				std::cerr << "ERROR LOADING TEXTURE '" << job.files[0] << "'" << std::endl;
+				job.failed = true;
+			}
+			return;
+		}
+
+		job.images.resize(job.files.size());
+		for (size_t i{}; i < job.files.size(); ++i) {
+			// a repeated face views the pixels of its first decode, which the
+			// job owns for as long as the view
+			auto first = std::find(job.files.begin(), job.files.begin() + i, job.files[i]);
+			if (first != job.files.begin() + i) {
+				Image& source = job.images[first - job.files.begin()];
+				if (!source.Empty()) {
+					job.images[i] = Image{ source.GetWidth(), source.GetHeight(), source.GetComponents(),
+						source.GetData(), std::shared_ptr<const void>(source.GetData(), [](const void*) {}) };
+				}
+				continue;
+			}
+			// cube map faces keep their top-down row order
+			if (!job.images[i].Load(job.files[i], 0, false)) {
+				std::cerr << "ERROR LOADING TEXTURE '" << job.files[i] << "'" << std::endl;
+				job.failed = true;
+			}
+		}
+	}
+
+	bool TextureLoader::Begin(Job& job) const {
+		job.visible = false;
+		job.next_image = 0;
+		job.next_row = 0;
+		if (!job.compressed.Empty()) {
+			job.staging = std::make_unique<Texture2D>();
+			return job.staging->AllocateCompressed(
+				job.compressed.GetLevel(0).width,
+				job.compressed.GetLevel(0).height,
+				job.compressed.GetInternalFormat(),
+				static_cast<GLsizei>(job.compressed.GetLevelCount()));
+		}
+
+		// failed 2d textures keep their placeholder, cube maps upload what decoded
+		auto first = std::find_if(job.images.begin(), job.images.end(),
+			[](const Image& image) { return !image.Empty(); });
+		if ((job.failed && !job.cube_map) || first == job.images.end()) return false;
+
+		job.staging = std::make_unique<Texture2D>();
+		job.staging->Allocate(
+			job.cube_map ? TextureTarget::CUBE_MAP : TextureTarget::TEXTURE_2D,
+			first->GetWidth(),
+			first->GetHeight(),
+			first->GetComponents(),
+			job.cube_map ? 1 : static_cast<GLsizei>(job.images.size()));
+		return true;
+	}
+
+	size_t TextureLoader::GetImageIndex(const Job& job) const {
+		return job.cube_map ? job.next_image : GetUploadCount(job) - 1 - job.next_image;
+	}
+
+	size_t TextureLoader::GetUploadCount(const Job& job) const {
+		return job.compressed.Empty() ? job.images.size() : job.compressed.GetLevelCount();
+	}
+
+	Texture2D& TextureLoader::GetUploadTarget(Job& job) const {
+		return job.visible ? *job.texture : *job.staging;
+	}
+
+	bool TextureLoader::UploadCompressedLevel(Job& job) {
+		const size_t level = GetImageIndex(job);
+		const CompressedImage::Level& info = job.compressed.GetLevel(level);
+		const unsigned char *data = job.compressed.GetLevelData(level);
+		// compressed levels go up whole, the block rows are not worth splitting
+		const bool staged = (info.size <= static_cast<size_t>(pool_->GetBufferSize()));
+		if (staged && !pool_->Stage(data, static_cast<GLsizeiptr>(info.size))) return false;
+
+		glBindTexture(GL_TEXTURE_2D, GetUploadTarget(job).GetHandle());
+		glCompressedTexSubImage2D(
+			GL_TEXTURE_2D,
+			static_cast<GLint>(level),
+			0, 0,
+			info.width,
+			info.height,
+			job.compressed.GetInternalFormat(),
+			static_cast<GLsizei>(info.size),
+			staged ? nullptr : data
+		);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		if (staged) pool_->Submit();
+
+		++job.next_image;
+		job.fences.push_back(std::make_pair(static_cast<GLint>(level), glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)));
+		return true;
+	}
+
+	bool TextureLoader::UploadSlice(Job& job) {
+		if (!job.compressed.Empty()) return UploadCompressedLevel(job);
+
+		const size_t index = GetImageIndex(job);
+		const Image& image = job.images[index];
+		const GLint level = job.cube_map ? 0 : static_cast<GLint>(index);
+		const GLenum gl_target = job.cube_map ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+		const GLenum image_target = job.cube_map
+			? GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(index)
+			: GL_TEXTURE_2D;
+
+		if (!image.Empty()) {
+			const size_t row_size = static_cast<size_t>(image.GetWidth()) * image.GetComponents();
+			const GLint rows = std::min<GLint>(
+				image.GetHeight() - job.next_row,
+				std::max<GLint>(static_cast<GLint>(pool_->GetBufferSize() / row_size), 1));
+			const unsigned char *data = image.GetData() + job.next_row * row_size;
+			// rows wider than a pixel buffer fall back to a direct upload
+			const bool staged = (row_size <= static_cast<size_t>(pool_->GetBufferSize()));
+			if (staged && !pool_->Stage(data, static_cast<GLsizeiptr>(rows * row_size))) return false;
+
+			const opengl::UnpackAlignmentScope unpack_alignment{ 1 };
+			glBindTexture(gl_target, GetUploadTarget(job).GetHandle());
+			glTexSubImage2D(
+				image_target,
+				level,
+				0, job.next_row,
+				image.GetWidth(),
+				rows,
+				Texture2D::GetFormat(image.GetComponents()),
+				GL_UNSIGNED_BYTE,
+				staged ? nullptr : data
+			);
+			glBindTexture(gl_target, 0);
+			if (staged) pool_->Submit();
+			job.next_row += rows;
+			if (job.next_row < image.GetHeight()) return true;
+		}
+
+		// every level is fenced for 2d textures, cube maps only show up complete
+		job.next_row = 0;
+		++job.next_image;
+		if (!job.cube_map || job.next_image == GetUploadCount(job)) {
+			job.fences.push_back(std::make_pair(level, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)));
+		}
+		return true;
+	}
+
+	bool TextureLoader::Complete(Job& job) const {
+		while (!job.fences.empty() && IsFenceSignaled(job.fences.front().second)) {
+			glDeleteSync(job.fences.front().second);
+			if (!job.visible) {
+				job.texture->Swap(*job.staging);
+				job.staging.reset();
+				job.visible = true;
+			}
+			if (!job.cube_map) job.texture->SetBaseLevel(job.fences.front().first);
+			job.fences.pop_front();
+		}
+		return job.fences.empty() && job.next_image == GetUploadCount(job);
+	}
+
+	size_t TextureLoader::Update(float budget_ms) {
+		const auto begin = std::chrono::steady_clock::now();
+		if (!pool_) pool_ = std::make_unique<PixelBufferPool>();
+
+		size_t completed{};
+		auto finished = std::remove_if(finishing_.begin(), finishing_.end(),
+			[this](const std::shared_ptr<Job>& job) { return Complete(*job); });
+		completed += static_cast<size_t>(finishing_.end() - finished);
+		finishing_.erase(finished, finishing_.end());
+		// large textures become visible while their finer levels still stream
+		if (uploading_ && uploading_->started) Complete(*uploading_);
+
+		for (;;) {
+			const std::chrono::duration<float, std::milli> elapsed{ std::chrono::steady_clock::now() - begin };
+			if (elapsed.count() >= budget_ms) break;
+
+			if (!uploading_) {
+				std::lock_guard<std::mutex> lock{ mutex_ };
+				if (decoded_.empty()) break;
+				uploading_ = std::move(decoded_.front());
+				decoded_.pop_front();
+			}
+			if (!uploading_->started) {
+				uploading_->started = true;
+				if (!Begin(*uploading_)) {
+					uploading_.reset();
+					++completed;
+					continue;
+				}
+			}
+			if (!UploadSlice(*uploading_)) break;
+			if (uploading_->next_image == GetUploadCount(*uploading_)) {
+				finishing_.push_back(std::move(uploading_));
+			}
+		}
+		pending_ -= completed;
+		return completed;
+	}
+
+	void TextureLoader::Flush() {
+		while (pending_ > 0) {
+			if (Update(1000.0f) == 0) std::this_thread::yield();
+		}
+	}
+}
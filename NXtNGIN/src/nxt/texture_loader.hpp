@@ -0,0 +1,96 @@
+#ifndef TEXTURE_LOADER_HPP_
+#define TEXTURE_LOADER_HPP_
+
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "texture2d.hpp"
+#include "image.hpp"
+#include "compressed_image.hpp"
+#include "texture_cache.hpp"
+#include "pixel_buffer_pool.hpp"
+#include "thread_pool.hpp"
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// Decodes images and builds their mip chains on the thread pool, or maps
+	// them from the TextureCache, then streams them through pixel buffers on
+	// the GL thread, coarsest level first. Returned textures hold a
+	// placeholder until the first level has arrived and sharpen as the finer
+	// levels complete. 2d textures with a cooked .dds or .ktx sibling skip
+	// decoding and stream whole blocks.
+	class TextureLoader : public NonCopyable, public NonMoveable {
+	public:
+		static TextureLoader& Instance();
+		~TextureLoader();
+
+		std::shared_ptr<Texture2D> Load(
+			const std::shared_ptr<Shader>& shader,
+			const std::string& file_name,
+			bool gen_mipmaps = true);
+		std::shared_ptr<Texture2D> Load(
+			const std::shared_ptr<Shader>& shader,
+			const std::vector<std::string>& faces);
+
+		// stages decoded rows until budget_ms is spent or every pixel buffer is
+		// in flight, returns how many textures completed; call once a frame on
+		// the GL thread
+		size_t Update(float budget_ms = 2.0f);
+		// blocks until every queued texture is uploaded
+		void Flush();
+
+		size_t GetPendingCount() const { return pending_; }
+		bool IsIdle() const { return pending_ == 0; }
+	private:
+		struct Job {
+			std::shared_ptr<Texture2D> texture;
+			// receives the uploads until it is swapped into texture
+			std::unique_ptr<Texture2D> staging;
+			std::vector<std::string> files;
+			// mip chain of a 2d texture, faces of a cube map
+			std::vector<Image> images;
+			// cooked mip chain, used instead of images when not empty
+			CompressedImage compressed;
+			bool cube_map;
+			bool gen_mipmaps;
+			bool failed;
+			bool started;
+			bool visible;
+			size_t next_image; // in upload order
+			GLint next_row;
+			// (level, fence) behind each fully submitted level
+			std::deque<std::pair<GLint, GLsync>> fences;
+		};
+
+		std::mutex mutex_;
+		std::deque<std::shared_ptr<Job>> decoded_;
+		std::atomic<size_t> pending_;
+		std::atomic<size_t> decoding_;
+
+		// GL thread only
+		std::unique_ptr<PixelBufferPool> pool_;
+		std::shared_ptr<Job> uploading_;
+		std::vector<std::shared_ptr<Job>> finishing_;
+
+		TextureLoader();
+		void Enqueue(const std::shared_ptr<Job>& job);
+		void Decode(Job& job) const;
+		bool Begin(Job& job) const;
+		bool UploadSlice(Job& job);
+		bool UploadCompressedLevel(Job& job);
+		bool Complete(Job& job) const;
+		size_t GetImageIndex(const Job& job) const;
+		size_t GetUploadCount(const Job& job) const;
+		Texture2D& GetUploadTarget(Job& job) const;
+	};
+}
+
+#endif // TEXTURE_LOADER_HPP_
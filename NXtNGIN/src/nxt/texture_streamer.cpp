@@ -0,0 +1,306 @@
+#include "texture_streamer.hpp"
+
+namespace nxt {
+	TextureStreamer& TextureStreamer::Instance() {
+		static std::unique_ptr<TextureStreamer> instance{ std::unique_ptr<TextureStreamer>(new TextureStreamer()) };
+		return *instance;
+	}
+
+	TextureStreamer::TextureStreamer() :
+		decoding_{ 0 }, frame_{ 1 }, budget_{ kDefaultBudget }, resident_bytes_{} {}
+
+	TextureStreamer::~TextureStreamer() {
+		// decode tasks still running on the pool refer to this streamer
+		while (decoding_ > 0) std::this_thread::yield();
+	}
+
+	std::shared_ptr<Texture2D> TextureStreamer::Load(
+		const std::shared_ptr<Shader>& shader,
+		const std::string& file_name,
+		const std::string& name) {
+		auto entry = std::make_shared<Entry>();
+		entry->name = name;
+		entry->file_name = file_name;
+		entry->texture = std::make_shared<Texture2D>(shader);
+		entry->texture->LoadPlaceholder(TextureTarget::TEXTURE_2D);
+		entry->compressed_format = 0;
+		entry->components = 0;
+		entry->failed = false;
+		entry->ready = false;
+		entry->released = false;
+		entry->reloading = false;
+		entry->level_count = 0;
+		entry->tail_level = 0;
+		entry->finest_level = 0;
+		entry->resident_level = 0;
+		entry->wanted_level = 0;
+		entry->last_used = 0;
+		entry->resident_bytes = 0;
+		entries_[entry->texture.get()] = entry;
+		Schedule(entry);
+		return entry->texture;
+	}
+
+	void TextureStreamer::Schedule(const std::shared_ptr<Entry>& entry) {
+		++decoding_;
+		ThreadPool::Instance().Submit([this, entry]() {
+			Decode(*entry);
+			{
+				std::lock_guard<std::mutex> lock{ mutex_ };
+				decoded_.push_back(entry);
+			}
+			--decoding_;
+		});
+	}
+
+	// only touches the chain, the GL thread leaves it alone until the entry
+	// is handed back through decoded_
+	void TextureStreamer::Decode(Entry& entry) const {
+		MemoryScope scope{ MemoryTag::TEXTURE };
+		const std::string compressed_file = Texture2D::FindCompressed(entry.file_name);
+		if (!compressed_file.empty() && entry.compressed.Load(compressed_file)) {
+			if (CompressedImage::IsSupported(entry.compressed.GetInternalFormat())) return;
+			entry.compressed = CompressedImage{};
+		}
+
+		if (!TextureCache::Instance().Load(entry.file_name, true, entry.levels) || entry.levels.empty()) {
+			std::cerr << "ERROR LOADING TEXTURE '" << entry.file_name << "'" << std::endl;
+			entry.failed = true;
+		}
+	}
+
+	void TextureStreamer::GetLevelSize(const Entry& entry, GLsizei level, GLsizei& width, GLsizei& height) const {
+		width = entry.level_sizes[level].x;
+		height = entry.level_sizes[level].y;
+	}
+
+	size_t TextureStreamer::GetResidentSize(const Entry& entry, GLsizei level) const {
+		size_t size{};
+		for (GLsizei i{ level }; i < entry.level_count; ++i) size += entry.level_bytes[i];
+		return size;
+	}
+
+	void TextureStreamer::Activate(Entry& entry) {
+		entry.level_sizes.clear();
+		entry.level_bytes.clear();
+		if (!entry.compressed.Empty()) {
+			entry.compressed_format = entry.compressed.GetInternalFormat();
+			entry.level_count = static_cast<GLsizei>(entry.compressed.GetLevelCount());
+			for (GLsizei i{}; i < entry.level_count; ++i) {
+				const CompressedImage::Level& info = entry.compressed.GetLevel(i);
+				entry.level_sizes.emplace_back(info.width, info.height);
+				entry.level_bytes.push_back(info.size);
+			}
+		}
+		else {
+			entry.components = entry.levels.front().GetComponents();
+			entry.level_count = static_cast<GLsizei>(entry.levels.size());
+			for (const Image& image : entry.levels) {
+				entry.level_sizes.emplace_back(image.GetWidth(), image.GetHeight());
+				// drivers pad rgb8 to four bytes a texel
+				entry.level_bytes.push_back(static_cast<size_t>(image.GetWidth()) * image.GetHeight()
+					* (entry.components == 3 ? 4 : entry.components));
+			}
+		}
+
+		entry.tail_level = 0;
+		for (GLsizei level{}; level < entry.level_count; ++level) {
+			GLsizei width, height;
+			GetLevelSize(entry, level, width, height);
+			entry.tail_level = level;
+			if (std::max(width, height) <= kResidentTailSize) break;
+		}
+		if (entry.last_used == 0) entry.wanted_level = entry.tail_level;
+		entry.ready = MakeResident(entry, entry.tail_level);
+	}
+
+	bool TextureStreamer::MakeResident(Entry& entry, GLsizei level) {
+		assert(!entry.released);
+		GLsizei width, height;
+		GetLevelSize(entry, level, width, height);
+		const GLsizei levels = entry.level_count - level;
+
+		// a texture with fewer levels releases the memory of the dropped ones,
+		// the coarser levels are uploaded again since they are a third at most
+		Texture2D texture;
+		if (entry.compressed_format != 0) {
+			if (!texture.AllocateCompressed(width, height, entry.compressed_format, levels)) return false;
+		}
+		else if (!texture.Allocate(TextureTarget::TEXTURE_2D, width, height, entry.components, levels)) {
+			return false;
+		}
+
+		glBindTexture(GL_TEXTURE_2D, texture.GetHandle());
+		for (GLsizei i{ level }; i < entry.level_count; ++i) UploadLevel(entry, i, i - level);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		entry.texture->Swap(texture);
+
+		resident_bytes_ -= entry.resident_bytes;
+		entry.resident_bytes = GetResidentSize(entry, level);
+		resident_bytes_ += entry.resident_bytes;
+		entry.resident_level = level;
+		if (level == 0) ReleaseLevels(entry);
+		return true;
+	}
+
+	// staged through the pixel buffer pool, a buffer at a time, whatever
+	// finds no free buffer goes up straight from the chain
+	void TextureStreamer::UploadLevel(const Entry& entry, GLsizei level, GLint target_level) {
+		const GLsizeiptr buffer_size = pool_->GetBufferSize();
+		if (entry.compressed_format != 0) {
+			const CompressedImage::Level& info = entry.compressed.GetLevel(level);
+			const unsigned char *data = entry.compressed.GetLevelData(level);
+			// compressed levels go up whole, the block rows are not worth splitting
+			const bool staged = (info.size <= static_cast<size_t>(buffer_size))
+				&& pool_->Stage(data, static_cast<GLsizeiptr>(info.size));
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, target_level, 0, 0, info.width, info.height,
+				entry.compressed_format, static_cast<GLsizei>(info.size), staged ? nullptr : data);
+			if (staged) pool_->Submit();
+			return;
+		}
+
+		const Image& image = entry.levels[level];
+		const size_t row_size = static_cast<size_t>(image.GetWidth()) * image.GetComponents();
+		const GLint slice_rows = static_cast<GLint>(static_cast<size_t>(buffer_size) / row_size);
+		const opengl::UnpackAlignmentScope unpack_alignment{ 1 };
+		for (GLint row{}; row < image.GetHeight();) {
+			const unsigned char *data = image.GetData() + row * row_size;
+			GLint rows = std::min(image.GetHeight() - row, slice_rows);
+			const bool staged = (rows > 0) && pool_->Stage(data, static_cast<GLsizeiptr>(rows * row_size));
+			if (!staged) rows = image.GetHeight() - row;
+			glTexSubImage2D(GL_TEXTURE_2D, target_level, 0, row, image.GetWidth(), rows,
+				Texture2D::GetFormat(image.GetComponents()), GL_UNSIGNED_BYTE, staged ? nullptr : data);
+			if (staged) pool_->Submit();
+			row += rows;
+		}
+	}
+
+	void TextureStreamer::ReleaseLevels(Entry& entry) const {
+		entry.levels.clear();
+		entry.levels.shrink_to_fit();
+		entry.compressed = CompressedImage{};
+		entry.released = true;
+	}
+
+	void TextureStreamer::Request(const std::shared_ptr<Texture2D>& texture, float screen_size) {
+		auto it = entries_.find(texture.get());
+		if (it == entries_.end()) return;
+		Entry& entry = *it->second;
+		if (!entry.ready) return;
+
+		GLsizei width, height;
+		GetLevelSize(entry, 0, width, height);
+		// one texel a pixel, a level finer halves the texel footprint
+		const float ratio = static_cast<float>(std::max(width, height)) / std::max(screen_size, 1.0f);
+		const GLsizei level = std::max(std::min(
+			static_cast<GLsizei>(std::max(std::floor(std::log2(std::max(ratio, 1.0f))), 0.0f)),
+			entry.tail_level), entry.finest_level);
+
+		// the finest request of a frame wins
+		entry.wanted_level = (entry.last_used == frame_) ? std::min(entry.wanted_level, level) : level;
+		entry.last_used = frame_;
+	}
+
+	float TextureStreamer::GetScreenSize(
+		const glm::fvec3& center,
+		float radius,
+		const glm::fvec3& eye,
+		float fov_degrees,
+		float viewport_height) {
+		const float distance = std::max(glm::length(center - eye) - radius, 0.01f);
+		return radius / (distance * std::tan(glm::radians(fov_degrees) * 0.5f)) * viewport_height;
+	}
+
+	bool TextureStreamer::EvictOne(const Entry* keep) {
+		Entry *victim{ nullptr };
+		for (auto& item : entries_) {
+			Entry& entry = *item.second;
+			if (&entry == keep || !entry.ready || entry.last_used >= frame_ || entry.resident_level >= entry.tail_level) continue;
+			if (entry.released) {
+				// evictable once its chain is back, a failed reload keeps it resident
+				if (!entry.reloading) {
+					entry.reloading = true;
+					Schedule(item.second);
+				}
+				continue;
+			}
+			if (!victim || entry.last_used < victim->last_used) victim = &entry;
+		}
+		if (!victim) return false;
+		if (!MakeResident(*victim, victim->resident_level + 1)) {
+			std::cerr << "ERROR SHRINKING TEXTURE '" << victim->name << "'" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	void TextureStreamer::Update(float budget_ms) {
+		const auto begin = std::chrono::steady_clock::now();
+		if (!pool_) pool_ = std::make_unique<PixelBufferPool>();
+		auto out_of_time = [&]() {
+			const std::chrono::duration<float, std::milli> elapsed{ std::chrono::steady_clock::now() - begin };
+			return elapsed.count() >= budget_ms;
+		};
+
+		for (;;) {
+			std::shared_ptr<Entry> entry;
+			{
+				std::lock_guard<std::mutex> lock{ mutex_ };
+				if (decoded_.empty()) break;
+				entry = std::move(decoded_.front());
+				decoded_.pop_front();
+			}
+			if (entry->failed) continue;
+			if (entry->reloading) {
+				entry->released = false;
+				entry->reloading = false;
+			}
+			else {
+				Activate(*entry);
+			}
+		}
+
+		// a lowered budget gives memory back even without new demand
+		while (resident_bytes_ > budget_ && EvictOne(nullptr)) {}
+
+		// last frame's most wanted textures first, one level a step
+		std::vector<Entry*> candidates;
+		for (auto& item : entries_) {
+			Entry& entry = *item.second;
+			if (entry.ready && entry.last_used == frame_ && entry.wanted_level < entry.resident_level) {
+				candidates.push_back(&entry);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) {
+			return (a->resident_level - a->wanted_level) > (b->resident_level - b->wanted_level);
+		});
+
+		for (Entry *entry : candidates) {
+			while (entry->wanted_level < entry->resident_level && !out_of_time()) {
+				const size_t grow = GetResidentSize(*entry, entry->resident_level - 1) - entry->resident_bytes;
+				while (resident_bytes_ + grow > budget_ && EvictOne(entry)) {}
+				if (resident_bytes_ + grow > budget_) break;
+				if (!MakeResident(*entry, entry->resident_level - 1)) {
+					// not asked for again, a failure each frame would keep evicting
+					std::cerr << "ERROR GROWING TEXTURE '" << entry->name << "'" << std::endl;
+					entry->finest_level = entry->resident_level;
+					entry->wanted_level = entry->resident_level;
+					break;
+				}
+			}
+		}
+		++frame_;
+	}
+
+	std::vector<TextureStreamer::Stats> TextureStreamer::GetStats() const {
+		std::vector<Stats> stats;
+		for (const auto& item : entries_) {
+			const Entry& entry = *item.second;
+			Stats stat{ entry.name, 0, 0, entry.level_count, entry.resident_level, entry.wanted_level, entry.resident_bytes };
+			if (entry.ready) GetLevelSize(entry, 0, stat.width, stat.height);
+			stats.push_back(stat);
+		}
+		std::sort(stats.begin(), stats.end(), [](const Stats& a, const Stats& b) { return a.name < b.name; });
+		return stats;
+	}
+}
@@ -0,0 +1,131 @@
+#ifndef TEXTURE_STREAMER_HPP_
+#define TEXTURE_STREAMER_HPP_
+
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "texture2d.hpp"
+#include "image.hpp"
+#include "compressed_image.hpp"
+#include "texture_cache.hpp"
+#include "pixel_buffer_pool.hpp"
+#include "thread_pool.hpp"
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// Keeps the mip chain of streamed textures in system memory, mapped from
+	// the TextureCache when it is warm, and only the levels their on-screen
+	// size asks for in video memory. Textures start with the levels up to
+	// kResidentTailSize, finer levels follow the demand reported through
+	// Request and are dropped from the least recently used textures once the
+	// budget would be exceeded. A fully resident texture releases its chain,
+	// it is decoded again before the texture may shrink.
+	class TextureStreamer : public NonCopyable, public NonMoveable {
+	public:
+		static constexpr GLsizei kResidentTailSize{ 128 };
+		static constexpr size_t kDefaultBudget{ 256u << 20 };
+
+		struct Stats {
+			std::string name;
+			GLsizei width;
+			GLsizei height;
+			GLsizei level_count;
+			// finest level in video memory and the finest one asked for
+			GLsizei resident_level;
+			GLsizei wanted_level;
+			size_t resident_bytes;
+		};
+
+		static TextureStreamer& Instance();
+		~TextureStreamer();
+
+		// returns a placeholder right away, decoded on the thread pool
+		std::shared_ptr<Texture2D> Load(
+			const std::shared_ptr<Shader>& shader,
+			const std::string& file_name,
+			const std::string& name);
+
+		// screen_size is the height in pixels the texture covers this frame
+		void Request(const std::shared_ptr<Texture2D>& texture, float screen_size);
+		// projected diameter of a bounding sphere for a perspective camera
+		static float GetScreenSize(
+			const glm::fvec3& center,
+			float radius,
+			const glm::fvec3& eye,
+			float fov_degrees,
+			float viewport_height);
+
+		// moves residency toward the last frame's requests until budget_ms is
+		// spent, call once a frame on the GL thread
+		void Update(float budget_ms = 2.0f);
+
+		void SetBudget(size_t bytes) { budget_ = bytes; }
+		size_t GetBudget() const { return budget_; }
+		size_t GetResidentBytes() const { return resident_bytes_; }
+		std::vector<Stats> GetStats() const;
+	private:
+		struct Entry {
+			std::string name;
+			std::string file_name;
+			std::shared_ptr<Texture2D> texture;
+			// either a decoded mip chain or a cooked one
+			std::vector<Image> levels;
+			CompressedImage compressed;
+			// taken on activation, they outlive a released chain
+			std::vector<glm::ivec2> level_sizes;
+			std::vector<size_t> level_bytes;
+			GLenum compressed_format;
+			int components;
+			bool failed;
+			bool ready;
+			bool released;
+			bool reloading;
+			GLsizei level_count;
+			GLsizei tail_level;
+			// finest level a texture could be allocated with
+			GLsizei finest_level;
+			GLsizei resident_level;
+			GLsizei wanted_level;
+			size_t last_used;
+			size_t resident_bytes;
+		};
+
+		std::mutex mutex_;
+		std::deque<std::shared_ptr<Entry>> decoded_;
+		std::atomic<size_t> decoding_;
+
+		// GL thread only
+		std::unordered_map<const Texture2D*, std::shared_ptr<Entry>> entries_;
+		size_t frame_;
+		size_t budget_;
+		size_t resident_bytes_;
+		std::unique_ptr<PixelBufferPool> pool_;
+
+		TextureStreamer();
+		void Schedule(const std::shared_ptr<Entry>& entry);
+		void Decode(Entry& entry) const;
+		void Activate(Entry& entry);
+		bool MakeResident(Entry& entry, GLsizei level);
+		void UploadLevel(const Entry& entry, GLsizei level, GLint target_level);
+		void ReleaseLevels(Entry& entry) const;
+		// drops the finest level of the least recently used texture not
+		// requested in the last frame, false when there is none or it failed
+		bool EvictOne(const Entry* keep);
+		size_t GetResidentSize(const Entry& entry, GLsizei level) const;
+		void GetLevelSize(const Entry& entry, GLsizei level, GLsizei& width, GLsizei& height) const;
+	};
+}
+
+#endif // TEXTURE_STREAMER_HPP_
@@ -0,0 +1,24 @@
+#include "thread_pool.hpp"
+
+namespace nxt {
+	ThreadPool& ThreadPool::Instance() {
+		static std::unique_ptr<ThreadPool> instance{ std::unique_ptr<ThreadPool>(
+			new ThreadPool(jobs::Scheduler::Instance())) };
+		return *instance;
+	}
+
+	std::future<void> ThreadPool::Submit(std::function<void()> task) {
+		// shared so the job stays copyable as std::function requires
+		const auto packaged = std::make_shared<std::packaged_task<void()>>(std::move(task));
+		std::future<void> result = packaged->get_future();
+		scheduler_.Run([packaged]() { (*packaged)(); });
+		return result;
+	}
+
+	void ThreadPool::ParallelFor(
+		size_t count,
+		size_t min_batch,
+		const std::function<void(size_t begin, size_t end)> &body) {
+		scheduler_.ParallelFor(count, min_batch, body);
+	}
+}
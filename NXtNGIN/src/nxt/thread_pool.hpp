@@ -0,0 +1,35 @@
+#ifndef THREAD_POOL_HPP_
+#define THREAD_POOL_HPP_
+
+#include <memory>
+#include <future>
+#include <functional>
+
+#include "jobs.hpp"
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// future based front of the jobs::Scheduler workers, for callers that
+	// hand off a task and check on it later
+	class ThreadPool : public NonCopyable, public NonMoveable {
+	public:
+		static ThreadPool& Instance();
+
+		std::future<void> Submit(std::function<void()> task);
+		// splits [0, count) into ranges of at least min_batch elements and
+		// blocks until all are done, the calling thread takes ranges too
+		void ParallelFor(
+			size_t count,
+			size_t min_batch,
+			const std::function<void(size_t begin, size_t end)> &body);
+
+		size_t GetThreadCount() const { return scheduler_.GetWorkerCount(); }
+	private:
+		jobs::Scheduler& scheduler_;
+
+		explicit ThreadPool(jobs::Scheduler& scheduler) : scheduler_{ scheduler } {}
+	};
+}
+
+#endif // THREAD_POOL_HPP_
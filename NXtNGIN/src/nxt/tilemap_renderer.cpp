@@ -0,0 +1,194 @@
+#include "tilemap_renderer.hpp"
+
+namespace nxt {
+	TilemapRenderer::TilemapRenderer(
+		const std::shared_ptr<Shader> &shader,
+		const GLfloat &width,
+		const GLfloat &height,
+		const std::shared_ptr<Texture2D> &texture,
+		std::vector<glm::fvec4> tile_uvs,
+		glm::fvec2 tile_size) :
+		indices_{ 0, 1, 2, 0, 2, 3 },
+		screen_size_{ width, height },
+		tile_size_{ tile_size },
+		drawn_chunks_{},
+		tile_uvs_{ std::move(tile_uvs) },
+		shader_{ shader },
+		texture_{ texture },
+		instance_layout_{ 1 } {
+		projection_ = glm::ortho<float>(
+			0.0f,
+			width,
+			height,
+			0.0f);
+		InitRenderData();
+		shader_->SetMat4("projection", projection_);
+		shader_->SetVec2("tile_size", tile_size_);
+		shader_->SetInt("chunk_size", static_cast<GLint>(kChunkSize));
+		shader_->SetInt("image_sampler", 0);
+	}
+
+	TilemapRenderer::~TilemapRenderer() {}
+
+	size_t TilemapRenderer::AddLayer(
+		GLuint width,
+		GLuint height,
+		const std::vector<std::uint16_t> &tiles) {
+		assert(tiles.size() == static_cast<size_t>(width) * height);
+
+		Layer layer;
+		layer.width = width;
+		layer.height = height;
+		layer.chunk_columns = (width + kChunkSize - 1) / kChunkSize;
+		layer.chunk_rows = (height + kChunkSize - 1) / kChunkSize;
+		layer.tiles = tiles;
+		layer.chunks.resize(static_cast<size_t>(layer.chunk_columns) * layer.chunk_rows);
+
+		for (GLuint chunk_y{}; chunk_y < layer.chunk_rows; ++chunk_y) {
+			for (GLuint chunk_x{}; chunk_x < layer.chunk_columns; ++chunk_x) {
+				BakeChunk(layer, chunk_x, chunk_y);
+			}
+		}
+		layers_.push_back(std::move(layer));
+		return layers_.size() - 1;
+	}
+
+	void TilemapRenderer::BakeChunk(Layer &layer, GLuint chunk_x, GLuint chunk_y) {
+		std::vector<glm::fvec4> uvs(kChunkSize * kChunkSize, GetTileUV(kEmptyTile));
+		GLuint tile_count{};
+		for (GLuint y{}; y < kChunkSize; ++y) {
+			GLuint map_y = chunk_y * kChunkSize + y;
+			if (map_y >= layer.height) break;
+			for (GLuint x{}; x < kChunkSize; ++x) {
+				GLuint map_x = chunk_x * kChunkSize + x;
+				if (map_x >= layer.width) break;
+				std::uint16_t tile = layer.tiles[static_cast<size_t>(map_y) * layer.width + map_x];
+				uvs[y * kChunkSize + x] = GetTileUV(tile);
+				if (!IsEmpty(tile)) ++tile_count;
+			}
+		}
+
+		Chunk &chunk = layer.chunks[static_cast<size_t>(chunk_y) * layer.chunk_columns + chunk_x];
+		chunk.tile_count = tile_count;
+		chunk.vb = std::make_shared<VertexBuffer>(
+			reinterpret_cast<const GLvoid*>(uvs.data()),
+			static_cast<GLuint>(uvs.size() * sizeof(glm::fvec4)));
+		chunk.va = std::make_shared<VertexArray>(*quad_vb_, quad_layout_);
+		chunk.va->AddBuffer(*chunk.vb, instance_layout_);
+		chunk.va->Unbind();
+		chunk.vb->Unbind();
+	}
+
+	void TilemapRenderer::SetTile(size_t layer_index, GLuint x, GLuint y, std::uint16_t tile) {
+		assert(layer_index < layers_.size());
+		Layer &layer = layers_[layer_index];
+		assert(x < layer.width && y < layer.height);
+
+		std::uint16_t &current = layer.tiles[static_cast<size_t>(y) * layer.width + x];
+		if (current == tile) return;
+
+		Chunk &chunk = layer.chunks[static_cast<size_t>(y / kChunkSize) * layer.chunk_columns + x / kChunkSize];
+		if (IsEmpty(current)) ++chunk.tile_count;
+		if (IsEmpty(tile)) --chunk.tile_count;
+		current = tile;
+
+		const glm::fvec4 uv = GetTileUV(tile);
+		const GLuint local_index = (y % kChunkSize) * kChunkSize + x % kChunkSize;
+		chunk.vb->Bind();
+		chunk.vb->BufferSubData(
+			reinterpret_cast<const GLvoid*>(&uv),
+			static_cast<GLuint>(sizeof(uv)),
+			static_cast<GLintptr>(local_index * sizeof(glm::fvec4)));
+		chunk.vb->Unbind();
+	}
+
+	std::uint16_t TilemapRenderer::GetTile(size_t layer_index, GLuint x, GLuint y) const {
+		assert(layer_index < layers_.size());
+		const Layer &layer = layers_[layer_index];
+		assert(x < layer.width && y < layer.height);
+		return layer.tiles[static_cast<size_t>(y) * layer.width + x];
+	}
+
+	void TilemapRenderer::Draw(const glm::fvec2 &view_pos) {
+		drawn_chunks_ = 0;
+		const glm::fvec2 chunk_extent = tile_size_ * static_cast<float>(kChunkSize);
+		// chunk range intersecting the orthographic view
+		const glm::ivec2 first = glm::ivec2(glm::floor(view_pos / chunk_extent));
+		const glm::ivec2 last = glm::ivec2(glm::floor((view_pos + screen_size_) / chunk_extent));
+
+		shader_->SetVec2("view_pos", view_pos);
+		texture_->BindUnit(0);
+		for (const Layer &layer : layers_) {
+			const GLint min_x = glm::max(first.x, 0);
+			const GLint min_y = glm::max(first.y, 0);
+			const GLint max_x = glm::min(last.x, static_cast<GLint>(layer.chunk_columns) - 1);
+			const GLint max_y = glm::min(last.y, static_cast<GLint>(layer.chunk_rows) - 1);
+
+			for (GLint chunk_y{ min_y }; chunk_y <= max_y; ++chunk_y) {
+				for (GLint chunk_x{ min_x }; chunk_x <= max_x; ++chunk_x) {
+					const Chunk &chunk = layer.chunks[static_cast<size_t>(chunk_y) * layer.chunk_columns + chunk_x];
+					if (chunk.tile_count == 0) continue;
+
+					shader_->SetVec2(
+						"chunk_origin",
+						glm::fvec2{ chunk_x, chunk_y } * chunk_extent);
+					Renderer::Render(*chunk.va, *ib_, *shader_, kChunkSize * kChunkSize);
+					++drawn_chunks_;
+				}
+			}
+		}
+		texture_->Unbind(0);
+	}
+
+	glm::fvec4 TilemapRenderer::GetTileUV(std::uint16_t tile) const {
+		// a negative width tells the vertex shader to collapse the quad
+		if (IsEmpty(tile)) return glm::fvec4{ 0.0f, 0.0f, -1.0f, -1.0f };
+		return tile_uvs_[tile];
+	}
+
+	std::vector<glm::fvec4> TilemapRenderer::GetGridUVs(int columns, int rows) {
+		std::vector<glm::fvec4> uvs;
+		const glm::fvec2 size{ 1.0f / columns, 1.0f / rows };
+		for (int row{}; row < rows; ++row) {
+			for (int column{}; column < columns; ++column) {
+				// textures are flipped on load, the top row ends at v = 1
+				uvs.push_back(glm::fvec4{
+					column * size.x,
+					1.0f - (row + 1) * size.y,
+					size.x,
+					size.y });
+			}
+		}
+		return uvs;
+	}
+
+	std::vector<glm::fvec4> TilemapRenderer::GetAtlasUVs(
+		const TextureAtlas &atlas,
+		const std::vector<std::string> &names) {
+		std::vector<glm::fvec4> uvs;
+		for (const std::string &name : names) {
+			uvs.push_back(atlas.GetRegion(name).uv_rect);
+		}
+		return uvs;
+	}
+
+	void TilemapRenderer::InitRenderData() {
+		constexpr GLubyte kNumberComponents{ 4 }; //position and texture coordinate
+		std::vector<GLfloat> vertices{
+			1.0f, 0.0f, 1.0f, 1.0f,
+			0.0f, 0.0f, 0.0f, 1.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			1.0f, 1.0f, 1.0f, 0.0f,
+		};
+		quad_vb_ = std::make_shared<VertexBuffer>(
+			reinterpret_cast<const GLvoid*>(vertices.data()),
+			static_cast<GLuint>(sizeof(GLfloat)) * static_cast<GLuint>(vertices.size()));
+		quad_layout_.Push<GLfloat>(kNumberComponents);
+		// uv rectangle per tile
+		instance_layout_.Push<GLfloat>(4);
+
+		ib_ = std::make_shared<IndexBuffer>(indices_.data(), static_cast<GLuint>(indices_.size()));
+		ib_->Unbind();
+		quad_vb_->Unbind();
+	}
+}
@@ -0,0 +1,95 @@
+#ifndef TILEMAP_RENDERER_HPP_
+#define TILEMAP_RENDERER_HPP_
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "texture2d.hpp"
+#include "texture_atlas.hpp"
+#include "renderer.hpp"
+
+namespace nxt {
+	// Tile layers are baked into static per-chunk buffers holding one uv
+	// rectangle per tile, a tile's position follows from its instance id.
+	class TilemapRenderer {
+	public:
+		static constexpr GLuint kChunkSize{ 32 }; // tiles per chunk side
+		static constexpr std::uint16_t kEmptyTile{ 0xFFFF };
+
+		TilemapRenderer(
+			const std::shared_ptr<Shader> &shader,
+			const GLfloat &width,
+			const GLfloat &height,
+			const std::shared_ptr<Texture2D> &texture,
+			std::vector<glm::fvec4> tile_uvs,
+			glm::fvec2 tile_size);
+		~TilemapRenderer();
+
+		// tile ids index into the uv table, kEmptyTile and ids past the table
+		// leave a hole
+		size_t AddLayer(
+			GLuint width,
+			GLuint height,
+			const std::vector<std::uint16_t> &tiles);
+		// rewrites just this tile's entry in its chunk buffer
+		void SetTile(size_t layer, GLuint x, GLuint y, std::uint16_t tile);
+		std::uint16_t GetTile(size_t layer, GLuint x, GLuint y) const;
+
+		// view_pos is the world position shown in the top-left screen corner
+		void Draw(const glm::fvec2 &view_pos);
+
+		size_t GetDrawnChunkCount() const { return drawn_chunks_; }
+		const glm::fvec2& GetTileSize() const { return tile_size_; }
+
+		// uv table of a regular tile sheet, ids run row by row from the top-left
+		static std::vector<glm::fvec4> GetGridUVs(int columns, int rows);
+		// uv table in the order of the given atlas region names
+		static std::vector<glm::fvec4> GetAtlasUVs(
+			const TextureAtlas &atlas,
+			const std::vector<std::string> &names);
+	private:
+		struct Chunk {
+			std::shared_ptr<VertexBuffer> vb;
+			std::shared_ptr<VertexArray> va;
+			GLuint tile_count; // non-empty tiles, empty chunks are skipped
+		};
+
+		struct Layer {
+			GLuint width;
+			GLuint height;
+			GLuint chunk_columns;
+			GLuint chunk_rows;
+			std::vector<std::uint16_t> tiles;
+			std::vector<Chunk> chunks;
+		};
+
+		std::vector<GLuint> indices_;
+		glm::fmat4 projection_;
+		glm::fvec2 screen_size_;
+		glm::fvec2 tile_size_;
+		size_t drawn_chunks_;
+
+		std::vector<glm::fvec4> tile_uvs_;
+		std::vector<Layer> layers_;
+
+		std::shared_ptr<Shader> shader_;
+		std::shared_ptr<Texture2D> texture_;
+		std::shared_ptr<IndexBuffer> ib_;
+		std::shared_ptr<VertexBuffer> quad_vb_;
+		VertexBufferLayout quad_layout_;
+		VertexBufferLayout instance_layout_;
+
+		void InitRenderData();
+		void BakeChunk(Layer &layer, GLuint chunk_x, GLuint chunk_y);
+		bool IsEmpty(std::uint16_t tile) const { return tile == kEmptyTile || tile >= tile_uvs_.size(); }
+		glm::fvec4 GetTileUV(std::uint16_t tile) const;
+	};
+}
+
+#endif // TILEMAP_RENDERER_HPP_
@@ -1,23 +1,47 @@
 #include "vertex_array.hpp"
 
 namespace nxt {
-	VertexArray::VertexArray() { glGenVertexArrays(1, &handle_); }
+	VertexArray::VertexArray() : attrib_count_{ 0 } { glGenVertexArrays(1, &handle_); }
 
 	VertexArray::~VertexArray() { glDeleteVertexArrays(1, &handle_); }
 
 	void VertexArray::Bind() const { glBindVertexArray(handle_); }
 	void VertexArray::Unbind() const { glBindVertexArray(0); }
 
-	void VertexArray::AddBuffer(const VertexBuffer& vbo, const VertexBufferLayout& layout) {
+	GLuint VertexArray::AddBuffer(const VertexBuffer& vbo, const VertexBufferLayout& layout) {
 		Bind();
 		vbo.Bind();
+		const GLuint first_attrib{ attrib_count_ };
 		const auto& elements = layout.GetElements();
-		GLuint offset{ 0 };
+		for (GLuint i{}; i < elements.size(); ++i) {
+			glEnableVertexAttribArray(first_attrib + i);
+			glVertexAttribDivisor(first_attrib + i, layout.GetDivisor());
+		}
+		SetAttribPointers(layout, first_attrib, 0);
+		attrib_count_ += static_cast<GLuint>(elements.size());
+		return first_attrib;
+	}
+
+	void VertexArray::SetBufferOffset(
+		const VertexBuffer& vbo,
+		const VertexBufferLayout& layout,
+		GLuint first_attrib,
+		GLintptr base_offset) const {
+		Bind();
+		vbo.Bind();
+		SetAttribPointers(layout, first_attrib, base_offset);
+	}
+
+	void VertexArray::SetAttribPointers(
+		const VertexBufferLayout& layout,
+		GLuint first_attrib,
+		GLintptr base_offset) const {
+		const auto& elements = layout.GetElements();
+		GLintptr offset{ base_offset };
 		for (GLuint i{}; i < elements.size(); ++i) {
 			const auto& element = elements[i];
-			glEnableVertexAttribArray(i);
 			glVertexAttribPointer(
-				i,
+				first_attrib + i,
 				element.count,
 				element.type,
 				element.normalized,
@@ -8,6 +8,13 @@ namespace nxt {
 	class VertexArray {
 	private:
 		GLuint handle_;
+		GLuint attrib_count_;
+
+		void SetAttribPointers(
+			const VertexBufferLayout& layout,
+			GLuint first_attrib,
+			GLintptr base_offset
+		) const;
 	public:
 		VertexArray();
 		VertexArray(
@@ -19,10 +26,20 @@ namespace nxt {
 		~VertexArray();
 		void Bind() const;
 		void Unbind() const;
-		void AddBuffer(
+		// attributes are appended after those of previously added buffers,
+		// returns the location of the first attribute of this buffer
+		GLuint AddBuffer(
 			const VertexBuffer& vbo,
 			const VertexBufferLayout& layout
 		);
+		// re-points the attributes of an added buffer, e.g. to draw a
+		// sub-range of an instance buffer without base instance support
+		void SetBufferOffset(
+			const VertexBuffer& vbo,
+			const VertexBufferLayout& layout,
+			GLuint first_attrib,
+			GLintptr base_offset
+		) const;
 	};
 }
 
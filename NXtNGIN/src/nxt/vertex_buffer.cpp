@@ -1,17 +1,16 @@
 #include "vertex_buffer.hpp"
 
 namespace nxt {
-	VertexBuffer::VertexBuffer(const GLvoid* data, GLuint size, DrawType draw_type) {
+	VertexBuffer::VertexBuffer(const GLvoid* data, GLuint size, DrawType draw_type) : size_{ size } {
 		glGenBuffers(1, &handle_);
 		glBindBuffer(GL_ARRAY_BUFFER, handle_);
-		if (DrawType::STATIC == draw_type)
-			glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
-		else if (DrawType::DYNAMIC == draw_type)
-			glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, size, data, GetUsage(draw_type));
+		MemoryTracker::Instance().AddGpu(GpuResource::VERTEX_BUFFER, 0, size_);
 	}
 
 	VertexBuffer::~VertexBuffer() {
 		glDeleteBuffers(1, &handle_);
+		MemoryTracker::Instance().RemoveGpu(GpuResource::VERTEX_BUFFER, 0, size_);
 	}
 
 	void VertexBuffer::Bind() const {
@@ -22,12 +21,29 @@ namespace nxt {
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
-	void VertexBuffer::BufferSubData(const GLvoid* data, GLuint size) const {
+	void VertexBuffer::BufferData(const GLvoid* data, GLuint size, DrawType draw_type) {
+		glBufferData(GL_ARRAY_BUFFER, size, data, GetUsage(draw_type));
+		// an orphaned store counts as freed, the driver reclaims it once unused
+		MemoryTracker::Instance().RemoveGpu(GpuResource::VERTEX_BUFFER, 0, size_);
+		MemoryTracker::Instance().AddGpu(GpuResource::VERTEX_BUFFER, 0, size);
+		size_ = size;
+	}
+
+	void VertexBuffer::BufferSubData(const GLvoid* data, GLuint size, GLintptr offset) const {
 		glBufferSubData(
 			GL_ARRAY_BUFFER,
-			0,
+			offset,
 			size,
 			data
 		);
 	}
+
+	GLenum VertexBuffer::GetUsage(DrawType draw_type) {
+		switch (draw_type) {
+		case DrawType::STATIC: return GL_STATIC_DRAW;
+		case DrawType::DYNAMIC: return GL_DYNAMIC_DRAW;
+		case DrawType::STREAM: return GL_STREAM_DRAW;
+		default: return GL_STATIC_DRAW;
+		}
+	}
 }
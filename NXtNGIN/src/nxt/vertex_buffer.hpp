@@ -3,15 +3,20 @@
 
 #include <GL/glew.h>
 
+#include "memory_tracker.hpp"
+
 namespace nxt {
 	enum class DrawType {
 		STATIC,
-		DYNAMIC
+		DYNAMIC,
+		STREAM
 	};
 
 	class VertexBuffer {
 	private:
 		GLuint handle_;
+		GLuint size_;
+		static GLenum GetUsage(DrawType draw_type);
 	public:
 		VertexBuffer(
 			const GLvoid* data,
@@ -22,7 +27,10 @@ namespace nxt {
 
 		void Bind() const;
 		void Unbind() const;
-		void BufferSubData(const GLvoid* data, GLuint size) const;
+		// reallocates the store, passing nullptr orphans the previous one
+		void BufferData(const GLvoid* data, GLuint size, DrawType draw_type);
+		void BufferSubData(const GLvoid* data, GLuint size, GLintptr offset = 0) const;
+		GLuint GetSize() const { return size_; }
 	};
 }
 
@@ -24,13 +24,15 @@ namespace nxt {
 	class VertexBufferLayout {
 	private:
 		GLuint stride_;
+		GLuint divisor_; // 0 per vertex, n advances every n instances
 		std::vector<VertexBufferElement> elements_;
 	public:
-		VertexBufferLayout() : stride_{ 0 } {}
+		VertexBufferLayout(GLuint divisor = 0) : stride_{ 0 }, divisor_{ divisor } {}
 		template <typename T>
 		void Push(GLuint count);
 		inline const std::vector<VertexBufferElement>& GetElements() const { return elements_; }
 		inline GLuint GetStride() const { return stride_; }
+		inline GLuint GetDivisor() const { return divisor_; }
 	};
 }
 
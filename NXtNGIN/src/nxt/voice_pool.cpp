@@ -0,0 +1,83 @@
+#include "voice_pool.hpp"
+
+namespace nxt {
+	VoicePool& VoicePool::Instance() {
+		static std::unique_ptr<VoicePool> instance{ std::unique_ptr<VoicePool>(new VoicePool()) };
+		return *instance;
+	}
+
+	VoicePool::VoicePool() : play_count_{ 0 }, owner_count_{ kNoOwner }, steal_count_{ 0 }, drop_count_{ 0 } {
+		// heard the same wherever the AudioScene listener is
+		for (Voice& voice : voices_) voice.sound.setRelativeToListener(true);
+	}
+
+	VoicePool::Voice* VoicePool::FindVoice(const sf::SoundBuffer& buffer, int priority) {
+		Voice *free_voice{};
+		Voice *victim{};
+		for (Voice& voice : voices_) {
+			if (voice.sound.getStatus() == sf::Sound::Stopped) {
+				if (voice.buffer.get() == &buffer) return &voice;
+				if (!free_voice) free_voice = &voice;
+			}
+			else if (!victim || voice.priority < victim->priority ||
+				(voice.priority == victim->priority && voice.started < victim->started)) {
+				victim = &voice;
+			}
+		}
+		if (free_voice) return free_voice;
+		if (victim->priority > priority) {
+			++drop_count_;
+			return nullptr;
+		}
+		++steal_count_;
+		return victim;
+	}
+
+	bool VoicePool::PlayOneShot(
+		const std::shared_ptr<const sf::SoundBuffer>& buffer,
+		float volume,
+		float pitch,
+		int priority,
+		std::uint64_t owner) {
+		if (!buffer) return false;
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		Voice *voice = FindVoice(*buffer, priority);
+		if (!voice) return false;
+
+		voice->sound.stop();
+		if (voice->buffer != buffer) {
+			// bound first, the previous buffer may go away with the reference
+			voice->sound.setBuffer(*buffer);
+			voice->buffer = buffer;
+		}
+		voice->sound.setVolume(volume);
+		voice->sound.setPitch(pitch);
+		voice->priority = priority;
+		voice->started = ++play_count_;
+		voice->owner = owner;
+		voice->sound.play();
+		return true;
+	}
+
+	void VoicePool::Stop(std::uint64_t owner) {
+		if (owner == kNoOwner) return;
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		for (Voice& voice : voices_) {
+			if (voice.owner == owner) voice.sound.stop();
+		}
+	}
+
+	void VoicePool::StopAll() {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		for (Voice& voice : voices_) voice.sound.stop();
+	}
+
+	size_t VoicePool::GetActiveCount() const {
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		size_t count{};
+		for (const Voice& voice : voices_) {
+			if (voice.sound.getStatus() != sf::Sound::Stopped) ++count;
+		}
+		return count;
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef VOICE_POOL_HPP_
+#define VOICE_POOL_HPP_
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#include <SFML/Audio.hpp>
+
+#include "non_copyable.hpp"
+#include "non_moveable.hpp"
+
+namespace nxt {
+	// A fixed set of voices for fire-and-forget effects, so overlapping
+	// plays of the same effect no longer cut each other off. When every
+	// voice is busy a play takes the voice of the lowest priority, the
+	// oldest of those, unless that priority is higher than its own.
+	//
+	// Voices are created with the pool and keep the buffer they last
+	// played. A free voice already holding the buffer is preferred, as
+	// binding another one is the only part of a play that allocates.
+	//
+	// Plays may name an owner from NewOwner, Stop then ends only its voices
+	// and leaves other plays of the same buffer alone.
+	class VoicePool : public NonCopyable, public NonMoveable {
+	public:
+		static constexpr size_t kVoiceCount{ 32 };
+		static constexpr std::uint64_t kNoOwner{ 0 };
+
+		static VoicePool& Instance();
+
+		// false when every voice is busy with a higher priority
+		bool PlayOneShot(
+			const std::shared_ptr<const sf::SoundBuffer>& buffer,
+			float volume = 100.0f,
+			float pitch = 1.0f,
+			int priority = 0,
+			std::uint64_t owner = kNoOwner);
+		// stops the voices started for owner
+		void Stop(std::uint64_t owner);
+		void StopAll();
+
+		std::uint64_t NewOwner() { return ++owner_count_; }
+		size_t GetActiveCount() const;
+		// plays that had to cut another one off, and those dropped instead
+		size_t GetStealCount() const { return steal_count_; }
+		size_t GetDropCount() const { return drop_count_; }
+	private:
+		struct Voice {
+			// before the sound, which is destroyed first
+			std::shared_ptr<const sf::SoundBuffer> buffer;
+			sf::Sound sound;
+			int priority{};
+			// order of the play, lower is older
+			std::uint64_t started{};
+			std::uint64_t owner{};
+		};
+
+		mutable std::mutex mutex_;
+		std::array<Voice, kVoiceCount> voices_;
+		std::uint64_t play_count_;
+		std::atomic<std::uint64_t> owner_count_;
+		std::atomic<size_t> steal_count_;
+		std::atomic<size_t> drop_count_;
+
+		VoicePool();
+		Voice* FindVoice(const sf::SoundBuffer& buffer, int priority);
+	};
+}
+
+#endif // VOICE_POOL_HPP_
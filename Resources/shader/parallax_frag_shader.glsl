@@ -0,0 +1,12 @@
+#version 330 core
+in vec3 to_frag_tex;
+out vec4 color;
+
+uniform sampler2DArray layer_sampler;
+
+void main() {
+	// horizontal wrap comes from GL_REPEAT, vertically a layer ends
+	if (to_frag_tex.y < 0.0f || to_frag_tex.y > 1.0f) discard;
+	color = texture(layer_sampler, to_frag_tex);
+	if (color.a == 0.0f) discard;
+}
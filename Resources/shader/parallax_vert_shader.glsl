@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec2 in_vert_pos;
+out vec3 to_frag_tex;
+
+uniform mat4 projection;
+uniform vec2 context_dimensions;
+uniform vec2 actor_pos;
+uniform float delta_perspective;
+uniform int first_layer;
+
+void main() {
+	// every instance covers the whole screen, the layer's scroll offset and
+	// scale only change where it samples
+	int layer = first_layer + gl_InstanceID;
+	float coefficient = delta_perspective * float(layer);
+	vec2 layer_pos = -coefficient * actor_pos;
+	vec2 layer_size = context_dimensions * (coefficient + 1.0f);
+
+	vec2 screen_pos = in_vert_pos * context_dimensions;
+	vec2 local = (screen_pos - layer_pos) / layer_size;
+	to_frag_tex = vec3(local.x, 1.0f - local.y, float(layer));
+	gl_Position = projection * vec4(screen_pos, 0.0f, 1.0f);
+}
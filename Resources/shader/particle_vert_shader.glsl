@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec4 in_vert_pos_tex;
+layout (location = 1) in vec3 in_position_size;
+layout (location = 2) in vec4 in_color;
+out vec2 to_frag_tex;
+out vec4 to_frag_color;
+
+uniform mat4 projection;
+
+void main() {
+	// quads are centered on the particle position
+	vec2 world = in_position_size.xy + (in_vert_pos_tex.xy - 0.5f) * in_position_size.z;
+
+	to_frag_tex = in_vert_pos_tex.zw;
+	to_frag_color = in_color;
+	gl_Position = projection * vec4(world, 0.0f, 1.0f);
+}
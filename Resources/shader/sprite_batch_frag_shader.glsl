@@ -0,0 +1,10 @@
+#version 330 core
+in vec2 to_frag_tex;
+in vec4 to_frag_color;
+out vec4 color;
+
+uniform sampler2D image_sampler;
+
+void main() {
+	color = to_frag_color * texture(image_sampler, to_frag_tex);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec4 in_vert_pos_tex;
+layout (location = 1) in vec4 in_position_size;
+layout (location = 2) in vec4 in_uv_rect;
+layout (location = 3) in vec4 in_color;
+layout (location = 4) in vec2 in_rotation_layer;
+out vec2 to_frag_tex;
+out vec4 to_frag_color;
+
+uniform mat4 projection;
+
+void main() {
+	vec2 half_size = 0.5f * in_position_size.zw;
+	vec2 local = in_vert_pos_tex.xy * in_position_size.zw - half_size;
+	float s = sin(in_rotation_layer.x);
+	float c = cos(in_rotation_layer.x);
+	vec2 world = vec2(c * local.x - s * local.y, s * local.x + c * local.y);
+	world += in_position_size.xy + half_size;
+
+	to_frag_tex = in_uv_rect.xy + in_vert_pos_tex.zw * in_uv_rect.zw;
+	to_frag_color = in_color;
+	gl_Position = projection * vec4(world, in_rotation_layer.y, 1.0f);
+}
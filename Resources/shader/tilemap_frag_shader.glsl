@@ -0,0 +1,9 @@
+#version 330 core
+in vec2 to_frag_tex;
+out vec4 color;
+
+uniform sampler2D image_sampler;
+
+void main() {
+	color = texture(image_sampler, to_frag_tex);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec4 in_vert_pos_tex;
+layout (location = 1) in vec4 in_uv_rect;
+out vec2 to_frag_tex;
+
+uniform mat4 projection;
+uniform vec2 view_pos;
+uniform vec2 chunk_origin;
+uniform vec2 tile_size;
+uniform int chunk_size;
+
+void main() {
+	vec2 tile = vec2(gl_InstanceID % chunk_size, gl_InstanceID / chunk_size);
+	vec2 world = chunk_origin + (tile + in_vert_pos_tex.xy) * tile_size;
+
+	to_frag_tex = in_uv_rect.xy + in_vert_pos_tex.zw * in_uv_rect.zw;
+	// empty tiles carry a negative uv width and collapse to a degenerate quad
+	gl_Position = in_uv_rect.z < 0.0f ? vec4(0.0f) : projection * vec4(world - view_pos, 0.0f, 1.0f);
+}
@@ -23,8 +23,12 @@ void Sandbox::Init()
 #else
         std::make_unique<nxt::OrbitCamera>();
 #endif
+    previous_camera_position_ = camera->GetPosition();
 
     nxt::FileSystem::Instance().SetResourceRootDir("Resources");
+    // built by nxt_cook pack, the loose files are used without it
+    const bf::path pack = nxt::FileSystem::Instance().GetResourceRootDir() / "resources.nxtpack";
+    if (bf::exists(pack)) nxt::FileSystem::Instance().MountPack(pack.string());
     nxt::FileSystem::Instance().InitSubDirs({ "fonts", "audio", "models", "shader", "textures" });
 
     audio_list_.push_back(std::make_unique<nxt::Music>());
@@ -40,6 +44,7 @@ void Sandbox::Init()
     config.context_size = nxt::context::Size::DEBUG;
 
     nxt::Context::Instance().Create(config);
+    nxt::Context::Instance().SetVSync(true);
     nxt::Context::Instance().SetCursorPos(
         static_cast<float>(nxt::Context::Instance().GetWidth() / 2),
         static_cast<float>(nxt::Context::Instance().GetHeight() / 2));
@@ -112,15 +117,22 @@ void Sandbox::Init()
         nxt::FileSystem::Instance().GetPathString("shader") + "sprite_frag_shader.glsl",
         "sprite");
 
-    nxt::ResourceManager::LoadTexture(
+    nxt::ResourceManager::LoadShader(
+        nxt::FileSystem::Instance().GetPathString("shader") + "particle_vert_shader.glsl",
+        nxt::FileSystem::Instance().GetPathString("shader") + "particle_frag_shader.glsl",
+        "particle");
+
+    // decoded on worker threads, uploaded by the loader's Update() in Render()
+    nxt::ResourceManager::LoadTextureAsync(
         nxt::ResourceManager::GetShader("cubemap"),
         cubemap_textures,
         "faces");
-    nxt::ResourceManager::LoadTexture(
+    // only the small mips stay resident until RequestTextureLevels() asks for more
+    nxt::ResourceManager::LoadTextureStreamed(
         nxt::ResourceManager::GetShader("model"),
         nxt::FileSystem::Instance().GetPathString("textures") + "cyborg_diffuse.png",
         "cyborg");
-    nxt::ResourceManager::LoadTexture(
+    nxt::ResourceManager::LoadTextureStreamed(
         nxt::ResourceManager::GetShader("model"),
         nxt::FileSystem::Instance().GetPathString("textures") + "bricks_3k.jpg",
         "floor");
@@ -181,6 +193,26 @@ void Sandbox::Init()
         nxt::Context::Instance().GetWidth(),
         nxt::Context::Instance().GetHeight()));
 
+    donut_trail_ = std::make_unique<nxt::ParticleSystem>(
+        nxt::ResourceManager::GetShader("particle"),
+        nxt::Context::Instance().GetWidth(),
+        nxt::Context::Instance().GetHeight(),
+        nxt::ResourceManager::GetTexture("donut"),
+        256);
+    nxt::ParticleEmitter trail{};
+    trail.position = glm::fvec2{ nxt::Context::Instance().GetWidth() - 50.0f, nxt::Context::Instance().GetHeight() - 50.0f };
+    trail.position_variance = glm::fvec2{ 5.0f, 5.0f };
+    trail.velocity = glm::fvec2{ -150.0f, 0.0f };
+    trail.velocity_variance = glm::fvec2{ 20.0f, 20.0f };
+    trail.lifetime = 1.5f;
+    trail.lifetime_variance = 0.3f;
+    trail.rate = 40.0f;
+    donut_trail_->AddEmitter(trail);
+    donut_trail_->SetSizeCurve({ { 0.0f, 80.0f }, { 1.0f, 10.0f } });
+    donut_trail_->SetColorCurve({
+        { 0.0f, glm::fvec4{ 1.0f, 1.0f, 1.0f, 0.8f } },
+        { 1.0f, glm::fvec4{ 1.0f, 0.6f, 0.8f, 0.0f } } });
+
     audio_list_[0]->Open(nxt::FileSystem::Instance().GetPathString("audio") + "throne.ogg");
     audio_list_[0]->Play(true);
     audio_list_[0]->Volume(10.0f);
@@ -188,6 +220,16 @@ void Sandbox::Init()
 
     audio_list_[1]->Open(nxt::FileSystem::Instance().GetPathString("audio") + "powerup1.ogg");
     audio_list_[1]->Play();
+    // R and V switch between the two while held, decoded once here; the
+    // second also loops on the orbiting light, heard from the camera
+    light_emitter_ = nxt::AudioScene::Instance().AddEmitter(
+        nxt::SoundBufferCache::Instance().Load(nxt::FileSystem::Instance().GetPathString("audio") + "powerup2.ogg"),
+        glm::fvec3{ 0.0f });
+    nxt::AudioScene::Instance().SetVolume(light_emitter_, 30.0f);
+    nxt::AudioScene::Instance().SetRange(light_emitter_, 2.0f, 40.0f);
+    nxt::AudioScene::Instance().Play(light_emitter_);
+
+    nxt::ResourceManager::ReportSharing();
 }
 
 void Sandbox::ProcessInput(float dt)
@@ -200,6 +242,7 @@ void Sandbox::ProcessInput(float dt)
     if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_Q))
         nxt::opengl::FillMode();
 
+    previous_camera_position_ = camera->GetPosition();
     if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_W))
         camera->HandleKeyboard(nxt::CameraMovement::FORWARD, dt);
     if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_S))
@@ -209,29 +252,46 @@ void Sandbox::ProcessInput(float dt)
     if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_D))
         camera->HandleKeyboard(nxt::CameraMovement::RIGHT, dt);
 
-    if (nxt::Context::Instance().KeyDown(nxt::MouseButton::MOUSE_LEFT))
-        audio_list_[1]->Play();
-    if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_F))
+    // one play per press, a held key would start a voice every step
+    const bool play_down =
+        nxt::Context::Instance().KeyDown(nxt::MouseButton::MOUSE_LEFT) ||
+        nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_F);
+    if (play_down && !play_held_)
         audio_list_[1]->Play();
+    play_held_ = play_down;
     if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_R))
         audio_list_[1]->Open(nxt::FileSystem::Instance().GetPathString("audio") + "powerup1.ogg");
     if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_V))
         audio_list_[1]->Open(nxt::FileSystem::Instance().GetPathString("audio") + "powerup2.ogg");
+
+    donut_trail_->Update(dt);
+
+    // on the simulation clock, so every step moves the light and its sound
+    light_time_ += dt;
+    light_position_.x = 4 * sinf(light_time_ * 3);
+    light_position_.z = 4 * cosf(light_time_ * 3);
+    nxt::AudioScene::Instance().SetPosition(light_emitter_, light_position_);
+    nxt::AudioScene::Instance().SetListener(*camera);
+    nxt::AudioScene::Instance().Update(dt);
 }
 
-void Sandbox::Render()
+void Sandbox::Render(float alpha)
 {
+    nxt::TextureLoader::Instance().Update();
+    nxt::TextureStreamer::Instance().Update();
     nxt::Renderer::Clear();
 
-    light_position_.x = static_cast<float>(4 * sinf(nxt::Context::Instance().GetTime() * 3));
-    light_position_.z = static_cast<float>(4 * cosf(nxt::Context::Instance().GetTime() * 3));
-
-    view_ = camera->GetViewMatrix();
+    // the camera between the last two steps, the view moved back by what
+    // the last step is ahead of it
+    const glm::fvec3 view_pos = glm::mix(previous_camera_position_, camera->GetPosition(), alpha);
+    view_ = camera->GetViewMatrix() * glm::translate(camera->GetPosition() - view_pos);
 
     nxt::ResourceManager::GetShader("model")->SetMat4("u_view", view_);
-    nxt::ResourceManager::GetShader("model")->SetVec3("u_view_pos", camera->GetPosition());
+    nxt::ResourceManager::GetShader("model")->SetVec3("u_view_pos", view_pos);
     nxt::ResourceManager::GetShader("model")->SetVec3("u_light.position", light_position_);
 
+    RequestTextureLevels();
+
     nxt::ResourceManager::GetTexture("floor")->Bind("u_material.diffuseMap", 0);
     meshes_[1]->Draw(5);
     nxt::ResourceManager::GetTexture("floor")->Unbind(0);
@@ -250,22 +310,106 @@ void Sandbox::Render()
     nxt::ResourceManager::GetTexture("faces")->Unbind(0);
 
     nxt::ResourceManager::GetTextRenderer("Wallpoet")->Draw(
-        "Framerate: " + std::to_string(nxt::Context::Instance().GetFrameRate(2)).substr(0, 5),
+        nxt::FrameArena::Get().Format("Framerate: %.2f", nxt::Context::Instance().GetFrameRate(2)),
         0.0f,
         0.0f,
         1.2f,
         glm::fvec3{ 0.5f, 0.5f, 0.5f });
+    DrawStreamingStats();
 
+    donut_trail_->Draw();
     sprites_[0]->Draw(
         nxt::ResourceManager::GetTexture("donut"),
         glm::fvec2{ nxt::Context::Instance().GetWidth() - 100.0f, nxt::Context::Instance().GetHeight() - 100.0f },
-        { glm::fvec2{ -100.0f, 0.0f }, glm::fvec2{ -200.0f, 0.0f } },
         glm::fvec2{ 100.0f, 100.0f });
 
+    nxt::ResidencyManager::Instance().Update();
     nxt::Context::Instance().PollEvents();
     nxt::Context::Instance().SwapBuffers();
 }
 
+void Sandbox::RequestTextureLevels()
+{
+    // the meshes are drawn five times along x, the closest instance decides
+    static const float xoffsets[]{ -10.0f, -5.0f, 0.0f, 5.0f, 10.0f };
+    const std::pair<size_t, const char*> textured_meshes[]{ { 0, "cyborg" }, { 1, "floor" } };
+
+    for (const auto& textured_mesh : textured_meshes)
+    {
+        const nxt::MeshRenderer& mesh = *meshes_[textured_mesh.first];
+        float screen_size{};
+        for (float xoffset : xoffsets)
+        {
+            screen_size = std::max(screen_size, nxt::TextureStreamer::GetScreenSize(
+                mesh.GetBoundsCenter() + glm::fvec3{ xoffset, 0.0f, 0.0f },
+                mesh.GetBoundsRadius(),
+                camera->GetPosition(),
+                camera->GetFov(),
+                static_cast<float>(nxt::Context::Instance().GetHeight())));
+        }
+        nxt::TextureStreamer::Instance().Request(
+            nxt::ResourceManager::GetTexture(textured_mesh.second), screen_size);
+    }
+}
+
+void Sandbox::DrawStreamingStats()
+{
+    const nxt::TextureStreamer& streamer = nxt::TextureStreamer::Instance();
+    float y{ 30.0f };
+    nxt::ResourceManager::GetTextRenderer("Wallpoet")->Draw(
+        nxt::FrameArena::Get().Format(
+            "Textures: %zu / %zu MB", streamer.GetResidentBytes() >> 20, streamer.GetBudget() >> 20),
+        0.0f,
+        y,
+        0.8f,
+        glm::fvec3{ 0.5f, 0.5f, 0.5f });
+
+    const nxt::MemoryTracker& memory = nxt::MemoryTracker::Instance();
+    y += 20.0f;
+    nxt::ResourceManager::GetTextRenderer("Wallpoet")->Draw(
+        nxt::FrameArena::Get().Format(
+            "Video memory: %zu MB Heap: %zu MB, %zu allocations per frame",
+            memory.GetGpuTotal().live_bytes >> 20,
+            memory.GetHeapTotal().live_bytes >> 20,
+            memory.GetHeapTotal().frame_count),
+        0.0f,
+        y,
+        0.8f,
+        glm::fvec3{ 0.5f, 0.5f, 0.5f });
+
+    const nxt::AudioScene& audio = nxt::AudioScene::Instance();
+    y += 20.0f;
+    nxt::ResourceManager::GetTextRenderer("Wallpoet")->Draw(
+        nxt::FrameArena::Get().Format(
+            "Audio emitters: %zu, %zu mixed, %zu virtual",
+            audio.GetEmitterCount(),
+            audio.GetRealCount(),
+            audio.GetVirtualCount()),
+        0.0f,
+        y,
+        0.8f,
+        glm::fvec3{ 0.5f, 0.5f, 0.5f });
+
+    for (const nxt::TextureStreamer::Stats& stats : streamer.GetStats())
+    {
+        y += 20.0f;
+        nxt::ResourceManager::GetTextRenderer("Wallpoet")->Draw(
+            nxt::FrameArena::Get().Format(
+                "%s: %dx%d mip %d/%d want %d %zu KB",
+                stats.name.c_str(),
+                std::max(stats.width >> stats.resident_level, 1),
+                std::max(stats.height >> stats.resident_level, 1),
+                stats.resident_level,
+                stats.level_count,
+                stats.wanted_level,
+                stats.resident_bytes >> 10),
+            0.0f,
+            y,
+            0.8f,
+            glm::fvec3{ 0.5f, 0.5f, 0.5f });
+    }
+}
+
 void Sandbox::SetCallbacks()
 {
     glfwSetScrollCallback(nxt::Context::Instance().Get(), [](GLFWwindow* win, double xoffset, double yoffset)
@@ -290,15 +434,6 @@ void Sandbox::SetCallbacks()
     });
 }
 
-void Sandbox::Run()
-{
-    while (!nxt::Context::Instance())
-    {
-        ProcessInput(nxt::Context::Instance().GetTimePerFrame());
-        Render();
-    }
-}
-
 nxt::Application* nxt::CreateApplication()
 {
     return new Sandbox();
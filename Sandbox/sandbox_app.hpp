@@ -11,18 +11,29 @@ public:
 
     virtual void Init() override final;
     virtual void ProcessInput(float dt) override final;
-    virtual void Render() override final;
+    virtual void Render(float alpha) override final;
     virtual void SetCallbacks() override final;
-    virtual void Run() override final;
 
 private:
-    glm::fvec3 light_position_;
+    // screen-space demand of the streamed textures, from mesh bounds and camera distance
+    void RequestTextureLevels();
+    void DrawStreamingStats();
+
+    glm::fvec3 light_position_{};
+    // seconds of simulation the light has orbited for
+    float light_time_{};
+    // where the camera was before the last step, Render interpolates from it
+    glm::fvec3 previous_camera_position_{};
     glm::fmat4 view_, model_;
     static glm::fmat4 projection;
     static std::unique_ptr<nxt::Camera> camera;
     std::vector<std::unique_ptr<nxt::Audio>> audio_list_;
+    nxt::EmitterHandle light_emitter_;
+    // F or the left mouse button was down on the last step
+    bool play_held_{};
     std::vector<std::unique_ptr<nxt::MeshRenderer>> meshes_;
     std::vector<std::unique_ptr<nxt::SpriteRenderer>> sprites_;
+    std::unique_ptr<nxt::ParticleSystem> donut_trail_;
 };
 
 nxt::Application* nxt::CreateApplication();
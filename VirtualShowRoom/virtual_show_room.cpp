@@ -1,6 +1,8 @@
 #include "virtual_show_room.hpp"
 
 #define FPS 1
+// GL calls recorded here and executed by nxt::RenderThread, experimental
+#define RENDER_THREAD 0
 
 glm::mat4 VirtualShowRoom::projection;
 std::unique_ptr<nxt::Camera> VirtualShowRoom::camera;
@@ -18,12 +20,14 @@ void VirtualShowRoom::Init() {
 #else
 		std::make_unique<nxt::OrbitCamera>();
 #endif
+	previous_camera_position_ = camera->GetPosition();
 
 	nxt::FileSystem::Instance().SetResourceRootDir("Resources");
+	// built by nxt_cook pack, the loose files are used without it
+	const bf::path pack = nxt::FileSystem::Instance().GetResourceRootDir() / "resources.nxtpack";
+	if (bf::exists(pack)) nxt::FileSystem::Instance().MountPack(pack.string());
 	nxt::FileSystem::Instance().InitSubDirs({ "fonts", "audio", "models", "shader", "textures" });
 
-	audio_list_.push_back(std::make_unique<nxt::Music>());
-
 	nxt::context::Config config;
 	config.opengl_major = 3;
 	config.opengl_minor = 3;
@@ -34,6 +38,7 @@ void VirtualShowRoom::Init() {
 	config.context_size = nxt::context::Size::FULLSCREEEN;
 
 	nxt::Context::Instance().Create(config);
+	nxt::Context::Instance().SetVSync(true);
 	nxt::Context::Instance().SetCursorPos(
 		static_cast<float>(nxt::Context::Instance().GetWidth() / 2),
 		static_cast<float>(nxt::Context::Instance().GetHeight() / 2));
@@ -75,63 +80,26 @@ void VirtualShowRoom::Init() {
 	table_model_ = glm::scale<float>(glm::fvec3{ 1.2f,1.2f,1.2f });
 	table_model_ *= glm::translate<float>(glm::fvec3{ 0.0f, -0.2f, 0.0f });
 
-	nxt::ResourceManager::LoadShader(
-		nxt::FileSystem::Instance().GetPathString("shader") + "cubemap_vert_shader.glsl",
-		nxt::FileSystem::Instance().GetPathString("shader") + "cubemap_frag_shader.glsl",
-		"cubemap");
-	nxt::ResourceManager::LoadShader(
-		nxt::FileSystem::Instance().GetPathString("shader") + "font_vert.glsl",
-		nxt::FileSystem::Instance().GetPathString("shader") + "font_frag.glsl",
-		"text");
-	nxt::ResourceManager::LoadShader(
-		nxt::FileSystem::Instance().GetPathString("shader") + "mesh_vert_phong.glsl",
-		nxt::FileSystem::Instance().GetPathString("shader") + "mesh_frag_phong.glsl",
-		"model");
-
-	std::vector<std::string> cubemap_textures{
-	nxt::FileSystem::Instance().GetPathString("textures") + "bricks.jpg",
-	nxt::FileSystem::Instance().GetPathString("textures") + "bricks.jpg",
-	nxt::FileSystem::Instance().GetPathString("textures") + "bricks.jpg",
-	nxt::FileSystem::Instance().GetPathString("textures") + "bricks.jpg",
-	nxt::FileSystem::Instance().GetPathString("textures") + "bricks.jpg",
-	nxt::FileSystem::Instance().GetPathString("textures") + "bricks.jpg" };
-
-	nxt::ResourceManager::LoadTexture(
-		nxt::ResourceManager::GetShader("cubemap"),
-		cubemap_textures,
-		"faces");
-	nxt::ResourceManager::LoadTexture(
-		nxt::ResourceManager::GetShader("model"),
-		nxt::FileSystem::Instance().GetPathString("textures") + "wood_floor.jpg",
-		"floor");
-	nxt::ResourceManager::LoadTexture(
-		nxt::ResourceManager::GetShader("model"),
-		nxt::FileSystem::Instance().GetPathString("textures") + "cupboard_table.jpg",
-		"cupboard_table");
-	nxt::ResourceManager::LoadTexture(
-		nxt::ResourceManager::GetShader("model"),
-		nxt::FileSystem::Instance().GetPathString("textures") + "tv.jpg",
-		"tv");
-	nxt::ResourceManager::LoadTexture(
-		nxt::ResourceManager::GetShader("model"),
-		nxt::FileSystem::Instance().GetPathString("textures") + "sofa.jpg",
-		"sofa");
-	nxt::ResourceManager::LoadTexture(
-		nxt::ResourceManager::GetShader("model"),
-		nxt::FileSystem::Instance().GetPathString("textures") + "lowboard.jpg",
-		"lowboard");
-	nxt::ResourceManager::LoadTexture(
-		nxt::ResourceManager::GetShader("model"),
-		nxt::FileSystem::Instance().GetPathString("textures") + "lamp.jpg",
-		"lamp");
-
-	nxt::ResourceManager::LoadTextRenderer(
-		nxt::ResourceManager::GetShader("text"),
-		nxt::Context::Instance().GetWidth(),
-		nxt::Context::Instance().GetHeight(),
-		20,
-		nxt::FileSystem::Instance().GetPathString("fonts") + "Wallpoet-Regular.ttf",
-		"Wallpoet");
+	// decoded and parsed on the thread pool, GL objects created here
+	nxt::AssetLoader assets;
+	const bool loaded = assets.Load((nxt::FileSystem::Instance().GetResourceRootDir() / "virtual_show_room.json").string());
+	assets.Report();
+	if (!loaded) {
+		std::cerr << "ERROR LOADING THE SHOW ROOM ASSETS" << std::endl;
+		nxt::Context::Instance().SetCloseFlag();
+		return;
+	}
+
+	model_shader_ = nxt::ResourceManager::GetShaderHandle("model");
+	cubemap_shader_ = nxt::ResourceManager::GetShaderHandle("cubemap");
+	floor_texture_ = nxt::ResourceManager::GetTextureHandle("floor");
+	cupboard_table_texture_ = nxt::ResourceManager::GetTextureHandle("cupboard_table");
+	tv_texture_ = nxt::ResourceManager::GetTextureHandle("tv");
+	sofa_texture_ = nxt::ResourceManager::GetTextureHandle("sofa");
+	lowboard_texture_ = nxt::ResourceManager::GetTextureHandle("lowboard");
+	lamp_texture_ = nxt::ResourceManager::GetTextureHandle("lamp");
+	faces_texture_ = nxt::ResourceManager::GetTextureHandle("faces");
+	text_renderer_ = nxt::ResourceManager::GetTextRendererHandle("Wallpoet");
 
 	nxt::ResourceManager::GetShader("model")->SetMat4("u_projection", projection);
 	nxt::ResourceManager::GetShader("model")->SetVec3("u_light_color", glm::fvec3{ 1.0f, 1.0f, 1.0f });
@@ -140,49 +108,23 @@ void VirtualShowRoom::Init() {
 	nxt::ResourceManager::GetShader("cubemap")->SetInt("skybox", 0);
 	nxt::ResourceManager::GetShader("cubemap")->SetMat4("projection", projection);
 
-	meshes_.push_back(std::make_unique<nxt::MeshRenderer>(nxt::ResourceManager::GetShader("model")));
-	meshes_[0]->Load(
-		nxt::FileSystem::Instance().GetPathString("models") + "floor.obj",
-		false);
-
-	meshes_.push_back(std::make_unique<nxt::MeshRenderer>(nxt::ResourceManager::GetShader("cubemap")));
-	meshes_[1]->Load(
-		nxt::FileSystem::Instance().GetPathString("models") + "cube.obj");
-
-	meshes_.push_back(std::make_unique<nxt::MeshRenderer>(nxt::ResourceManager::GetShader("model")));
-	meshes_[2]->Load(
-		nxt::FileSystem::Instance().GetPathString("models") + "cupboard.obj",
-		false);
-
-	meshes_.push_back(std::make_unique<nxt::MeshRenderer>(nxt::ResourceManager::GetShader("model")));
-	meshes_[3]->Load(
-		nxt::FileSystem::Instance().GetPathString("models") + "table.obj",
-		false);
-
-	meshes_.push_back(std::make_unique<nxt::MeshRenderer>(nxt::ResourceManager::GetShader("model")));
-	meshes_[4]->Load(
-		nxt::FileSystem::Instance().GetPathString("models") + "tv.obj",
-		false);
-
-	meshes_.push_back(std::make_unique<nxt::MeshRenderer>(nxt::ResourceManager::GetShader("model")));
-	meshes_[5]->Load(
-		nxt::FileSystem::Instance().GetPathString("models") + "sofa.obj",
-		false);
-
-	meshes_.push_back(std::make_unique<nxt::MeshRenderer>(nxt::ResourceManager::GetShader("model")));
-	meshes_[6]->Load(
-		nxt::FileSystem::Instance().GetPathString("models") + "lowboard.obj",
-		false);
-
-	meshes_.push_back(std::make_unique<nxt::MeshRenderer>(nxt::ResourceManager::GetShader("model")));
-	meshes_[7]->Load(
-		nxt::FileSystem::Instance().GetPathString("models") + "lamp.obj",
-		false);
-
-	audio_list_[0]->Open(nxt::FileSystem::Instance().GetPathString("audio") + "waves.ogg");
-	audio_list_[0]->Play(true);
-	audio_list_[0]->Volume(10.0f);
-	audio_list_[0]->Pitch(1.0f);
+	for (const char* mesh : { "floor_mesh", "cube_mesh", "cupboard_mesh", "table_mesh", "tv_mesh", "sofa_mesh", "lowboard_mesh", "lamp_mesh" }) {
+		meshes_.push_back(assets.TakeMesh(mesh));
+		if (!meshes_.back()) {
+			std::cerr << "MESH '" << mesh << "' IS MISSING FROM THE SHOW ROOM ASSETS" << std::endl;
+			nxt::Context::Instance().SetCloseFlag();
+			return;
+		}
+	}
+
+	// the room is shown without its sound
+	std::unique_ptr<nxt::Audio> waves = assets.TakeAudio("waves");
+	if (waves) {
+		waves->Play(true);
+		waves->Volume(10.0f);
+		waves->Pitch(1.0f);
+		audio_list_.push_back(std::move(waves));
+	}
 }
 
 void VirtualShowRoom::ProcessInput(float dt) {
@@ -190,10 +132,11 @@ void VirtualShowRoom::ProcessInput(float dt) {
 		nxt::Context::Instance().SetCloseFlag();
 
 	if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_E))
-		nxt::opengl::PolygonMode();
+		nxt::RenderThread::Instance().Record([]() { nxt::opengl::PolygonMode(); });
 	if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_Q))
-		nxt::opengl::FillMode();
+		nxt::RenderThread::Instance().Record([]() { nxt::opengl::FillMode(); });
 
+	previous_camera_position_ = camera->GetPosition();
 	if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_W))
 		camera->HandleKeyboard(nxt::CameraMovement::FORWARD, dt);
 	if (nxt::Context::Instance().KeyDown(nxt::KeyNum::KEY_S))
@@ -204,68 +147,84 @@ void VirtualShowRoom::ProcessInput(float dt) {
 		camera->HandleKeyboard(nxt::CameraMovement::RIGHT, dt);
 }
 
-void VirtualShowRoom::Render() {
-	nxt::Renderer::Clear();
-
-	view_ = camera->GetViewMatrix();
-	nxt::ResourceManager::GetShader("model")->SetMat4("u_view", view_);
-	nxt::ResourceManager::GetShader("model")->SetVec3("u_view_pos", camera->GetPosition());
-
-	nxt::ResourceManager::GetShader("model")->SetMat4("u_model", floor_model_);
-	nxt::ResourceManager::GetTexture("floor")->Bind("u_tex_sampler", 0);
-	meshes_[0]->Draw();
-	nxt::ResourceManager::GetTexture("floor")->Unbind(0);
-
-	nxt::ResourceManager::GetShader("model")->SetMat4("u_model", cupboard_model_);
-	nxt::ResourceManager::GetTexture("cupboard_table")->Bind("u_tex_sampler", 0);
-	meshes_[2]->Draw();
-	nxt::ResourceManager::GetTexture("cupboard_table")->Unbind(0);
-
-	nxt::ResourceManager::GetShader("model")->SetMat4("u_model", table_model_);
-	nxt::ResourceManager::GetTexture("cupboard_table")->Bind("u_tex_sampler", 0);
-	meshes_[3]->Draw();
-	nxt::ResourceManager::GetTexture("cupboard_table")->Unbind(0);
-
-	nxt::ResourceManager::GetShader("model")->SetMat4("u_model", tv_model_);
-	nxt::ResourceManager::GetTexture("tv")->Bind("u_tex_sampler", 0);
-	meshes_[4]->Draw();
-	nxt::ResourceManager::GetTexture("tv")->Unbind(0);
-
-	nxt::ResourceManager::GetShader("model")->SetMat4("u_model", sofa_model_);
-	nxt::ResourceManager::GetTexture("sofa")->Bind("u_tex_sampler", 0);
-	meshes_[5]->Draw();
-	nxt::ResourceManager::GetTexture("sofa")->Unbind(0);
-
-	nxt::ResourceManager::GetShader("model")->SetMat4("u_model", lowboard_model_);
-	nxt::ResourceManager::GetTexture("lowboard")->Bind("u_tex_sampler", 0);
-	meshes_[6]->Draw();
-	nxt::ResourceManager::GetTexture("lowboard")->Unbind(0);
-
-	nxt::ResourceManager::GetShader("model")->SetMat4("u_model", lamp_model_);
-	nxt::ResourceManager::GetTexture("lamp")->Bind("u_tex_sampler", 0);
-	nxt::opengl::DisableCullFace();
-	meshes_[7]->Draw();
-	nxt::opengl::EnableCullFace();
-	nxt::ResourceManager::GetTexture("lamp")->Unbind(0);
-
-	view_ = camera->GetViewMatrix(false);
-	nxt::ResourceManager::GetShader("cubemap")->SetMat4("view", view_);
-
-	nxt::ResourceManager::GetTexture("faces")->Bind("skybox", 0);
-	nxt::opengl::SetCubeMapMode();
-	meshes_[1]->Draw();
-	nxt::opengl::ResetCubeMapMode();
-	nxt::ResourceManager::GetTexture("faces")->Unbind(0);
-
-	nxt::ResourceManager::GetTextRenderer("Wallpoet")->Draw(
-		"Framerate: " + std::to_string(nxt::Context::Instance().GetFrameRate(2)).substr(0, 5),
-		0.0f,
-		0.0f,
-		1.2f,
-		glm::fvec3{ 0.5f, 0.5f, 0.5f });
+void VirtualShowRoom::Render(float alpha) {
+	// what the frame needs from the simulation, taken now as the next
+	// frame is simulated while this one is drawn
+	const glm::fvec3 view_pos = glm::mix(previous_camera_position_, camera->GetPosition(), alpha);
+	const glm::fmat4 view = camera->GetViewMatrix() * glm::translate(camera->GetPosition() - view_pos);
+	const glm::fmat4 skybox_view = camera->GetViewMatrix(false);
+	// the arena keeps it until the render thread is done with this frame
+	const boost::string_view framerate =
+		nxt::FrameArena::Get().Format("Framerate: %.2f", nxt::Context::Instance().GetFrameRate(2));
+
+	nxt::RenderThread::Instance().Record([this, view, skybox_view, view_pos, framerate]() {
+		nxt::Renderer::Clear();
+
+		nxt::Shader& model_shader = nxt::ResourceManager::Get(model_shader_);
+		nxt::Shader& cubemap_shader = nxt::ResourceManager::Get(cubemap_shader_);
+
+		model_shader.SetMat4("u_view", view);
+		model_shader.SetVec3("u_view_pos", view_pos);
+
+		model_shader.SetMat4("u_model", floor_model_);
+		nxt::ResourceManager::Get(floor_texture_).Bind("u_tex_sampler", 0);
+		meshes_[0]->Draw();
+		nxt::ResourceManager::Get(floor_texture_).Unbind(0);
+
+		model_shader.SetMat4("u_model", cupboard_model_);
+		nxt::ResourceManager::Get(cupboard_table_texture_).Bind("u_tex_sampler", 0);
+		meshes_[2]->Draw();
+		nxt::ResourceManager::Get(cupboard_table_texture_).Unbind(0);
+
+		model_shader.SetMat4("u_model", table_model_);
+		nxt::ResourceManager::Get(cupboard_table_texture_).Bind("u_tex_sampler", 0);
+		meshes_[3]->Draw();
+		nxt::ResourceManager::Get(cupboard_table_texture_).Unbind(0);
+
+		model_shader.SetMat4("u_model", tv_model_);
+		nxt::ResourceManager::Get(tv_texture_).Bind("u_tex_sampler", 0);
+		meshes_[4]->Draw();
+		nxt::ResourceManager::Get(tv_texture_).Unbind(0);
+
+		model_shader.SetMat4("u_model", sofa_model_);
+		nxt::ResourceManager::Get(sofa_texture_).Bind("u_tex_sampler", 0);
+		meshes_[5]->Draw();
+		nxt::ResourceManager::Get(sofa_texture_).Unbind(0);
+
+		model_shader.SetMat4("u_model", lowboard_model_);
+		nxt::ResourceManager::Get(lowboard_texture_).Bind("u_tex_sampler", 0);
+		meshes_[6]->Draw();
+		nxt::ResourceManager::Get(lowboard_texture_).Unbind(0);
+
+		model_shader.SetMat4("u_model", lamp_model_);
+		nxt::ResourceManager::Get(lamp_texture_).Bind("u_tex_sampler", 0);
+		nxt::opengl::DisableCullFace();
+		meshes_[7]->Draw();
+		nxt::opengl::EnableCullFace();
+		nxt::ResourceManager::Get(lamp_texture_).Unbind(0);
+
+		cubemap_shader.SetMat4("view", skybox_view);
+
+		nxt::ResourceManager::Get(faces_texture_).Bind("skybox", 0);
+		nxt::opengl::SetCubeMapMode();
+		meshes_[1]->Draw();
+		nxt::opengl::ResetCubeMapMode();
+		nxt::ResourceManager::Get(faces_texture_).Unbind(0);
+
+		nxt::ResourceManager::Get(text_renderer_).Draw(
+			framerate,
+			0.0f,
+			0.0f,
+			1.2f,
+			glm::fvec3{ 0.5f, 0.5f, 0.5f });
+
+		// evicts GL objects, so it runs where they are used
+		nxt::ResidencyManager::Instance().Update();
+		nxt::Context::Instance().SwapBuffers();
+	});
 
 	nxt::Context::Instance().PollEvents();
-	nxt::Context::Instance().SwapBuffers();
+	nxt::RenderThread::Instance().Submit();
 }
 
 void VirtualShowRoom::SetCallbacks() {
@@ -273,8 +232,11 @@ void VirtualShowRoom::SetCallbacks() {
 		camera->HandleScroll(static_cast<float>(yoffset));
 #if FPS == 1
 		projection = camera->GetProjectionMatrix(nxt::Context::Instance().GetRatio());
-		nxt::ResourceManager::GetShader("model")->SetMat4("u_projection", projection);
-		nxt::ResourceManager::GetShader("cubemap")->SetMat4("projection", projection);
+		const glm::fmat4 scrolled = projection;
+		nxt::RenderThread::Instance().Record([scrolled]() {
+			nxt::ResourceManager::GetShader("model")->SetMat4("u_projection", scrolled);
+			nxt::ResourceManager::GetShader("cubemap")->SetMat4("projection", scrolled);
+		});
 #endif
 	});
 
@@ -284,15 +246,16 @@ void VirtualShowRoom::SetCallbacks() {
 
 	glfwSetFramebufferSizeCallback(
 		nxt::Context::Instance().Get(), [](GLFWwindow*, int width, int height) {
-		nxt::opengl::SetViewport(0, 0, width, height);
+		nxt::RenderThread::Instance().Record([width, height]() { nxt::opengl::SetViewport(0, 0, width, height); });
 	});
 }
 
 void VirtualShowRoom::Run() {
-	while (!nxt::Context::Instance()) {
-		ProcessInput(nxt::Context::Instance().GetTimePerFrame());
-		Render();
-	}
+#if RENDER_THREAD == 1
+	nxt::RenderThread::Instance().Start(nxt::Context::Instance().Get());
+#endif
+	nxt::Application::Run();
+	nxt::RenderThread::Instance().Stop();
 }
 
 nxt::Application* nxt::CreateApplication() {
@@ -10,14 +10,15 @@ public:
 
 	virtual void Init() override final;
 	virtual void ProcessInput(float dt) override final;
-	virtual void Render() override final;
+	virtual void Render(float alpha) override final;
 	virtual void SetCallbacks() override final;
 	virtual void Run() override final;
 
 private:
 	glm::fvec3 light_position_;
+	// where the camera was before the last step, Render interpolates from it
+	glm::fvec3 previous_camera_position_{};
 
-	glm::fmat4 view_{};
 	glm::fmat4 floor_model_{};
 	glm::fmat4 cupboard_model_{};
 	glm::fmat4 table_model_{};
@@ -26,6 +27,18 @@ private:
 	glm::fmat4 lowboard_model_{};
 	glm::fmat4 lamp_model_{};
 
+	// looked up once in Init, resolved every frame in Render
+	nxt::ShaderHandle model_shader_{};
+	nxt::ShaderHandle cubemap_shader_{};
+	nxt::TextureHandle floor_texture_{};
+	nxt::TextureHandle cupboard_table_texture_{};
+	nxt::TextureHandle tv_texture_{};
+	nxt::TextureHandle sofa_texture_{};
+	nxt::TextureHandle lowboard_texture_{};
+	nxt::TextureHandle lamp_texture_{};
+	nxt::TextureHandle faces_texture_{};
+	nxt::TextRendererHandle text_renderer_{};
+
 	static glm::fmat4 projection;
 	static std::unique_ptr<nxt::Camera> camera;
 	std::vector<std::unique_ptr<nxt::Audio>> audio_list_;